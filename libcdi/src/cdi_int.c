@@ -30,6 +30,8 @@ int cdiDefaultModelID  = CDI_UNDEFID;
 int cdiDefaultTableID  = CDI_UNDEFID;
 //int cdiNcMissingValue  = CDI_UNDEFID;
 int cdiNcChunksizehint = CDI_UNDEFID;
+int cdiNcSlabCache     = 256;     /* MB */
+int cdiVerbose         = FALSE;
 int cdiChunkType       = CHUNK_GRID;
 int cdiSplitLtype105   = CDI_UNDEFID;
 
@@ -37,6 +39,9 @@ int cdiIgnoreAttCoordinates = FALSE;
 int cdiIgnoreValidRange     = FALSE;
 int cdiSkipRecords          = 0;
 int cdiInventoryMode        = 1;
+int cdiGribIndex            = 0;
+int cdiGribReadAhead        = 0;
+int cdiGribWriteBehind      = 0;
 size_t CDI_netcdf_hdr_pad   = 0UL;
 
 char *cdiPartabPath   = NULL;
@@ -304,6 +309,15 @@ void cdiInitialize(void)
       value = cdiGetenvInt("CDI_NETCDF_HDR_PAD");
       if ( value >= 0 ) CDI_netcdf_hdr_pad = (size_t) value;
 
+      value = cdiGetenvInt("CDI_GRIB_INDEX");
+      if ( value >= 0 ) cdiGribIndex = (int) value;
+
+      value = cdiGetenvInt("CDI_GRIB_READAHEAD");
+      if ( value >= 0 ) cdiGribReadAhead = (int) value;
+
+      value = cdiGetenvInt("CDI_GRIB_WRITEBEHIND");
+      if ( value >= 0 ) cdiGribWriteBehind = (int) value;
+
       envString = getenv("CDI_MISSVAL");
       if ( envString ) cdiDefaultMissval = atof(envString);
       /*
@@ -313,6 +327,9 @@ void cdiInitialize(void)
       envString = getenv("NC_CHUNKSIZEHINT");
       if ( envString ) cdiNcChunksizehint = atoi(envString);
 
+      value = cdiGetenvInt("CDI_NC_SLAB_CACHE");
+      if ( value >= 0 ) cdiNcSlabCache = (int) value;
+
       envString = getenv("CDI_CHUNK_ALGO");
       if ( envString ) cdiSetChunk(envString);
 
@@ -397,6 +414,8 @@ void cdiDefGlobal(const char *string, int val)
   else if ( strcmp(string, "HAVE_MISSVAL")     == 0 ) cdiHaveMissval = val;
   else if ( strcmp(string, "NC_CHUNKSIZEHINT") == 0 ) cdiNcChunksizehint = val;
   else if ( strcmp(string, "NETCDF_HDR_PAD")   == 0 ) CDI_netcdf_hdr_pad = (size_t) val;
+  else if ( strcmp(string, "NC_SLAB_CACHE")    == 0 ) cdiNcSlabCache = val;
+  else if ( strcmp(string, "VERBOSE")          == 0 ) cdiVerbose = val;
   else Warning("Unsupported global key: %s", string);
 }
 
@@ -168,6 +168,7 @@ typedef struct {
   int      *level;       /* record IDs */
   int      *lindex;      /* level index */
   int       defmiss;     /* TRUE if missval is defined in file */
+  char     *lskip;       /* levels skipped by the record filter */
 
   int       isUsed;
   int       gridID;
@@ -231,6 +232,10 @@ typedef struct {
   void       *gribContainers;
 #endif
   int         vlistIDorig;
+  void       *gribIndex;    // GRIB record index of the file (read mode)
+  void       *gribReadAhead; // records decoded in advance (read mode)
+  void       *cdfSlabCache;  // cached slabs of NetCDF variables (read mode)
+  void       *gribWriteBehind; // records encoded by worker threads (write mode)
   /* only used by MPI-parallelized version of library */
   int       ownerRank;    // MPI rank of owner process
   /* ---------------------------------- */
@@ -251,11 +256,16 @@ extern int cdiDefaultTableID;
 extern int cdiDefaultLeveltype;
 //extern int cdiNcMissingValue;
 extern int cdiNcChunksizehint;
+extern int cdiNcSlabCache;
+extern int cdiVerbose;
 extern int cdiChunkType;
 extern int cdiSplitLtype105;
 extern int cdiDataUnreduced;
 extern int cdiSortName;
 extern int cdiHaveMissval;
+extern int cdiGribIndex;
+extern int cdiGribReadAhead;
+extern int cdiGribWriteBehind;
 extern int STREAM_Debug;
 
 
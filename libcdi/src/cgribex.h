@@ -225,6 +225,8 @@ void  gribRepair1(int nrec, long recsize, unsigned char *gribbuffer);
 
 int   gribGetZip(long recsize, unsigned char *gribbuffer, long *urecsize);
 
+int   gribExPDS(unsigned char *kgrib, int *isec0, int *isec1, int *iret);
+
 int   gribBzip(unsigned char *dbuf, long dbufsize, unsigned char *sbuf, long sbufsize);
 int   gribZip(unsigned char *dbuf, long dbufsize, unsigned char *sbuf, long sbufsize);
 int   gribUnzip(unsigned char *dbuf, long dbufsize, unsigned char *sbuf, long sbufsize);
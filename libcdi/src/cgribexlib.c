@@ -2002,6 +2002,320 @@ void sse41_decode_array_2byte_double(size_t datasize, const unsigned char * rest
 #undef _ENABLE_AVX
 #undef _ENABLE_SSE4_1
 
+/*
+  Runtime dispatched SIMD kernels for unpacking and packing of GRIB data
+  with any number of bits per value (1-32).
+
+  A group of 8 values with n bits occupies exactly n bytes, so the groups are
+  processed independently. The kernels return the number of values done, always
+  a multiple of 8. The remaining values are byte aligned and done by the scalar
+  code. The floating point operations are the same as in the scalar code
+  (separate multiply and add, no FMA), the results are bit identical.
+*/
+
+#if defined (__GNUC__) && (__GNUC__ >= 5 || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+#define GRIB_SIMD_DISPATCH
+#endif
+
+#if defined (GRIB_SIMD_DISPATCH)
+#include <immintrin.h>
+#if defined (HAVE_LIBPTHREAD)
+#include <pthread.h>
+#endif
+
+#define  GRIB_SIMD_NONE    0
+#define  GRIB_SIMD_AVX2    1
+#define  GRIB_SIMD_AVX512  2
+
+static int grib_simd_level = -1;
+
+static
+int grib_simd_init(void)
+{
+  int level = GRIB_SIMD_NONE;
+  char *envString = getenv("GRIBEX_SIMD");
+
+  __builtin_cpu_init();
+
+  if ( __builtin_cpu_supports("avx2") ) level = GRIB_SIMD_AVX2;
+  if ( __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+       __builtin_cpu_supports("avx512dq") ) level = GRIB_SIMD_AVX512;
+
+  /* GRIBEX_SIMD=0 disables the SIMD kernels, 1 limits them to AVX2 */
+  if ( envString && atoi(envString) < level ) level = atoi(envString);
+  if ( level < 0 ) level = GRIB_SIMD_NONE;
+
+  return (level);
+}
+
+#if defined (HAVE_LIBPTHREAD)
+static pthread_once_t grib_simd_once = PTHREAD_ONCE_INIT;
+#endif
+
+static
+void grib_simd_init_level(void)
+{
+  grib_simd_level = grib_simd_init();
+}
+
+/* the level is set once, the decode and encode threads may call the kernels concurrently */
+static inline
+int grib_simd_get_level(void)
+{
+#if defined (HAVE_LIBPTHREAD)
+  pthread_once(&grib_simd_once, grib_simd_init_level);
+#else
+  if ( grib_simd_level == -1 ) grib_simd_init_level();
+#endif
+  return (grib_simd_level);
+}
+
+/* shuffle control and shift counts of a group, a 64-bit lane gets the 5 bytes of one value */
+static
+void grib_simd_group_layout(int numBits, unsigned char *shuffle, long long *shift)
+{
+  int k, b, off, first;
+
+  for ( k = 0; k < 8; ++k )
+    {
+      first = ((k & ~1)*numBits) >> 3;  /* load offset of the 16 byte pair */
+      off   = ((k*numBits) >> 3) - first;
+      for ( b = 0; b < 8; ++b )
+	shuffle[8*k+b] = (unsigned char) ((b < 3) ? 0x80 : off + 7 - b);
+      shift[k] = (k*numBits) & 7;
+    }
+}
+
+__attribute__ ((target ("avx2")))
+static
+long avx2_decode_array_double(const unsigned char *restrict igrib, long jlend, int numBits,
+			      double fmin, double zscale, double *restrict fpdata)
+{
+  unsigned char shuffle[64];
+  long long shift[8];
+  long i, ngroups, nbytes = (jlend*numBits + 7) / 8;
+  long off2 = (2*numBits) >> 3, off4 = (4*numBits) >> 3, off6 = (6*numBits) >> 3;
+
+  /* the last group reads 16 bytes at off6 */
+  ngroups = (nbytes - off6 - 16) / numBits;
+  if ( ngroups > jlend/8 ) ngroups = jlend/8;
+  if ( ngroups <= 0 ) return (0);
+
+  grib_simd_group_layout(numBits, shuffle, shift);
+
+  const __m256i shufA  = _mm256_loadu_si256((const __m256i *) shuffle);
+  const __m256i shufB  = _mm256_loadu_si256((const __m256i *) (shuffle+32));
+  const __m256i shiftA = _mm256_loadu_si256((const __m256i *) shift);
+  const __m256i shiftB = _mm256_loadu_si256((const __m256i *) (shift+4));
+  const __m256i magic  = _mm256_set1_epi64x(0x4330000000000000LL);
+  const __m256d dmagic = _mm256_set1_pd(4503599627370496.0);  /* 2^52 */
+  const __m256d dmin   = _mm256_set1_pd(fmin);
+  const __m256d dscale = _mm256_set1_pd(zscale);
+  const int rshift = 64 - numBits;
+
+  for ( i = 0; i < ngroups; ++i )
+    {
+      const unsigned char *bits = igrib + i*numBits;
+      __m256i va = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) bits)),
+					   _mm_loadu_si128((const __m128i *) (bits+off2)), 1);
+      __m256i vb = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) (bits+off4))),
+					   _mm_loadu_si128((const __m128i *) (bits+off6)), 1);
+
+      va = _mm256_srli_epi64(_mm256_sllv_epi64(_mm256_shuffle_epi8(va, shufA), shiftA), rshift);
+      vb = _mm256_srli_epi64(_mm256_sllv_epi64(_mm256_shuffle_epi8(vb, shufB), shiftB), rshift);
+
+      /* exact conversion of the integers < 2^52 */
+      __m256d da = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(va, magic)), dmagic);
+      __m256d db = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(vb, magic)), dmagic);
+
+      _mm256_storeu_pd(fpdata+8*i,   _mm256_add_pd(dmin, _mm256_mul_pd(dscale, da)));
+      _mm256_storeu_pd(fpdata+8*i+4, _mm256_add_pd(dmin, _mm256_mul_pd(dscale, db)));
+    }
+
+  return (ngroups*8);
+}
+
+__attribute__ ((target ("avx512f,avx512bw,avx512dq")))
+static
+long avx512_decode_array_double(const unsigned char *restrict igrib, long jlend, int numBits,
+				double fmin, double zscale, double *restrict fpdata)
+{
+  unsigned char shuffle[64];
+  long long shift[8];
+  long i, ngroups, nbytes = (jlend*numBits + 7) / 8;
+  long off2 = (2*numBits) >> 3, off4 = (4*numBits) >> 3, off6 = (6*numBits) >> 3;
+
+  ngroups = (nbytes - off6 - 16) / numBits;
+  if ( ngroups > jlend/8 ) ngroups = jlend/8;
+  if ( ngroups <= 0 ) return (0);
+
+  grib_simd_group_layout(numBits, shuffle, shift);
+
+  const __m512i shuf   = _mm512_loadu_si512((const void *) shuffle);
+  const __m512i vshift = _mm512_loadu_si512((const void *) shift);
+  const __m512d dmin   = _mm512_set1_pd(fmin);
+  const __m512d dscale = _mm512_set1_pd(zscale);
+  const unsigned int rshift = (unsigned int) (64 - numBits);
+
+  for ( i = 0; i < ngroups; ++i )
+    {
+      const unsigned char *bits = igrib + i*numBits;
+      __m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *) bits));
+      v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *) (bits+off2)), 1);
+      v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *) (bits+off4)), 2);
+      v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *) (bits+off6)), 3);
+
+      v = _mm512_srli_epi64(_mm512_sllv_epi64(_mm512_shuffle_epi8(v, shuf), vshift), rshift);
+
+      /* no contraction to FMA, the result has to be identical to the scalar code */
+      __m512d d = _mm512_mul_round_pd(dscale, _mm512_cvtepu64_pd(v), _MM_FROUND_CUR_DIRECTION);
+      _mm512_storeu_pd(fpdata+8*i, _mm512_add_round_pd(dmin, d, _MM_FROUND_CUR_DIRECTION));
+    }
+
+  return (ngroups*8);
+}
+
+static
+long grib_decode_array_simd(const unsigned char *restrict igrib, long jlend, int numBits,
+			    double fmin, double zscale, double *restrict fpdata)
+{
+  int simd_level = grib_simd_get_level();
+
+  if ( numBits < 1 || numBits > 32 ) return (0);
+
+  if ( simd_level == GRIB_SIMD_AVX512 )
+    return (avx512_decode_array_double(igrib, jlend, numBits, fmin, zscale, fpdata));
+  else if ( simd_level == GRIB_SIMD_AVX2 )
+    return (avx2_decode_array_double(igrib, jlend, numBits, fmin, zscale, fpdata));
+
+  return (0);
+}
+
+/* appends 8 values with numBits bits to the bit stream, full 64-bit words are stored big endian */
+static inline
+void grib_pack_group(const long long *restrict ival, int numBits, uint64_t *acc, int *nacc, unsigned char **out)
+{
+  int k, spill;
+  uint64_t v, word;
+
+  for ( k = 0; k < 8; ++k )
+    {
+      v = (uint64_t) ival[k];
+      if ( *nacc + numBits < 64 )
+	{
+	  *acc |= v << (64 - *nacc - numBits);
+	  *nacc += numBits;
+	}
+      else
+	{
+	  spill = *nacc + numBits - 64;
+	  word = *acc | (v >> spill);
+	  word = __builtin_bswap64(word);
+	  memcpy(*out, &word, 8);
+	  *out += 8;
+	  *acc = spill ? v << (64 - spill) : 0;
+	  *nacc = spill;
+	}
+    }
+}
+
+static inline
+void grib_pack_flush(uint64_t acc, int nacc, unsigned char **out)
+{
+  for ( ; nacc > 0; nacc -= 8 )
+    {
+      *(*out)++ = (unsigned char) (acc >> 56);
+      acc <<= 8;
+    }
+}
+
+__attribute__ ((target ("avx2")))
+static
+size_t avx2_encode_array_double(int numBits, size_t datasize, unsigned char *restrict lGrib,
+				const double *restrict data, double zref, double factor)
+{
+  long long ival[8] __attribute__ ((aligned (32)));
+  size_t i, ngroups = datasize/8;
+  uint64_t acc = 0;
+  int nacc = 0;
+  unsigned char *out = lGrib;
+  const __m256d dref    = _mm256_set1_pd(zref);
+  const __m256d dfactor = _mm256_set1_pd(factor);
+  const __m256d dhalf   = _mm256_set1_pd(0.5);
+  const __m256d dmagic  = _mm256_set1_pd(4503599627370496.0);  /* 2^52 */
+  const __m256i mask    = _mm256_set1_epi64x((long long) ((1ULL << numBits) - 1));
+
+  for ( i = 0; i < ngroups; ++i )
+    {
+      __m256d ta = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(data+8*i),   dref), dfactor), dhalf);
+      __m256d tb = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(data+8*i+4), dref), dfactor), dhalf);
+      /* truncation, the integer is in the mantissa of 2^52 + t */
+      ta = _mm256_add_pd(_mm256_round_pd(ta, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), dmagic);
+      tb = _mm256_add_pd(_mm256_round_pd(tb, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), dmagic);
+      _mm256_store_si256((__m256i *) ival,     _mm256_and_si256(_mm256_castpd_si256(ta), mask));
+      _mm256_store_si256((__m256i *) (ival+4), _mm256_and_si256(_mm256_castpd_si256(tb), mask));
+
+      grib_pack_group(ival, numBits, &acc, &nacc, &out);
+    }
+
+  grib_pack_flush(acc, nacc, &out);
+
+  return (ngroups*8);
+}
+
+__attribute__ ((target ("avx512f,avx512bw,avx512dq")))
+static
+size_t avx512_encode_array_double(int numBits, size_t datasize, unsigned char *restrict lGrib,
+				  const double *restrict data, double zref, double factor)
+{
+  long long ival[8] __attribute__ ((aligned (64)));
+  size_t i, ngroups = datasize/8;
+  uint64_t acc = 0;
+  int nacc = 0;
+  unsigned char *out = lGrib;
+  const __m512d dref    = _mm512_set1_pd(zref);
+  const __m512d dfactor = _mm512_set1_pd(factor);
+  const __m512d dhalf   = _mm512_set1_pd(0.5);
+  const __m512i mask    = _mm512_set1_epi64((long long) ((1ULL << numBits) - 1));
+
+  for ( i = 0; i < ngroups; ++i )
+    {
+      __m512d t = _mm512_sub_round_pd(_mm512_loadu_pd(data+8*i), dref, _MM_FROUND_CUR_DIRECTION);
+      t = _mm512_mul_round_pd(t, dfactor, _MM_FROUND_CUR_DIRECTION);
+      t = _mm512_add_round_pd(t, dhalf, _MM_FROUND_CUR_DIRECTION);
+      __m512i v = _mm512_cvttpd_epu64(t);
+      _mm512_store_si512((void *) ival, _mm512_and_si512(v, mask));
+
+      grib_pack_group(ival, numBits, &acc, &nacc, &out);
+    }
+
+  grib_pack_flush(acc, nacc, &out);
+
+  return (ngroups*8);
+}
+
+static
+size_t grib_encode_array_simd(int numBits, size_t datasize, unsigned char *restrict lGrib,
+			      const double *restrict data, double zref, double factor, size_t *gz)
+{
+  size_t nvals = 0;
+
+  int simd_level = grib_simd_get_level();
+
+  if ( numBits < 1 || numBits > 32 ) return (0);
+
+  if ( simd_level == GRIB_SIMD_AVX512 )
+    nvals = avx512_encode_array_double(numBits, datasize, lGrib + *gz, data, zref, factor);
+  else if ( simd_level == GRIB_SIMD_AVX2 )
+    nvals = avx2_encode_array_double(numBits, datasize, lGrib + *gz, data, zref, factor);
+
+  *gz += nvals/8*(size_t)numBits;
+
+  return (nvals);
+}
+
+#endif /* GRIB_SIMD_DISPATCH */
+
 
 void confp3(double pval, int *kexp, int *kmant, int kbits, int kround)
 {
@@ -5478,9 +5792,9 @@ void ref2ibm(double *pref, int kbits)
 
   */
 
-  static int itrnd;
-  static int kexp, kmant;
-  static double ztemp, zdumm;
+  int itrnd;
+  int kexp, kmant;
+  double ztemp, zdumm;
   extern int CGRIBEX_Debug;
 
   /* ----------------------------------------------------------------- */
@@ -9278,6 +9592,23 @@ int decodePDS(unsigned char *pds, int *isec0, int *isec1)
   return (pdsLen);
 }
 
+/*
+  Decodes section 0 and 1 of a GRIB1 message, the buffer needs only these sections.
+  Returns the length of section 0 and 1.
+*/
+int gribExPDS(unsigned char *kgrib, int *isec0, int *isec1, int *iret)
+{
+  int isLen, pdsLen;
+
+  *iret = 0;
+  isLen = decodeIS(kgrib, isec0, iret);
+  if ( *iret != 0 ) return (0);
+
+  pdsLen = decodePDS(kgrib + isLen, isec0, isec1);
+
+  return (isLen + pdsLen);
+}
+
 
 void gribPrintSec2_double(int *isec0, int *isec2, double *fsec2) {gribPrintSec2DP(isec0, isec2, fsec2);}
 void gribPrintSec3_double(int *isec0, int *isec3, double *fsec3) {gribPrintSec3DP(isec0, isec3, fsec3);}
@@ -9450,6 +9781,16 @@ void TEMPLATE(decode_array,T)(const unsigned char *restrict igrib, long jlend, i
   if ( lgrib ) free(lgrib);
 
 #else
+#if defined (GRIB_SIMD_DISPATCH)
+  if ( numBits > 0 && numBits <= 32 )
+    {
+      long nvals = grib_decode_array_simd(igrib, jlend, numBits, fmin, zscale, fpdata);
+      igrib  += nvals/8*numBits;
+      fpdata += nvals;
+      jlend  -= nvals;
+    }
+#endif
+
   if ( numBits ==  0 )
     {
       for ( i = 0; i < jlend; i++ )
@@ -12113,6 +12454,16 @@ void TEMPLATE(encode_array,T)(int numBits, size_t packStart, size_t datasize,
   data += packStart;
   datasize -= packStart;
 
+#if defined (GRIB_SIMD_DISPATCH)
+  /* the byte aligned loops below are faster than the bit packer */
+  if ( numBits > 0 && numBits < 32 && numBits%8 != 0 )
+    {
+      size_t nvals = grib_encode_array_simd(numBits, datasize, lGrib, (const double *) data, zref, factor, &z);
+      data     += nvals;
+      datasize -= nvals;
+    }
+#endif
+
   if      ( numBits ==  8 )
     {
 #ifdef _GET_IBM_COUNTER 
@@ -14204,6 +14555,90 @@ cgribexLibraryVersion(void)
   return (grb_libvers);
 }
 
+#if defined (TEST_UNPACK) && defined (GRIB_SIMD_DISPATCH)
+/*
+  Benchmark and check of the SIMD kernels against the scalar code:
+
+  gcc -O2 -DHAVE_CONFIG_H -DTEST_UNPACK -I. cgribexlib.c .libs/libcdi.a -lm
+*/
+#include <stdio.h>
+#include <sys/time.h>
+
+static
+double unpack_dtime(void)
+{
+  struct timeval mytime;
+  gettimeofday(&mytime, NULL);
+  return ((double) mytime.tv_sec + (double) mytime.tv_usec*1.0e-6);
+}
+
+#define NRUN 100
+
+int main(void)
+{
+  static const int nbits[] = {1, 3, 7, 8, 11, 12, 13, 16, 17, 18, 20, 23, 24, 25, 27, 31, 32};
+  size_t datasize = 1000003;
+  size_t i, z0, z1;
+  int ib, irun, level, simd_level = grib_simd_get_level();
+  double zref = -2.5, factor, zscale, t0, tenc[2], tdec[2];
+  double *data, *fdata0, *fdata1;
+  unsigned char *lgrib0, *lgrib1;
+
+  data   = (double*) malloc(datasize*sizeof(double));
+  fdata0 = (double*) malloc(datasize*sizeof(double));
+  fdata1 = (double*) malloc(datasize*sizeof(double));
+  lgrib0 = (unsigned char*) malloc(4*datasize + 16);
+  lgrib1 = (unsigned char*) malloc(4*datasize + 16);
+
+  srand(42);
+  for ( i = 0; i < datasize; ++i ) data[i] = zref + 100.0*rand()/RAND_MAX;
+
+  printf("SIMD level: %d\n", simd_level);
+  printf("nbits  encode scalar     simd    decode scalar     simd\n");
+
+  for ( ib = 0; ib < (int) (sizeof(nbits)/sizeof(nbits[0])); ++ib )
+    {
+      factor = ((double) ((1ULL << nbits[ib]) - 1))/100.0;
+      zscale = 1.0/factor;
+
+      for ( level = 0; level < 2; ++level )
+	{
+	  double *fdata = level ? fdata1 : fdata0;
+	  unsigned char *lgrib = level ? lgrib1 : lgrib0;
+	  size_t *pz = level ? &z1 : &z0;
+
+	  grib_simd_level = level ? simd_level : GRIB_SIMD_NONE;
+
+	  t0 = unpack_dtime();
+	  for ( irun = 0; irun < NRUN; ++irun )
+	    {
+	      *pz = 0;
+	      encode_array_double(nbits[ib], 0, datasize, lgrib, data, zref, factor, pz);
+	    }
+	  tenc[level] = unpack_dtime() - t0;
+
+	  t0 = unpack_dtime();
+	  for ( irun = 0; irun < NRUN; ++irun )
+	    decode_array_double(lgrib0, (long) datasize, nbits[ib], zref, zscale, fdata);
+	  tdec[level] = unpack_dtime() - t0;
+	}
+
+      printf("%5d  %14.3fs %8.3fs %14.3fs %8.3fs", nbits[ib], tenc[0], tenc[1], tdec[0], tdec[1]);
+      if ( z0 != z1 || memcmp(lgrib0, lgrib1, z0) != 0 ) printf("  encode differs!");
+      if ( memcmp(fdata0, fdata1, datasize*sizeof(double)) != 0 ) printf("  decode differs!");
+      printf("\n");
+    }
+
+  free(data);
+  free(fdata0);
+  free(fdata1);
+  free(lgrib0);
+  free(lgrib1);
+
+  return (0);
+}
+#endif /* TEST_UNPACK */
+
 #if __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ > 5)
 #pragma GCC diagnostic pop
 #endif
@@ -14,6 +14,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>  // gettimeofday()
+#if defined (__linux__)
+#  include <sys/sendfile.h>
+#  include <sys/syscall.h>
+#endif
 
 #include "dmemory.h"
 #include "error.h"
@@ -140,6 +144,7 @@ static int    FileBufferTypeEnv =  0;
 static int    FileTypeRead  = FILE_TYPE_OPEN;
 static int    FileTypeWrite = FILE_TYPE_FOPEN;
 static int    FileFlagWrite = 0;
+static int    FileCopyKernel = TRUE;  /* copy records with copy_file_range/sendfile */
 
 static int    FILE_Debug = 0;   /* If set to 1, debugging */
 
@@ -812,6 +817,9 @@ void file_initialize(void)
 #endif
     }
 
+  value = file_getenv("FILE_COPY");
+  if ( value == 0 ) FileCopyKernel = FALSE;
+
   value = file_getenv("FILE_BUFTYPE");
 #if ! defined (HAVE_MMAP)
   if ( value == FILE_BUFTYPE_MMAP )
@@ -1472,6 +1480,86 @@ size_t fileWrite(int fileID, const void *restrict ptr, size_t size)
 
   return (nwrite);
 }
+
+/*
+  Appends size bytes from offset of fileID1 to fileID2 without a user space copy of the data.
+  The kernel copy (copy_file_range or sendfile) is used if available, the rest is copied
+  through the file buffers. fileID1 is positioned behind the copied bytes.
+*/
+size_t fileCopy(int fileID2, int fileID1, off_t offset, size_t size)
+{
+  size_t ncopy = 0;
+  bfile_t *fileptr1, *fileptr2;
+
+  fileptr1 = file_to_pointer(fileID1);
+  fileptr2 = file_to_pointer(fileID2);
+
+  if ( fileptr1 == NULL || fileptr2 == NULL ) return (0);
+
+#if defined (__linux__)
+  if ( FileCopyKernel && fileptr2->mode == 'w' )
+    {
+      double t_begin = 0.0;
+      off_t inpos = offset;
+      ssize_t n;
+      int fd1, fd2;
+
+      if ( FileInfo ) t_begin = file_time();
+
+      fd1 = (fileptr1->type == FILE_TYPE_OPEN) ? fileptr1->fd : fileno(fileptr1->fp);
+      if ( fileptr2->type == FILE_TYPE_FOPEN )
+        {
+          fflush(fileptr2->fp);
+          fd2 = fileno(fileptr2->fp);
+        }
+      else
+        fd2 = fileptr2->fd;
+
+#if defined (SYS_copy_file_range)
+      while ( ncopy < size )
+        {
+          n = syscall(SYS_copy_file_range, fd1, &inpos, fd2, NULL, size - ncopy, 0);
+          if ( n <= 0 ) break;
+          ncopy += (size_t)n;
+        }
+#endif
+      while ( ncopy < size )
+        {
+          n = sendfile(fd2, fd1, &inpos, size - ncopy);
+          if ( n <= 0 ) break;
+          ncopy += (size_t)n;
+        }
+
+      /* resync the stdio stream with the file offset */
+      if ( ncopy > 0 && fileptr2->type == FILE_TYPE_FOPEN )
+        fseek(fileptr2->fp, lseek(fd2, 0, SEEK_CUR), SEEK_SET);
+
+      if ( FileInfo ) fileptr2->time_in_sec += file_time() - t_begin;
+
+      fileptr1->byteTrans += (off_t)ncopy;
+      fileptr2->position  += (off_t)ncopy;
+      fileptr2->byteTrans += (off_t)ncopy;
+      fileptr2->access++;
+    }
+#endif
+
+  fileSetPos(fileID1, offset + (off_t)ncopy, SEEK_SET);
+
+  if ( ncopy < size )
+    {
+      size_t nread, nrest = size - ncopy;
+      void *buffer = malloc(nrest);
+
+      nread = fileRead(fileID1, buffer, nrest);
+      ncopy += fileWrite(fileID2, buffer, nread);
+
+      free(buffer);
+    }
+
+  if ( FILE_Debug ) Message("size %ld  ncopy %ld", size, ncopy);
+
+  return (ncopy);
+}
 /*
  * Local Variables:
  * c-file-style: "Java"
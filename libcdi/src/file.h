@@ -47,6 +47,7 @@ int    filePtrGetc(void *fileptr);
 size_t filePtrRead(void *fileptr, void *restrict ptr, size_t size);
 size_t fileRead(int fileID, void *restrict ptr, size_t size);
 size_t fileWrite(int fileID, const void *restrict ptr, size_t size);
+size_t fileCopy(int fileID2, int fileID1, off_t offset, size_t size);
 
 #endif  /* _FILE_H */
 /*
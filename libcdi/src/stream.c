@@ -870,6 +870,10 @@ void streamDefaultValue ( stream_t * streamptr )
 
   streamptr->gribContainers    = NULL;
   streamptr->vlistIDorig       = CDI_UNDEFID;
+  streamptr->gribIndex         = NULL;
+  streamptr->gribReadAhead     = NULL;
+  streamptr->cdfSlabCache      = NULL;
+  streamptr->gribWriteBehind   = NULL;
 }
 
 
@@ -907,7 +911,10 @@ cdiStreamCloseDefaultDelegate(stream_t *streamptr, int recordBufIsToBeDeleted)
       case FILETYPE_GRB:
       case FILETYPE_GRB2:
         {
+          grbReadAheadClose(streamptr);
+          grbWriteBehindClose(streamptr);
           gribClose(fileID);
+          grbIndexClose(streamptr);
           if (recordBufIsToBeDeleted)
             gribContainersDelete(streamptr);
           break;
@@ -946,6 +953,7 @@ cdiStreamCloseDefaultDelegate(stream_t *streamptr, int recordBufIsToBeDeleted)
       case FILETYPE_NC4:
       case FILETYPE_NC4C:
         {
+          cdfSlabCacheClose(streamptr);
           cdfClose(fileID);
           break;
         }
@@ -1008,6 +1016,8 @@ void streamClose(int streamID)
 	free(streamptr->vars[index].level);
       if ( streamptr->vars[index].lindex )
 	free(streamptr->vars[index].lindex);
+      if ( streamptr->vars[index].lskip )
+	free(streamptr->vars[index].lskip);
     }
   free(streamptr->vars);
 
@@ -1086,6 +1096,9 @@ void cdiStreamSync_(stream_t *streamptr)
 #endif
 	    default:
 	      {
+#if  defined  (HAVE_LIBGRIB)
+		if ( filetype == FILETYPE_GRB || filetype == FILETYPE_GRB2 ) grbWriteBehindFlush(streamptr);
+#endif
 		fileFlush(fileID);
 		break;
 	      }
@@ -4113,7 +4113,8 @@ int cdfGetSkipDim(int fileId, int ncvarid, int (*dimIds)[3])
 
 
 static
-void cdfGetSliceSlapDescription(stream_t *streamptr, int varId, int levelId, bool *outSwapXY, size_t (*start)[4], size_t (*count)[4])
+void cdfGetSliceSlapDescription(stream_t *streamptr, int varId, int levelId, bool *outSwapXY, size_t (*start)[4], size_t (*count)[4],
+                                int *outNdims, int *outLevelDim)
 {
   int tsID = streamptr->curTsID;
   if ( CDI_Debug ) Message("tsID = %d", tsID);
@@ -4139,6 +4140,7 @@ void cdfGetSliceSlapDescription(stream_t *streamptr, int varId, int levelId, boo
   *outSwapXY = (dimorder[2] == 2 || dimorder[0] == 1) && dimIds[0] != UNDEFID && dimIds[1] != UNDEFID ;
 
   int ndims = 0;
+  *outLevelDim = -1;
 
 #define addDimension(startIndex, extent) do {   \
       (*start)[ndims] = startIndex; \
@@ -4164,6 +4166,7 @@ void cdfGetSliceSlapDescription(stream_t *streamptr, int varId, int levelId, boo
             break;
 
           case 3:
+            *outLevelDim = ndims;
             addDimension((size_t)levelId, 1);
             break;
 
@@ -4188,6 +4191,8 @@ void cdfGetSliceSlapDescription(stream_t *streamptr, int varId, int levelId, boo
 
   if ( nvdims != ndims )
     Error("Internal error, variable %s has an unsupported array structure!", vlistInqVarNamePtr(vlistId, varId));
+
+  *outNdims = ndims;
 }
 
 void cdfReadVarDP(stream_t *streamptr, int varID, double *data, int *nmiss)
@@ -4252,6 +4257,253 @@ void cdfReadVarSP(stream_t *streamptr, int varID, float *data, int *nmiss)
   *nmiss = (int)nmiss_;
 }
 
+/*
+  Slab cache of the NetCDF input (CDI_NC_SLAB_CACHE=<MB>, 0 switches it off)
+
+  streamReadRecord reads one level of a variable. On chunked NetCDF4 files each chunk that
+  contains several levels would be read and decompressed once per level. Instead, the levels
+  of a chunk are read with one call and the other levels are taken from the cache. Variables
+  that aren't chunked (e.g. all NetCDF3 files) are read level by level. The memory limit is
+  shared by all open streams; if it is reached, the least recently used slabs of the stream
+  are removed. Slabs of past timesteps are removed when the timestep advances.
+*/
+typedef struct {
+  int            varID;
+  int            tsID;         // -1 for constant variables
+  int            memtype;
+  int            lev1, nlevs;  // levels of the slab
+  size_t         nbytes;
+  unsigned long  lastuse;
+  void          *data;
+}
+cdfslab_t;
+
+typedef struct {
+  int            tsID;         // timestep of the cached slabs
+  unsigned long  usecount;
+  int            nslabs, nalloc;
+  cdfslab_t     *slabs;
+  int           *slabLevels;   // number of levels read at once for each variable, 0: not yet known
+}
+cdfslabcache_t;
+
+/* bytes held by the slab caches of all streams */
+static size_t cdfSlabBytes = 0;
+
+#if  defined  (HAVE_LIBPTHREAD)
+#include <pthread.h>
+
+static pthread_mutex_t cdfSlabMutex = PTHREAD_MUTEX_INITIALIZER;
+
+#  define SLAB_LOCK()    pthread_mutex_lock(&cdfSlabMutex)
+#  define SLAB_UNLOCK()  pthread_mutex_unlock(&cdfSlabMutex)
+#else
+#  define SLAB_LOCK()
+#  define SLAB_UNLOCK()
+#endif
+
+static
+bool cdfSlabReserve(size_t nbytes)
+{
+  size_t maxbytes = (size_t)cdiNcSlabCache*1024*1024;
+  bool reserved = false;
+
+  SLAB_LOCK();
+  if ( cdfSlabBytes + nbytes <= maxbytes )
+    {
+      cdfSlabBytes += nbytes;
+      reserved = true;
+    }
+  SLAB_UNLOCK();
+
+  return reserved;
+}
+
+static
+void cdfSlabFree(cdfslabcache_t *cache, int islab)
+{
+  SLAB_LOCK();
+  cdfSlabBytes -= cache->slabs[islab].nbytes;
+  SLAB_UNLOCK();
+
+  free(cache->slabs[islab].data);
+  cache->slabs[islab] = cache->slabs[--cache->nslabs];
+}
+
+
+void cdfSlabCacheClose(stream_t *streamptr)
+{
+  cdfslabcache_t *cache = (cdfslabcache_t *) streamptr->cdfSlabCache;
+
+  if ( cache == NULL ) return;
+
+  while ( cache->nslabs > 0 ) cdfSlabFree(cache, cache->nslabs - 1);
+  if ( cache->slabs ) free(cache->slabs);
+  free(cache->slabLevels);
+  free(cache);
+
+  streamptr->cdfSlabCache = NULL;
+}
+
+static
+int cdfSlabLevels(stream_t *streamptr, cdfslabcache_t *cache, int varID, int levelDim, int nlevs)
+{
+  if ( cache->slabLevels[varID] == 0 )
+    {
+      int slabLevels = 1;
+#if  defined  (HAVE_NETCDF4)
+      int fileID  = streamptr->fileID;
+      int ncvarid = streamptr->vars[varID].ncvarid;
+      int nvdims, storage;
+      cdf_inq_varndims(fileID, ncvarid, &nvdims);
+      size_t chunks[nvdims];
+      if ( nc_inq_var_chunking(fileID, ncvarid, &storage, chunks) == NC_NOERR && storage == NC_CHUNKED )
+        {
+          slabLevels = (chunks[levelDim] < (size_t)nlevs) ? (int)chunks[levelDim] : nlevs;
+
+          if ( cdiVerbose )
+            {
+              char buf[256];
+              size_t len = 0;
+              buf[0] = 0;
+              for ( int i = 0; i < nvdims && len < sizeof(buf) - 24; ++i )
+                len += (size_t)sprintf(buf+len, i ? "x%lu" : "%lu", (unsigned long)chunks[i]);
+              Message("%s: chunks %s, %d of %d levels per read", vlistInqVarNamePtr(streamptr->vlistID, varID),
+                      buf, slabLevels, nlevs);
+            }
+        }
+      else
+#endif
+      if ( cdiVerbose )
+        Message("%s: not chunked, levels are read one by one", vlistInqVarNamePtr(streamptr->vlistID, varID));
+
+      cache->slabLevels[varID] = slabLevels;
+    }
+
+  return cache->slabLevels[varID];
+}
+
+/*
+  Copies the level levelID of a variable from the slab cache to data (memtype); the slab with
+  this level is read if it's not cached. start and count describe the slice of the level,
+  levelDim is the index of the level dimension. Returns false if the slice must be read directly.
+*/
+static
+bool cdfSlabRead(stream_t *streamptr, int varID, int levelID, int ndims, int levelDim,
+                 const size_t start[4], const size_t count[4], int memtype, void *data)
+{
+  if ( cdiNcSlabCache <= 0 || levelDim < 0 ) return false;
+
+  int vlistID = streamptr->vlistID;
+  int nlevs = zaxisInqSize(vlistInqVarZaxis(vlistID, varID));
+  if ( nlevs < 2 ) return false;
+
+  cdfslabcache_t *cache = (cdfslabcache_t *) streamptr->cdfSlabCache;
+  if ( cache == NULL )
+    {
+      cache = (cdfslabcache_t *) xmalloc(sizeof(cdfslabcache_t));
+      cache->tsID       = streamptr->curTsID;
+      cache->usecount   = 0;
+      cache->nslabs     = 0;
+      cache->nalloc     = 0;
+      cache->slabs      = NULL;
+      cache->slabLevels = (int *) xcalloc((size_t)vlistNvars(vlistID), sizeof(int));
+      streamptr->cdfSlabCache = cache;
+    }
+
+  int slabLevels = cdfSlabLevels(streamptr, cache, varID, levelDim, nlevs);
+  if ( slabLevels < 2 ) return false;
+
+  if ( cache->tsID != streamptr->curTsID )
+    {
+      for ( int i = cache->nslabs - 1; i >= 0; --i )
+        if ( cache->slabs[i].tsID != -1 && cache->slabs[i].tsID != streamptr->curTsID )
+          cdfSlabFree(cache, i);
+
+      cache->tsID = streamptr->curTsID;
+    }
+
+  /* values before and after the level dimension */
+  size_t outer = 1, inner = 1;
+  for ( int i = 0; i < levelDim; ++i ) outer *= count[i];
+  for ( int i = levelDim+1; i < ndims; ++i ) inner *= count[i];
+
+  size_t elemsize = (memtype == MEMTYPE_FLOAT) ? sizeof(float) : sizeof(double);
+  int lev1 = (levelID/slabLevels)*slabLevels;
+  int nlev = (nlevs - lev1 < slabLevels) ? nlevs - lev1 : slabLevels;
+  size_t nbytes = outer*(size_t)nlev*inner*elemsize;
+  if ( nbytes > (size_t)cdiNcSlabCache*1024*1024 ) return false;
+
+  int tsID = (vlistInqVarTsteptype(vlistID, varID) == TSTEP_CONSTANT) ? -1 : streamptr->curTsID;
+
+  cdfslab_t *slab = NULL;
+  for ( int i = 0; i < cache->nslabs; ++i )
+    if ( cache->slabs[i].varID == varID && cache->slabs[i].tsID == tsID &&
+         cache->slabs[i].memtype == memtype && cache->slabs[i].lev1 == lev1 )
+      {
+        slab = &cache->slabs[i];
+        break;
+      }
+
+  if ( slab == NULL )
+    {
+      while ( !cdfSlabReserve(nbytes) )
+        {
+          /* the other streams hold the rest of the memory: read directly */
+          if ( cache->nslabs == 0 ) return false;
+
+          int ilru = 0;
+          for ( int i = 1; i < cache->nslabs; ++i )
+            if ( cache->slabs[i].lastuse < cache->slabs[ilru].lastuse ) ilru = i;
+
+          cdfSlabFree(cache, ilru);
+        }
+
+      if ( cache->nslabs == cache->nalloc )
+        {
+          cache->nalloc = cache->nalloc ? 2*cache->nalloc : 16;
+          cache->slabs = (cdfslab_t *) xrealloc(cache->slabs, (size_t)cache->nalloc*sizeof(cdfslab_t));
+        }
+
+      slab = &cache->slabs[cache->nslabs++];
+      slab->varID   = varID;
+      slab->tsID    = tsID;
+      slab->memtype = memtype;
+      slab->lev1    = lev1;
+      slab->nlevs   = nlev;
+      slab->nbytes  = nbytes;
+      slab->data    = xmalloc(nbytes);
+
+      size_t slabstart[4], slabcount[4];
+      for ( int i = 0; i < ndims; ++i )
+        {
+          slabstart[i] = start[i];
+          slabcount[i] = count[i];
+        }
+      slabstart[levelDim] = (size_t)lev1;
+      slabcount[levelDim] = (size_t)nlev;
+
+      int fileID  = streamptr->fileID;
+      int ncvarid = streamptr->vars[varID].ncvarid;
+      if ( memtype == MEMTYPE_FLOAT )
+        cdf_get_vara_float(fileID, ncvarid, slabstart, slabcount, (float *)slab->data);
+      else
+        cdf_get_vara_double(fileID, ncvarid, slabstart, slabcount, (double *)slab->data);
+    }
+
+  slab->lastuse = ++cache->usecount;
+
+  const unsigned char *src = (const unsigned char *) slab->data;
+  unsigned char *dst = (unsigned char *) data;
+  size_t k = (size_t)(levelID - slab->lev1);
+  size_t nslab = (size_t)slab->nlevs;
+  for ( size_t o = 0; o < outer; ++o )
+    memcpy(dst + o*inner*elemsize, src + (o*nslab + k)*inner*elemsize, inner*elemsize);
+
+  return true;
+}
+
+
 void cdfReadVarSliceDP(stream_t *streamptr, int varID, int levelID, double *data, int *nmiss)
 {
   size_t start[4];
@@ -4264,7 +4516,8 @@ void cdfReadVarSliceDP(stream_t *streamptr, int varID, int levelID, double *data
   int fileID = streamptr->fileID;
 
   bool swapxy;
-  cdfGetSliceSlapDescription(streamptr, varID, levelID, &swapxy, &start, &count);
+  int ndims, levelDim;
+  cdfGetSliceSlapDescription(streamptr, varID, levelID, &swapxy, &start, &count, &ndims, &levelDim);
 
   int ncvarid = streamptr->vars[varID].ncvarid;
   int gridId = vlistInqVarGrid(vlistID, varID);
@@ -4275,7 +4528,8 @@ void cdfReadVarSliceDP(stream_t *streamptr, int varID, int levelID, double *data
   if ( vlistInqVarDatatype(vlistID, varID) == DATATYPE_FLT32 )
     {
       float *data_fp = (float *)xmalloc(gridsize*sizeof(*data_fp));
-      cdf_get_vara_float(fileID, ncvarid, start, count, data_fp);
+      if ( !cdfSlabRead(streamptr, varID, levelID, ndims, levelDim, start, count, MEMTYPE_FLOAT, data_fp) )
+        cdf_get_vara_float(fileID, ncvarid, start, count, data_fp);
       for ( size_t i = 0; i < gridsize; i++ )
         data[i] = (double) data_fp[i];
       free(data_fp);
@@ -4292,7 +4546,8 @@ void cdfReadVarSliceDP(stream_t *streamptr, int varID, int levelID, double *data
     }
   else
     {
-      cdf_get_vara_double(fileID, ncvarid, start, count, data);
+      if ( !cdfSlabRead(streamptr, varID, levelID, ndims, levelDim, start, count, MEMTYPE_DOUBLE, data) )
+        cdf_get_vara_double(fileID, ncvarid, start, count, data);
     }
 
   if ( swapxy ) transpose2dArrayDP(ysize, xsize, data);
@@ -4322,7 +4577,8 @@ void cdfReadVarSliceSP(stream_t *streamptr, int varID, int levelID, float *data,
   int fileID = streamptr->fileID;
 
   bool swapxy;
-  cdfGetSliceSlapDescription(streamptr, varID, levelID, &swapxy, &start, &count);
+  int ndims, levelDim;
+  cdfGetSliceSlapDescription(streamptr, varID, levelID, &swapxy, &start, &count, &ndims, &levelDim);
 
   int ncvarid = streamptr->vars[varID].ncvarid;
   int gridId = vlistInqVarGrid(vlistID, varID);
@@ -4333,7 +4589,8 @@ void cdfReadVarSliceSP(stream_t *streamptr, int varID, int levelID, float *data,
   if ( vlistInqVarDatatype(vlistID, varID) == DATATYPE_FLT64 )
     {
       double *data_dp = (double *)xmalloc(gridsize*sizeof(*data_dp));
-      cdf_get_vara_double(fileID, ncvarid, start, count, data_dp);
+      if ( !cdfSlabRead(streamptr, varID, levelID, ndims, levelDim, start, count, MEMTYPE_DOUBLE, data_dp) )
+        cdf_get_vara_double(fileID, ncvarid, start, count, data_dp);
       for ( size_t i = 0; i < gridsize; i++ )
         data[i] = (float) data_dp[i];
       free(data_dp);
@@ -4350,7 +4607,8 @@ void cdfReadVarSliceSP(stream_t *streamptr, int varID, int levelID, float *data,
     }
   else
     {
-      cdf_get_vara_float(fileID, ncvarid, start, count, data);
+      if ( !cdfSlabRead(streamptr, varID, levelID, ndims, levelDim, start, count, MEMTYPE_FLOAT, data) )
+        cdf_get_vara_float(fileID, ncvarid, start, count, data);
     }
 
   if ( swapxy ) transpose2dArraySP(ysize, xsize, data);
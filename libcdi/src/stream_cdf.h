@@ -24,6 +24,7 @@ void   cdf_write_var(stream_t *streamptr, int varID, int memtype, const void *da
 
 void   cdfReadVarSliceDP(stream_t *streamptr, int varID, int levelID, double *data, int *nmiss);
 void   cdfReadVarSliceSP(stream_t *streamptr, int varID, int levelID, float *data, int *nmiss);
+void   cdfSlabCacheClose(stream_t *streamptr);
 void   cdf_write_var_slice(stream_t *streamptr, int varID, int levelID, int memtype, const void *data, int nmiss);
 
 void   cdf_write_var_chunk(stream_t *streamptr, int varID, int memtype,
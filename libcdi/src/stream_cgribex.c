@@ -13,6 +13,7 @@
 #include "datetime.h"
 #include "vlist.h"
 #include "stream_grb.h"
+#include "stream_cgribex.h"
 
 #if  defined  (HAVE_LIBCGRIBEX)
 #  include "cgribex.h"
@@ -1055,6 +1056,38 @@ int cgribexScanTimestep2(stream_t * streamptr)
 
 
 #if  defined  (HAVE_LIBCGRIBEX)
+/*
+  Reads only section 0 and 1 of a GRIB1 record at the current file position and
+  decodes isec0 and isec1. Returns 0 on success, otherwise the record is read as usual.
+*/
+static
+int cgribexReadHeader(int fileID, unsigned char *gribbuffer, long recsize, int *isec0, int *isec1)
+{
+  enum { IS_LEN = 8 };
+  int iret = 0;
+  long pdsLen;
+
+  if ( recsize < IS_LEN + 3 ) return (1);
+  if ( fileRead(fileID, gribbuffer, IS_LEN + 3) != IS_LEN + 3 ) return (1);
+  if ( gribbuffer[7] != 1 ) return (1);
+
+  pdsLen = (gribbuffer[8] << 16) + (gribbuffer[9] << 8) + gribbuffer[10];
+  if ( pdsLen < 28 || IS_LEN + pdsLen > recsize ) return (1);
+
+  if ( fileRead(fileID, gribbuffer + IS_LEN + 3, (size_t)pdsLen - 3) != (size_t)pdsLen - 3 ) return (1);
+
+  memset(isec1, 0, 256*sizeof(int));
+
+  gribExPDS(gribbuffer, isec0, isec1, &iret);
+
+  return (iret != 0);
+}
+
+/*
+  The timesteps after the second are identified by section 1, the data of the
+  records is not read. Not for SZIP compressed variables, the record buffer
+  needs the size of the decompressed records.
+*/
 int cgribexScanTimestep(stream_t * streamptr)
 {
   int rstatus = 0;
@@ -1113,6 +1146,10 @@ int cgribexScanTimestep(stream_t * streamptr)
 
       fileSetPos(fileID, streamptr->tsteps[tsID].position, SEEK_SET);
 
+      int lheader = TRUE;
+      for ( int varID = 0; varID < vlistNvars(streamptr->vlistID); ++varID )
+        if ( vlistInqVarCompType(streamptr->vlistID, varID) == COMPRESS_SZIP ) lheader = FALSE;
+
       nrecs_scanned = streamptr->tsteps[0].nallrecs + streamptr->tsteps[1].nrecs*(tsID-1);
       rindex = 0;
       while ( TRUE )
@@ -1134,27 +1171,36 @@ int cgribexScanTimestep(stream_t * streamptr)
 
 	  if ( rindex >= nrecs ) break;
 
-	  readsize = (size_t)recsize;
-	  rstatus = gribRead(fileID, gribbuffer, &readsize);
-	  if ( rstatus )
+	  if ( lheader && cgribexReadHeader(fileID, gribbuffer, recsize, isec0, isec1) == 0 )
 	    {
-	      Warning("Inconsistent timestep %d (GRIB record %d/%d)!", tsID+1, rindex+1,
-                      streamptr->tsteps[tsID].recordSize);
-	      break;
+	      fileSetPos(fileID, recpos + (off_t)recsize, SEEK_SET);
 	    }
-
-	  if ( gribGetZip(recsize, gribbuffer, &unzipsize) > 0 )
+	  else
 	    {
-	      unzipsize += 100; /* need 0 to 1 bytes for rounding of bds */
-	      if ( buffersize < (size_t)unzipsize )
+	      fileSetPos(fileID, recpos, SEEK_SET);
+
+	      readsize = (size_t)recsize;
+	      rstatus = gribRead(fileID, gribbuffer, &readsize);
+	      if ( rstatus )
 		{
-		  buffersize = (size_t)unzipsize;
-		  gribbuffer = (unsigned char *) realloc(gribbuffer, buffersize);
+		  Warning("Inconsistent timestep %d (GRIB record %d/%d)!", tsID+1, rindex+1,
+			  streamptr->tsteps[tsID].recordSize);
+		  break;
 		}
-	    }
 
-	  cgribexDecodeHeader(isec0, isec1, isec2, fsec2, isec3, fsec3, isec4, fsec4,
-			      (int *) gribbuffer, (int)recsize, &lmv, &iret);
+	      if ( gribGetZip(recsize, gribbuffer, &unzipsize) > 0 )
+		{
+		  unzipsize += 100; /* need 0 to 1 bytes for rounding of bds */
+		  if ( buffersize < (size_t)unzipsize )
+		    {
+		      buffersize = (size_t)unzipsize;
+		      gribbuffer = (unsigned char *) realloc(gribbuffer, buffersize);
+		    }
+		}
+
+	      cgribexDecodeHeader(isec0, isec1, isec2, fsec2, isec3, fsec3, isec4, fsec4,
+				  (int *) gribbuffer, (int)recsize, &lmv, &iret);
+	    }
 
           nrecs_scanned++;
 
@@ -2168,24 +2214,22 @@ void cgribexDefEnsembleVar(int *isec1, int vlistID, int varID)
 
 
 #if  defined  (HAVE_LIBCGRIBEX)
-size_t cgribexEncode(int memtype, int varID, int levelID, int vlistID, int gridID, int zaxisID,
-		     int vdate, int vtime, int tsteptype, int numavg,
-		     long datasize, const double *data, int nmiss, unsigned char *gribbuffer, size_t gribbuffersize)
+/*
+  Sets the GRIB sections of the record, the data are packed with cgribexEncodeData().
+  Only this part uses the CDI resources.
+*/
+void cgribexEncodeSec(cgribexsec_t *sec, int varID, int levelID, int vlistID, int gridID, int zaxisID,
+		      int vdate, int vtime, int tsteptype, int numavg, int nmiss)
 {
-  size_t nbytes = 0;
-  int gribsize;
-  int iret = 0, iword = 0;
-  int isec0[2], isec1[4096], isec2[4096], isec3[2], isec4[512];
-  float fsec2f[512], fsec3f[2];
-  double fsec2[512], fsec3[2];
+  int *isec0 = sec->isec0, *isec1 = sec->isec1, *isec2 = sec->isec2, *isec4 = sec->isec4;
+  double *fsec2 = sec->fsec2, *fsec3 = sec->fsec3;
   int datatype;
   int param;
 
   memset(isec1, 0, 256*sizeof(int));
   fsec2[0] = 0; fsec2[1] = 0;
-  fsec2f[0] = 0; fsec2f[1] = 0;
+  sec->fsec2f[0] = 0; sec->fsec2f[1] = 0;
 
-  gribsize = (int)(gribbuffersize / sizeof(int));
   param    = vlistInqVarParam(vlistID, varID);
 
   cgribexDefaultSec0(isec0);
@@ -2212,6 +2256,23 @@ size_t cgribexEncode(int memtype, int varID, int levelID, int vlistID, int gridI
       FSEC3_MissVal = vlistInqVarMissval(vlistID, varID);
       ISEC1_Sec2Or3Flag |= 64;
     }
+}
+
+/*
+  Packs the data with the sections of cgribexEncodeSec(), returns the size of the GRIB record.
+  The sections are changed by the encoding.
+*/
+size_t cgribexEncodeData(cgribexsec_t *sec, int memtype, long datasize, const double *data,
+			 unsigned char *gribbuffer, size_t gribbuffersize)
+{
+  size_t nbytes = 0;
+  int gribsize;
+  int iret = 0, iword = 0;
+  int *isec0 = sec->isec0, *isec1 = sec->isec1, *isec2 = sec->isec2, *isec3 = sec->isec3, *isec4 = sec->isec4;
+  double *fsec2 = sec->fsec2, *fsec3 = sec->fsec3;
+  float *fsec2f = sec->fsec2f, *fsec3f = sec->fsec3f;
+
+  gribsize = (int)(gribbuffersize / sizeof(int));
 
   if ( isec4[2] == 128 && isec4[3] == 64 )
     {
@@ -2240,6 +2301,18 @@ size_t cgribexEncode(int memtype, int varID, int levelID, int vlistID, int gridI
   nbytes = (size_t)iword * sizeof (int);
   return (nbytes);
 }
+
+
+size_t cgribexEncode(int memtype, int varID, int levelID, int vlistID, int gridID, int zaxisID,
+		     int vdate, int vtime, int tsteptype, int numavg,
+		     long datasize, const double *data, int nmiss, unsigned char *gribbuffer, size_t gribbuffersize)
+{
+  cgribexsec_t sec;
+
+  cgribexEncodeSec(&sec, varID, levelID, vlistID, gridID, zaxisID, vdate, vtime, tsteptype, numavg, nmiss);
+
+  return (cgribexEncodeData(&sec, memtype, datasize, data, gribbuffer, gribbuffersize));
+}
 #endif
 /*
  * Local Variables:
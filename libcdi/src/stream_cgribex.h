@@ -8,6 +8,19 @@ int cgribexScanTimestep(stream_t * streamptr);
 int cgribexDecode(unsigned char *gribbuffer, int gribsize, double *data, int gridsize,
 		  int unreduced, int *nmiss, double missval);
 
+/* GRIB sections of cgribexEncode */
+typedef struct {
+  int     isec0[2], isec1[4096], isec2[4096], isec3[2], isec4[512];
+  float   fsec2f[512], fsec3f[2];
+  double  fsec2[512], fsec3[2];
+}
+cgribexsec_t;
+
+void cgribexEncodeSec(cgribexsec_t *sec, int varID, int levelID, int vlistID, int gridID, int zaxisID,
+		      int vdate, int vtime, int tsteptype, int numavg, int nmiss);
+size_t cgribexEncodeData(cgribexsec_t *sec, int memtype, long datasize, const double *data,
+			 unsigned char *gribbuffer, size_t gribbuffersize);
+
 size_t cgribexEncode(int memtype, int varID, int levelID, int vlistID, int gridID, int zaxisID,
 		     int vdate, int vtime, int tsteptype, int numavg, 
 		     long datasize, const double *data, int nmiss, unsigned char *gribbuffer, size_t gribbuffersize);
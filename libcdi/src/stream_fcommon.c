@@ -17,18 +17,8 @@ void streamFCopyRecord(stream_t *streamptr2, stream_t *streamptr1,
   off_t recpos  = streamptr1->tsteps[tsID].records[recID].position;
   size_t recsize = streamptr1->tsteps[tsID].records[recID].size;
 
-  if (fileSetPos(fileID1, recpos, SEEK_SET) != 0)
-    Error("Cannot seek input file for %s record copy!", container_name);
-
-  char *buffer = xmalloc(recsize);
-
-  if (fileRead(fileID1, buffer, recsize) != recsize)
-    Error("Failed to read record from %s file for copying!", container_name);
-
-  if (fileWrite(fileID2, buffer, recsize) != recsize)
-    Error("Failed to write record to %s file when copying!", container_name);
-
-  free(buffer);
+  if (fileCopy(fileID2, fileID1, recpos, recsize) != recsize)
+    Error("Failed to copy record from %s file!", container_name);
 }
 
 /*
@@ -3,7 +3,14 @@
 #endif
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#if defined (HAVE_MMAP)
+#  include <sys/mman.h>
+#endif
 
 #include "dmemory.h"
 #include "cdi.h"
@@ -15,6 +22,10 @@
 #include "cgribex.h"  /* gribZip gribGetZip gribGinfo */
 #include "gribapi.h"
 #include "namespace.h"
+#include "thread_pool.h"
+
+extern int cdiInventoryMode;
+extern int cdiSkipRecords;
 
 
 int grib1ltypeToZaxisType(int grib_ltype)
@@ -272,8 +283,16 @@ int grbUnzipRecord(unsigned char *gribbuffer, size_t *gribsize)
 }
 
 
+static void grb_readahead_read(stream_t *streamptr, double *data, int *nmiss);
+
 void grbReadRecord(stream_t * streamptr, double *data, int *nmiss)
 {
+  if ( cdiGribReadAhead > 0 )
+    {
+      grb_readahead_read(streamptr, data, nmiss);
+      return;
+    }
+
   int filetype = streamptr->filetype;
 
   unsigned char *gribbuffer = (unsigned char *) streamptr->record->buffer;
@@ -304,6 +323,505 @@ void grbReadRecord(stream_t * streamptr, double *data, int *nmiss)
   grbDecode(filetype, gribbuffer, (int)recsize, data, gridsize, streamptr->unreduced, nmiss, missval, vlistID, varID);
 }
 
+/*
+  GRIB record index (CDI_GRIB_INDEX=1)
+
+  After a complete scan the record table of all timesteps is written to
+  <filename>.cdidx. On the next open only the first two timesteps are decoded,
+  they are needed for the variable definitions and to check the index. The
+  other timesteps are taken from the mapped index file when they are accessed.
+  The index is only used if the size, the modification time (with nanoseconds),
+  the inode and device of the GRIB file, the records of the first two timesteps
+  and the checksum of the header of the last record are unchanged.
+*/
+
+#define  GRBIDX_MAGIC    "CDIGRBIX"
+#define  GRBIDX_VERSION  2
+#define  GRBIDX_SUMSIZE  64      /* number of bytes of the last record in the checksum */
+
+typedef struct {
+  char     magic[8];
+  int32_t  version;
+  int32_t  filetype;
+  int32_t  inventory;    /* cdiInventoryMode of the scan */
+  int32_t  nallrecs;     /* number of records of the first timestep */
+  int32_t  nrecs;        /* number of non constant records */
+  int32_t  reserved;
+  int64_t  ntsteps;
+  int64_t  filesize;     /* size and modification time of the GRIB file */
+  int64_t  mtime;
+  int64_t  mtime_nsec;
+  uint64_t ino;
+  uint64_t dev;
+  int64_t  lastpos;      /* position of the last record and checksum of its first bytes */
+  uint64_t lastsum;
+}
+grbidx_header_t;
+
+/* records of the first timestep */
+typedef struct {
+  int32_t  param;
+  int32_t  ilevel;
+  int32_t  ilevel2;
+  int32_t  ltype;
+  int64_t  position;
+  int64_t  size;
+}
+grbidx_record_t;
+
+/* timestep, followed by nrecs grbidx_trec_t */
+typedef struct {
+  int64_t  position;
+  int32_t  type, vdate, vtime, rdate, rtime, fdate, ftime, calendar, unit, numavg;
+  int32_t  climatology, has_bounds, vdate_lb, vtime_lb, vdate_ub, vtime_ub, fc_unit;
+  int32_t  reserved;
+  double   fc_period;
+}
+grbidx_tstep_t;
+
+typedef struct {
+  int32_t  recID;
+  int32_t  reserved;
+  int64_t  position;
+  int64_t  size;
+}
+grbidx_trec_t;
+
+typedef struct {
+  void                  *data;
+  size_t                 datasize;
+  int                    mapped;
+  const grbidx_header_t *header;
+  const grbidx_record_t *records;
+  const unsigned char   *tsteps;     /* tstep blocks, starting with the second timestep */
+  size_t                 tstepsize;
+}
+grbidx_t;
+
+
+static
+int64_t grb_index_mtime_nsec(const struct stat *filestat)
+{
+#if defined (__APPLE__)
+  return ((int64_t) filestat->st_mtimespec.tv_nsec);
+#elif defined (st_mtime)
+  /* POSIX.1-2008, st_mtime is defined as st_mtim.tv_sec */
+  return ((int64_t) filestat->st_mtim.tv_nsec);
+#else
+  (void) filestat;
+  return (0);
+#endif
+}
+
+/* stores the identity of the GRIB file in the index header */
+static
+void grb_index_set_filestat(grbidx_header_t *header, const struct stat *filestat)
+{
+  header->filesize   = (int64_t) filestat->st_size;
+  header->mtime      = (int64_t) filestat->st_mtime;
+  header->mtime_nsec = grb_index_mtime_nsec(filestat);
+  header->ino        = (uint64_t) filestat->st_ino;
+  header->dev        = (uint64_t) filestat->st_dev;
+}
+
+static
+int grb_index_cmp_filestat(const grbidx_header_t *header, const struct stat *filestat)
+{
+  return (header->filesize   == (int64_t) filestat->st_size &&
+          header->mtime      == (int64_t) filestat->st_mtime &&
+          header->mtime_nsec == grb_index_mtime_nsec(filestat) &&
+          header->ino        == (uint64_t) filestat->st_ino &&
+          header->dev        == (uint64_t) filestat->st_dev);
+}
+
+/* FNV-1a checksum of the first GRBIDX_SUMSIZE bytes at position, returns 0 on read errors */
+static
+uint64_t grb_index_checksum(const char *filename, int64_t position)
+{
+  unsigned char buffer[GRBIDX_SUMSIZE];
+  uint64_t sum = 14695981039346656037ULL;
+
+  int fd = open(filename, O_RDONLY);
+  if ( fd == -1 ) return (0);
+
+  ssize_t nread = pread(fd, buffer, GRBIDX_SUMSIZE, (off_t) position);
+  close(fd);
+  if ( nread <= 0 ) return (0);
+
+  for ( ssize_t i = 0; i < nread; i++ )
+    {
+      sum ^= buffer[i];
+      sum *= 1099511628211ULL;
+    }
+
+  return (sum);
+}
+
+
+static
+char *grb_index_filename(const char *filename)
+{
+  char *idxname = (char *) malloc(strlen(filename) + 7);
+  sprintf(idxname, "%s.cdidx", filename);
+  return (idxname);
+}
+
+static
+size_t grb_index_tstepsize(int nrecs)
+{
+  return (sizeof(grbidx_tstep_t) + (size_t)nrecs*sizeof(grbidx_trec_t));
+}
+
+static
+const grbidx_tstep_t *grb_index_tstep(const grbidx_t *gidx, int tsID)
+{
+  return ((const grbidx_tstep_t *) (gidx->tsteps + (size_t)(tsID-1)*gidx->tstepsize));
+}
+
+static
+void grb_index_set_tstep(grbidx_tstep_t *itstep, off_t position, const taxis_t *taxis)
+{
+  memset(itstep, 0, sizeof(grbidx_tstep_t));
+  itstep->position    = (int64_t) position;
+  itstep->type        = taxis->type;
+  itstep->vdate       = taxis->vdate;
+  itstep->vtime       = taxis->vtime;
+  itstep->rdate       = taxis->rdate;
+  itstep->rtime       = taxis->rtime;
+  itstep->fdate       = taxis->fdate;
+  itstep->ftime       = taxis->ftime;
+  itstep->calendar    = taxis->calendar;
+  itstep->unit        = taxis->unit;
+  itstep->numavg      = taxis->numavg;
+  itstep->climatology = taxis->climatology;
+  itstep->has_bounds  = taxis->has_bounds;
+  itstep->vdate_lb    = taxis->vdate_lb;
+  itstep->vtime_lb    = taxis->vtime_lb;
+  itstep->vdate_ub    = taxis->vdate_ub;
+  itstep->vtime_ub    = taxis->vtime_ub;
+  itstep->fc_unit     = taxis->fc_unit;
+  itstep->fc_period   = taxis->fc_period;
+}
+
+static
+void grb_index_get_tstep(const grbidx_tstep_t *itstep, taxis_t *taxis)
+{
+  taxis->type        = itstep->type;
+  taxis->vdate       = itstep->vdate;
+  taxis->vtime       = itstep->vtime;
+  taxis->rdate       = itstep->rdate;
+  taxis->rtime       = itstep->rtime;
+  taxis->fdate       = itstep->fdate;
+  taxis->ftime       = itstep->ftime;
+  taxis->calendar    = itstep->calendar;
+  taxis->unit        = itstep->unit;
+  taxis->numavg      = itstep->numavg;
+  taxis->climatology = itstep->climatology;
+  taxis->has_bounds  = itstep->has_bounds;
+  taxis->vdate_lb    = itstep->vdate_lb;
+  taxis->vtime_lb    = itstep->vtime_lb;
+  taxis->vdate_ub    = itstep->vdate_ub;
+  taxis->vtime_ub    = itstep->vtime_ub;
+  taxis->fc_unit     = itstep->fc_unit;
+  taxis->fc_period   = itstep->fc_period;
+}
+
+static
+void grb_index_free(grbidx_t *gidx)
+{
+#if defined (HAVE_MMAP)
+  if ( gidx->mapped )
+    munmap(gidx->data, gidx->datasize);
+  else
+#endif
+    free(gidx->data);
+
+  free(gidx);
+}
+
+
+void grbIndexClose(stream_t *streamptr)
+{
+  if ( streamptr->gribIndex )
+    {
+      grb_index_free((grbidx_t *) streamptr->gribIndex);
+      streamptr->gribIndex = NULL;
+    }
+}
+
+/* compares the timestep tsID of the stream with the index */
+static
+int grb_index_check_tstep(stream_t *streamptr, const grbidx_t *gidx, int tsID)
+{
+  const tsteps_t *tstep = &streamptr->tsteps[tsID];
+  const grbidx_tstep_t *itstep = grb_index_tstep(gidx, tsID);
+  const grbidx_trec_t *irecs = (const grbidx_trec_t *) (itstep + 1);
+
+  if ( itstep->vdate != tstep->taxis.vdate || itstep->vtime != tstep->taxis.vtime ) return (FALSE);
+
+  for ( int vrecID = 0; vrecID < tstep->nrecs; vrecID++ )
+    {
+      int recID = tstep->recIDs[vrecID];
+      if ( irecs[vrecID].recID    != recID ||
+           irecs[vrecID].position != (int64_t) tstep->records[recID].position ||
+           irecs[vrecID].size     != (int64_t) tstep->records[recID].size ) return (FALSE);
+    }
+
+  return (TRUE);
+}
+
+/*
+  Opens the index after the first two timesteps are scanned. The index is ignored if it doesn't fit to the file.
+*/
+static
+void grb_index_open(stream_t *streamptr)
+{
+  struct stat filestat, idxstat;
+  grbidx_t *gidx = NULL;
+  int lvalid = FALSE;
+
+  if ( stat(streamptr->filename, &filestat) != 0 ) return;
+
+  char *idxname = grb_index_filename(streamptr->filename);
+
+  int fd = open(idxname, O_RDONLY);
+  if ( fd == -1 ) goto cleanup;
+
+  if ( fstat(fd, &idxstat) != 0 || (size_t)idxstat.st_size < sizeof(grbidx_header_t) ) goto cleanup;
+
+  gidx = (grbidx_t *) malloc(sizeof(grbidx_t));
+  gidx->datasize = (size_t) idxstat.st_size;
+  gidx->mapped   = FALSE;
+#if defined (HAVE_MMAP)
+  gidx->data = mmap(NULL, gidx->datasize, PROT_READ, MAP_SHARED, fd, 0);
+  if ( gidx->data == MAP_FAILED )
+    {
+      free(gidx);
+      gidx = NULL;
+      goto cleanup;
+    }
+  gidx->mapped = TRUE;
+#else
+  gidx->data = malloc(gidx->datasize);
+  if ( read(fd, gidx->data, gidx->datasize) != (ssize_t) gidx->datasize ) goto cleanup;
+#endif
+
+  gidx->header  = (const grbidx_header_t *) gidx->data;
+  gidx->records = (const grbidx_record_t *) (gidx->header + 1);
+
+  const grbidx_header_t *header = gidx->header;
+
+  if ( memcmp(header->magic, GRBIDX_MAGIC, 8) != 0 || header->version != GRBIDX_VERSION ) goto cleanup;
+  if ( header->filetype  != streamptr->filetype ||
+       header->inventory != cdiInventoryMode ||
+       ! grb_index_cmp_filestat(header, &filestat) ) goto cleanup;
+
+  if ( header->nallrecs != streamptr->tsteps[0].nallrecs ||
+       header->nrecs    != streamptr->tsteps[1].nrecs ||
+       header->ntsteps  <= streamptr->rtsteps ) goto cleanup;
+
+  gidx->tsteps    = (const unsigned char *) (gidx->records + header->nallrecs);
+  gidx->tstepsize = grb_index_tstepsize(header->nrecs);
+
+  if ( gidx->datasize != sizeof(grbidx_header_t) + (size_t)header->nallrecs*sizeof(grbidx_record_t)
+                         + (size_t)(header->ntsteps-1)*gidx->tstepsize ) goto cleanup;
+
+  for ( int recID = 0; recID < header->nallrecs; recID++ )
+    {
+      const record_t *record = &streamptr->tsteps[0].records[recID];
+      const grbidx_record_t *irecord = &gidx->records[recID];
+      if ( irecord->param    != record->param   || irecord->ilevel != record->ilevel ||
+           irecord->ilevel2  != record->ilevel2 || irecord->ltype  != record->ltype  ||
+           irecord->position != (int64_t) record->position ||
+           irecord->size     != (int64_t) record->size ) goto cleanup;
+    }
+
+  if ( ! grb_index_check_tstep(streamptr, gidx, 1) ) goto cleanup;
+
+  if ( header->lastsum == 0 || header->lastsum != grb_index_checksum(streamptr->filename, header->lastpos) ) goto cleanup;
+
+  lvalid = TRUE;
+
+ cleanup:
+
+  if ( fd != -1 ) close(fd);
+
+  if ( lvalid )
+    {
+      streamptr->gribIndex = gidx;
+      if ( CDI_Debug ) Message("Using GRIB index %s", idxname);
+    }
+  else
+    {
+      if ( gidx ) grb_index_free(gidx);
+      if ( CDI_Debug && fd != -1 ) Message("GRIB index %s outdated!", idxname);
+    }
+
+  free(idxname);
+}
+
+/*
+  Sets the next timestep from the index, same result as grbScanTimestep().
+*/
+static
+int grb_index_scan_timestep(stream_t *streamptr)
+{
+  const grbidx_t *gidx = (const grbidx_t *) streamptr->gribIndex;
+  int tsID = streamptr->rtsteps;
+
+  if ( tsID >= gidx->header->ntsteps ) return ((int) streamptr->ntsteps);
+
+  tsteps_t *tstep = &streamptr->tsteps[tsID];
+
+  if ( tstep->recordSize == 0 )
+    {
+      const grbidx_tstep_t *itstep = grb_index_tstep(gidx, tsID);
+      const grbidx_trec_t *irecs = (const grbidx_trec_t *) (itstep + 1);
+      int nrecs = streamptr->tsteps[1].nrecs;
+
+      cdi_create_records(streamptr, tsID);
+
+      tstep->nrecs  = nrecs;
+      tstep->recIDs = (int *) malloc((size_t)nrecs*sizeof(int));
+
+      for ( int vrecID = 0; vrecID < nrecs; vrecID++ )
+        {
+          int recID = irecs[vrecID].recID;
+          if ( recID < 0 || recID >= tstep->recordSize )
+            Error("Invalid record %d in GRIB index of %s", recID, streamptr->filename);
+
+          tstep->recIDs[vrecID] = recID;
+          tstep->records[recID].used     = TRUE;
+          tstep->records[recID].position = (off_t) irecs[vrecID].position;
+          tstep->records[recID].size     = (size_t) irecs[vrecID].size;
+        }
+
+      grb_index_get_tstep(itstep, &tstep->taxis);
+
+      streamptr->rtsteps++;
+
+      if ( streamptr->rtsteps == gidx->header->ntsteps )
+        {
+          streamptr->ntsteps = streamptr->rtsteps;
+        }
+      else
+        {
+          tsID = tstepsNewEntry(streamptr);
+          if ( tsID != streamptr->rtsteps )
+            Error("Internal error. tsID = %d", tsID);
+
+          streamptr->tsteps[tsID-1].next   = 1;
+          streamptr->tsteps[tsID].position = (off_t) grb_index_tstep(gidx, tsID)->position;
+        }
+    }
+
+  return ((int) streamptr->ntsteps);
+}
+
+/*
+  Writes the index of a completely scanned file. A temporary file is renamed to the index.
+*/
+static
+void grb_index_write(stream_t *streamptr)
+{
+  struct stat filestat;
+  grbidx_header_t header;
+  int nallrecs = streamptr->tsteps[0].nallrecs;
+  int nrecs    = streamptr->tsteps[1].nrecs;
+  long ntsteps = streamptr->ntsteps;
+
+  if ( cdiSkipRecords > 0 ) return;
+
+  for ( long tsID = 1; tsID < ntsteps; tsID++ )
+    if ( streamptr->tsteps[tsID].nrecs != nrecs ) return;
+
+  if ( stat(streamptr->filename, &filestat) != 0 ) return;
+
+  char *idxname = grb_index_filename(streamptr->filename);
+  char *tmpname = (char *) malloc(strlen(idxname) + 32);
+  sprintf(tmpname, "%s.tmp%ld", idxname, (long) getpid());
+
+  FILE *fp = fopen(tmpname, "wb");
+  if ( fp == NULL )
+    {
+      if ( CDI_Debug ) Message("Open of GRIB index %s failed!", tmpname);
+      free(tmpname);
+      free(idxname);
+      return;
+    }
+
+  memset(&header, 0, sizeof(grbidx_header_t));
+  memcpy(header.magic, GRBIDX_MAGIC, 8);
+  header.version   = GRBIDX_VERSION;
+  header.filetype  = streamptr->filetype;
+  header.inventory = cdiInventoryMode;
+  header.nallrecs  = nallrecs;
+  header.nrecs     = nrecs;
+  header.ntsteps   = ntsteps;
+  grb_index_set_filestat(&header, &filestat);
+
+  const tsteps_t *lasttstep = &streamptr->tsteps[ntsteps-1];
+  for ( int vrecID = 0; vrecID < nrecs; vrecID++ )
+    {
+      int64_t position = (int64_t) lasttstep->records[lasttstep->recIDs[vrecID]].position;
+      if ( position > header.lastpos ) header.lastpos = position;
+    }
+  header.lastsum = grb_index_checksum(streamptr->filename, header.lastpos);
+
+  int lerror = fwrite(&header, sizeof(grbidx_header_t), 1, fp) != 1;
+
+  for ( int recID = 0; recID < nallrecs && !lerror; recID++ )
+    {
+      const record_t *record = &streamptr->tsteps[0].records[recID];
+      grbidx_record_t irecord;
+      memset(&irecord, 0, sizeof(grbidx_record_t));
+      irecord.param    = record->param;
+      irecord.ilevel   = record->ilevel;
+      irecord.ilevel2  = record->ilevel2;
+      irecord.ltype    = record->ltype;
+      irecord.position = (int64_t) record->position;
+      irecord.size     = (int64_t) record->size;
+      lerror = fwrite(&irecord, sizeof(grbidx_record_t), 1, fp) != 1;
+    }
+
+  size_t tstepsize = grb_index_tstepsize(nrecs);
+  unsigned char *buffer = (unsigned char *) malloc(tstepsize);
+
+  for ( long tsID = 1; tsID < ntsteps && !lerror; tsID++ )
+    {
+      const tsteps_t *tstep = &streamptr->tsteps[tsID];
+      grbidx_trec_t *irecs = (grbidx_trec_t *) (buffer + sizeof(grbidx_tstep_t));
+
+      grb_index_set_tstep((grbidx_tstep_t *) buffer, tstep->position, &tstep->taxis);
+
+      for ( int vrecID = 0; vrecID < nrecs; vrecID++ )
+        {
+          int recID = tstep->recIDs[vrecID];
+          irecs[vrecID].recID    = recID;
+          irecs[vrecID].reserved = 0;
+          irecs[vrecID].position = (int64_t) tstep->records[recID].position;
+          irecs[vrecID].size     = (int64_t) tstep->records[recID].size;
+        }
+
+      lerror = fwrite(buffer, tstepsize, 1, fp) != 1;
+    }
+
+  free(buffer);
+
+  if ( fclose(fp) != 0 ) lerror = TRUE;
+
+  if ( lerror || rename(tmpname, idxname) != 0 )
+    {
+      if ( CDI_Debug ) Message("Write of GRIB index %s failed!", idxname);
+      unlink(tmpname);
+    }
+  else if ( CDI_Debug )
+    Message("GRIB index %s written", idxname);
+
+  free(tmpname);
+  free(idxname);
+}
+
 static
 int grbScanTimestep1(stream_t * streamptr)
 {
@@ -358,6 +876,8 @@ int grbScanTimestep(stream_t * streamptr)
 
   filetype  = streamptr->filetype;
 
+  if ( streamptr->gribIndex ) return (grb_index_scan_timestep(streamptr));
+
 #if  defined  (HAVE_LIBCGRIBEX)
   if ( filetype == FILETYPE_GRB )
     {
@@ -375,6 +895,25 @@ int grbScanTimestep(stream_t * streamptr)
 }
 
 
+/*
+  Scans the next timestep, returns the number of timesteps or CDI_UNDEFID
+*/
+static
+int grb_scan_next_timestep(stream_t *streamptr)
+{
+  int ntsteps = grbScanTimestep(streamptr);
+
+  if ( ntsteps == CDI_EUFSTRUCT )
+    streamptr->ntsteps = streamptr->rtsteps;
+
+  /* the file is scanned completely, write the index for the next open */
+  if ( ntsteps > 2 && ntsteps == streamptr->ntsteps && cdiGribIndex && streamptr->gribIndex == NULL )
+    grb_index_write(streamptr);
+
+  return (ntsteps);
+}
+
+
 int grbInqContents(stream_t * streamptr)
 {
   int fileID;
@@ -388,6 +927,8 @@ int grbInqContents(stream_t * streamptr)
 
   if ( status == 0 && streamptr->ntsteps == -1 ) status = grbScanTimestep2(streamptr);
 
+  if ( status == 0 && streamptr->ntsteps == -1 && cdiGribIndex && cdiSkipRecords == 0 ) grb_index_open(streamptr);
+
   fileSetPos(fileID, 0, SEEK_SET);
 
   return (status);
@@ -406,14 +947,7 @@ int grbInqTimestep(stream_t * streamptr, int tsID)
 
   ntsteps = CDI_UNDEFID;
   while ( (tsID + 1) > streamptr->rtsteps && ntsteps == CDI_UNDEFID )
-    {
-      ntsteps = grbScanTimestep(streamptr);
-      if ( ntsteps == CDI_EUFSTRUCT )
-	{
-	  streamptr->ntsteps = streamptr->rtsteps;
-	  break;
-	}
-    }
+    ntsteps = grb_scan_next_timestep(streamptr);
 
   if ( tsID >= streamptr->ntsteps && streamptr->ntsteps != CDI_UNDEFID )
     {
@@ -429,6 +963,283 @@ int grbInqTimestep(stream_t * streamptr, int tsID)
 }
 
 
+/*
+  Read-ahead of GRIB records (CDI_GRIB_READAHEAD=<nthreads>)
+
+  The records following the current record are read in advance and decoded by
+  a pool of worker threads. The records are read on the calling thread in the
+  order of the record table, only the unzip and the decoding are done by the
+  workers. If the next timestep is not yet known it is scanned, so the decoding
+  continues across timesteps. Records skipped by the record filter
+  (streamDefRecordFilter) are not read in advance. A record that is not in the
+  ring (e.g. after a selection) restarts the read-ahead at this record.
+  GRIB2 records are decoded with GRIB_API, it has to be built thread safe.
+*/
+
+typedef struct {
+  int            tsID;
+  int            vrecID;
+  int            done;
+  unsigned char *buffer;
+  size_t         buffersize;
+  size_t         recsize;
+  double        *data;
+  size_t         datasize;
+  int            filetype;
+  int            gridsize;
+  int            unreduced;
+  int            vlistID;
+  int            varID;
+  double         missval;
+  int            nmiss;
+  int            zip;
+}
+grbslot_t;
+
+typedef struct {
+  threadpool_t  *pool;
+  int            nslots;
+  int            first;        /* slot of the oldest record */
+  int            nused;
+  int            tsID;         /* next record to read */
+  int            vrecID;
+  grbslot_t     *slots;
+}
+grbreadahead_t;
+
+
+static
+void grb_readahead_decode(void *arg)
+{
+  grbslot_t *slot = (grbslot_t *) arg;
+
+  slot->zip = grbUnzipRecord(slot->buffer, &slot->recsize);
+
+  grbDecode(slot->filetype, slot->buffer, (int)slot->recsize, slot->data, slot->gridsize,
+            slot->unreduced, &slot->nmiss, slot->missval, slot->vlistID, slot->varID);
+}
+
+static
+grbreadahead_t *grb_readahead_new(int nthreads)
+{
+  grbreadahead_t *ra = (grbreadahead_t *) malloc(sizeof(grbreadahead_t));
+  int i;
+
+  ra->pool   = threadPoolNew(nthreads);
+  ra->nslots = 2*nthreads;
+  ra->first  = 0;
+  ra->nused  = 0;
+  ra->tsID   = CDI_UNDEFID;
+  ra->vrecID = CDI_UNDEFID;
+  ra->slots  = (grbslot_t *) malloc((size_t)ra->nslots*sizeof(grbslot_t));
+
+  for ( i = 0; i < ra->nslots; ++i )
+    {
+      ra->slots[i].buffer     = NULL;
+      ra->slots[i].buffersize = 0;
+      ra->slots[i].data       = NULL;
+      ra->slots[i].datasize   = 0;
+    }
+
+  return (ra);
+}
+
+/* waits for all records in the ring and discards them */
+static
+void grb_readahead_drain(grbreadahead_t *ra)
+{
+  while ( ra->nused > 0 )
+    {
+      threadPoolWait(ra->pool, &ra->slots[ra->first].done);
+      ra->first = (ra->first + 1) % ra->nslots;
+      ra->nused--;
+    }
+}
+
+
+void grbReadAheadClose(stream_t *streamptr)
+{
+  grbreadahead_t *ra = (grbreadahead_t *) streamptr->gribReadAhead;
+  int i;
+
+  if ( ra )
+    {
+      grb_readahead_drain(ra);
+      threadPoolDelete(ra->pool);
+
+      for ( i = 0; i < ra->nslots; ++i )
+        {
+          if ( ra->slots[i].buffer ) free(ra->slots[i].buffer);
+          if ( ra->slots[i].data )   free(ra->slots[i].data);
+        }
+
+      free(ra->slots);
+      free(ra);
+      streamptr->gribReadAhead = NULL;
+    }
+}
+
+/* returns FALSE if the timestep doesn't exist, the next timestep is scanned if needed */
+static
+int grb_readahead_tstep(stream_t *streamptr, int tsID)
+{
+  while ( tsID >= streamptr->rtsteps && streamptr->ntsteps == CDI_UNDEFID )
+    if ( grb_scan_next_timestep(streamptr) != CDI_UNDEFID ) break;
+
+  if ( tsID >= streamptr->rtsteps ) return (FALSE);
+  if ( streamptr->ntsteps != CDI_UNDEFID && tsID >= streamptr->ntsteps ) return (FALSE);
+
+  return (TRUE);
+}
+
+/* TRUE if the record is skipped by the record filter */
+static
+int grb_record_skipped(const stream_t *streamptr, const record_t *record)
+{
+  const svarinfo_t *var = &streamptr->vars[record->varID];
+
+  return (var->lskip != NULL && var->lskip[var->lindex[record->levelID]]);
+}
+
+/* reads the next records of the record table and passes them to the workers,
+   the first record is the current record */
+static
+void grb_readahead_fill(stream_t *streamptr, grbreadahead_t *ra)
+{
+  int vlistID = streamptr->vlistID;
+  int fileID  = streamptr->fileID;
+
+  while ( ra->nused < ra->nslots )
+    {
+      if ( ra->vrecID >= streamptr->tsteps[ra->tsID].nrecs )
+        {
+          if ( !grb_readahead_tstep(streamptr, ra->tsID+1) ) break;
+          ra->tsID++;
+          ra->vrecID = 0;
+          continue;
+        }
+
+      grbslot_t *slot = &ra->slots[(ra->first + ra->nused) % ra->nslots];
+      int recID = streamptr->tsteps[ra->tsID].recIDs[ra->vrecID];
+      const record_t *record = &streamptr->tsteps[ra->tsID].records[recID];
+
+      if ( ra->nused > 0 && grb_record_skipped(streamptr, record) )
+        {
+          ra->vrecID++;
+          continue;
+        }
+
+      size_t recsize = record->size;
+      size_t buffersize = streamptr->record->buffersize;
+      if ( buffersize < recsize ) buffersize = recsize;
+
+      slot->tsID      = ra->tsID;
+      slot->vrecID    = ra->vrecID;
+      slot->filetype  = streamptr->filetype;
+      slot->unreduced = streamptr->unreduced;
+      slot->vlistID   = vlistID;
+      slot->varID     = record->varID;
+      slot->gridsize  = gridInqSize(vlistInqVarGrid(vlistID, slot->varID));
+      slot->missval   = vlistInqVarMissval(vlistID, slot->varID);
+      slot->recsize   = recsize;
+
+      if ( slot->buffersize < buffersize )
+        {
+          slot->buffersize = buffersize;
+          slot->buffer = (unsigned char *) realloc(slot->buffer, buffersize);
+        }
+
+      if ( slot->datasize < (size_t)slot->gridsize )
+        {
+          slot->datasize = (size_t)slot->gridsize;
+          slot->data = (double *) realloc(slot->data, slot->datasize*sizeof(double));
+        }
+
+      fileSetPos(fileID, record->position, SEEK_SET);
+
+      if ( fileRead(fileID, slot->buffer, recsize) != recsize )
+        Error("Failed to read GRIB record");
+
+      threadPoolSubmit(ra->pool, grb_readahead_decode, slot, &slot->done);
+
+      ra->nused++;
+      ra->vrecID++;
+    }
+}
+
+static
+void grb_readahead_read(stream_t *streamptr, double *data, int *nmiss)
+{
+  grbreadahead_t *ra = (grbreadahead_t *) streamptr->gribReadAhead;
+  int tsID   = streamptr->curTsID;
+  int vrecID = streamptr->tsteps[tsID].curRecID;
+  int recID  = streamptr->tsteps[tsID].recIDs[vrecID];
+  int i;
+
+  if ( ra == NULL )
+    {
+      ra = grb_readahead_new(cdiGribReadAhead);
+      streamptr->gribReadAhead = ra;
+    }
+
+  /* skip the records before the current record, restart if it's not in the ring */
+  for ( i = 0; i < ra->nused; ++i )
+    {
+      const grbslot_t *slot = &ra->slots[(ra->first + i) % ra->nslots];
+      if ( slot->tsID == tsID && slot->vrecID == vrecID ) break;
+    }
+
+  if ( i == ra->nused )
+    {
+      grb_readahead_drain(ra);
+      ra->tsID   = tsID;
+      ra->vrecID = vrecID;
+    }
+  else
+    {
+      for ( ; i > 0; --i )
+        {
+          threadPoolWait(ra->pool, &ra->slots[ra->first].done);
+          ra->first = (ra->first + 1) % ra->nslots;
+          ra->nused--;
+        }
+    }
+
+  grb_readahead_fill(streamptr, ra);
+
+  grbslot_t *slot = &ra->slots[ra->first];
+  threadPoolWait(ra->pool, &slot->done);
+
+  streamptr->numvals += slot->gridsize;
+  streamptr->tsteps[tsID].records[recID].zip = slot->zip;
+
+  /* the record buffer holds the current record, like after a synchronous read (streamInqGRIBinfo),
+     so the ring is filled again on the next read, a scan of the next timestep would overwrite it */
+  if ( streamptr->record->buffersize < slot->buffersize )
+    {
+      streamptr->record->buffersize = slot->buffersize;
+      streamptr->record->buffer = realloc(streamptr->record->buffer, slot->buffersize);
+    }
+  memcpy(streamptr->record->buffer, slot->buffer, slot->recsize);
+
+  if ( DBL_IS_EQUAL(slot->missval, vlistInqVarMissval(streamptr->vlistID, slot->varID)) )
+    {
+      memcpy(data, slot->data, (size_t)slot->gridsize*sizeof(double));
+      *nmiss = slot->nmiss;
+    }
+  else
+    {
+      /* the missing value was changed after the record was decoded */
+      slot->missval = vlistInqVarMissval(streamptr->vlistID, slot->varID);
+      grbDecode(slot->filetype, slot->buffer, (int)slot->recsize, data, slot->gridsize,
+                slot->unreduced, nmiss, slot->missval, slot->vlistID, slot->varID);
+    }
+
+  ra->first = (ra->first + 1) % ra->nslots;
+  ra->nused--;
+}
+
+
 void grbReadVarDP(stream_t * streamptr, int varID, double *data, int *nmiss)
 {
   int filetype = streamptr->filetype;
@@ -584,6 +1395,192 @@ size_t grbSzip(int filetype, unsigned char *gribbuffer, size_t gribbuffersize)
 }
 
 
+/*
+  Write-behind of GRIB1 records (CDI_GRIB_WRITEBEHIND=<nthreads>)
+
+  The GRIB sections are set on the calling thread, the field is copied and
+  packed by a pool of worker threads, including the szip compression. The
+  records are written in the order of the calls from a ring of 2*nthreads slots,
+  a full ring waits for the oldest record. GRIB2 records are encoded with
+  GRIB_API on the calling thread, the encoding uses the grib handles of the stream.
+*/
+
+#if  defined  (HAVE_LIBCGRIBEX)
+typedef struct {
+  int            done;
+  int            tsID;
+  int            memtype;
+  int            filetype;
+  int            szip;
+  long           datasize;
+  void          *data;
+  size_t         dataalloc;
+  unsigned char *buffer;
+  size_t         buffersize;
+  size_t         nbytes;
+  cgribexsec_t   sec;
+}
+grbwslot_t;
+
+typedef struct {
+  threadpool_t  *pool;
+  int            nslots;
+  int            first;        /* slot of the oldest record */
+  int            nused;
+  grbwslot_t    *slots;
+}
+grbwritebehind_t;
+
+
+static
+void grb_writebehind_encode(void *arg)
+{
+  grbwslot_t *slot = (grbwslot_t *) arg;
+
+  slot->nbytes = cgribexEncodeData(&slot->sec, slot->memtype, slot->datasize, (const double *) slot->data,
+                                   slot->buffer, slot->buffersize);
+
+  if ( slot->szip ) slot->nbytes = grbSzip(slot->filetype, slot->buffer, slot->nbytes);
+}
+
+static
+grbwritebehind_t *grb_writebehind_new(int nthreads)
+{
+  grbwritebehind_t *wb = (grbwritebehind_t *) malloc(sizeof(grbwritebehind_t));
+  int i;
+
+  wb->pool   = threadPoolNew(nthreads);
+  wb->nslots = 2*nthreads;
+  wb->first  = 0;
+  wb->nused  = 0;
+  wb->slots  = (grbwslot_t *) malloc((size_t)wb->nslots*sizeof(grbwslot_t));
+
+  for ( i = 0; i < wb->nslots; ++i )
+    {
+      wb->slots[i].data       = NULL;
+      wb->slots[i].dataalloc  = 0;
+      wb->slots[i].buffer     = NULL;
+      wb->slots[i].buffersize = 0;
+    }
+
+  return (wb);
+}
+
+/* waits for the oldest record and writes it */
+static
+void grb_writebehind_write(stream_t *streamptr, grbwritebehind_t *wb)
+{
+  grbwslot_t *slot = &wb->slots[wb->first];
+  size_t nwrite;
+
+  threadPoolWait(wb->pool, &slot->done);
+
+  {
+    size_t (*myFileWrite)(int fileID, const void *restrict buffer,
+                          size_t len, int tsID)
+      = (size_t (*)(int, const void *restrict, size_t, int))
+      namespaceSwitchGet(NSSWITCH_FILE_WRITE).func;
+    nwrite = myFileWrite(streamptr->fileID, slot->buffer, slot->nbytes, slot->tsID);
+  }
+
+  if ( nwrite != slot->nbytes )
+    {
+      perror(__func__);
+      Error("Failed to write GRIB slice!");
+    }
+
+  wb->first = (wb->first + 1) % wb->nslots;
+  wb->nused--;
+}
+
+static
+void grb_writebehind_submit(stream_t *streamptr, int memtype, int varID, int levelID, int gridID, int zaxisID,
+                            int date, int time, int tsteptype, int numavg,
+                            size_t datasize, const void *data, int nmiss)
+{
+  grbwritebehind_t *wb = (grbwritebehind_t *) streamptr->gribWriteBehind;
+  size_t datalen = datasize*(memtype == MEMTYPE_FLOAT ? sizeof(float) : sizeof(double));
+  size_t buffersize = datasize*4+3000;
+
+  if ( wb == NULL )
+    {
+      wb = grb_writebehind_new(cdiGribWriteBehind);
+      streamptr->gribWriteBehind = wb;
+    }
+
+  if ( wb->nused == wb->nslots ) grb_writebehind_write(streamptr, wb);
+
+  grbwslot_t *slot = &wb->slots[(wb->first + wb->nused) % wb->nslots];
+
+  slot->tsID     = streamptr->curTsID;
+  slot->memtype  = memtype;
+  slot->filetype = streamptr->filetype;
+  slot->szip     = streamptr->comptype == COMPRESS_SZIP;
+  slot->datasize = (long)datasize;
+
+  if ( slot->dataalloc < datalen )
+    {
+      slot->dataalloc = datalen;
+      slot->data = realloc(slot->data, datalen);
+    }
+  memcpy(slot->data, data, datalen);
+
+  if ( slot->buffersize < buffersize )
+    {
+      slot->buffersize = buffersize;
+      slot->buffer = (unsigned char *) realloc(slot->buffer, buffersize);
+    }
+
+  cgribexEncodeSec(&slot->sec, varID, levelID, streamptr->vlistID, gridID, zaxisID,
+                   date, time, tsteptype, numavg, nmiss);
+
+  threadPoolSubmit(wb->pool, grb_writebehind_encode, slot, &slot->done);
+
+  wb->nused++;
+}
+#endif
+
+
+void grbWriteBehindFlush(stream_t *streamptr)
+{
+#if  defined  (HAVE_LIBCGRIBEX)
+  grbwritebehind_t *wb = (grbwritebehind_t *) streamptr->gribWriteBehind;
+
+  if ( wb )
+    while ( wb->nused > 0 ) grb_writebehind_write(streamptr, wb);
+#else
+  (void)streamptr;
+#endif
+}
+
+
+void grbWriteBehindClose(stream_t *streamptr)
+{
+#if  defined  (HAVE_LIBCGRIBEX)
+  grbwritebehind_t *wb = (grbwritebehind_t *) streamptr->gribWriteBehind;
+  int i;
+
+  if ( wb )
+    {
+      grbWriteBehindFlush(streamptr);
+      threadPoolDelete(wb->pool);
+
+      for ( i = 0; i < wb->nslots; ++i )
+        {
+          if ( wb->slots[i].data )   free(wb->slots[i].data);
+          if ( wb->slots[i].buffer ) free(wb->slots[i].buffer);
+        }
+
+      free(wb->slots);
+      free(wb);
+      streamptr->gribWriteBehind = NULL;
+    }
+#else
+  (void)streamptr;
+#endif
+}
+
+
 void grb_write_var_slice(stream_t *streamptr, int varID, int levelID, int memtype, const void *data, int nmiss)
 {
   size_t nwrite;
@@ -623,6 +1620,14 @@ void grb_write_var_slice(stream_t *streamptr, int varID, int levelID, int memtyp
   gribbuffersize = datasize*4+3000;
   gribbuffer = (unsigned char *) malloc(gribbuffersize);
   */
+#if  defined  (HAVE_LIBCGRIBEX)
+  if ( filetype == FILETYPE_GRB && cdiGribWriteBehind > 0 )
+    {
+      grb_writebehind_submit(streamptr, memtype, varID, levelID, gridID, zaxisID, date, time, tsteptype, numavg,
+                             datasize, data, nmiss);
+      return;
+    }
+#endif
 #if  defined  (HAVE_LIBCGRIBEX)
   if ( filetype == FILETYPE_GRB )
     {
@@ -706,6 +1711,24 @@ void grbCopyRecord(stream_t * streamptr2, stream_t * streamptr1)
   off_t recpos  = streamptr1->tsteps[tsID].records[recID].position;
   size_t recsize = streamptr1->tsteps[tsID].records[recID].size;
 
+  grbWriteBehindFlush(streamptr2);
+
+  /* records are passed through unchanged unless they have to be szip compressed */
+  if ( !(filetype == FILETYPE_GRB && streamptr2->comptype == COMPRESS_SZIP) )
+    {
+      static const unsigned char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+      size_t npad = (8 - (recsize & 7)) & 7;
+
+      if ( fileCopy(fileID2, fileID1, recpos, recsize) != recsize ||
+           (npad && fileWrite(fileID2, padding, npad) != npad) )
+        {
+          perror(__func__);
+          Error("Could not copy GRIB record!");
+        }
+
+      return;
+    }
+
   fileSetPos(fileID1, recpos, SEEK_SET);
 
   /* round up recsize to next multiple of 8 */
@@ -718,15 +1741,10 @@ void grbCopyRecord(stream_t * streamptr2, stream_t * streamptr1)
 
   size_t nbytes = recsize;
 
-  if ( filetype == FILETYPE_GRB )
-    {
-      long unzipsize;
-      int izip = gribGetZip((long)recsize, gribbuffer, &unzipsize);
+  long unzipsize;
+  int izip = gribGetZip((long)recsize, gribbuffer, &unzipsize);
 
-      if ( izip == 0 )
-        if ( streamptr2->comptype == COMPRESS_SZIP )
-          nbytes = grbSzip(filetype, gribbuffer, nbytes);
-    }
+  if ( izip == 0 ) nbytes = grbSzip(filetype, gribbuffer, nbytes);
 
   while ( nbytes & 7 ) gribbuffer[nbytes++] = 0;
 
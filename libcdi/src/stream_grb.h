@@ -5,6 +5,10 @@ int   grbBitsPerValue(int datatype);
 
 int   grbInqContents(stream_t * streamptr);
 int   grbInqTimestep(stream_t * streamptr, int tsID);
+void  grbIndexClose(stream_t * streamptr);
+void  grbReadAheadClose(stream_t * streamptr);
+void  grbWriteBehindFlush(stream_t * streamptr);
+void  grbWriteBehindClose(stream_t * streamptr);
 
 int   grbInqRecord(stream_t * streamptr, int *varID, int *levelID);
 void  grbDefRecord(stream_t * streamptr);
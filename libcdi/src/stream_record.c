@@ -354,6 +354,45 @@ void streamWriteRecordF(int streamID, const float *data, int nmiss)
   stream_write_record(streamID, MEMTYPE_FLOAT, (const void *) data, nmiss);
 }
 
+/*
+@Function  streamDefRecordFilter
+@Title     Define the records which are read
+
+@Prototype void streamDefRecordFilter(int streamID, int varID, int levelID, int flag)
+@Parameter
+    @Item  streamID  Stream ID, from a previous call to @fref{streamOpenRead}.
+    @Item  varID     Variable identifier.
+    @Item  levelID   Level identifier.
+    @Item  flag      FALSE if the record will not be read.
+
+@Description
+The function streamDefRecordFilter marks the records of a level that will not be read.
+These records are not read in advance and not decoded, they are still returned by
+@func{streamInqRecord} and can be read if needed. By default all records are read.
+@EndFunction
+*/
+void streamDefRecordFilter(int streamID, int varID, int levelID, int flag)
+{
+  stream_t *streamptr = stream_to_pointer(streamID);
+  stream_check_ptr(__func__, streamptr);
+
+  if ( varID < 0 || varID >= streamptr->nvars )
+    Error("varID %d undefined!", varID);
+
+  svarinfo_t *var = &streamptr->vars[varID];
+
+  /* the filter is a hint, levels unknown to the stream are read */
+  if ( levelID < 0 || levelID >= var->nlevs ) return;
+
+  if ( var->lskip == NULL )
+    {
+      if ( flag ) return;
+      var->lskip = (char *) xcalloc((size_t)var->nlevs, sizeof (char));
+    }
+
+  var->lskip[levelID] = (char) !flag;
+}
+
 
 void streamCopyRecord(int streamID2, int streamID1)
 {
@@ -19,6 +19,7 @@ void streamvar_init_entry(stream_t *streamptr, int varID)
   streamptr->vars[varID].nlevs        = 0;
   streamptr->vars[varID].level        = NULL;
   streamptr->vars[varID].lindex       = NULL;
+  streamptr->vars[varID].lskip        = NULL;
 
   streamptr->vars[varID].gridID       = CDI_UNDEFID;
   streamptr->vars[varID].zaxisID      = CDI_UNDEFID;
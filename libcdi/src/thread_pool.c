@@ -0,0 +1,214 @@
+#if defined (HAVE_CONFIG_H)
+#  include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "dmemory.h"
+#include "cdi.h"
+#include "cdi_int.h"
+#include "error.h"
+#include "thread_pool.h"
+
+#if  defined  (HAVE_LIBPTHREAD)
+#include <pthread.h>
+
+typedef struct {
+  void  (*func)(void *);
+  void   *arg;
+  int    *done;
+}
+tpjob_t;
+
+struct threadpool {
+  int              nthreads;
+  pthread_t       *threads;
+  pthread_mutex_t  mutex;
+  pthread_cond_t   work_cond;   /* signaled if a job is submitted */
+  pthread_cond_t   done_cond;   /* signaled if a job is finished */
+  tpjob_t         *jobs;        /* ring buffer of the waiting jobs */
+  int              jobsize;
+  int              first;
+  int              njobs;
+  int              shutdown;
+};
+
+
+static
+void *thread_pool_worker(void *arg)
+{
+  threadpool_t *pool = (threadpool_t *) arg;
+  tpjob_t job;
+
+  pthread_mutex_lock(&pool->mutex);
+
+  while ( 1 )
+    {
+      while ( pool->njobs == 0 && !pool->shutdown )
+        pthread_cond_wait(&pool->work_cond, &pool->mutex);
+
+      if ( pool->njobs == 0 ) break;
+
+      job = pool->jobs[pool->first];
+      pool->first = (pool->first + 1) % pool->jobsize;
+      pool->njobs--;
+
+      pthread_mutex_unlock(&pool->mutex);
+
+      job.func(job.arg);
+
+      pthread_mutex_lock(&pool->mutex);
+      *job.done = TRUE;
+      pthread_cond_broadcast(&pool->done_cond);
+    }
+
+  pthread_mutex_unlock(&pool->mutex);
+
+  return (NULL);
+}
+
+
+threadpool_t *threadPoolNew(int nthreads)
+{
+  threadpool_t *pool = (threadpool_t *) malloc(sizeof(threadpool_t));
+  int i;
+
+  if ( nthreads < 1 ) nthreads = 1;
+
+  pool->nthreads = 0;
+  pool->threads  = (pthread_t *) malloc((size_t)nthreads*sizeof(pthread_t));
+  pool->jobsize  = 2*nthreads;
+  pool->jobs     = (tpjob_t *) malloc((size_t)pool->jobsize*sizeof(tpjob_t));
+  pool->first    = 0;
+  pool->njobs    = 0;
+  pool->shutdown = FALSE;
+
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->work_cond, NULL);
+  pthread_cond_init(&pool->done_cond, NULL);
+
+  for ( i = 0; i < nthreads; ++i )
+    {
+      if ( pthread_create(&pool->threads[i], NULL, thread_pool_worker, pool) != 0 )
+        {
+          Warning("Creation of worker thread %d failed!", i+1);
+          break;
+        }
+      pool->nthreads++;
+    }
+
+  if ( pool->nthreads == 0 ) Error("Creation of the thread pool failed!");
+
+  return (pool);
+}
+
+/*
+  Finishes all submitted jobs and stops the worker threads.
+*/
+void threadPoolDelete(threadpool_t *pool)
+{
+  int i;
+
+  if ( pool == NULL ) return;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->shutdown = TRUE;
+  pthread_cond_broadcast(&pool->work_cond);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for ( i = 0; i < pool->nthreads; ++i ) pthread_join(pool->threads[i], NULL);
+
+  pthread_cond_destroy(&pool->done_cond);
+  pthread_cond_destroy(&pool->work_cond);
+  pthread_mutex_destroy(&pool->mutex);
+
+  free(pool->jobs);
+  free(pool->threads);
+  free(pool);
+}
+
+
+void threadPoolSubmit(threadpool_t *pool, void (*func)(void *), void *arg, int *done)
+{
+  pthread_mutex_lock(&pool->mutex);
+
+  if ( pool->njobs == pool->jobsize )
+    {
+      int i, jobsize = 2*pool->jobsize;
+      tpjob_t *jobs = (tpjob_t *) malloc((size_t)jobsize*sizeof(tpjob_t));
+
+      for ( i = 0; i < pool->njobs; ++i )
+        jobs[i] = pool->jobs[(pool->first + i) % pool->jobsize];
+
+      free(pool->jobs);
+      pool->jobs    = jobs;
+      pool->jobsize = jobsize;
+      pool->first   = 0;
+    }
+
+  *done = FALSE;
+  pool->jobs[(pool->first + pool->njobs) % pool->jobsize].func = func;
+  pool->jobs[(pool->first + pool->njobs) % pool->jobsize].arg  = arg;
+  pool->jobs[(pool->first + pool->njobs) % pool->jobsize].done = done;
+  pool->njobs++;
+
+  pthread_cond_signal(&pool->work_cond);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+
+void threadPoolWait(threadpool_t *pool, int *done)
+{
+  pthread_mutex_lock(&pool->mutex);
+  while ( !*done ) pthread_cond_wait(&pool->done_cond, &pool->mutex);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+#else
+
+struct threadpool {
+  int nthreads;
+};
+
+
+threadpool_t *threadPoolNew(int nthreads)
+{
+  threadpool_t *pool = (threadpool_t *) malloc(sizeof(threadpool_t));
+
+  pool->nthreads = nthreads;
+
+  return (pool);
+}
+
+
+void threadPoolDelete(threadpool_t *pool)
+{
+  if ( pool ) free(pool);
+}
+
+
+void threadPoolSubmit(threadpool_t *pool, void (*func)(void *), void *arg, int *done)
+{
+  (void)pool;
+  *done = FALSE;
+  func(arg);
+  *done = TRUE;
+}
+
+
+void threadPoolWait(threadpool_t *pool, int *done)
+{
+  (void)pool;
+  (void)done;
+}
+
+#endif
+/*
+ * Local Variables:
+ * c-file-style: "Java"
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * show-trailing-whitespace: t
+ * require-trailing-newline: t
+ * End:
+ */
@@ -0,0 +1,28 @@
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+/*
+  Fixed size pool of worker threads.
+
+  Jobs are started in the order of submission. The done flag of a job is set
+  by the worker after the job function returned, threadPoolWait() blocks
+  until it is set. Without pthreads the jobs are executed by threadPoolSubmit().
+*/
+typedef struct threadpool threadpool_t;
+
+threadpool_t *threadPoolNew(int nthreads);
+void  threadPoolDelete(threadpool_t *pool);
+
+void  threadPoolSubmit(threadpool_t *pool, void (*func)(void *), void *arg, int *done);
+void  threadPoolWait(threadpool_t *pool, int *done);
+
+#endif  /* _THREAD_POOL_H */
+/*
+ * Local Variables:
+ * c-file-style: "Java"
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * show-trailing-whitespace: t
+ * require-trailing-newline: t
+ * End:
+ */
@@ -26,9 +26,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
-
-
-#define  NALLOC_INC  1024
+#include "tstore.h"
 
 
 static
@@ -71,22 +69,16 @@ void *Detrend(void *argument)
   int nrecs;
   int gridID, varID, levelID, recID;
   int tsID;
-  int i;
+  long i, first, npoints, nblk;
   int nts;
-  int nalloc = 0;
   int streamID1, streamID2;
   int vlistID1, vlistID2, taxisID1, taxisID2;
   int nmiss;
   int nvars, nlevel;
   double missval;
-  field_t ***vars = NULL;
+  double *array, *tile;
+  tstore_t *store;
   dtlist_type *dtlist = dtlist_new();
-  typedef struct
-  {
-    double *array1;
-    double *array2;
-  } memory_t;
-  memory_t *ompmem = NULL;
 
   cdoInitialize(argument);
 
@@ -105,27 +97,20 @@ void *Detrend(void *argument)
 
   nvars = vlistNvars(vlistID1);
 
+  array = (double*) malloc(vlistGridsizeMax(vlistID1)*sizeof(double));
+
+  store = tstore_new(vlistID1);
+
   tsID = 0;
   while ( (nrecs = streamInqTimestep(streamID1, tsID)) )
     {
-      if ( tsID >= nalloc )
-	{
-	  nalloc += NALLOC_INC;
-	  vars   = (field_t ***) realloc(vars, nalloc*sizeof(field_t **));
-	}
-
       dtlist_taxisInqTimestep(dtlist, taxisID1, tsID);
 
-      vars[tsID] = field_malloc(vlistID1, FIELD_NONE);
-
       for ( recID = 0; recID < nrecs; recID++ )
 	{
 	  streamInqRecord(streamID1, &varID, &levelID);
-	  gridID   = vlistInqVarGrid(vlistID1, varID);
-	  gridsize = gridInqSize(gridID);
-	  vars[tsID][varID][levelID].ptr = (double*) malloc(gridsize*sizeof(double));
-	  streamReadRecord(streamID1, vars[tsID][varID][levelID].ptr, &nmiss);
-	  vars[tsID][varID][levelID].nmiss = nmiss;
+	  streamReadRecord(streamID1, array, &nmiss);
+	  tstore_put_field(store, tsID, varID, levelID, array, nmiss);
 	}
 
       tsID++;
@@ -133,45 +118,33 @@ void *Detrend(void *argument)
 
   nts = tsID;
 
-  ompmem = (memory_t*) malloc(ompNumThreads*sizeof(memory_t));
-  for ( i = 0; i < ompNumThreads; i++ )
-    {
-      ompmem[i].array1 = (double*) malloc(nts*sizeof(double));
-      ompmem[i].array2 = (double*) malloc(nts*sizeof(double));
-    }
-
   for ( varID = 0; varID < nvars; varID++ )
     {
       gridID   = vlistInqVarGrid(vlistID1, varID);
       missval  = vlistInqVarMissval(vlistID1, varID);
       gridsize = gridInqSize(gridID);
       nlevel   = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+      npoints  = tstore_tilesize(store, varID);
+      tile     = (double*) malloc(npoints*nts*sizeof(double));
+
       for ( levelID = 0; levelID < nlevel; levelID++ )
-	{
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(i, tsID)
-#endif
-	  for ( i = 0; i < gridsize; i++ )
-	    {
-              int ompthID = cdo_omp_get_thread_num();
+	for ( first = 0; first < gridsize; first += npoints )
+	  {
+	    nblk = gridsize - first < npoints ? gridsize - first : npoints;
 
-	      for ( tsID = 0; tsID < nts; tsID++ )
-		ompmem[ompthID].array1[tsID] = vars[tsID][varID][levelID].ptr[i];
+	    tstore_get_tile(store, varID, levelID, first, nblk, tile);
 
-	      detrend(nts, missval, ompmem[ompthID].array1, ompmem[ompthID].array2);
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) private(i)
+#endif
+	    for ( i = 0; i < nblk; i++ )
+	      detrend(nts, missval, tile+i*nts, tile+i*nts);
 
-	      for ( tsID = 0; tsID < nts; tsID++ )
-		vars[tsID][varID][levelID].ptr[i] = ompmem[ompthID].array2[tsID];
-	    }
-	}
-    }
+	    tstore_put_tile(store, varID, levelID, first, nblk, tile);
+	  }
 
-  for ( i = 0; i < ompNumThreads; i++ )
-    {
-      free(ompmem[i].array1);
-      free(ompmem[i].array2);
+      free(tile);
     }
-  free(ompmem);
 
   for ( tsID = 0; tsID < nts; tsID++ )
     {
@@ -183,21 +156,20 @@ void *Detrend(void *argument)
 	  nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
 	  for ( levelID = 0; levelID < nlevel; levelID++ )
 	    {
-	      if ( vars[tsID][varID][levelID].ptr )
+	      nmiss = tstore_inq_nmiss(store, tsID, varID, levelID);
+	      if ( nmiss >= 0 )
 		{
-		  nmiss = vars[tsID][varID][levelID].nmiss;
+		  tstore_get_field(store, tsID, varID, levelID, array);
 		  streamDefRecord(streamID2, varID, levelID);
-		  streamWriteRecord(streamID2, vars[tsID][varID][levelID].ptr, nmiss);
-		  free(vars[tsID][varID][levelID].ptr);
-		  vars[tsID][varID][levelID].ptr = NULL;
+		  streamWriteRecord(streamID2, array, nmiss);
 		}
 	    }
 	}
-
-      field_free(vars[tsID], vlistID1);
     }
 
-  if ( vars  ) free(vars);
+  tstore_delete(store);
+
+  free(array);
 
   dtlist_delete(dtlist);
 
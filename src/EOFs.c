@@ -42,6 +42,9 @@
 
 // NO MISSING VALUE SUPPORT ADDED SO FAR
 
+/* number of timesteps per covariance update in grid space */
+#define  NPANEL  32
+
 static
 void scale_eigvec_grid(double *restrict out, int tsID, int npack, const int *restrict pack, const double *restrict weight, double **covar, double sum_w)
 {
@@ -114,17 +117,20 @@ enum T_EIGEN_MODE get_eigenmode(void)
 	eigen_mode = DANIELSON_LANCZOS;
       else if ( !strncmp(envstr, "jacobi", 6) )
 	eigen_mode = JACOBI;
+      else if ( !strncmp(envstr, "lanczos", 7) )
+	eigen_mode = LANCZOS;
       else
 	{
 	  cdoWarning("Unknown environmental setting %s for CDO_SVD_MODE. Available options are", envstr);
 	  cdoWarning("  - 'jacobi' for a one-sided parallelized jacobi algorithm");
 	  cdoWarning("  - 'danielson_lanzcos' for the D/L algorithm");
+	  cdoWarning("  - 'lanczos' for a Lanczos iteration of the requested eigenvalues only");
 	}
     }
 
   if ( cdoVerbose ) 
     cdoPrint("Using CDO_SVD_MODE '%s' from %s",
-	     eigen_mode==JACOBI?"jacobi":"danielson_lanczos",
+	     eigen_mode==JACOBI?"jacobi":eigen_mode==LANCZOS?"lanczos":"danielson_lanczos",
 	     envstr?"Environment":" default");  
 
 #if defined(_OPENMP)
@@ -180,7 +186,6 @@ void *EOFs(void * argument)
   int calendar = CALENDAR_STANDARD;
   juldate_t juldate;
 
-  double sum;
   double missval = 0;
   double xvals, yvals;
 
@@ -191,6 +196,9 @@ void *EOFs(void * argument)
     double *covar_array;
     double **covar;
     double **data;
+    double *panel_array;
+    double **panel;
+    int npanel;
   }
   eofdata_t;
 
@@ -344,6 +352,9 @@ void *EOFs(void * argument)
 	  eofdata[varID][levelID].covar_array = NULL;
 	  eofdata[varID][levelID].covar = NULL;
 	  eofdata[varID][levelID].data = NULL;
+	  eofdata[varID][levelID].panel_array = NULL;
+	  eofdata[varID][levelID].panel = NULL;
+	  eofdata[varID][levelID].npanel = 0;
 
 	  if ( time_space )
 	    eofdata[varID][levelID].data = (double **) malloc(nts*sizeof(double *));
@@ -378,7 +389,7 @@ void *EOFs(void * argument)
 	      npack = 0;
 	      for ( i = 0; i < gridsize; ++i )
 		{
-		  if ( !DBL_IS_EQUAL(weight[i], 0) && !DBL_IS_EQUAL(weight[i], missval) &&
+		  if ( !DBL_IS_EQUAL(weight[i], 0.) && !DBL_IS_EQUAL(weight[i], missval) &&
 		       !DBL_IS_EQUAL(in[i], missval) )
 		    pack[npack++] = i;
 		}
@@ -393,7 +404,7 @@ void *EOFs(void * argument)
 	  ipack = 0;
 	  for ( i = 0; i < gridsize; ++i )
 	    {
-	      if ( !DBL_IS_EQUAL(weight[i], 0) && !DBL_IS_EQUAL(weight[i], missval) &&
+	      if ( !DBL_IS_EQUAL(weight[i], 0.) && !DBL_IS_EQUAL(weight[i], missval) &&
 		   !DBL_IS_EQUAL(in[i], missval) && pack[ipack++] != i )
 		{
 		  cdoAbort("Missing values unsupported!");
@@ -419,18 +430,24 @@ void *EOFs(void * argument)
 
 		  eofdata[varID][levelID].covar_array = covar_array;
 		  eofdata[varID][levelID].covar       = covar;
+
+		  double *panel_array = (double *) malloc(NPANEL*npack*sizeof(double));
+		  double **panel = (double **) malloc(NPANEL*sizeof(double *));
+		  for ( i = 0; i < NPANEL; ++i ) panel[i] = panel_array + npack*i;
+
+		  eofdata[varID][levelID].panel_array = panel_array;
+		  eofdata[varID][levelID].panel       = panel;
 		}
-	      else
-		{
-		  covar = eofdata[varID][levelID].covar;
-		}
-#if defined(_OPENMP)
-#pragma omp parallel for private(ipack, jpack) default(shared)
-#endif
-	      for ( ipack = 0; ipack < npack; ++ipack )
+
+	      /* the timesteps are collected in a panel, the covariance is updated once per panel */
+	      double *data = eofdata[varID][levelID].panel[eofdata[varID][levelID].npanel++];
+	      for ( ipack = 0; ipack < npack; ipack++ )
+		data[ipack] = in[pack[ipack]];
+
+	      if ( eofdata[varID][levelID].npanel == NPANEL )
 		{
-		  for ( jpack = ipack; jpack < npack; ++jpack )
-		    covar[ipack][jpack] += in[pack[ipack]] * in[pack[jpack]];
+		  covar_panel_update(eofdata[varID][levelID].covar, npack, eofdata[varID][levelID].panel, NPANEL);
+		  eofdata[varID][levelID].npanel = 0;
 		}
 	    }
           else if ( time_space )
@@ -542,6 +559,9 @@ void *EOFs(void * argument)
 
 		      covar = eofdata[varID][levelID].covar;
 
+		      if ( eofdata[varID][levelID].npanel )
+			covar_panel_update(covar, npack, eofdata[varID][levelID].panel, eofdata[varID][levelID].npanel);
+
 		      for ( ipack = 0; ipack < npack; ++ipack )
 			{
 			  i = pack[ipack];
@@ -576,21 +596,17 @@ void *EOFs(void * argument)
 		      eofdata[varID][levelID].covar_array = covar_array;
 		      eofdata[varID][levelID].covar       = covar;
 
-#if defined(_OPENMP)
-#pragma omp parallel for private(j1, j2, i, sum) default(shared) schedule(dynamic)
-#endif
+		      double *wpack = (double *) malloc(npack*sizeof(double));
+		      for ( i = 0; i < npack; i++ ) wpack[i] = weight[pack[i]];
+
+		      weighted_gram_matrix(covar, data, wpack, nts, npack);
+
+		      free(wpack);
+
 		      for ( j1 = 0; j1 < nts; j1++ )
 			{
 			  for ( j2 = 0; j2 < j1; j2++ ) covar[j1][j2] = covar[j2][j1];
-			  for ( j2 = j1; j2 < nts; j2++ )
-			    {
-			      sum = 0;
-			      double *df1p = data[j1];
-			      double *df2p = data[j2];
-			      for ( i = 0; i < npack; i++ )
-				sum += weight[pack[i]]*df1p[i]*df2p[i];
-			      covar[j1][j2] = sum / sum_w / nts;
-			    }
+			  for ( j2 = j1; j2 < nts; j2++ ) covar[j1][j2] = covar[j1][j2] / sum_w / nts;
 			}
 		      
 		      if ( cdoVerbose )
@@ -605,6 +621,12 @@ void *EOFs(void * argument)
 		  if ( eigen_mode == JACOBI ) 
 		    // TODO: use return status (>0 okay, -1 did not converge at all) 
 		    parallel_eigen_solution_of_symmetric_matrix(covar, eig_val, n, __func__);
+		  else if ( eigen_mode == LANCZOS )
+		    {
+		      /* only the first n_eig eigenvalues are computed, the others are missing */
+		      truncated_eigen_solution_of_symmetric_matrix(covar, eig_val, n, n_eig, __func__);
+		      for ( i = n_eig; i < n; i++ ) eig_val[i] = missval;
+		    }
 		  else 
 		    eigen_solution_of_symmetric_matrix(covar, eig_val, n, __func__);
 
@@ -650,6 +672,8 @@ void *EOFs(void * argument)
 	  if ( eofdata[varID][levelID].eig_val ) free(eofdata[varID][levelID].eig_val);
 	  if ( eofdata[varID][levelID].covar_array ) free(eofdata[varID][levelID].covar_array);
 	  if ( eofdata[varID][levelID].covar ) free(eofdata[varID][levelID].covar);
+	  if ( eofdata[varID][levelID].panel_array ) free(eofdata[varID][levelID].panel_array);
+	  if ( eofdata[varID][levelID].panel ) free(eofdata[varID][levelID].panel);
 	  if ( time_space && eofdata[varID][levelID].data )
 	    {
 	      for ( tsID = 0; tsID < nts; tsID++ )
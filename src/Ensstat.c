@@ -30,12 +30,540 @@
       Ensstat    enspctl         Ensemble percentiles
 */
 
+/*
+  The moment based statistics (min, max, sum, mean, avg, var, std) are accumulated
+  member by member into contiguous fields. For records with at least ENS_PREFETCH_MIN
+  values the next member is read by a reader thread while the current one is
+  accumulated. The results are the same as with fldfun() on the gathered members
+  of a gridpoint. Only the percentiles need all members of a gridpoint.
+
+  With more than CDO_ENSSTAT_GROUP members the files are opened, read and closed
+  in groups of this size. The partial moments of all timesteps (or the members
+  for the percentiles) are kept in a time series store between the groups, its
+  memory is limited by CDO_TSTORE_MEMORY.
+*/
+
+#if defined(HAVE_CONFIG_H)
+#  include "config.h"
+#endif
 
 #include <cdi.h>
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
 #include "util.h"
+#include "par_io.h"
+#include "tstore.h"
+#include "thread_pool.h"
+
+/* minimum record size for reading the next member in the background */
+#define  ENS_PREFETCH_MIN  16384
+
+
+typedef struct
+{
+  double *count;  /* number of valid members */
+  double *sum;
+  double *sumq;
+  double *ext;    /* minimum/maximum of all members */
+  double *vext;   /* minimum/maximum of the valid members */
+} ens_moments_t;
+
+
+static
+void ens_moments_init(ens_moments_t *em, int operfunc, long len, const double *array)
+{
+  long i;
+
+  for ( i = 0; i < len; ++i ) em->count[i] = 0;
+
+  if ( operfunc == func_min || operfunc == func_max )
+    {
+      double rinit = operfunc == func_min ? DBL_MAX : -DBL_MAX;
+      for ( i = 0; i < len; ++i ) em->ext[i]  = array[i];
+      for ( i = 0; i < len; ++i ) em->vext[i] = rinit;
+    }
+  else
+    {
+      for ( i = 0; i < len; ++i ) em->sum[i] = 0;
+      if ( em->sumq ) for ( i = 0; i < len; ++i ) em->sumq[i] = 0;
+    }
+}
+
+/*
+  Adds one member. A value is missing if DBL_IS_EQUAL(array[i], missval), the NaN case
+  is decided once per array. Adding 0 for a missing value gives the same sum as
+  skipping it, the sum starts with +0.
+*/
+static
+void ens_moments_add(ens_moments_t *em, int operfunc, long len, const double *restrict array, double missval)
+{
+  long i;
+  const int lnan = DBL_IS_NAN(missval);
+  double *restrict count = em->count;
+
+  if ( operfunc == func_min || operfunc == func_max )
+    {
+      double *restrict ext  = em->ext;
+      double *restrict vext = em->vext;
+
+      if ( operfunc == func_min )
+        {
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static) if ( len > 100000 )
+#endif
+          for ( i = 0; i < len; ++i )
+            {
+              double v = array[i];
+              int valid = !((v == missval) | (lnan & (v != v)));
+              count[i] += valid;
+              ext[i]  = v < ext[i] ? v : ext[i];
+              vext[i] = (valid & (v < vext[i])) ? v : vext[i];
+            }
+        }
+      else
+        {
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static) if ( len > 100000 )
+#endif
+          for ( i = 0; i < len; ++i )
+            {
+              double v = array[i];
+              int valid = !((v == missval) | (lnan & (v != v)));
+              count[i] += valid;
+              ext[i]  = v > ext[i] ? v : ext[i];
+              vext[i] = (valid & (v > vext[i])) ? v : vext[i];
+            }
+        }
+    }
+  else if ( em->sumq )
+    {
+      double *restrict sum  = em->sum;
+      double *restrict sumq = em->sumq;
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static) if ( len > 100000 )
+#endif
+      for ( i = 0; i < len; ++i )
+        {
+          double v = array[i];
+          int valid = !((v == missval) | (lnan & (v != v)));
+          count[i] += valid;
+          sum[i]  += valid ? v : 0.;
+          sumq[i] += valid ? v*v : 0.;
+        }
+    }
+  else
+    {
+      double *restrict sum = em->sum;
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static) if ( len > 100000 )
+#endif
+      for ( i = 0; i < len; ++i )
+        {
+          double v = array[i];
+          int valid = !((v == missval) | (lnan & (v != v)));
+          count[i] += valid;
+          sum[i] += valid ? v : 0.;
+        }
+    }
+}
+
+/*
+  Computes the statistic from the moments like fldfun() with unit weights,
+  the number of missing values of the result is returned.
+*/
+static
+int ens_moments_result(const ens_moments_t *em, int operfunc, long len, int nfiles, double missval, double *array2)
+{
+  long i;
+  int nmiss = 0;
+  const double missval1 = missval;
+  const double missval2 = missval;
+  const double *count = em->count;
+  const double rinit = operfunc == func_min ? DBL_MAX : -DBL_MAX;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) reduction(+:nmiss) if ( len > 100000 )
+#endif
+  for ( i = 0; i < len; ++i )
+    {
+      double n = count[i];
+      double rval, rvar;
+      int lmiss = n < nfiles;
+
+      if ( operfunc == func_min || operfunc == func_max )
+        {
+          if ( !lmiss )
+            rval = em->ext[i];
+          else
+            rval = IS_EQUAL(em->vext[i], rinit) ? missval : em->vext[i];
+        }
+      else if ( operfunc == func_sum )
+        {
+          rval = n > 0 ? em->sum[i] : missval;
+        }
+      else if ( operfunc == func_mean )
+        {
+          rval = FDIV(em->sum[i], n);
+        }
+      else if ( operfunc == func_avg )
+        {
+          rval = lmiss ? missval : FDIV(em->sum[i], n);
+        }
+      else
+        {
+          double sum = em->sum[i], sumq = em->sumq[i];
+
+          if ( operfunc == func_var || operfunc == func_std )
+            rvar = IS_NOT_EQUAL(n, 0) ? (sumq*n - sum*sum) / (n*n) : missval;
+          else
+            rvar = (n*n > n) ? (sumq*n - sum*sum) / (n*n - n) : missval;
+          if ( rvar < 0 && rvar > -1.e-5 ) rvar = 0;
+
+          if ( operfunc == func_var || operfunc == func_var1 )
+            rval = rvar;
+          else if ( DBL_IS_EQUAL(rvar, missval) || rvar < 0 )
+            rval = missval;
+          else
+            rval = IS_NOT_EQUAL(rvar, 0) ? sqrt(rvar) : 0;
+        }
+
+      array2[i] = rval;
+      if ( DBL_IS_EQUAL(rval, missval) ) nmiss++;
+    }
+
+  return (nmiss);
+}
+
+/* the components of the moments, count first */
+static
+int ens_moments_comps(ens_moments_t *em, double *comp[3])
+{
+  int ncomp = 0;
+
+  comp[ncomp++] = em->count;
+  if ( em->sum  ) comp[ncomp++] = em->sum;
+  if ( em->sumq ) comp[ncomp++] = em->sumq;
+  if ( em->ext  ) comp[ncomp++] = em->ext;
+  if ( em->vext ) comp[ncomp++] = em->vext;
+
+  return (ncomp);
+}
+
+/* component c of variable varID is the variable c*nvars+varID of the state store */
+static
+void ens_moments_put(ens_moments_t *em, tstore_t *state, int nvars, int tsID, int varID, int levelID)
+{
+  int c, ncomp;
+  double *comp[3];
+
+  ncomp = ens_moments_comps(em, comp);
+  for ( c = 0; c < ncomp; ++c )
+    tstore_put_field(state, tsID, c*nvars+varID, levelID, comp[c], 0);
+}
+
+static
+void ens_moments_get(ens_moments_t *em, tstore_t *state, int nvars, int tsID, int varID, int levelID)
+{
+  int c, ncomp;
+  double *comp[3];
+
+  ncomp = ens_moments_comps(em, comp);
+  for ( c = 0; c < ncomp; ++c )
+    tstore_get_field(state, tsID, c*nvars+varID, levelID, comp[c]);
+}
+
+typedef struct
+{
+  int streamID;
+  int vlistID;
+  double *array;
+} ens_file_t;
+
+static
+void ens_read_job(void *arg)
+{
+  readRecord(arg);
+}
+
+/*
+  Reads the current record of all members and accumulates the moments. With a
+  reader pool and large records member fileID+1 is read while member fileID is
+  added. If state is not NULL the moments of the previous members are taken from
+  the state store.
+*/
+static
+void ens_moments_record(const ens_file_t *ef, int nfiles, int operfunc, ens_moments_t *em, double *buffer[2],
+                        threadpool_t *reader, tstore_t *state, int nvars, int tsID,
+                        int *varID, int *levelID, long *gridsize, double *missval)
+{
+  int fileID, cur, nxt, prefetch;
+  int varIDs[2], levelIDs[2], nmiss[2];
+  int done = TRUE;
+  read_arg_t read_arg[2];
+
+  for ( cur = 0; cur < 2; ++cur )
+    {
+      read_arg[cur].varID   = &varIDs[cur];
+      read_arg[cur].levelID = &levelIDs[cur];
+      read_arg[cur].nmiss   = &nmiss[cur];
+      read_arg[cur].array   = buffer[cur];
+    }
+
+  read_arg[0].streamID = ef[0].streamID;
+  readRecord(&read_arg[0]);
+
+  *varID    = varIDs[0];
+  *levelID  = levelIDs[0];
+  *gridsize = gridInqSize(vlistInqVarGrid(ef[0].vlistID, *varID));
+  *missval  = vlistInqVarMissval(ef[0].vlistID, *varID);
+
+  prefetch = reader != NULL && *gridsize >= ENS_PREFETCH_MIN;
+
+  for ( fileID = 0; fileID < nfiles; fileID++ )
+    {
+      cur = fileID%2;
+      nxt = 1 - cur;
+
+      if ( fileID > 0 && !prefetch )
+        {
+          read_arg[cur].streamID = ef[fileID].streamID;
+          readRecord(&read_arg[cur]);
+        }
+
+      if ( fileID+1 < nfiles && prefetch )
+        {
+          read_arg[nxt].streamID = ef[fileID+1].streamID;
+          threadPoolSubmit(reader, ens_read_job, &read_arg[nxt], &done);
+        }
+
+      if ( fileID == 0 )
+        {
+          if ( state )
+            ens_moments_get(em, state, nvars, tsID, *varID, *levelID);
+          else
+            ens_moments_init(em, operfunc, *gridsize, buffer[cur]);
+        }
+      ens_moments_add(em, operfunc, *gridsize, buffer[cur], *missval);
+
+      if ( fileID+1 < nfiles && prefetch ) threadPoolWait(reader, &done);
+    }
+}
+
+/*
+  Percentiles of the current record from the members in the state store,
+  the gridpoints are processed in blocks with all members.
+*/
+static
+int ens_pctl_record(tstore_t *state, int nfiles, int tsID, int varID, int levelID, long gridsize, double missval,
+                    int pn, field_t *field, double *array2, double *count2)
+{
+  long i, first, nblk;
+  int fileID;
+  int nmiss = 0;
+  long blksize = tstore_blocksize(state, varID, nfiles);
+  double *block = (double *) malloc(blksize*nfiles*sizeof(double));
+
+  for ( first = 0; first < gridsize; first += blksize )
+    {
+      nblk = gridsize - first < blksize ? gridsize - first : blksize;
+
+      tstore_get_block(state, tsID*nfiles, nfiles, varID, levelID, first, nblk, block);
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) private(i, fileID)
+#endif
+      for ( i = 0; i < nblk; i++ )
+	{
+	  int ompthID = cdo_omp_get_thread_num();
+
+	  field[ompthID].missval = missval;
+	  field[ompthID].nmiss = 0;
+	  for ( fileID = 0; fileID < nfiles; fileID++ )
+	    {
+	      field[ompthID].ptr[fileID] = block[i*nfiles+fileID];
+	      if ( DBL_IS_EQUAL(field[ompthID].ptr[fileID], missval) )
+		field[ompthID].nmiss++;
+	    }
+
+	  array2[first+i] = fldpctl(field[ompthID], pn);
+
+	  if ( DBL_IS_EQUAL(array2[first+i], field[ompthID].missval) )
+	    {
+#if defined(_OPENMP)
+#include "pragma_omp_atomic_update.h"
+#endif
+	      nmiss++;
+	    }
+
+	  if ( count2 ) count2[first+i] = nfiles - field[ompthID].nmiss;
+	}
+    }
+
+  free(block);
+
+  return (nmiss);
+}
+
+/*
+  Processes the members in groups of ngroup files, the first group is already open.
+  The moments (or all members for the percentiles, at step tsID*nfiles+fileID) are
+  collected in a time series store, the result is written after the last group.
+*/
+static
+void ens_groups(ens_file_t *ef, int nfiles, int ngroup, int operfunc, int pn, int vlistID1, int streamID2, int taxisID2,
+                ens_moments_t *em, double *buffer[2], threadpool_t *reader, field_t *field, double *array2, double *count2)
+{
+  int fileID, fileID0, nf;
+  int tsID, recID, nrecs, nrecs0;
+  int varID, levelID, nmiss;
+  int c, ncomp;
+  long gridsize;
+  double missval;
+  double *comp[3];
+  int lpctl = operfunc == func_pctl;
+  int nvars = vlistNvars(vlistID1);
+  int vlistIDs = vlistID1;
+  int nts = 0, nrecsall = 0;
+  int *recfirst = NULL, *recVarID = NULL, *recLevelID = NULL;
+  dtlist_type *dtlist = dtlist_new();
+
+  /* the state store has a variable for each component of the moments */
+  if ( !lpctl )
+    {
+      vlistIDs = vlistDuplicate(vlistID1);
+      ncomp = ens_moments_comps(em, comp);
+      for ( c = 1; c < ncomp; ++c )
+	for ( varID = 0; varID < nvars; ++varID )
+	  vlistDefVar(vlistIDs, vlistInqVarGrid(vlistID1, varID), vlistInqVarZaxis(vlistID1, varID), TSTEP_INSTANT);
+    }
+
+  tstore_t *state = tstore_new(vlistIDs);
+
+  for ( fileID0 = 0; fileID0 < nfiles; fileID0 += ngroup )
+    {
+      nf = nfiles - fileID0 < ngroup ? nfiles - fileID0 : ngroup;
+
+      if ( cdoVerbose ) cdoPrint("Process ensemble members %d to %d.", fileID0+1, fileID0+nf);
+
+      if ( fileID0 > 0 )
+	for ( fileID = fileID0; fileID < fileID0+nf; fileID++ )
+	  {
+	    ef[fileID].streamID = streamOpenRead(cdoStreamName(fileID));
+	    ef[fileID].vlistID  = streamInqVlist(ef[fileID].streamID);
+	    vlistCompare(vlistID1, ef[fileID].vlistID, CMP_ALL);
+	  }
+
+      for ( tsID = 0; ; tsID++ )
+	{
+	  nrecs0 = streamInqTimestep(ef[fileID0].streamID, tsID);
+	  if ( fileID0 > 0 && nrecs0 != (tsID < nts ? recfirst[tsID+1] - recfirst[tsID] : 0) )
+	    {
+	      if ( nrecs0 == 0 )
+		cdoAbort("Inconsistent ensemble file, too few time steps in %s!", cdoStreamName(fileID0)->args);
+	      else
+		cdoAbort("Inconsistent ensemble file, number of records at time step %d of %s and %s differ!",
+			 tsID+1, cdoStreamName(0)->args, cdoStreamName(fileID0)->args);
+	    }
+
+	  for ( fileID = fileID0+1; fileID < fileID0+nf; fileID++ )
+	    {
+	      nrecs = streamInqTimestep(ef[fileID].streamID, tsID);
+	      if ( nrecs != nrecs0 )
+		{
+		  if ( nrecs == 0 )
+		    cdoAbort("Inconsistent ensemble file, too few time steps in %s!", cdoStreamName(fileID)->args);
+		  else
+		    cdoAbort("Inconsistent ensemble file, number of records at time step %d of %s and %s differ!",
+			     tsID+1, cdoStreamName(0)->args, cdoStreamName(fileID)->args);
+		}
+	    }
+
+	  if ( nrecs0 == 0 ) break;
+
+	  if ( fileID0 == 0 )
+	    {
+	      dtlist_taxisInqTimestep(dtlist, vlistInqTaxis(ef[0].vlistID), tsID);
+	      nts++;
+	      recfirst   = (int *) realloc(recfirst, (nts+1)*sizeof(int));
+	      recVarID   = (int *) realloc(recVarID, (nrecsall+nrecs0)*sizeof(int));
+	      recLevelID = (int *) realloc(recLevelID, (nrecsall+nrecs0)*sizeof(int));
+	      recfirst[tsID]   = nrecsall;
+	      recfirst[tsID+1] = nrecsall + nrecs0;
+	    }
+
+	  for ( recID = 0; recID < nrecs0; recID++ )
+	    {
+	      if ( lpctl )
+		{
+		  for ( fileID = fileID0; fileID < fileID0+nf; fileID++ )
+		    {
+		      streamInqRecord(ef[fileID].streamID, &varID, &levelID);
+		      streamReadRecord(ef[fileID].streamID, buffer[0], &nmiss);
+		      tstore_put_field(state, tsID*nfiles+fileID, varID, levelID, buffer[0], nmiss);
+		    }
+		}
+	      else
+		{
+		  ens_moments_record(ef+fileID0, nf, operfunc, em, buffer, reader, fileID0 > 0 ? state : NULL, nvars, tsID,
+				     &varID, &levelID, &gridsize, &missval);
+		  ens_moments_put(em, state, nvars, tsID, varID, levelID);
+		}
+
+	      if ( fileID0 == 0 )
+		{
+		  recVarID[nrecsall]   = varID;
+		  recLevelID[nrecsall] = levelID;
+		  nrecsall++;
+		}
+	    }
+	}
+
+      for ( fileID = fileID0; fileID < fileID0+nf; fileID++ )
+	streamClose(ef[fileID].streamID);
+    }
+
+  for ( tsID = 0; tsID < nts; tsID++ )
+    {
+      dtlist_taxisDefTimestep(dtlist, taxisID2, tsID);
+      streamDefTimestep(streamID2, tsID);
+
+      for ( recID = recfirst[tsID]; recID < recfirst[tsID+1]; recID++ )
+	{
+	  varID    = recVarID[recID];
+	  levelID  = recLevelID[recID];
+	  gridsize = gridInqSize(vlistInqVarGrid(vlistID1, varID));
+	  missval  = vlistInqVarMissval(vlistID1, varID);
+
+	  if ( lpctl )
+	    {
+	      nmiss = ens_pctl_record(state, nfiles, tsID, varID, levelID, gridsize, missval, pn, field, array2, count2);
+	    }
+	  else
+	    {
+	      ens_moments_get(em, state, nvars, tsID, varID, levelID);
+	      nmiss = ens_moments_result(em, operfunc, gridsize, nfiles, missval, array2);
+	    }
+
+	  streamDefRecord(streamID2, varID, levelID);
+	  streamWriteRecord(streamID2, array2, nmiss);
+
+	  if ( count2 )
+	    {
+	      streamDefRecord(streamID2, varID+nvars, levelID);
+	      streamWriteRecord(streamID2, lpctl ? count2 : em->count, 0);
+	    }
+	}
+    }
+
+  tstore_delete(state);
+  if ( vlistIDs != vlistID1 ) vlistDestroy(vlistIDs);
+  dtlist_delete(dtlist);
+
+  if ( recfirst   ) free(recfirst);
+  if ( recVarID   ) free(recVarID);
+  if ( recLevelID ) free(recLevelID);
+}
 
 
 void *Ensstat(void *argument)
@@ -49,12 +577,6 @@ void *Ensstat(void *argument)
   int nmiss;
   int fileID;
   double missval;
-  typedef struct
-  {
-    int streamID;
-    int vlistID;
-    double *array;
-  } ens_file_t;
   int pn = 0;
 
   cdoInitialize(argument);
@@ -105,36 +627,69 @@ void *Ensstat(void *argument)
 
   ens_file_t *ef = (ens_file_t *) malloc(nfiles*sizeof(ens_file_t));
 
-  field_t *field = (field_t *) malloc(ompNumThreads*sizeof(field_t));
-  for ( i = 0; i < ompNumThreads; i++ )
+  field_t *field = NULL;
+  if ( operfunc == func_pctl )
     {
-      field_init(&field[i]);
-      field[i].size   = nfiles;
-      field[i].ptr    = (double*) malloc(nfiles*sizeof(double));
-      field[i].weight = (double*) malloc(nfiles*sizeof(double));
-      for ( fileID = 0; fileID < nfiles; fileID++ ) field[i].weight[fileID] = 1;
+      field = (field_t *) malloc(ompNumThreads*sizeof(field_t));
+      for ( i = 0; i < ompNumThreads; i++ )
+        {
+          field_init(&field[i]);
+          field[i].size   = nfiles;
+          field[i].ptr    = (double*) malloc(nfiles*sizeof(double));
+          field[i].weight = (double*) malloc(nfiles*sizeof(double));
+          for ( fileID = 0; fileID < nfiles; fileID++ ) field[i].weight[fileID] = 1;
+        }
     }
 
-  for ( fileID = 0; fileID < nfiles; fileID++ )
+  /* number of files open at the same time */
+  int ngroup = nfiles;
+  if ( CDO_Ensstat_Group > 0 && CDO_Ensstat_Group < nfiles ) ngroup = CDO_Ensstat_Group;
+
+  for ( fileID = 0; fileID < ngroup; fileID++ )
     {
       ef[fileID].streamID = streamOpenRead(cdoStreamName(fileID));
       ef[fileID].vlistID  = streamInqVlist(ef[fileID].streamID);
     }
 
   /* check that the contents is always the same */
-  for ( fileID = 1; fileID < nfiles; fileID++ )
+  for ( fileID = 1; fileID < ngroup; fileID++ )
     vlistCompare(ef[0].vlistID, ef[fileID].vlistID, CMP_ALL);
 
   int vlistID1 = ef[0].vlistID;
+  if ( ngroup < nfiles ) vlistID1 = vlistDuplicate(ef[0].vlistID);
   int vlistID2 = vlistDuplicate(vlistID1);
-  int taxisID1 = vlistInqTaxis(vlistID1);
+  int taxisID1 = vlistInqTaxis(ef[0].vlistID);
   int taxisID2 = taxisDuplicate(taxisID1);
   vlistDefTaxis(vlistID2, taxisID2);
 
   int gridsize = vlistGridsizeMax(vlistID1);
 
   for ( fileID = 0; fileID < nfiles; fileID++ )
-    ef[fileID].array = (double*) malloc(gridsize*sizeof(double));
+    ef[fileID].array = (operfunc == func_pctl && ngroup == nfiles) ? (double*) malloc(gridsize*sizeof(double)) : NULL;
+
+  ens_moments_t em;
+  double *buffer[2] = { NULL, NULL };
+  if ( operfunc != func_pctl || ngroup < nfiles )
+    {
+      buffer[0] = (double *) malloc(gridsize*sizeof(double));
+      buffer[1] = (double *) malloc(gridsize*sizeof(double));
+    }
+
+  /* one reader thread for the whole run, used only for large records */
+  threadpool_t *reader = NULL;
+  if ( operfunc != func_pctl && nfiles > 1 && gridsize >= ENS_PREFETCH_MIN ) reader = threadPoolNew(1);
+
+  if ( operfunc != func_pctl )
+    {
+      int lsumq = (operfunc == func_var || operfunc == func_var1 || operfunc == func_std || operfunc == func_std1);
+      int lext  = (operfunc == func_min || operfunc == func_max);
+
+      em.count = (double *) malloc(gridsize*sizeof(double));
+      em.sum   = lext  ? NULL : (double *) malloc(gridsize*sizeof(double));
+      em.sumq  = lsumq ? (double *) malloc(gridsize*sizeof(double)) : NULL;
+      em.ext   = lext  ? (double *) malloc(gridsize*sizeof(double)) : NULL;
+      em.vext  = lext  ? (double *) malloc(gridsize*sizeof(double)) : NULL;
+    }
 
   double *array2 = (double *) malloc(gridsize*sizeof(double));
 
@@ -162,96 +717,121 @@ void *Ensstat(void *argument)
 
   streamDefVlist(streamID2, vlistID2);
 
-  int tsID = 0;
-  do
+  if ( ngroup < nfiles )
     {
-      nrecs0 = streamInqTimestep(ef[0].streamID, tsID);
-      for ( fileID = 1; fileID < nfiles; fileID++ )
+      ens_groups(ef, nfiles, ngroup, operfunc, pn, vlistID1, streamID2, taxisID2,
+		 &em, buffer, reader, field, array2, count2);
+      vlistDestroy(vlistID1);
+    }
+  else
+    {
+      int tsID = 0;
+      do
 	{
-	  streamID = ef[fileID].streamID;
-	  nrecs = streamInqTimestep(streamID, tsID);
-	  if ( nrecs != nrecs0 )
+	  nrecs0 = streamInqTimestep(ef[0].streamID, tsID);
+	  for ( fileID = 1; fileID < nfiles; fileID++ )
 	    {
-	      if ( nrecs == 0 )
-		cdoAbort("Inconsistent ensemble file, too few time steps in %s!", cdoStreamName(fileID)->args);
-	      else
-		cdoAbort("Inconsistent ensemble file, number of records at time step %d of %s and %s differ!",
-			 tsID+1, cdoStreamName(0)->args, cdoStreamName(fileID)->args);
+	      streamID = ef[fileID].streamID;
+	      nrecs = streamInqTimestep(streamID, tsID);
+	      if ( nrecs != nrecs0 )
+		{
+		  if ( nrecs == 0 )
+		    cdoAbort("Inconsistent ensemble file, too few time steps in %s!", cdoStreamName(fileID)->args);
+		  else
+		    cdoAbort("Inconsistent ensemble file, number of records at time step %d of %s and %s differ!",
+			     tsID+1, cdoStreamName(0)->args, cdoStreamName(fileID)->args);
+		}
 	    }
-	}
-
-      if ( nrecs0 > 0 )
-	{
-	  taxisCopyTimestep(taxisID2, taxisID1);
-	  streamDefTimestep(streamID2, tsID);
-	}
 
-      for ( recID = 0; recID < nrecs0; recID++ )
-	{
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(fileID, streamID, nmiss) \
-                                     lastprivate(varID, levelID)
-#endif
-	  for ( fileID = 0; fileID < nfiles; fileID++ )
+	  if ( nrecs0 > 0 )
 	    {
-	      streamID = ef[fileID].streamID;
-	      streamInqRecord(streamID, &varID, &levelID);
-	      streamReadRecord(streamID, ef[fileID].array, &nmiss);
+	      taxisCopyTimestep(taxisID2, taxisID1);
+	      streamDefTimestep(streamID2, tsID);
 	    }
 
-	  gridID   = vlistInqVarGrid(vlistID1, varID);
-	  gridsize = gridInqSize(gridID);
-	  missval  = vlistInqVarMissval(vlistID1, varID);
-
-	  nmiss = 0;
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(i, fileID)
-#endif
-	  for ( i = 0; i < gridsize; i++ )
+	  for ( recID = 0; recID < nrecs0; recID++ )
 	    {
-	      int ompthID = cdo_omp_get_thread_num();
+	      if ( operfunc != func_pctl )
+		{
+		  long len;
+		  ens_moments_record(ef, nfiles, operfunc, &em, buffer, reader, NULL, 0, tsID, &varID, &levelID, &len, &missval);
+
+		  nmiss = ens_moments_result(&em, operfunc, len, nfiles, missval, array2);
+
+		  streamDefRecord(streamID2, varID, levelID);
+		  streamWriteRecord(streamID2, array2, nmiss);
 
-	      field[ompthID].missval = missval;
-	      field[ompthID].nmiss = 0;
+		  if ( count_data )
+		    {
+		      streamDefRecord(streamID2, varID+nvars, levelID);
+		      streamWriteRecord(streamID2, em.count, 0);
+		    }
+
+		  continue;
+		}
+
+    #if defined(_OPENMP)
+    #pragma omp parallel for default(shared) private(fileID, streamID, nmiss) \
+					 lastprivate(varID, levelID)
+    #endif
 	      for ( fileID = 0; fileID < nfiles; fileID++ )
 		{
-		  field[ompthID].ptr[fileID] = ef[fileID].array[i];
-		  if ( DBL_IS_EQUAL(field[ompthID].ptr[fileID], missval) )
-		    field[ompthID].nmiss++;
+		  streamID = ef[fileID].streamID;
+		  streamInqRecord(streamID, &varID, &levelID);
+		  streamReadRecord(streamID, ef[fileID].array, &nmiss);
 		}
 
-	      if ( operfunc == func_pctl )
-	        array2[i] = fldpctl(field[ompthID], pn);
-	      else  
-	        array2[i] = fldfun(field[ompthID], operfunc);
+	      gridID   = vlistInqVarGrid(vlistID1, varID);
+	      gridsize = gridInqSize(gridID);
+	      missval  = vlistInqVarMissval(vlistID1, varID);
 
-	      if ( DBL_IS_EQUAL(array2[i], field[ompthID].missval) )
+	      nmiss = 0;
+    #if defined(_OPENMP)
+    #pragma omp parallel for default(shared) private(i, fileID)
+    #endif
+	      for ( i = 0; i < gridsize; i++ )
 		{
-#if defined(_OPENMP)
-#include "pragma_omp_atomic_update.h"
-#endif
-		  nmiss++;
+		  int ompthID = cdo_omp_get_thread_num();
+
+		  field[ompthID].missval = missval;
+		  field[ompthID].nmiss = 0;
+		  for ( fileID = 0; fileID < nfiles; fileID++ )
+		    {
+		      field[ompthID].ptr[fileID] = ef[fileID].array[i];
+		      if ( DBL_IS_EQUAL(field[ompthID].ptr[fileID], missval) )
+			field[ompthID].nmiss++;
+		    }
+
+		  array2[i] = fldpctl(field[ompthID], pn);
+
+		  if ( DBL_IS_EQUAL(array2[i], field[ompthID].missval) )
+		    {
+    #if defined(_OPENMP)
+    #include "pragma_omp_atomic_update.h"
+    #endif
+		      nmiss++;
+		    }
+
+		  if ( count_data ) count2[i] = nfiles - field[ompthID].nmiss;
 		}
 
-	      if ( count_data ) count2[i] = nfiles - field[ompthID].nmiss;
-	    }
-
-	  streamDefRecord(streamID2, varID, levelID);
-	  streamWriteRecord(streamID2, array2, nmiss);
+	      streamDefRecord(streamID2, varID, levelID);
+	      streamWriteRecord(streamID2, array2, nmiss);
 
-	  if ( count_data )
-	    {
-	      streamDefRecord(streamID2, varID+nvars, levelID);
-	      streamWriteRecord(streamID2, count2, 0);
+	      if ( count_data )
+		{
+		  streamDefRecord(streamID2, varID+nvars, levelID);
+		  streamWriteRecord(streamID2, count2, 0);
+		}
 	    }
+
+	  tsID++;
 	}
+      while ( nrecs0 > 0 );
 
-      tsID++;
+      for ( fileID = 0; fileID < nfiles; fileID++ )
+	streamClose(ef[fileID].streamID);
     }
-  while ( nrecs0 > 0 );
-
-  for ( fileID = 0; fileID < nfiles; fileID++ )
-    streamClose(ef[fileID].streamID);
 
   streamClose(streamID2);
 
@@ -262,13 +842,29 @@ void *Ensstat(void *argument)
   if ( array2 ) free(array2);
   if ( count2 ) free(count2);
 
-  for ( i = 0; i < ompNumThreads; i++ )
+  if ( field )
     {
-      if ( field[i].ptr    ) free(field[i].ptr);
-      if ( field[i].weight ) free(field[i].weight);
+      for ( i = 0; i < ompNumThreads; i++ )
+        {
+          if ( field[i].ptr    ) free(field[i].ptr);
+          if ( field[i].weight ) free(field[i].weight);
+        }
+      free(field);
     }
 
-  if ( field ) free(field);
+  if ( operfunc != func_pctl )
+    {
+      free(em.count);
+      if ( em.sum  ) free(em.sum);
+      if ( em.sumq ) free(em.sumq);
+      if ( em.ext  ) free(em.ext);
+      if ( em.vext ) free(em.vext);
+    }
+
+  if ( buffer[0] ) free(buffer[0]);
+  if ( buffer[1] ) free(buffer[1]);
+
+  if ( reader ) threadPoolDelete(reader);
 
   cdoFinish();
 
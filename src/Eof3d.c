@@ -66,7 +66,7 @@ void *EOF3d(void * argument)
   double **cov = NULL;                                /* TODO: covariance matrix / eigenvectors after solving */
   double *eigv;
   double *xvals, *yvals, *zvals;
-  double *df1p, *df2p;
+  double *df1p;
 
 
   if ( cdoTimer )
@@ -273,7 +273,7 @@ void *EOF3d(void * argument)
       if ( weight_mode == WEIGHT_ON )
 	{
 	  sum_w = 0;
-	  for ( i = 0; i < npack; i++ )  sum_w += weight[pack[i]];
+	  for ( i = 0; i < npack; i++ )  sum_w += weight[pack[i]%gridsize];
 	}
 
       if ( npack < 1 ) {
@@ -295,19 +295,23 @@ void *EOF3d(void * argument)
       }
 
 
-#if defined(_OPENMP)
-#pragma omp parallel for private(j1,j2,sum,df1p,df2p) default(shared) schedule(static,2000)
-#endif 
-      for ( j1 = 0; j1 < nts; j1++)
+      /* pack the data in place, pack[i] >= i */
+      for ( j1 = 0; j1 < nts; j1++ )
+	{
+	  df1p = datafields[varID][j1];
+	  for ( i = 0; i < npack; i++ ) df1p[i] = df1p[pack[i]];
+	}
+
+      double *wpack = (double *) malloc(npack*sizeof(double));
+      for ( i = 0; i < npack; i++ ) wpack[i] = weight[pack[i]%gridsize];
+
+      weighted_gram_matrix(cov, datafields[varID], wpack, nts, npack);
+
+      free(wpack);
+
+      for ( j1 = 0; j1 < nts; j1++ )
 	for ( j2 = j1; j2 < nts; j2++ )
-	  {
-	    sum = 0;
-	    df1p = datafields[varID][j1];
-	    df2p = datafields[varID][j2];
-	    for ( i = 0; i < npack; i++ )
-	      sum += weight[pack[i]%gridsize]*df1p[pack[i]]*df2p[pack[i]];
-	    cov[j2][j1] = cov[j1][j2] = sum / sum_w / nts;
-	  }
+	  cov[j2][j1] = cov[j1][j2] = cov[j1][j2] / sum_w / nts;
       
       if ( cdoVerbose ) cdoPrint("calculated cov-matrix");
 
@@ -320,8 +324,15 @@ void *EOF3d(void * argument)
       if ( cdoVerbose ) 
 	cdoPrint("Processed correlation matrix for var %2i | npack: %4i",varID,n);
 
+      int neig = n;
       if ( eigen_mode == JACOBI ) 
 	parallel_eigen_solution_of_symmetric_matrix(cov, eigv, n, __func__);
+      else if ( eigen_mode == LANCZOS )
+	{
+	  /* only the first n_eig eigenvalues are computed, the others stay missing */
+	  truncated_eigen_solution_of_symmetric_matrix(cov, eigv, n, n_eig, __func__);
+	  neig = n_eig;
+	}
       else 
 	eigen_solution_of_symmetric_matrix(cov, eigv, n, __func__);
       /* NOW: cov contains the eigenvectors, eigv the eigenvalues */
@@ -329,7 +340,7 @@ void *EOF3d(void * argument)
       if ( cdoVerbose ) 
 	cdoPrint("Processed SVD decomposition for var %i from %i x %i matrix",varID,n,n);
 
-      for( eofID=0; eofID<n; eofID++ )
+      for( eofID=0; eofID<neig; eofID++ )
 	eigenvalues[varID][eofID][0] = eigv[eofID];
       
       if ( cdoTimer ) timer_stop(timer_eig);
@@ -345,7 +356,7 @@ void *EOF3d(void * argument)
 	    {
 	      sum = 0;
 	      for ( j = 0; j < nts; j++ )
-		sum += datafields[varID][j][pack[i]] * cov[eofID][j];
+		sum += datafields[varID][j][i] * cov[eofID][j];
 
 	      eigenvec[pack[i]] = sum;
 	    }
@@ -469,7 +480,7 @@ void *EOF3d(void * argument)
                   streamWriteRecord(streamID3, &eigenvectors[varID][tsID][offset], nmiss);
                 }
 	    }
-	  if ( DBL_IS_EQUAL(eigenvalues[varID][tsID][i], missval) ) nmiss = 1;
+	  if ( DBL_IS_EQUAL(eigenvalues[varID][tsID][0], missval) ) nmiss = 1;
 	  else nmiss = 0;
 	  streamDefRecord(streamID2, varID, 0);
 	  streamWriteRecord(streamID2, eigenvalues[varID][tsID],nmiss);
@@ -480,7 +491,7 @@ void *EOF3d(void * argument)
     {
       for( i = 0; i < nts; i++)
 	{
-	  free(datafields[varID][tsID]);
+	  free(datafields[varID][i]);
 	  if ( i < n_eig )
 	    free(eigenvectors[varID][i]);
 	  free(eigenvalues[varID][i]);
@@ -142,6 +142,7 @@ void *Expr(void *argument)
   parse_arg.gridID2  = -1;
   parse_arg.zaxisID2 = -1;
   parse_arg.tsteptype2  = -1;
+  parse_arg.plan     = NULL;
   for ( varID = 0; varID < nvars; varID++ )
     parse_arg.var_needed[varID] = FALSE;
 
@@ -238,8 +239,7 @@ void *Expr(void *argument)
 	  memset(parse_arg.vardata2[varID], 0, gridsize*nlevel*sizeof(double));
 	}
 
-      yy_scan_string(exprs, scanner);
-      yyparse(&parse_arg, scanner);
+      expr_plan_run(&parse_arg);
 
       for ( varID = 0; varID < nvars2; varID++ )
 	{
@@ -274,6 +274,8 @@ void *Expr(void *argument)
 
   yylex_destroy(scanner);
 
+  expr_plan_delete(parse_arg.plan);
+
   if ( array ) free(array);
   if ( exprs ) free(exprs);
 
@@ -20,6 +20,8 @@
 
 */
 
+#include <limits.h>  /* INT_MAX */
+
 #include <cdi.h>
 #include <cdi.h>
 #include "cdo.h"
@@ -28,19 +30,91 @@
 #include "grid.h"
 
 
+#define  NCOLBLK  64
+
+/*
+  Distance to the next valid point left (kl), right (kr), below (ko) and
+  above (ku) of each missing point, 0 if there is none. Each row and column
+  is swept once in both directions, the rows of global grids are cyclic.
+*/
+static
+void find_neighbours(long nx, long ny, int globgrid, const double *array, double missval,
+                     int *kl, int *kr, int *ko, int *ku)
+{
+  long i, j;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(nx, ny, globgrid, array, missval, kl, kr) private(i)
+#endif
+  for ( j = 0; j < ny; j++ )
+    {
+      const double *row = array + j*nx;
+      int *rkl = kl + j*nx, *rkr = kr + j*nx;
+      long first = -1, last = -1;
+      long prev, next;
+      int lprev, lnext;
+
+      for ( i = 0; i < nx; i++ )
+        if ( !DBL_IS_EQUAL(row[i], missval) ) { first = i; break; }
+
+      for ( i = nx-1; i >= 0; i-- )
+        if ( !DBL_IS_EQUAL(row[i], missval) ) { last = i; break; }
+
+      /* position of the last valid point left of i, wrapped below 0 */
+      lprev = globgrid && last >= 0;
+      prev  = last - nx;
+      for ( i = 0; i < nx; i++ )
+        {
+          if ( !DBL_IS_EQUAL(row[i], missval) ) { prev = i; lprev = TRUE; }
+          else rkl[i] = lprev ? i - prev : 0;
+        }
+
+      lnext = globgrid && first >= 0;
+      next  = first + nx;
+      for ( i = nx-1; i >= 0; i-- )
+        {
+          if ( !DBL_IS_EQUAL(row[i], missval) ) { next = i; lnext = TRUE; }
+          else rkr[i] = lnext ? next - i : 0;
+        }
+    }
+
+  /* the columns in blocks of NCOLBLK, so the sweeps run along the rows */
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(nx, ny, array, missval, ko, ku) private(i, j)
+#endif
+  for ( long ib = 0; ib < nx; ib += NCOLBLK )
+    {
+      long ie = ib + NCOLBLK < nx ? ib + NCOLBLK : nx;
+      long jpos[NCOLBLK];
+
+      for ( i = ib; i < ie; i++ ) jpos[i-ib] = -1;
+      for ( j = 0; j < ny; j++ )
+        for ( i = ib; i < ie; i++ )
+          {
+            if ( !DBL_IS_EQUAL(array[j*nx+i], missval) ) jpos[i-ib] = j;
+            else ko[j*nx+i] = jpos[i-ib] >= 0 ? j - jpos[i-ib] : 0;
+          }
+
+      for ( i = ib; i < ie; i++ ) jpos[i-ib] = -1;
+      for ( j = ny-1; j >= 0; j-- )
+        for ( i = ib; i < ie; i++ )
+          {
+            if ( !DBL_IS_EQUAL(array[j*nx+i], missval) ) jpos[i-ib] = j;
+            else ku[j*nx+i] = jpos[i-ib] >= 0 ? jpos[i-ib] - j : 0;
+          }
+    }
+}
+
+
 void fillmiss(field_t *field1, field_t *field2, int nfill)
 {
-  int gridID, nx, ny, i, j;
-  int nmiss1, nmiss2 = 0;
-  int kr, ku, kl, ko;
-  int ir, iu, il, io;
-  int kh, kv, k1, k2, kk;
+  int gridID, i, j;
+  long nx, ny;
+  long nmiss1, nmiss2 = 0;
   int globgrid = FALSE,gridtype;
-  double s1, s2;
-  double xr, xu, xl, xo;
   double missval;
   double *array1, *array2;
-  double **matrix1, **matrix2;
+  int *kl, *kr, *ko, *ku;
 
   gridID   = field1->grid;
   nmiss1   = field1->nmiss;
@@ -53,109 +127,79 @@ void fillmiss(field_t *field1, field_t *field2, int nfill)
   globgrid = gridIsCircular(gridID);
 
   gridtype = gridInqType(gridID);
-  if ( !(gridtype == GRID_LONLAT || gridtype == GRID_GAUSSIAN ) )
+  if ( !(gridtype == GRID_LONLAT || gridtype == GRID_GAUSSIAN || gridtype == GRID_CURVILINEAR) )
     cdoAbort("Unsupported grid type: %s!", gridNamePtr(gridtype));
 
-  matrix1 = (double **) malloc(ny * sizeof(double *));
-  matrix2 = (double **) malloc(ny * sizeof(double *));
+  kl = (int*) malloc(4*nx*ny*sizeof(int));
+  kr = kl + nx*ny;
+  ko = kr + nx*ny;
+  ku = ko + nx*ny;
 
-  for ( j = 0; j < ny; j++ )
-    {
-      matrix1[j] = array1 + j*nx;
-      matrix2[j] = array2 + j*nx;
-    }
+  find_neighbours(nx, ny, globgrid, array1, missval, kl, kr, ko, ku);
 
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(nx, ny, nfill, missval, array1, array2, kl, kr, ko, ku) \
+  private(i) reduction(+:nmiss2)
+#endif
   for ( j = 0; j < ny; j++ )
     for ( i = 0; i < nx; i++ )
       {
-	if ( DBL_IS_EQUAL(matrix1[j][i], missval) )
+        long ij = j*nx + i;
+        int kh, kv, k1, k2, kk;
+        double s1, s2;
+        double xr = 0, xu = 0, xl = 0, xo = 0;
+
+	if ( DBL_IS_EQUAL(array1[ij], missval) )
 	  {
 	    nmiss2++;
 
-	    kr = ku = kl = ko = 0;
-	    xr = xu = xl = xo = 0.;
-
-	    for ( ir = i + 1; ir < nx; ir++ )
-	      if ( !DBL_IS_EQUAL(matrix1[j][ir], missval) )
-		{ kr = ir - i; xr = matrix1[j][ir]; break; }
+	    if ( kr[ij] ) xr = array1[j*nx + (i+kr[ij])%nx];
+	    if ( kl[ij] ) xl = array1[j*nx + (i-kl[ij]+nx)%nx];
+	    if ( ku[ij] ) xu = array1[ij + ku[ij]*nx];
+	    if ( ko[ij] ) xo = array1[ij - ko[ij]*nx];
 
-	    if ( globgrid && ir == nx )
-	      {
-		for ( ir = 0; ir < i; ir++ )
-		  if ( !DBL_IS_EQUAL(matrix1[j][ir], missval) )
-		    { kr = nx + ir - i; xr = matrix1[j][ir]; break; }
-	      }
-
-	    for ( il = i-1; il >= 0; il-- )
-	      if ( !DBL_IS_EQUAL(matrix1[j][il], missval) )
-		{ kl = i - il; xl = matrix1[j][il]; break; }
-
-	    if ( globgrid && il == -1 )
-	      {
-		for ( il = nx-1; il > i; il-- )
-		  if ( !DBL_IS_EQUAL(matrix1[j][il], missval) )
-		    { kl = nx + i - il; xl = matrix1[j][il]; break; }
-	      }
-
-	    for ( iu = j + 1; iu < ny; iu++ )
-	      if ( !DBL_IS_EQUAL(matrix1[iu][i], missval) )
-		{ ku = iu - j; xu = matrix1[iu][i]; break; }
-	    
-	    for ( io = j - 1; io >= 0; io-- )
-	      if ( !DBL_IS_EQUAL(matrix1[io][i], missval) )
-		{ ko = j - io; xo = matrix1[io][i]; break; }
-	    
-	    /*  printf("%d %d %d %d %d %d %g %g %g %g\n", j,i,kr,kl,ku,ko,xr,xl,xu,xo);*/
-
-	    kh = kl + kr;
-	    kv = ko + ku;
+	    kh = kl[ij] + kr[ij];
+	    kv = ko[ij] + ku[ij];
 	    if      ( kh == 0 ) { s1 = 0.; k1 = 0; }
-	    else if ( kl == 0 ) { s1 = xr; k1 = 1; }
-	    else if ( kr == 0 ) { s1 = xl; k1 = 1; }
-	    else { s1 = xr*kl/kh + xl*kr/kh; k1 = 2; }
+	    else if ( kl[ij] == 0 ) { s1 = xr; k1 = 1; }
+	    else if ( kr[ij] == 0 ) { s1 = xl; k1 = 1; }
+	    else { s1 = xr*kl[ij]/kh + xl*kr[ij]/kh; k1 = 2; }
 
 	    if      ( kv == 0 ) { s2 = 0.; k2 = 0; }
-	    else if ( ku == 0 ) { s2 = xo; k2 = 1; }
-	    else if ( ko == 0 ) { s2 = xu; k2 = 1; }
-	    else { s2 = xu*ko/kv + xo*ku/kv; k2 = 2; }
+	    else if ( ku[ij] == 0 ) { s2 = xo; k2 = 1; }
+	    else if ( ko[ij] == 0 ) { s2 = xu; k2 = 1; }
+	    else { s2 = xu*ko[ij]/kv + xo*ku[ij]/kv; k2 = 2; }
 
 	    kk = k1 + k2;
 	    if ( kk >= nfill )
 	      {
 		if      ( kk == 0 ) cdoAbort("no point found!");
-		else if ( k1 == 0 ) matrix2[j][i] = s2;
-		else if ( k2 == 0 ) matrix2[j][i] = s1;
-		else  matrix2[j][i] = s1*k2/kk + s2*k1/kk;
+		else if ( k1 == 0 ) array2[ij] = s2;
+		else if ( k2 == 0 ) array2[ij] = s1;
+		else  array2[ij] = s1*k2/kk + s2*k1/kk;
 	      }
 	    else
-	      matrix2[j][i] = matrix1[j][i];
-
-	    /* matrix1[j][i] = matrix2[j][i]; */
+	      array2[ij] = array1[ij];
 	  }
 	else
 	  {
-	    matrix2[j][i] = matrix1[j][i];
+	    array2[ij] = array1[ij];
 	  }
       }
 
-  if ( nmiss1 != nmiss2 ) cdoAbort("found only %d of %d missing values!", nmiss2, nmiss1);
+  if ( nmiss1 != nmiss2 ) cdoAbort("found only %ld of %ld missing values!", nmiss2, nmiss1);
 
-  free(matrix2);
-  free(matrix1);
+  free(kl);
 }
 
 void fillmiss_one_step(field_t *field1, field_t *field2, int maxfill)
 {
-  int gridID, nx, ny, i, j;
-  int nmiss2 = 0;
-  int kr, ku, kl, ko;
-  int ir, iu, il, io;
-  int kh, kv, k1, k2, kk;
-  double s1, s2;
-  double xr, xu, xl, xo;
+  int gridID, i, j;
+  long nx, ny;
+  long nfilled;
   double missval;
   double *array1, *array2;
-  double **matrix1, **matrix2;
+  int *kl, *kr, *ko, *ku;
 
   gridID  = field1->grid;
   missval = field1->missval;
@@ -165,106 +209,295 @@ void fillmiss_one_step(field_t *field1, field_t *field2, int maxfill)
   nx  = gridInqXsize(gridID);
   ny  = gridInqYsize(gridID);
 
-  matrix1 = (double **) malloc(ny * sizeof(double *));
-  matrix2 = (double **) malloc(ny * sizeof(double *));
+  kl = (int*) malloc(4*nx*ny*sizeof(int));
+  kr = kl + nx*ny;
+  ko = kr + nx*ny;
+  ku = ko + nx*ny;
 
-  for ( j = 0; j < ny; j++ ) { matrix1[j] = array1 + j*nx; matrix2[j] = array2 + j*nx; }
+  for ( int fill_iterations = 0; fill_iterations < maxfill; fill_iterations++ )
+    {
+      find_neighbours(nx, ny, FALSE, array1, missval, kl, kr, ko, ku);
+
+      nfilled = 0;
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(nx, ny, missval, array1, array2, kl, kr, ko, ku) \
+  private(i) reduction(+:nfilled)
+#endif
+      for ( j = 0; j < ny; j++ )
+        for ( i = 0; i < nx; i++ )
+          {
+            long ij = j*nx + i;
+            int k1, k2;
+            double s1, s2;
 
-  for (int fill_iterations=0; fill_iterations < maxfill; fill_iterations++) {
-  for ( j = 0; j < ny; j++ )
-    for ( i = 0; i < nx; i++ )
+            if ( DBL_IS_EQUAL(array1[ij], missval) )
+              {
+                /* nearest point of the row and of the column */
+                if      ( kl[ij] == 0 && kr[ij] == 0 ) { s1 = 0.; k1 = 0; }
+                else if ( kl[ij] == 0 ) { s1 = array1[ij+kr[ij]]; k1 = kr[ij]; }
+                else if ( kr[ij] == 0 ) { s1 = array1[ij-kl[ij]]; k1 = kl[ij]; }
+                else if ( kl[ij] < kr[ij] ) { s1 = array1[ij-kl[ij]]; k1 = kl[ij]; }
+                else { s1 = array1[ij+kr[ij]]; k1 = kr[ij]; }
+
+                if      ( ko[ij] == 0 && ku[ij] == 0 ) { s2 = 0.; k2 = 0; }
+                else if ( ku[ij] == 0 ) { s2 = array1[ij-ko[ij]*nx]; k2 = ko[ij]; }
+                else if ( ko[ij] == 0 ) { s2 = array1[ij+ku[ij]*nx]; k2 = ku[ij]; }
+                else if ( ku[ij] < ko[ij] ) { s2 = array1[ij+ku[ij]*nx]; k2 = ku[ij]; }
+                else { s2 = array1[ij-ko[ij]*nx]; k2 = ko[ij]; }
+
+                if      ( k1 + k2 == 0 ) array2[ij] = array1[ij];
+                else if ( k1 == 0 ) array2[ij] = s2;
+                else if ( k2 == 0 ) array2[ij] = s1;
+                else if ( k1 <= k2 ) array2[ij] = s1;
+                else array2[ij] = s2;
+
+                if ( k1 + k2 ) nfilled++;
+              }
+            else
+              {
+                array2[ij] = array1[ij];
+              }
+          }
+
+      memcpy(array1, array2, nx*ny*sizeof(double));
+
+      /* further iterations would not change the field */
+      if ( nfilled == 0 ) break;
+    }
+
+  free(kl);
+}
+
+/* neighbours of the cells of an unstructured grid, found by their common edges */
+typedef struct {
+  long  gridsize;
+  int  *offset;    /* the neighbours of cell i are cells[offset[i]] to cells[offset[i+1]-1] */
+  int  *cells;
+} cellnbr_t;
+
+typedef struct {
+  double x1, y1, x2, y2;
+  int    cell;
+} edge_t;
+
+static
+int cmp_edge(const void *s1, const void *s2)
+{
+  const edge_t *e1 = (const edge_t*) s1;
+  const edge_t *e2 = (const edge_t*) s2;
+
+  if ( e1->x1 < e2->x1 ) return (-1);
+  if ( e1->x1 > e2->x1 ) return (1);
+  if ( e1->y1 < e2->y1 ) return (-1);
+  if ( e1->y1 > e2->y1 ) return (1);
+  if ( e1->x2 < e2->x2 ) return (-1);
+  if ( e1->x2 > e2->x2 ) return (1);
+  if ( e1->y2 < e2->y2 ) return (-1);
+  if ( e1->y2 > e2->y2 ) return (1);
+
+  return (e1->cell - e2->cell);
+}
+
+static
+int same_edge(const edge_t *e1, const edge_t *e2)
+{
+  return (IS_EQUAL(e1->x1, e2->x1) && IS_EQUAL(e1->y1, e2->y1) &&
+          IS_EQUAL(e1->x2, e2->x2) && IS_EQUAL(e1->y2, e2->y2));
+}
+
+static
+cellnbr_t *cellnbr_new(int gridID)
+{
+  char units[CDI_MAX_NAME];
+  long gridsize = gridInqSize(gridID);
+  int nv = gridInqNvertex(gridID);
+  long i, k, n, e, e1, e2;
+
+  if ( nv < 3 || !gridInqXbounds(gridID, NULL) || !gridInqYbounds(gridID, NULL) )
+    cdoAbort("Grid cell bounds missing, they are needed to find the neighbours of %s grid cells!",
+             gridNamePtr(gridInqType(gridID)));
+
+  double *xbounds = (double*) malloc(nv*gridsize*sizeof(double));
+  double *ybounds = (double*) malloc(nv*gridsize*sizeof(double));
+  gridInqXbounds(gridID, xbounds);
+  gridInqYbounds(gridID, ybounds);
+
+  gridInqXunits(gridID, units);
+  grid_to_degree(units, nv*gridsize, xbounds, "grid corner lon");
+  gridInqYunits(gridID, units);
+  grid_to_degree(units, nv*gridsize, ybounds, "grid corner lat");
+
+  /* same vertex for -180 and 180 degree and at the poles */
+  for ( n = 0; n < nv*gridsize; n++ )
+    {
+      if ( ybounds[n] >= 90 || ybounds[n] <= -90 ) xbounds[n] = 0;
+      xbounds[n] = fmod(xbounds[n], 360.);
+      if ( xbounds[n] < 0 ) xbounds[n] += 360;
+    }
+
+  edge_t *edges = (edge_t*) malloc(nv*gridsize*sizeof(edge_t));
+  long nedges = 0;
+
+  for ( i = 0; i < gridsize; i++ )
+    for ( k = 0; k < nv; k++ )
       {
-        if ( DBL_IS_EQUAL(matrix1[j][i], missval) )
-          {
-            nmiss2++;
+        long n1 = i*nv + k;
+        long n2 = i*nv + (k+1)%nv;
+        edge_t *edge = &edges[nedges];
 
-            kr = ku = kl = ko = 0;
-            xr = xu = xl = xo = 0.;
+        /* cells with less vertices repeat the last one */
+        if ( IS_EQUAL(xbounds[n1], xbounds[n2]) && IS_EQUAL(ybounds[n1], ybounds[n2]) ) continue;
 
-            for ( ir = i + 1; ir < nx; ir++ )
-              if ( !DBL_IS_EQUAL(matrix1[j][ir], missval) )
-                { kr = ir - i; xr = matrix1[j][ir]; break; }
+        if ( xbounds[n1] < xbounds[n2] || (IS_EQUAL(xbounds[n1], xbounds[n2]) && ybounds[n1] < ybounds[n2]) )
+          { edge->x1 = xbounds[n1]; edge->y1 = ybounds[n1]; edge->x2 = xbounds[n2]; edge->y2 = ybounds[n2]; }
+        else
+          { edge->x1 = xbounds[n2]; edge->y1 = ybounds[n2]; edge->x2 = xbounds[n1]; edge->y2 = ybounds[n1]; }
 
-            for ( il = i-1; il >= 0; il-- )
-              if ( !DBL_IS_EQUAL(matrix1[j][il], missval) )
-                { kl = i - il; xl = matrix1[j][il]; break; }
+        edge->cell = (int) i;
+        nedges++;
+      }
 
+  free(xbounds);
+  free(ybounds);
 
-            for ( iu = j + 1; iu < ny; iu++ )
-              if ( !DBL_IS_EQUAL(matrix1[iu][i], missval) )
-                { ku = iu - j; xu = matrix1[iu][i]; break; }
+  qsort(edges, nedges, sizeof(edge_t), cmp_edge);
 
-            for ( io = j - 1; io >= 0; io-- )
-              if ( !DBL_IS_EQUAL(matrix1[io][i], missval) )
-                { ko = j - io; xo = matrix1[io][i]; break; }
+  cellnbr_t *nbr = (cellnbr_t*) malloc(sizeof(cellnbr_t));
+  nbr->gridsize = gridsize;
+  nbr->offset   = (int*) calloc(gridsize+1, sizeof(int));
 
+  /* two passes over the runs of equal edges: count, then store the neighbours */
+  for ( int lstore = 0; lstore < 2; lstore++ )
+    {
+      for ( e = 0; e < nedges; e = e2 )
+        {
+          for ( e2 = e+1; e2 < nedges && same_edge(&edges[e], &edges[e2]); e2++ );
 
-            kh = kl + kr;
-            kv = ko + ku;
-            if      ( kh == 0 ) { s1 = 0.; k1 = 0; }
-            else if ( kl == 0 ) { s1 = xr; k1 = kr; }
-            else if ( kr == 0 ) { s1 = xl; k1 = kl; }
-            else
-              {
-                if ( kl < kr )
+          for ( e1 = e; e1 < e2; e1++ )
+            for ( n = e; n < e2; n++ )
+              if ( edges[n].cell != edges[e1].cell )
                 {
-                  s1 = xl;
-                  k1 = kl;
+                  if ( lstore ) nbr->cells[nbr->offset[edges[e1].cell]++] = edges[n].cell;
+                  else          nbr->offset[edges[e1].cell+1]++;
                 }
-              else
-                {
-                  s1 = xr;
-                  k1 = kr;
-                }
-              }
+        }
+
+      if ( lstore )
+        {
+          for ( i = gridsize; i > 0; i-- ) nbr->offset[i] = nbr->offset[i-1];
+          nbr->offset[0] = 0;
+        }
+      else
+        {
+          for ( i = 0; i < gridsize; i++ ) nbr->offset[i+1] += nbr->offset[i];
+          nbr->cells = (int*) malloc((nbr->offset[gridsize] > 0 ? nbr->offset[gridsize] : 1)*sizeof(int));
+        }
+    }
 
-            if      ( kv == 0 ) { s2 = 0.; k2 = 0; }
-            else if ( ku == 0 ) { s2 = xo; k2 = ko; }
-            else if ( ko == 0 ) { s2 = xu; k2 = ku; }
-            else
-              {
-                if ( ku < ko )
-                  {
-                    s2 = xu;
-                    k2 = ku;
-                  }
-                else
-                  {
-                    s2 = xo;
-                    k2 = ko;
-                  }
-              }
+  free(edges);
 
-            kk = k1 + k2;
-            if      ( kk == 0 ) matrix2[j][i] = matrix1[j][i];
-            else if ( k1 == 0 ) matrix2[j][i] = s2;
-            else if ( k2 == 0 ) matrix2[j][i] = s1;
-            else
-              {
-                if ( k1 <= k2 )
-                {
-                  matrix2[j][i] = s1;
-                }
-                else
-                {
-                  matrix2[j][i] = s2;
-                }
+  return (nbr);
+}
+
+static
+void cellnbr_delete(cellnbr_t *nbr)
+{
+  free(nbr->offset);
+  free(nbr->cells);
+  free(nbr);
+}
+
+/*
+  Fill the missing values of an unstructured grid layer by layer. A missing
+  cell gets the mean (fillmiss2: the first) of its filled neighbours.
+  fillmiss only fills cells with at least nfill filled neighbours,
+  fillmiss2 stops after nfill (maxiter) layers. Cells without a path to a
+  valid cell stay missing.
+*/
+static
+void fillmiss_cells(field_t *field1, field_t *field2, const cellnbr_t *nbr, int nfill, int lnearest)
+{
+  long gridsize = nbr->gridsize;
+  double missval = field1->missval;
+  const double *array1 = field1->ptr;
+  double *array2 = field2->ptr;
+  long i, k, n, nfront = 0, nnext;
+  int layer;
+  int minnbr  = lnearest ? 1 : nfill;
+  int maxfill = lnearest ? nfill : INT_MAX;
+
+  int *cell_layer = (int*) malloc(gridsize*sizeof(int));
+  int *front      = (int*) malloc(gridsize*sizeof(int));
+  int *next       = (int*) malloc(gridsize*sizeof(int));
+  int *nvalid     = (int*) malloc(gridsize*sizeof(int));
+
+  for ( i = 0; i < gridsize; i++ )
+    {
+      array2[i] = array1[i];
+      if ( DBL_IS_EQUAL(array1[i], missval) )
+        cell_layer[i] = -1;
+      else
+        {
+          cell_layer[i] = 0;
+          front[nfront++] = (int) i;
+        }
+    }
 
+  for ( layer = 1; nfront > 0 && layer <= maxfill; layer++ )
+    {
+      /* missing neighbours of the last layer are the candidates (-2) of this one */
+      nnext = 0;
+      for ( n = 0; n < nfront; n++ )
+        for ( k = nbr->offset[front[n]]; k < nbr->offset[front[n]+1]; k++ )
+          if ( cell_layer[nbr->cells[k]] == -1 )
+            {
+              cell_layer[nbr->cells[k]] = -2;
+              next[nnext++] = nbr->cells[k];
+            }
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(nbr, nnext, next, nvalid, cell_layer, lnearest, minnbr, array2) private(k)
+#endif
+      for ( n = 0; n < nnext; n++ )
+        {
+          int cell = next[n];
+          long cnt = 0;
+          double sum = 0;
+
+          for ( k = nbr->offset[cell]; k < nbr->offset[cell+1]; k++ )
+            if ( cell_layer[nbr->cells[k]] >= 0 )
+              {
+                if ( lnearest ) { sum = array2[nbr->cells[k]]; cnt = 1; break; }
+                sum += array2[nbr->cells[k]];
+                cnt++;
               }
 
-            //printf("%d %d %2d %2d %2d %2d %2g %2g %2g %2g %2g %2g %2g\n", j,i,kr,kl,ku,ko,xr,xl,xu,xo,s1,s2,matrix2[j][i]);
-            /* matrix1[j][i] = matrix2[j][i]; */
-          }
-        else
-          {
-            matrix2[j][i] = matrix1[j][i];
-          }
-      }
-  for ( j = 0; j < ny; j++ ) for ( i = 0; i < nx; i++ ) matrix1[j][i] = matrix2[j][i];
-  }
+          nvalid[n] = (int) cnt;
+          if ( cnt >= minnbr ) array2[cell] = sum/cnt;
+        }
+
+      /* candidates with too few filled neighbours may come back with a later layer */
+      nfront = 0;
+      for ( n = 0; n < nnext; n++ )
+        {
+          if ( nvalid[n] >= minnbr )
+            {
+              cell_layer[next[n]] = layer;
+              next[nfront++] = next[n];
+            }
+          else
+            cell_layer[next[n]] = -1;
+        }
+
+      int *tmp = front;
+      front  = next;
+      next   = tmp;
+    }
 
-  free(matrix2);
-  free(matrix1);
+  free(cell_layer);
+  free(front);
+  free(next);
+  free(nvalid);
 }
 
 
@@ -283,6 +516,7 @@ void *Fillmiss(void *argument)
   int taxisID1, taxisID2;
   int nmiss, i, nfill = 1;
   void (*fill_method) (field_t *fin , field_t *fout , int);
+  cellnbr_t **cellnbr;
 
   cdoInitialize(argument);
 
@@ -325,13 +559,22 @@ void *Fillmiss(void *argument)
   vlistDefTaxis(vlistID2, taxisID2);
 
   ngrids = vlistNgrids(vlistID1);
+  cellnbr = (cellnbr_t**) malloc(ngrids*sizeof(cellnbr_t*));
   for ( index = 0; index < ngrids; index++ )
     {
       gridID1 = vlistGrid(vlistID1, index);
-
-      if ( gridInqType(gridID1) == GRID_GME ||
-	   gridInqType(gridID1) == GRID_UNSTRUCTURED )
-	cdoAbort("Interpolation of %s data unsupported!", gridNamePtr(gridInqType(gridID1)) );
+      cellnbr[index] = NULL;
+
+      if ( gridInqType(gridID1) == GRID_UNSTRUCTURED )
+        {
+          cellnbr[index] = cellnbr_new(gridID1);
+        }
+      else if ( gridInqType(gridID1) == GRID_GME )
+        {
+          int gridID = gridToUnstructured(gridID1, 1);
+          cellnbr[index] = cellnbr_new(gridID);
+          gridDestroy(gridID);
+        }
     }
 
   streamID2 = streamOpenWrite(cdoStreamName(1), cdoFiletype());
@@ -364,7 +607,11 @@ void *Fillmiss(void *argument)
 	  field2.nmiss   = 0;
 	  field2.missval = field1.missval;
 
-	  fill_method(&field1, &field2, nfill);
+	  index = vlistGridIndex(vlistID1, field1.grid);
+	  if ( cellnbr[index] )
+	    fillmiss_cells(&field1, &field2, cellnbr[index], nfill, operatorID == FILLMISSONESTEP);
+	  else
+	    fill_method(&field1, &field2, nfill);
 
 	  gridsize = gridInqSize(field2.grid);
 	  nmiss = 0;
@@ -380,6 +627,10 @@ void *Fillmiss(void *argument)
   streamClose(streamID2);
   streamClose(streamID1);
 
+  for ( index = 0; index < ngrids; index++ )
+    if ( cellnbr[index] ) cellnbr_delete(cellnbr[index]);
+  free(cellnbr);
+
   if ( field2.ptr ) free(field2.ptr);
   if ( field1.ptr ) free(field1.ptr);
 
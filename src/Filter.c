@@ -33,14 +33,16 @@
 #include "cdo_int.h"
 #include "statistic.h"
 #include "pstream.h"
+#include "tstore.h"
+#include "fftplan.h"
 
 #if defined(HAVE_LIBFFTW3) 
 #include <fftw3.h>
 #endif
 
 
-#define  NALLOC_INC  1024
-
+/* number of complex vectors per batch, each holds two time series */
+#define  NBATCH  16
 
 /* include from Tinfo.c */
 void getTimeInc(double jdelta, int vdate0, int vdate1, int *incperiod, int *incunit);
@@ -62,20 +64,31 @@ void create_fmasc(int nts, double fdata, double fmin, double fmax, int *fmasc)
     fmasc[i] = fmasc[nts-i] = 1; 
 }
 
+/*
+  The time series are real and only the real part of the back transform was
+  used, this is the same as filtering with the symmetric part of the mask.
+  The factor 1/nts of the back transform is included.
+*/
+static
+void create_fmask(int nts, const int *fmasc, double *fmask)
+{
+  for ( int i = 0; i < nts; i++ )
+    fmask[i] = 0.5*(fmasc[i] + fmasc[(nts-i)%nts])/nts;
+}
+
 #if defined(HAVE_LIBFFTW3) 
 static
-void filter_fftw(int nts, const int *fmasc, fftw_complex *fft_out, fftw_plan *p_T2S, fftw_plan *p_S2T)
+void filter_fftw(int nts, const double *fmask, fftw_complex *fft_out, fftw_plan *p_T2S, fftw_plan *p_S2T)
 {  
   int i;
 
   fftw_execute(*p_T2S);
 
-  for ( i = 0; i < nts; i++ )
-    if ( ! fmasc[i] )
-      {
-        fft_out[i][0] = 0;
-        fft_out[i][1] = 0;
-      }
+  for ( i = 0; i <= nts/2; i++ )
+    {
+      fft_out[i][0] *= fmask[i];
+      fft_out[i][1] *= fmask[i];
+    }
   
   fftw_execute(*p_S2T);
   
@@ -83,38 +96,57 @@ void filter_fftw(int nts, const int *fmasc, fftw_complex *fft_out, fftw_plan *p_
 }
 #endif
 
+/*
+  Filter nser time series of length nts at once. Two real series are packed
+  into one complex vector, the real and imaginary part of the result are the
+  filtered series.
+*/
 static
-void filter_intrinsic(int nts, const int *fmasc, double *array1, double *array2)
+void filter_intrinsic(const fftplan_t *plan, int nts, const double *fmask, long nser, double *series,
+                      double *re, double *im, double *work)
 {  
-  int i;
-  int lpower2 = FALSE;
-  double *work_r = NULL;
-  double *work_i = NULL;
-
-  if ( (nts&(nts-1)) == 0 ) lpower2 = TRUE;
+  long lot = (nser+1)/2;
+  long b, i;
 
-  if ( !lpower2 )
+  for ( b = 0; b < lot; b++ )
     {
-      work_r = (double*) malloc(nts*sizeof(double));
-      work_i = (double*) malloc(nts*sizeof(double));
+      const double *ts1 = series + 2*b*nts;
+      const double *ts2 = ts1 + nts;
+
+      if ( 2*b+1 < nser )
+        for ( i = 0; i < nts; i++ )
+          {
+            re[i*lot+b] = ts1[i];
+            im[i*lot+b] = ts2[i];
+          }
+      else
+        for ( i = 0; i < nts; i++ )
+          {
+            re[i*lot+b] = ts1[i];
+            im[i*lot+b] = 0;
+          }
     }
 
-  if ( lpower2 )
-    fft(array1, array2, nts, 1);
-  else
-    ft_r(array1, array2, nts, 1, work_r, work_i);
+  fftplan_exec(plan, re, im, lot, 1, work);
 
   for ( i = 0; i < nts; i++ )
-    if ( ! fmasc[i] )
-      array1[i] = array2[i] = 0;
+    for ( b = 0; b < lot; b++ )
+      {
+        re[i*lot+b] *= fmask[i];
+        im[i*lot+b] *= fmask[i];
+      }
 
-  if ( lpower2 )
-    fft(array1, array2, nts, -1);
-  else
-    ft_r(array1, array2, nts, -1, work_r, work_i);
+  fftplan_exec(plan, re, im, lot, -1, work);
+
+  for ( b = 0; b < lot; b++ )
+    {
+      double *ts1 = series + 2*b*nts;
+      double *ts2 = ts1 + nts;
 
-  if ( work_r ) free(work_r);
-  if ( work_i ) free(work_i);
+      for ( i = 0; i < nts; i++ ) ts1[i] = re[i*lot+b];
+      if ( 2*b+1 < nser )
+        for ( i = 0; i < nts; i++ ) ts2[i] = im[i*lot+b];
+    }
   
   return;
 }
@@ -130,23 +162,26 @@ void *Filter(void *argument)
   int gridID, varID, levelID, recID;
   int tsID;
   int i;
+  long j, first, npoints, nblk, nser;
   int nts;
-  int nalloc = 0;
   int nmiss;
   int nvars, nlevel;
   int incperiod0, incunit0, incunit, calendar;
   int year0, month0, day0;
   double fdata = 0;
-  field_t ***vars = NULL;
+  double *array, *tile;
+  tstore_t *store;
   double fmin = 0, fmax = 0;
   int use_fftw = FALSE;
+  fftplan_t *plan = NULL;
   dtlist_type *dtlist = dtlist_new();
   typedef struct
   {
-    double *array1;
-    double *array2;
+    double *re;
+    double *im;
+    double *work;
 #if defined(HAVE_LIBFFTW3) 
-    fftw_complex *in_fft;
+    double *in_fft;
     fftw_complex *out_fft;
     fftw_plan p_T2S;
     fftw_plan p_S2T;
@@ -187,28 +222,21 @@ void *Filter(void *argument)
   calendar = taxisInqCalendar(taxisID1);  
  
   nvars = vlistNvars(vlistID1);
+
+  array = (double*) malloc(vlistGridsizeMax(vlistID1)*sizeof(double));
+
+  store = tstore_new(vlistID1);
   
   tsID = 0;    
   while ( (nrecs = streamInqTimestep(streamID1, tsID)) )
     {
-      if ( tsID >= nalloc )
-        {
-          nalloc += NALLOC_INC;
-          vars   = (field_t ***) realloc(vars, nalloc*sizeof(field_t **));
-        }
-                       
       dtlist_taxisInqTimestep(dtlist, taxisID1, tsID);
-   
-      vars[tsID] = field_malloc(vlistID1, FIELD_NONE);
            
       for ( recID = 0; recID < nrecs; recID++ )
         {
           streamInqRecord(streamID1, &varID, &levelID);
-          gridID   = vlistInqVarGrid(vlistID1, varID);
-          gridsize = gridInqSize(gridID);
-          vars[tsID][varID][levelID].ptr = (double*) malloc(gridsize*sizeof(double));
-          streamReadRecord(streamID1, vars[tsID][varID][levelID].ptr, &nmiss);
-          vars[tsID][varID][levelID].nmiss = nmiss;
+          streamReadRecord(streamID1, array, &nmiss);
+          tstore_put_field(store, tsID, varID, levelID, array, nmiss);
           if ( nmiss ) cdoAbort("Missing value support for operators in module Filter not added yet!");
         }
 
@@ -265,24 +293,27 @@ void *Filter(void *argument)
       ompmem = (memory_t*) malloc(ompNumThreads*sizeof(memory_t));
       for ( i = 0; i < ompNumThreads; i++ )
 	{
-	  ompmem[i].in_fft  = (fftw_complex*) malloc(nts*sizeof(fftw_complex));
-	  ompmem[i].out_fft = (fftw_complex*) malloc(nts*sizeof(fftw_complex));
-	  ompmem[i].p_T2S = fftw_plan_dft_1d(nts, ompmem[i].in_fft, ompmem[i].out_fft,  1, FFTW_ESTIMATE);
-	  ompmem[i].p_S2T = fftw_plan_dft_1d(nts, ompmem[i].out_fft, ompmem[i].in_fft, -1, FFTW_ESTIMATE);
+	  ompmem[i].in_fft  = (double*) fftw_malloc(nts*sizeof(double));
+	  ompmem[i].out_fft = (fftw_complex*) fftw_malloc((nts/2+1)*sizeof(fftw_complex));
+	  ompmem[i].p_T2S = fftw_plan_dft_r2c_1d(nts, ompmem[i].in_fft, ompmem[i].out_fft, FFTW_ESTIMATE);
+	  ompmem[i].p_S2T = fftw_plan_dft_c2r_1d(nts, ompmem[i].out_fft, ompmem[i].in_fft, FFTW_ESTIMATE);
 	}
 #endif
     }
   else
     {
+      plan = fftplan_new(nts);
       ompmem = (memory_t*) malloc(ompNumThreads*sizeof(memory_t));
       for ( i = 0; i < ompNumThreads; i++ )
 	{
-	  ompmem[i].array1 = (double*) malloc(nts*sizeof(double));
-	  ompmem[i].array2 = (double*) malloc(nts*sizeof(double));
+	  ompmem[i].re   = (double*) malloc(NBATCH*nts*sizeof(double));
+	  ompmem[i].im   = (double*) malloc(NBATCH*nts*sizeof(double));
+	  ompmem[i].work = (double*) malloc(fftplan_worksize(plan, NBATCH)*sizeof(double));
 	}
     }
 
   int *fmasc = (int*) calloc(nts, sizeof(int));
+  double *fmask = (double*) malloc(nts*sizeof(double));
 
   switch(operfunc)
     {
@@ -315,61 +346,64 @@ void *Filter(void *argument)
   if ( cdoVerbose ) cdoPrint("fmin=%g  fmax=%g", fmin, fmax);
   
   create_fmasc(nts, fdata, fmin, fmax, fmasc);
+  create_fmask(nts, fmasc, fmask);
 
   for ( varID = 0; varID < nvars; varID++ )
     {
       gridID   = vlistInqVarGrid(vlistID1, varID);
       gridsize = gridInqSize(gridID);
       nlevel   = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+      npoints  = tstore_tilesize(store, varID);
+      tile     = (double*) malloc(npoints*nts*sizeof(double));
       
       for ( levelID = 0; levelID < nlevel; levelID++ )
-        {
-          if ( use_fftw )
-            {
+        for ( first = 0; first < gridsize; first += npoints )
+          {
+            nblk = gridsize - first < npoints ? gridsize - first : npoints;
+
+            tstore_get_tile(store, varID, levelID, first, nblk, tile);
+
+            if ( use_fftw )
+              {
 #if defined(HAVE_LIBFFTW3) 
 #if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(i, tsID)
+#pragma omp parallel for default(shared) private(j, tsID)
 #endif
-              for ( i = 0; i < gridsize; i++ )
-                {
-            	  int ompthID = cdo_omp_get_thread_num();
+                for ( j = 0; j < nblk; j++ )
+                  {
+                    int ompthID = cdo_omp_get_thread_num();
+                    double *ts = tile + j*nts;
 
-                  for ( tsID = 0; tsID < nts; tsID++ )                              
-                    {
-                      ompmem[ompthID].in_fft[tsID][0] = vars[tsID][varID][levelID].ptr[i];
-                      ompmem[ompthID].in_fft[tsID][1] = 0;
-                    }
+                    for ( tsID = 0; tsID < nts; tsID++ )
+                      ompmem[ompthID].in_fft[tsID] = ts[tsID];
 
-                  filter_fftw(nts, fmasc, ompmem[ompthID].out_fft, &ompmem[ompthID].p_T2S, &ompmem[ompthID].p_S2T);
+                    filter_fftw(nts, fmask, ompmem[ompthID].out_fft, &ompmem[ompthID].p_T2S, &ompmem[ompthID].p_S2T);
                   
-                  for ( tsID = 0; tsID < nts; tsID++ )
-                    {
-                      vars[tsID][varID][levelID].ptr[i] = ompmem[ompthID].in_fft[tsID][0] / nts;  
-                    }
-                }
+                    for ( tsID = 0; tsID < nts; tsID++ )
+                      ts[tsID] = ompmem[ompthID].in_fft[tsID];
+                  }
 #endif
-            }
-          else
-            {
+              }
+            else
+              {
 #if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(i, tsID)
+#pragma omp parallel for default(shared) private(j, nser)
 #endif
-              for ( i = 0; i < gridsize; i++ )  
-                {
-            	  int ompthID = cdo_omp_get_thread_num();
+                for ( j = 0; j < nblk; j += 2*NBATCH )  
+                  {
+                    int ompthID = cdo_omp_get_thread_num();
 
-                  for ( tsID = 0; tsID < nts; tsID++ )
-                    ompmem[ompthID].array1[tsID] = vars[tsID][varID][levelID].ptr[i];
+                    nser = nblk - j < 2*NBATCH ? nblk - j : 2*NBATCH;
 
-                  memset(ompmem[ompthID].array2, 0, nts*sizeof(double));
+                    filter_intrinsic(plan, nts, fmask, nser, tile + j*nts,
+                                     ompmem[ompthID].re, ompmem[ompthID].im, ompmem[ompthID].work);
+                  }
+              }
 
-                  filter_intrinsic(nts, fmasc, ompmem[ompthID].array1, ompmem[ompthID].array2);
+            tstore_put_tile(store, varID, levelID, first, nblk, tile);
+          }
 
-                  for ( tsID = 0; tsID < nts; tsID++ )
-                    vars[tsID][varID][levelID].ptr[i] = ompmem[ompthID].array1[tsID];
-                }
-            }
-        }
+      free(tile);
     }
 
   if ( use_fftw )
@@ -377,8 +411,10 @@ void *Filter(void *argument)
 #if defined(HAVE_LIBFFTW3) 
       for ( i = 0; i < ompNumThreads; i++ )
 	{
-	  free(ompmem[i].in_fft);
-	  free(ompmem[i].out_fft);
+	  fftw_destroy_plan(ompmem[i].p_T2S);
+	  fftw_destroy_plan(ompmem[i].p_S2T);
+	  fftw_free(ompmem[i].in_fft);
+	  fftw_free(ompmem[i].out_fft);
 	}
       free(ompmem);
 #endif
@@ -387,12 +423,17 @@ void *Filter(void *argument)
     {
       for ( i = 0; i < ompNumThreads; i++ )
 	{
-	  free(ompmem[i].array1);
-	  free(ompmem[i].array2);
+	  free(ompmem[i].re);
+	  free(ompmem[i].im);
+	  free(ompmem[i].work);
 	}
       free(ompmem);
+      fftplan_delete(plan);
     }
 
+  free(fmasc);
+  free(fmask);
+
   int streamID2 = streamOpenWrite(cdoStreamName(1), cdoFiletype());
   
   streamDefVlist(streamID2, vlistID2);
@@ -407,22 +448,20 @@ void *Filter(void *argument)
           nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
           for ( levelID = 0; levelID < nlevel; levelID++ )
             {
-              if ( vars[tsID][varID][levelID].ptr )
+              nmiss = tstore_inq_nmiss(store, tsID, varID, levelID);
+              if ( nmiss >= 0 )
                 {
-                  nmiss = vars[tsID][varID][levelID].nmiss;
+                  tstore_get_field(store, tsID, varID, levelID, array);
                   streamDefRecord(streamID2, varID, levelID);
-                  streamWriteRecord(streamID2, vars[tsID][varID][levelID].ptr, nmiss);
-
-                  free(vars[tsID][varID][levelID].ptr);
-                  vars[tsID][varID][levelID].ptr = NULL;
+                  streamWriteRecord(streamID2, array, nmiss);
                 }
             }
         }
-
-      field_free(vars[tsID], vlistID1);
     }
 
-  if ( vars   ) free(vars);
+  tstore_delete(store);
+
+  free(array);
 
   dtlist_delete(dtlist);
 
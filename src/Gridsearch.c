@@ -19,23 +19,161 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "grid.h"
+#include "remap.h"
 
 
+static
+void grid_center_coordinates(int gridID, long *gridsize, double **lon, double **lat)
+{
+  char xunits[CDI_MAX_NAME], yunits[CDI_MAX_NAME];
+  int lgrid_destroy = FALSE;
+
+  if ( gridInqType(gridID) != GRID_UNSTRUCTURED && gridInqType(gridID) != GRID_CURVILINEAR )
+    {
+      gridID = gridToCurvilinear(gridID, 0);
+      lgrid_destroy = TRUE;
+    }
+
+  if ( gridInqXvals(gridID, NULL) == 0 || gridInqYvals(gridID, NULL) == 0 )
+    cdoAbort("Grid cell center coordinates missing!");
+
+  *gridsize = gridInqSize(gridID);
+  *lon = (double*) malloc(*gridsize*sizeof(double));
+  *lat = (double*) malloc(*gridsize*sizeof(double));
+
+  gridInqXvals(gridID, *lon);
+  gridInqYvals(gridID, *lat);
+
+  gridInqXunits(gridID, xunits);
+  gridInqYunits(gridID, yunits);
+
+  grid_to_radian(xunits, *gridsize, *lon, "grid center lon");
+  grid_to_radian(yunits, *gridsize, *lat, "grid center lat");
+
+  if ( lgrid_destroy ) gridDestroy(gridID);
+}
+
+/* nearest point by a full search, equal distances by the lowest address */
+static
+int full_search_nn(long gridsize, const double *restrict lon, const double *restrict lat, double plat, double plon, double *dist)
+{
+  long i;
+  int nadd = -1;
+  double distance;
+  double coslat_dst = cos(plat);
+  double coslon_dst = cos(plon);
+  double sinlat_dst = sin(plat);
+  double sinlon_dst = sin(plon);
+
+  *dist = BIGNUM;
+
+  for ( i = 0; i < gridsize; ++i )
+    {
+      distance =  sinlat_dst*sin(lat[i]) + coslat_dst*cos(lat[i])*
+	         (coslon_dst*cos(lon[i]) + sinlon_dst*sin(lon[i]));
+      if ( distance > 1. ) distance = 1.;
+      distance = acos(distance);
+      if ( distance < *dist )
+	{
+	  *dist = distance;
+	  nadd = i;
+	}
+    }
+
+  return (nadd);
+}
+
+static
+void test_point_search(int gridID1, int gridID2)
+{
+  long i, gridsize1, gridsize2;
+  long nerr = 0;
+  int nbr_add, nadd;
+  double nbr_dist, dist;
+  double *lon1, *lat1, *lon2, *lat2;
+  double tbuild, tsearch, tfull;
+  int timer_build, timer_search, timer_full;
+
+  timer_build  = timer_new("kdtree build");
+  timer_search = timer_new("kdtree search");
+  timer_full   = timer_new("full search");
+
+  grid_center_coordinates(gridID1, &gridsize1, &lon1, &lat1);
+  grid_center_coordinates(gridID2, &gridsize2, &lon2, &lat2);
+
+  timer_start(timer_build);
+  kdtree_t *tree = kdtree_new(gridsize1, lon1, lat1);
+  timer_stop(timer_build);
+
+  int *add = (int*) malloc(gridsize2*sizeof(int));
+
+  timer_start(timer_search);
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(gridsize2, tree, lon2, lat2, add) private(nbr_add, nbr_dist)
+#endif
+  for ( i = 0; i < gridsize2; ++i )
+    {
+      kdtree_search_nbr(tree, 1, &nbr_add, &nbr_dist, lat2[i], lon2[i], -1.);
+      add[i] = nbr_add;
+    }
+  timer_stop(timer_search);
+
+  timer_start(timer_full);
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(gridsize1, gridsize2, lon1, lat1, lon2, lat2, add) private(nadd, dist) reduction(+:nerr)
+#endif
+  for ( i = 0; i < gridsize2; ++i )
+    {
+      nadd = full_search_nn(gridsize1, lon1, lat1, lat2[i], lon2[i], &dist);
+      if ( nadd != add[i] ) nerr++;
+    }
+  timer_stop(timer_full);
+
+  tbuild  = timer_val(timer_build);
+  tsearch = timer_val(timer_search);
+  tfull   = timer_val(timer_full);
+
+  cdoPrint("Point search of %ld points in %ld points", gridsize2, gridsize1);
+  cdoPrint("  kdtree: build %.3fs  search %.3fs", tbuild, tsearch);
+  cdoPrint("  full search: %.3fs", tfull);
+  cdoPrint("  different nearest neighbors: %ld", nerr);
+
+  if ( nerr ) cdoWarning("Point search failed for %ld points!", nerr);
+
+  kdtree_delete(tree);
+
+  free(add);
+  free(lon1);
+  free(lat1);
+  free(lon2);
+  free(lat2);
+}
+
 
 void *Gridsearch(void *argument)
 {
+  int TESTPOINTSEARCH, TESTCELLSEARCH;
+  int operatorID;
   int gridID1, gridID2;
 
   cdoInitialize(argument);
 
-  cdoOperatorAdd("testpointsearch",  0,   0, NULL);
-  cdoOperatorAdd("testcellsearch",   0,   0, NULL);
+  TESTPOINTSEARCH = cdoOperatorAdd("testpointsearch",  0,   0, NULL);
+  TESTCELLSEARCH  = cdoOperatorAdd("testcellsearch",   0,   0, NULL);
+
+  operatorID = cdoOperatorID();
 
   operatorInputArg("source and target grid description file or name");
   operatorCheckArgc(2);
   gridID1 = cdoDefineGrid(operatorArgv()[0]);
   gridID2 = cdoDefineGrid(operatorArgv()[1]);
 
+  if ( operatorID == TESTPOINTSEARCH )
+    test_point_search(gridID1, gridID2);
+  else if ( operatorID == TESTCELLSEARCH )
+    cdoWarning("Cell search test not implemented!");
+
   cdoFinish();
 
   return (0);
@@ -22,6 +22,21 @@
 */
 
 
+#if defined(HAVE_CONFIG_H)
+#  include "config.h"
+#endif
+
+#if defined(HAVE_LIBPTHREAD)
+#  include <pthread.h>
+#endif
+
+#if defined(HAVE_GETRLIMIT)
+#if defined(HAVE_SYS_RESOURCE_H)
+#include <sys/time.h>       /* getrlimit */
+#include <sys/resource.h>   /* getrlimit */
+#endif
+#endif
+
 #include <cdi.h>
 #include "cdo.h"
 #include "cdo_int.h"
@@ -29,34 +44,191 @@
 #include "util.h"
 
 
+typedef struct
+{
+  int streamID;
+  int vlistID;
+  int taxisID;
+  int tsID;
+  int vdate;
+  int vtime;
+  int nrecs;
+  int ispipe;
+} sfile_t;
+
+/* all records of one timestep of an input file */
+typedef struct
+{
+  int streamID;
+  int nrecs;
+  int nalloc;
+  long gridsize;
+  int *varID, *levelID, *nmiss;
+  double *array;
+} tsbuf_t;
+
+
+static
+int sfile_less(const sfile_t *sf, int a, int b)
+{
+  if ( sf[a].vdate != sf[b].vdate ) return (sf[a].vdate < sf[b].vdate);
+  if ( sf[a].vtime != sf[b].vtime ) return (sf[a].vtime < sf[b].vtime);
+  return (a < b);
+}
+
+/*
+  Binary min heap of file IDs ordered by the date and time of their next
+  timestep. Equal times are ordered by the file ID, so the files are merged
+  in the same order as with a linear search over all files.
+*/
+static
+void heap_push(int *heap, int *nheap, const sfile_t *sf, int fileID)
+{
+  int i = (*nheap)++;
+
+  while ( i > 0 )
+    {
+      int parent = (i-1)/2;
+      if ( !sfile_less(sf, fileID, heap[parent]) ) break;
+      heap[i] = heap[parent];
+      i = parent;
+    }
+  heap[i] = fileID;
+}
+
+static
+int heap_pop(int *heap, int *nheap, const sfile_t *sf)
+{
+  int top = heap[0];
+  int last = heap[--(*nheap)];
+  int n = *nheap;
+  int i = 0;
+
+  while ( 2*i+1 < n )
+    {
+      int child = 2*i+1;
+      if ( child+1 < n && sfile_less(sf, heap[child+1], heap[child]) ) child++;
+      if ( !sfile_less(sf, heap[child], last) ) break;
+      heap[i] = heap[child];
+      i = child;
+    }
+  if ( n > 0 ) heap[i] = last;
+
+  return (top);
+}
+
+/* Maximum number of input files that are kept open at the same time */
+static
+int mergetime_maxopen(void)
+{
+  int maxopen = 1024;
+
+#if defined(HAVE_GETRLIMIT)
+#if defined(RLIMIT_NOFILE)
+  struct rlimit rlim;
+  if ( getrlimit(RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY )
+    maxopen = (int) (rlim.rlim_cur < 4096 ? rlim.rlim_cur : 4096);
+#endif
+#endif
+
+  /* leave room for the output, pipes and the libraries */
+  maxopen /= 2;
+  if ( maxopen < 8 ) maxopen = 8;
+
+  return (maxopen);
+}
+
+static
+void tsbuf_resize(tsbuf_t *buf, int nrecs)
+{
+  if ( nrecs > buf->nalloc )
+    {
+      buf->nalloc  = nrecs;
+      buf->varID   = (int*) realloc(buf->varID, nrecs*sizeof(int));
+      buf->levelID = (int*) realloc(buf->levelID, nrecs*sizeof(int));
+      buf->nmiss   = (int*) realloc(buf->nmiss, nrecs*sizeof(int));
+      buf->array   = (double*) realloc(buf->array, nrecs*buf->gridsize*sizeof(double));
+      if ( buf->array == NULL ) cdoAbort("Not enough memory for %d records!", nrecs);
+    }
+}
+
+/* Read all records of the current timestep */
+static
+void *tsbuf_read(void *arg)
+{
+  tsbuf_t *buf = (tsbuf_t *) arg;
+
+  for ( int recID = 0; recID < buf->nrecs; recID++ )
+    {
+      streamInqRecord(buf->streamID, &buf->varID[recID], &buf->levelID[recID]);
+      streamReadRecord(buf->streamID, buf->array+recID*buf->gridsize, &buf->nmiss[recID]);
+    }
+
+  return (NULL);
+}
+
+static
+void sfile_open(sfile_t *sf, int fileID)
+{
+  if ( cdoVerbose ) cdoPrint("process: %s", cdoStreamName(fileID)->args);
+
+  sf[fileID].streamID = streamOpenRead(cdoStreamName(fileID));
+  sf[fileID].vlistID  = streamInqVlist(sf[fileID].streamID);
+  sf[fileID].taxisID  = vlistInqTaxis(sf[fileID].vlistID);
+  sf[fileID].ispipe   = cdoStreamName(fileID)->args[0] == '-';
+}
+
+static
+void sfile_close(sfile_t *sf, int fileID)
+{
+  streamClose(sf[fileID].streamID);
+  sf[fileID].streamID = -1;
+}
+
+/* Go to the next timestep, returns the number of records */
+static
+int sfile_next(sfile_t *sf, int fileID)
+{
+  sf[fileID].nrecs = streamInqTimestep(sf[fileID].streamID, sf[fileID].tsID);
+  if ( sf[fileID].nrecs > 0 )
+    {
+      sf[fileID].vdate = taxisInqVdate(sf[fileID].taxisID);
+      sf[fileID].vtime = taxisInqVtime(sf[fileID].taxisID);
+    }
+
+  return (sf[fileID].nrecs);
+}
+
+/*
+  The files are merged with a heap ordered by the time of their next
+  timestep. While the records of one timestep are written, the next
+  timestep in time order is read by a second thread. With more input files
+  than can be kept open, the files are opened when their first timestep is
+  next and closed when they are exhausted.
+*/
 void *Mergetime(void *argument)
 {
-  int streamID1, streamID2 = CDI_UNDEFID;
+  int streamID2 = CDI_UNDEFID;
   int tsID2 = 0, recID, varID, levelID;
-  int vlistID1, vlistID2;
+  int vlistID2 = CDI_UNDEFID;
   int nfiles, fileID;
-  int taxisID1, taxisID2 = CDI_UNDEFID;
+  int taxisID2 = CDI_UNDEFID;
   int lcopy = FALSE;
-  int gridsize;
-  int nmiss;
+  int lazy = FALSE;
   int vdate, vtime;
   int last_vdate = -1, last_vtime = -1;
   int next_fileID;
   int skip_same_time = FALSE;
   int process_timestep;
+  int cur, nxt, lprefetch = FALSE;
+  int *heap = NULL, nheap = 0;
   const char *ofilename;
-  double *array = NULL;
-  typedef struct
-  {
-    int streamID;
-    int vlistID;
-    int taxisID;
-    int tsID;
-    int vdate;
-    int vtime;
-    int nrecs;
-  } sfile_t;
+  tsbuf_t tsbuf[2];
   sfile_t *sf = NULL;
+#if defined(HAVE_LIBPTHREAD)
+  pthread_t thrID;
+  int rval;
+#endif
 
   cdoInitialize(argument);
 
@@ -80,41 +252,37 @@ void *Mergetime(void *argument)
 
   nfiles = cdoStreamCnt() - 1;
 
-  sf = (sfile_t*) malloc(nfiles*sizeof(sfile_t));
-
-  for ( fileID = 0; fileID < nfiles; fileID++ )
-    {
-      if ( cdoVerbose ) cdoPrint("process: %s", cdoStreamName(fileID)->args);
-
-      streamID1 = streamOpenRead(cdoStreamName(fileID));
-
-      vlistID1 = streamInqVlist(streamID1);
-      taxisID1 = vlistInqTaxis(vlistID1);
-
-      sf[fileID].streamID = streamID1;
-      sf[fileID].vlistID  = vlistID1;
-      sf[fileID].taxisID  = taxisID1;
-    }
+  if ( nfiles > mergetime_maxopen() ) lazy = TRUE;
+  if ( cdoVerbose && lazy ) cdoPrint("Open at most %d input files at once", mergetime_maxopen());
 
-  
-  /* check that the contents is always the same */
-  for ( fileID = 1; fileID < nfiles; fileID++ )
-    vlistCompare(sf[0].vlistID, sf[fileID].vlistID, CMP_ALL);
+  sf   = (sfile_t*) malloc(nfiles*sizeof(sfile_t));
+  heap = (int*) malloc(nfiles*sizeof(int));
 
   /* read the first time step */
   for ( fileID = 0; fileID < nfiles; fileID++ )
     {
+      sfile_open(sf, fileID);
+
+      /* check that the contents is always the same */
+      if ( fileID == 0 )
+	{
+	  vlistID2 = vlistDuplicate(sf[0].vlistID);
+	  taxisID2 = taxisDuplicate(sf[0].taxisID);
+	  vlistDefTaxis(vlistID2, taxisID2);
+	}
+      else
+	vlistCompare(vlistID2, sf[fileID].vlistID, CMP_ALL);
+
       sf[fileID].tsID = 0;
-      sf[fileID].nrecs = streamInqTimestep(sf[fileID].streamID, sf[fileID].tsID);
-      if ( sf[fileID].nrecs == 0 )
+      if ( sfile_next(sf, fileID) == 0 )
 	{
-	  streamClose(sf[fileID].streamID);
-	  sf[fileID].streamID = -1;
+	  sfile_close(sf, fileID);
 	}
       else
 	{
-	  sf[fileID].vdate = taxisInqVdate(sf[fileID].taxisID);
-	  sf[fileID].vtime = taxisInqVtime(sf[fileID].taxisID);
+	  heap_push(heap, &nheap, sf, fileID);
+	  /* pipes can't be reopened */
+	  if ( lazy && !sf[fileID].ispipe ) sfile_close(sf, fileID);
 	}
     }
 
@@ -127,11 +295,16 @@ void *Mergetime(void *argument)
 
   streamID2 = streamOpenWrite(cdoStreamName(nfiles), cdoFiletype());
 
-  if ( ! lcopy )
+  for ( cur = 0; cur < 2; ++cur )
     {
-      gridsize = vlistGridsizeMax(sf[0].vlistID);
-      array = (double*) malloc(gridsize*sizeof(double));
+      tsbuf[cur].nalloc   = 0;
+      tsbuf[cur].gridsize = vlistGridsizeMax(vlistID2);
+      tsbuf[cur].varID    = NULL;
+      tsbuf[cur].levelID  = NULL;
+      tsbuf[cur].nmiss    = NULL;
+      tsbuf[cur].array    = NULL;
     }
+  cur = 0;
 
   while ( TRUE )
     {
@@ -140,16 +313,11 @@ void *Mergetime(void *argument)
       next_fileID = -1;
       vdate = 0;
       vtime = 0;
-      for ( fileID = 0; fileID < nfiles; fileID++ )
+      if ( nheap > 0 )
 	{
-	  if ( sf[fileID].streamID != -1 )
-	    if ( next_fileID == -1 || sf[fileID].vdate < vdate ||
-		 (sf[fileID].vdate == vdate && sf[fileID].vtime < vtime) )
-	      {
-		next_fileID = fileID;
-		vdate = sf[fileID].vdate;
-		vtime = sf[fileID].vtime;
-	      }
+	  next_fileID = heap_pop(heap, &nheap, sf);
+	  vdate = sf[next_fileID].vdate;
+	  vtime = sf[next_fileID].vtime;
 	}
 
       fileID = next_fileID;
@@ -159,6 +327,13 @@ void *Mergetime(void *argument)
 
       if ( next_fileID == -1 ) break;
 
+      if ( sf[fileID].streamID == -1 )
+	{
+	  sfile_open(sf, fileID);
+	  sf[fileID].tsID = 0;
+	  sfile_next(sf, fileID);
+	}
+
       if ( skip_same_time )
 	if ( vdate == last_vdate && vtime == last_vtime )
 	  {
@@ -170,18 +345,26 @@ void *Mergetime(void *argument)
 	    process_timestep = FALSE;
 	  }
 
+      /* the records of this timestep, prefetched or read now */
+      if ( lprefetch )
+	{
+#if defined(HAVE_LIBPTHREAD)
+	  rval = pthread_join(thrID, NULL);
+	  if ( rval != 0 ) cdoAbort("pthread_join failed!");
+#endif
+	  lprefetch = FALSE;
+	}
+      else if ( process_timestep && !lcopy )
+	{
+	  tsbuf[cur].streamID = sf[fileID].streamID;
+	  tsbuf[cur].nrecs    = sf[fileID].nrecs;
+	  tsbuf_resize(&tsbuf[cur], tsbuf[cur].nrecs);
+	  tsbuf_read(&tsbuf[cur]);
+	}
+
       if ( process_timestep )
 	{
-	  if ( tsID2 == 0 )
-	    {
-	      vlistID1 = sf[0].vlistID;
-	      vlistID2 = vlistDuplicate(vlistID1);
-	      taxisID1 = vlistInqTaxis(vlistID1);
-	      taxisID2 = taxisDuplicate(taxisID1);
-	      vlistDefTaxis(vlistID2, taxisID2);
-	      
-	      streamDefVlist(streamID2, vlistID2);
-	    }
+	  if ( tsID2 == 0 ) streamDefVlist(streamID2, vlistID2);
 
 	  last_vdate = vdate;
 	  last_vtime = vtime;
@@ -189,44 +372,74 @@ void *Mergetime(void *argument)
 	  taxisCopyTimestep(taxisID2, sf[fileID].taxisID);
 
 	  streamDefTimestep(streamID2, tsID2);
-	       
-	  for ( recID = 0; recID < sf[fileID].nrecs; recID++ )
-	    {
-	      streamInqRecord(sf[fileID].streamID, &varID, &levelID);
-	      streamDefRecord(streamID2,  varID,  levelID);
-	  
-	      if ( lcopy )
-		{
-		  streamCopyRecord(streamID2, sf[fileID].streamID); 
-		}
-	      else
-		{
-		  streamReadRecord(sf[fileID].streamID, array, &nmiss);
-		  streamWriteRecord(streamID2, array, nmiss);
-		}
-	    }
 
-	  tsID2++;
+	  if ( lcopy )
+	    for ( recID = 0; recID < sf[fileID].nrecs; recID++ )
+	      {
+		streamInqRecord(sf[fileID].streamID, &varID, &levelID);
+		streamDefRecord(streamID2,  varID,  levelID);
+		streamCopyRecord(streamID2, sf[fileID].streamID); 
+	      }
 	}
 
-      sf[fileID].nrecs = streamInqTimestep(sf[fileID].streamID, ++sf[fileID].tsID);
-      if ( sf[fileID].nrecs == 0 )
+      sf[fileID].tsID++;
+      if ( sfile_next(sf, fileID) == 0 )
+	sfile_close(sf, fileID);
+      else
+	heap_push(heap, &nheap, sf, fileID);
+
+      /* read the next timestep while this one is written */
+      nxt = 1 - cur;
+      if ( !lcopy && nheap > 0 )
 	{
-	  streamClose(sf[fileID].streamID);
-	  sf[fileID].streamID = -1;
+	  next_fileID = heap[0];
+	  if ( sf[next_fileID].streamID == -1 )
+	    {
+	      sfile_open(sf, next_fileID);
+	      sf[next_fileID].tsID = 0;
+	      sfile_next(sf, next_fileID);
+	    }
+
+	  tsbuf[nxt].streamID = sf[next_fileID].streamID;
+	  tsbuf[nxt].nrecs    = sf[next_fileID].nrecs;
+	  tsbuf_resize(&tsbuf[nxt], tsbuf[nxt].nrecs);
+#if defined(HAVE_LIBPTHREAD)
+	  rval = pthread_create(&thrID, NULL, tsbuf_read, &tsbuf[nxt]);
+	  if ( rval != 0 ) cdoAbort("pthread_create failed!");
+#else
+	  tsbuf_read(&tsbuf[nxt]);
+#endif
+	  lprefetch = TRUE;
 	}
-      else
+
+      if ( process_timestep )
 	{
-	  sf[fileID].vdate = taxisInqVdate(sf[fileID].taxisID);
-	  sf[fileID].vtime = taxisInqVtime(sf[fileID].taxisID);
+	  if ( !lcopy )
+	    for ( recID = 0; recID < tsbuf[cur].nrecs; recID++ )
+	      {
+		streamDefRecord(streamID2, tsbuf[cur].varID[recID], tsbuf[cur].levelID[recID]);
+		streamWriteRecord(streamID2, tsbuf[cur].array+recID*tsbuf[cur].gridsize, tsbuf[cur].nmiss[recID]);
+	      }
+
+	  tsID2++;
 	}
+
+      if ( lprefetch ) cur = nxt;
     }
 
   streamClose(streamID2);
 
-  if ( ! lcopy )
-    if ( array ) free(array);
+  for ( cur = 0; cur < 2; ++cur )
+    {
+      if ( tsbuf[cur].varID )   free(tsbuf[cur].varID);
+      if ( tsbuf[cur].levelID ) free(tsbuf[cur].levelID);
+      if ( tsbuf[cur].nmiss )   free(tsbuf[cur].nmiss);
+      if ( tsbuf[cur].array )   free(tsbuf[cur].array);
+    }
+
+  vlistDestroy(vlistID2);
 
+  if ( heap ) free(heap);
   if ( sf ) free(sf);
 
   cdoFinish();
@@ -35,6 +35,9 @@
       Remap       remap           SCRIP grid remapping
 */
 
+#include <unistd.h>  /* access */
+#include <errno.h>
+
 #include <cdi.h>
 #include "cdo.h"
 #include "cdo_int.h"
@@ -217,6 +220,8 @@ int lextrapolate = FALSE;
 int max_remaps = -1;
 int sort_mode = HEAP_SORT;
 double remap_frac_min = 0;
+int remap_mask_weights = FALSE;
+char *remap_cache_dir = NULL;
 
 
 static
@@ -349,6 +354,19 @@ void get_remap_env(void)
 	}
     }
 
+  envstr = getenv("REMAP_MASK_WEIGHTS");
+  if ( envstr )
+    {
+      int ival;
+      ival = atoi(envstr);
+      if ( ival >= 0 )
+	{
+	  remap_mask_weights = ival;
+	  if ( cdoVerbose )
+	    cdoPrint("Set REMAP_MASK_WEIGHTS to %d", remap_mask_weights);
+	}
+    }
+
   envstr = getenv("REMAP_NUM_SRCH_BINS");
   if ( envstr )
     {
@@ -446,6 +464,25 @@ void get_remap_env(void)
 	    }
 	}
     }
+
+  envstr = getenv("CDO_REMAP_CACHE");
+  if ( envstr && *envstr )
+    {
+#if defined(HAVE_LIBNETCDF)
+      /* a cache that can't be written must not stop the remapping */
+      if ( access(envstr, W_OK | X_OK) != 0 )
+	cdoWarning("CDO_REMAP_CACHE directory %s is not writable (%s), remap weight cache disabled!",
+		   envstr, strerror(errno));
+      else
+	{
+	  remap_cache_dir = envstr;
+	  if ( cdoVerbose )
+	    cdoPrint("Set CDO_REMAP_CACHE to %s", remap_cache_dir);
+	}
+#else
+      cdoWarning("CDO_REMAP_CACHE needs netCDF support, remap weight cache disabled!");
+#endif
+    }
 }
 
 static
@@ -698,15 +735,168 @@ void sort_remap_add(remapvars_t *remapvars)
 }
 
 
+/* the levels of a variable which use the same weights are remapped together */
+#define  MAX_REMAP_BATCH      32
+#define  MAX_REMAP_BATCH_MEM  (128*1024*1024)
+
+typedef struct {
+  int      max_batch;        /* max number of fields in the batch       */
+  int      nbatch;           /* actual number of fields in the batch    */
+  int      r;                /* remap used by all fields of the batch   */
+  int      varID;
+  int      gridsize;         /* source grid size of the fields          */
+  double   missval;
+  int      lrenorm;          /* TRUE if a field has missing values with mask independent weights */
+  int     *levelID;          /* level of each field [max_batch]         */
+  long     src_size;         /* distance of the source fields           */
+  long     dst_size;         /* distance of the target fields           */
+  double  *src_array;        /* source fields [max_batch*src_size]      */
+  double  *dst_array;        /* target fields [max_batch*dst_size]      */
+}
+remap_batch_t;
+
+static
+void remap_batch_init(remap_batch_t *batch, int vlistID, long src_size, long dst_size)
+{
+  int nzaxis, index, zaxissize;
+  int max_batch = 1;
+
+  nzaxis = vlistNzaxis(vlistID);
+  for ( index = 0; index < nzaxis; index++ )
+    {
+      zaxissize = zaxisInqSize(vlistZaxis(vlistID, index));
+      if ( zaxissize > max_batch ) max_batch = zaxissize;
+    }
+
+  if ( max_batch > MAX_REMAP_BATCH ) max_batch = MAX_REMAP_BATCH;
+  while ( max_batch > 1 && max_batch*(src_size+dst_size)*sizeof(double) > MAX_REMAP_BATCH_MEM ) max_batch--;
+
+  if ( cdoVerbose ) cdoPrint("Remap up to %d levels together", max_batch);
+
+  batch->max_batch = max_batch;
+  batch->nbatch    = 0;
+  batch->r         = -1;
+  batch->varID     = -1;
+  batch->gridsize  = 0;
+  batch->missval   = 0;
+  batch->lrenorm   = FALSE;
+  batch->src_size  = src_size;
+  batch->dst_size  = dst_size;
+  batch->levelID   = (int*) malloc(max_batch*sizeof(int));
+  batch->src_array = (double*) malloc(max_batch*src_size*sizeof(double));
+  batch->dst_array = (double*) malloc(max_batch*dst_size*sizeof(double));
+}
+
+static
+void remap_batch_free(remap_batch_t *batch)
+{
+  free(batch->levelID);
+  free(batch->src_array);
+  free(batch->dst_array);
+}
+
+static
+void remap_write_record(int streamID2, int vlistID1, int varID, int levelID, int gridID2, int operfunc,
+			int remap_order, remap_t *remap, int gridsize, double *array1, double *array2, double missval)
+{
+  int gridsize2;
+  int i, j, nmiss2;
+  char varname[CDI_MAX_NAME];
+
+  gridsize2 = gridInqSize(gridID2);
+
+  if ( operfunc == REMAPCON || operfunc == REMAPCON2 || operfunc == REMAPYCON )
+    {
+      /* used only to check the result of remapcon */
+      if ( 0 ) remap_normalize(remap->vars.norm_opt, gridsize2, array2, missval, &remap->tgt_grid);
+
+      remap_set_frac_min(gridsize2, array2, missval, &remap->tgt_grid);
+    }
+
+  if ( operfunc == REMAPSUM )
+    {
+      double array1sum = 0;
+      double array2sum = 0;
+   
+      for ( i = 0; i < gridsize; i++ )
+	printf("1 %d %g %g %g %g\n", i, array1[i], remap->src_grid.cell_frac[i], remap->src_grid.cell_area[i],remap->src_grid.cell_frac[i]);
+      for ( i = 0; i < gridsize; i++ )
+	array1sum += remap->src_grid.cell_area[i];
+
+      for ( i = 0; i < gridsize2; i++ )
+	printf("2 %d %g %g %g %g\n", i, array2[i], remap->tgt_grid.cell_frac[i],remap->tgt_grid.cell_area[i],remap->tgt_grid.cell_frac[i]);
+      for ( i = 0; i < gridsize2; i++ )
+	array2sum += remap->tgt_grid.cell_area[i];
+
+      printf("array1sum %g, array2sum %g\n", array1sum, array2sum);
+    }
+
+  vlistInqVarName(vlistID1, varID, varname);
+  if ( operfunc == REMAPCON || operfunc == REMAPCON2 || operfunc == REMAPYCON )
+    if ( strcmp(varname, "gridbox_area") == 0 )
+      {
+	scale_gridbox_area(gridsize, array1, gridsize2, array2, remap->tgt_grid.cell_area);
+      }
+
+  /* calculate some statistics */
+  if ( cdoVerbose )
+    remap_stat(remap_order, remap->src_grid, remap->tgt_grid, remap->vars, array1, array2, missval);
+
+  if ( gridInqType(gridID2) == GRID_GME )
+    {
+      int ni, nd;
+      ni = gridInqGMEni(gridID2);
+      nd = gridInqGMEnd(gridID2);
+      j = remap->tgt_grid.size;
+
+      for ( i = gridsize2-1; i >=0 ; i-- )
+	if ( remap->tgt_grid.vgpm[i] ) array2[i] = array2[--j];
+
+      gme_grid_restore(array2, ni, nd);
+    }
+
+  nmiss2 = 0;
+  for ( i = 0; i < gridsize2; i++ )
+    if ( DBL_IS_EQUAL(array2[i], missval) ) nmiss2++;
+
+  streamDefRecord(streamID2, varID, levelID);
+  streamWriteRecord(streamID2, array2, nmiss2);
+}
+
+static
+void remap_batch_flush(remap_batch_t *batch, remap_t *remaps, int streamID2, int vlistID1, int gridID2,
+		       int operfunc, int remap_order)
+{
+  int k;
+  int nbatch = batch->nbatch;
+  remap_t *remap;
+
+  if ( nbatch == 0 ) return;
+
+  remap = &remaps[batch->r];
+
+  remap_csr(batch->dst_array, batch->missval, batch->dst_size, nbatch, &remap->vars,
+	    batch->src_array, batch->src_size, batch->lrenorm, NULL, NULL, NULL);
+
+  for ( k = 0; k < nbatch; ++k )
+    remap_write_record(streamID2, vlistID1, batch->varID, batch->levelID[k], gridID2, operfunc, remap_order,
+		       remap, batch->gridsize, batch->src_array + k*batch->src_size,
+		       batch->dst_array + k*batch->dst_size, batch->missval);
+
+  batch->nbatch  = 0;
+  batch->lrenorm = FALSE;
+}
+
+
 void *Remap(void *argument)
 {
   int streamID2 = -1;
   int nrecs;
   int index;
   int tsID, recID, varID, levelID;
-  int gridsize, gridsize2;
+  int gridsize;
   int gridID1 = -1, gridID2;
-  int nmiss1, nmiss2, i, j, r = -1;
+  int nmiss1, nmiss_mask, i, j, r = -1;
   int *imask = NULL;
   int nremaps = 0;
   int norm_opt = NORM_OPT_NONE;
@@ -715,11 +905,13 @@ void *Remap(void *argument)
   int num_neighbors = 4;
   int need_gradiants = FALSE;
   int grid1sizemax;
-  char varname[CDI_MAX_NAME];
+  int lbatch;
+  int lmaskfree = FALSE;
   double missval;
   double *array1 = NULL, *array2 = NULL;
   double *grad1_lat = NULL, *grad1_lon = NULL, *grad1_latlon = NULL;
   remap_t *remaps = NULL;
+  remap_batch_t batch;
   char *remap_file = NULL;
 
   if ( cdoTimer ) init_remap_timer();
@@ -814,6 +1006,13 @@ void *Remap(void *argument)
   if ( lwrite_remap || operfunc == REMAPXXX )
     remap_genweights = TRUE;
 
+  if ( remap_cache_dir && operfunc != REMAPXXX )
+    {
+      /* cached weights are complete SCRIP weights like those of the gen operators */
+      remap_genweights = TRUE;
+      remap_set_int(REMAP_WRITE_REMAP, TRUE);
+    }
+
   if ( operfunc == REMAPXXX )
     {
       int gridsize2;
@@ -881,6 +1080,18 @@ void *Remap(void *argument)
 
   grid1sizemax = vlistGridsizeMax(vlistID1);
 
+  if ( map_type == MAP_TYPE_DISTWGT )
+    {
+      /* space for the halo of non global grids */
+      int ngrids = vlistNgrids(vlistID1);
+      for ( index = 0; index < ngrids; index++ )
+	{
+	  int gridIDx = vlistGrid(vlistID1, index);
+	  int gridsize_new = gridInqSize(gridIDx) + 4*(gridInqXsize(gridIDx)+2) + 4*(gridInqYsize(gridIDx)+2);
+	  if ( gridsize_new > grid1sizemax ) grid1sizemax = gridsize_new;
+	}
+    }
+
   if ( map_type == MAP_TYPE_BICUBIC ) need_gradiants = TRUE;
   if ( map_type == MAP_TYPE_CONSERV && remap_order == 2 )
     {
@@ -890,6 +1101,15 @@ void *Remap(void *argument)
   else
     remap_order = 1;
 
+  /*
+    The first order conservative weights are computed once for the full source grid.
+    Missing values are skipped when the weights are applied, the result is renormalized
+    like with weights of the masked grid. Otherwise the weights are computed for each mask.
+  */
+  if ( operfunc == REMAPCON && remap_order == 1 && !lwrite_remap && !remap_test &&
+       !remap_mask_weights && remap_frac_min <= 0 )
+    lmaskfree = TRUE;
+
   if ( need_gradiants )
     {
       grad1_lat    = (double*) malloc(grid1sizemax*sizeof(double));
@@ -897,11 +1117,9 @@ void *Remap(void *argument)
       grad1_latlon = (double*) malloc(grid1sizemax*sizeof(double));
     }
 
-  array1 = (double*) malloc(grid1sizemax*sizeof(double));
   imask  = (int*) malloc(grid1sizemax*sizeof(int));
 
-  gridsize = gridInqSize(gridID2);
-  array2   = (double*) malloc(gridsize*sizeof(double));
+  remap_batch_init(&batch, vlistID1, grid1sizemax, gridInqSize(gridID2));
 
   if ( ! lwrite_remap )
     {
@@ -920,6 +1138,7 @@ void *Remap(void *argument)
       for ( recID = 0; recID < nrecs; recID++ )
 	{
 	  streamInqRecord(streamID1, &varID, &levelID);
+	  array1 = batch.src_array + batch.nbatch*batch.src_size;
 	  streamReadRecord(streamID1, array1, &nmiss1);
 
 	  gridID1 = vlistInqVarGrid(vlistID1, varID);
@@ -929,9 +1148,12 @@ void *Remap(void *argument)
 	      if ( lwrite_remap ) continue;
 	      else
 		{
-		  nmiss2 = nmiss1;
+		  remap_batch_flush(&batch, remaps, streamID2, vlistID1, gridID2, operfunc, remap_order);
+		  array2 = batch.dst_array;
 		  *array2 = *array1;
-		  goto SKIPVAR;
+		  streamDefRecord(streamID2, varID, levelID);
+		  streamWriteRecord(streamID2, array2, nmiss1);
+		  continue;
 		}
 	    }
 
@@ -953,19 +1175,6 @@ void *Remap(void *argument)
 	      nx = gridInqXsize(gridID1);
 	      ny = gridInqYsize(gridID1);
 	      gridsize_new = gridsize + 4*(nx+2) + 4*(ny+2);
-	      if ( gridsize_new > grid1sizemax )
-		{
-		  grid1sizemax = gridsize_new;
-		  array1 = (double*) realloc(array1, grid1sizemax*sizeof(double));
-		  imask  = (int*) realloc(imask, grid1sizemax*sizeof(int));
-
-		  if ( need_gradiants )
-		    {
-		      grad1_lat    = (double*) realloc(grad1_lat, grid1sizemax*sizeof(double));
-		      grad1_lon    = (double*) realloc(grad1_lon, grid1sizemax*sizeof(double));
-		      grad1_latlon = (double*) realloc(grad1_latlon, grid1sizemax*sizeof(double));
-		    }
-		}
 	      
 	      for ( j = ny-1; j >= 0; j-- )
 		for ( i = nx-1; i >= 0; i-- )
@@ -977,15 +1186,24 @@ void *Remap(void *argument)
 	      nmiss1 += 4*(nx+2) + 4*(ny+2);
 	    }
 
-	  for ( i = 0; i < gridsize; i++ )
-	    if ( DBL_IS_EQUAL(array1[i], missval) )
-	      imask[i] = FALSE;
-	    else
-	      imask[i] = TRUE;
+	  if ( lmaskfree )
+	    {
+	      for ( i = 0; i < gridsize; i++ ) imask[i] = TRUE;
+	      nmiss_mask = 0;
+	    }
+	  else
+	    {
+	      for ( i = 0; i < gridsize; i++ )
+		if ( DBL_IS_EQUAL(array1[i], missval) )
+		  imask[i] = FALSE;
+		else
+		  imask[i] = TRUE;
+	      nmiss_mask = nmiss1;
+	    }
 
 	  for ( r = nremaps-1; r >= 0; r-- )
 	    {
-	      if ( gridID1 == remaps[r].gridID && nmiss1 == remaps[r].nmiss )
+	      if ( gridID1 == remaps[r].gridID && nmiss_mask == remaps[r].nmiss )
 		{
 		  if ( memcmp(imask, remaps[r].src_grid.mask, remaps[r].src_grid.size*sizeof(int)) == 0 )
 		    break;
@@ -994,6 +1212,19 @@ void *Remap(void *argument)
 
 	  if ( cdoVerbose && r >= 0 ) cdoPrint("Using remap %d", r);
 
+	  /* levels with the same weights are collected and remapped together */
+	  lbatch = remap_genweights && !need_gradiants && operfunc != REMAPLAF && operfunc != REMAPSUM;
+
+	  if ( batch.nbatch > 0 && (!lbatch || r < 0 || r != batch.r || varID != batch.varID) )
+	    {
+	      remap_batch_flush(&batch, remaps, streamID2, vlistID1, gridID2, operfunc, remap_order);
+	      if ( array1 != batch.src_array )
+		{
+		  memcpy(batch.src_array, array1, gridsize*sizeof(double));
+		  array1 = batch.src_array;
+		}
+	    }
+
 	  if ( r < 0 )
 	    {
 	      if ( nremaps < max_remaps )
@@ -1050,7 +1281,7 @@ void *Remap(void *argument)
 		}
 
 	      remaps[r].gridID = gridID1;
-	      remaps[r].nmiss  = nmiss1;
+	      remaps[r].nmiss  = nmiss_mask;
 
 	      if ( gridInqType(gridID1) == GRID_GME )
 		{
@@ -1076,18 +1307,53 @@ void *Remap(void *argument)
 
 	      if ( remap_genweights )
 		{
-		  print_remap_info(operfunc, &remaps[r].src_grid, &remaps[r].tgt_grid, nmiss1);
+		  char *cachefile = NULL;
+		  int lockfd = -1;
+		  int lcached = FALSE;
+
+		  if ( remap_cache_dir )
+		    {
+		      int iparam[] = {map_type, submap_type, num_neighbors, remap_order, norm_opt,
+				      remap_extrapolate, remap_num_srch_bins};
+		      double dparam[] = {remap_search_radius, remap_threshhold};
+
+		      cachefile = remap_cache_filename(remap_cache_dir, iparam, sizeof(iparam)/sizeof(int),
+						       dparam, sizeof(dparam)/sizeof(double),
+						       &remaps[r].src_grid, &remaps[r].tgt_grid);
+
+		      lcached = remap_cache_read(cachefile, gridID1, gridID2, &remaps[r]);
+		      if ( !lcached )
+			{
+			  /* an other process may have computed the weights while waiting for the lock */
+			  lockfd = remap_cache_lock(cachefile);
+			  lcached = remap_cache_read(cachefile, gridID1, gridID2, &remaps[r]);
+			}
+		    }
+
+		  if ( !lcached )
+		    {
+		      print_remap_info(operfunc, &remaps[r].src_grid, &remaps[r].tgt_grid, nmiss_mask);
 
-		  if      ( map_type == MAP_TYPE_CONSERV     ) scrip_remap_weights_conserv(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
-		  else if ( map_type == MAP_TYPE_BILINEAR    ) scrip_remap_weights_bilinear(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
-		  else if ( map_type == MAP_TYPE_BICUBIC     ) scrip_remap_weights_bicubic(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
-		  else if ( map_type == MAP_TYPE_DISTWGT     ) scrip_remap_weights_distwgt(num_neighbors, &remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
-		  else if ( map_type == MAP_TYPE_CONSERV_YAC ) remap_weights_conserv(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
+		      if      ( map_type == MAP_TYPE_CONSERV     ) scrip_remap_weights_conserv(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
+		      else if ( map_type == MAP_TYPE_BILINEAR    ) scrip_remap_weights_bilinear(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
+		      else if ( map_type == MAP_TYPE_BICUBIC     ) scrip_remap_weights_bicubic(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
+		      else if ( map_type == MAP_TYPE_DISTWGT     ) scrip_remap_weights_distwgt(num_neighbors, &remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
+		      else if ( map_type == MAP_TYPE_CONSERV_YAC ) remap_weights_conserv(&remaps[r].src_grid, &remaps[r].tgt_grid, &remaps[r].vars);
 
-		  if ( map_type == MAP_TYPE_CONSERV && remaps[r].vars.num_links != remaps[r].vars.max_links )
-		    resize_remap_vars(&remaps[r].vars, remaps[r].vars.num_links-remaps[r].vars.max_links);
+		      if ( map_type == MAP_TYPE_CONSERV && remaps[r].vars.num_links != remaps[r].vars.max_links )
+			resize_remap_vars(&remaps[r].vars, remaps[r].vars.num_links-remaps[r].vars.max_links);
 		  
-		  if ( remaps[r].vars.sort_add ) sort_remap_add(&remaps[r].vars);
+		      if ( remaps[r].vars.sort_add ) sort_remap_add(&remaps[r].vars);
+
+		      if ( cachefile )
+			remap_cache_write(cachefile, map_type, submap_type, num_neighbors, remap_order, &remaps[r]);
+		    }
+
+		  if ( cachefile )
+		    {
+		      remap_cache_unlock(lockfd);
+		      free(cachefile);
+		    }
 
 		  if ( lwrite_remap ) goto WRITE_REMAP;
 
@@ -1102,6 +1368,27 @@ void *Remap(void *argument)
 		if ( remaps[r].src_grid.vgpm[i] ) array1[j++] = array1[i];
 	    }
 	  
+	  if ( lbatch )
+	    {
+	      if ( batch.nbatch == 0 )
+		{
+		  batch.r        = r;
+		  batch.varID    = varID;
+		  batch.gridsize = gridsize;
+		  batch.missval  = missval;
+		}
+
+	      if ( lmaskfree && nmiss1 > 0 ) batch.lrenorm = TRUE;
+	      batch.levelID[batch.nbatch++] = levelID;
+
+	      if ( batch.nbatch == batch.max_batch )
+		remap_batch_flush(&batch, remaps, streamID2, vlistID1, gridID2, operfunc, remap_order);
+
+	      continue;
+	    }
+
+	  array2 = batch.dst_array;
+
 	  if ( remap_genweights )
 	    {
 	      if ( need_gradiants )
@@ -1119,9 +1406,8 @@ void *Remap(void *argument)
 		remap_sum(array2, missval, gridInqSize(gridID2), remaps[r].vars.num_links, remaps[r].vars.wts,
 			  remaps[r].vars.num_wts, remaps[r].vars.tgt_cell_add, remaps[r].vars.src_cell_add, array1);
 	      else
-		remap(array2, missval, gridInqSize(gridID2), remaps[r].vars.num_links, remaps[r].vars.wts,
-		      remaps[r].vars.num_wts, remaps[r].vars.tgt_cell_add, remaps[r].vars.src_cell_add,
-		      array1, grad1_lat, grad1_lon, grad1_latlon, remaps[r].vars.links);
+		remap_csr(array2, missval, gridInqSize(gridID2), 1, &remaps[r].vars,
+			  array1, grid1sizemax, FALSE, grad1_lat, grad1_lon, grad1_latlon);
 	    }
 	  else
 	    {
@@ -1130,67 +1416,12 @@ void *Remap(void *argument)
 	      else if ( map_type == MAP_TYPE_CONSERV_YAC ) remap_conserv(&remaps[r].src_grid, &remaps[r].tgt_grid, array1, array2, missval);
 	    }
 
-	  gridsize2 = gridInqSize(gridID2);
-
-	  if ( operfunc == REMAPCON || operfunc == REMAPCON2 || operfunc == REMAPYCON )
-	    {
-	      /* used only to check the result of remapcon */
-	      if ( 0 ) remap_normalize(remaps[r].vars.norm_opt, gridsize2, array2, missval, &remaps[r].tgt_grid);
-
-	      remap_set_frac_min(gridsize2, array2, missval, &remaps[r].tgt_grid);
-	    }
-
-	  if ( operfunc == REMAPSUM )
-	    {
-	      double array1sum = 0;
-	      double array2sum = 0;
-   
-	      for ( i = 0; i < gridsize; i++ )
-		printf("1 %d %g %g %g %g\n", i, array1[i], remaps[r].src_grid.cell_frac[i], remaps[r].src_grid.cell_area[i],remaps[r].src_grid.cell_frac[i]);
-	      for ( i = 0; i < gridsize; i++ )
-		array1sum += remaps[r].src_grid.cell_area[i];
-
-	      for ( i = 0; i < gridsize2; i++ )
-		printf("2 %d %g %g %g %g\n", i, array2[i], remaps[r].tgt_grid.cell_frac[i],remaps[r].tgt_grid.cell_area[i],remaps[r].tgt_grid.cell_frac[i]);
-	      for ( i = 0; i < gridsize2; i++ )
-		array2sum += remaps[r].tgt_grid.cell_area[i];
-
-	      printf("array1sum %g, array2sum %g\n", array1sum, array2sum);
-	    }
-
-	  vlistInqVarName(vlistID1, varID, varname);
-	  if ( operfunc == REMAPCON || operfunc == REMAPCON2 || operfunc == REMAPYCON )
-	    if ( strcmp(varname, "gridbox_area") == 0 )
-	      {
-		scale_gridbox_area(gridsize, array1, gridsize2, array2, remaps[r].tgt_grid.cell_area);
-	      }
-
-	  /* calculate some statistics */
-	  if ( cdoVerbose )
-	    remap_stat(remap_order, remaps[r].src_grid, remaps[r].tgt_grid, remaps[r].vars, array1, array2, missval);
-
-	  if ( gridInqType(gridID2) == GRID_GME )
-	    {
-	      int ni, nd;
- 	      ni = gridInqGMEni(gridID2);
-	      nd = gridInqGMEnd(gridID2);
-	      j = remaps[r].tgt_grid.size;
-
-	      for ( i = gridsize2-1; i >=0 ; i-- )
-		if ( remaps[r].tgt_grid.vgpm[i] ) array2[i] = array2[--j];
-
-	      gme_grid_restore(array2, ni, nd);
-	    }
-
-	  nmiss2 = 0;
-	  for ( i = 0; i < gridsize2; i++ )
-	    if ( DBL_IS_EQUAL(array2[i], missval) ) nmiss2++;
+	  remap_write_record(streamID2, vlistID1, varID, levelID, gridID2, operfunc, remap_order,
+			     &remaps[r], gridsize, array1, array2, missval);
+	}
 
-	SKIPVAR:
+      remap_batch_flush(&batch, remaps, streamID2, vlistID1, gridID2, operfunc, remap_order);
 
-	  streamDefRecord(streamID2, varID, levelID);
-	  streamWriteRecord(streamID2, array2, nmiss2);
-	}
       tsID++;
     }
 
@@ -1205,8 +1436,7 @@ void *Remap(void *argument)
   streamClose(streamID1);
 
   if ( imask )  free(imask);
-  if ( array2 ) free(array2);
-  if ( array1 ) free(array1);
+  remap_batch_free(&batch);
 
   if ( grad1_latlon ) free(grad1_latlon);
   if ( grad1_lon ) free(grad1_lon);
@@ -33,25 +33,23 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "runacc.h"
 
 
 void *Runstat(void *argument)
 {
   int timestat_date = TIMESTAT_MEAN;
   int gridsize;
-  int i;
   int varID;
   int recID;
   int nrecs;
   int levelID;
   int tsID;
   int otsID;
-  int inp, its;
   int nmiss;
   int nlevel;
   int runstat_nomiss = 0;
   double missval;
-  field_t ***vars1 = NULL, ***vars2 = NULL, ***samp1 = NULL;
 
   cdoInitialize(argument);
 
@@ -79,11 +77,6 @@ void *Runstat(void *argument)
   operatorInputArg("number of timesteps");
   int ndates = parameter2int(operatorArgv()[0]);
 
-  int lmean   = operfunc == func_mean || operfunc == func_avg;
-  int lstd    = operfunc == func_std || operfunc == func_std1;
-  int lvarstd = operfunc == func_std || operfunc == func_var || operfunc == func_std1 || operfunc == func_var1;
-  double divisor = operfunc == func_std1 || operfunc == func_var1;
-
   int streamID1 = streamOpenRead(cdoStreamName(0));
 
   int vlistID1 = streamInqVlist(streamID1);
@@ -107,23 +100,20 @@ void *Runstat(void *argument)
   dtlist_set_stat(dtlist, timestat_date);
   dtlist_set_calendar(dtlist, taxisInqCalendar(taxisID1));
 
-  vars1 = (field_t ***) malloc((ndates+1)*sizeof(field_t **));
-  if ( !runstat_nomiss )
-    samp1 = (field_t ***) malloc((ndates+1)*sizeof(field_t **));
-  if ( lvarstd )
-    vars2 = (field_t ***) malloc((ndates+1)*sizeof(field_t **));
-
-  for ( its = 0; its < ndates; its++ )
+  runacc_t ***racc = (runacc_t ***) malloc(nvars*sizeof(runacc_t **));
+  for ( varID = 0; varID < nvars; varID++ )
     {
-      vars1[its] = field_malloc(vlistID1, FIELD_PTR);
-      if ( !runstat_nomiss )
-	samp1[its] = field_malloc(vlistID1, FIELD_PTR);
-      if ( lvarstd )
-	vars2[its] = field_malloc(vlistID1, FIELD_PTR);
+      gridsize = gridInqSize(vlistInqVarGrid(vlistID1, varID));
+      nlevel   = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+      missval  = vlistInqVarMissval(vlistID1, varID);
+
+      racc[varID] = (runacc_t **) malloc(nlevel*sizeof(runacc_t *));
+      for ( levelID = 0; levelID < nlevel; levelID++ )
+	racc[varID][levelID] = runaccNew(operfunc, ndates, gridsize, missval);
     }
 
   int gridsizemax = vlistGridsizeMax(vlistID1);
-  int *imask = (int*) malloc(gridsizemax*sizeof(int));
+  double *array = (double*) malloc(gridsizemax*sizeof(double));
 
   for ( tsID = 0; tsID < ndates; tsID++ )
     {
@@ -142,101 +132,17 @@ void *Runstat(void *argument)
 	      recLevelID[recID] = levelID;
 	    }
 	  
-	  streamReadRecord(streamID1, vars1[tsID][varID][levelID].ptr, &nmiss);
-	  vars1[tsID][varID][levelID].nmiss = nmiss;
+	  streamReadRecord(streamID1, array, &nmiss);
 
 	  if ( runstat_nomiss && nmiss > 0 ) cdoAbort("Missing values supported swichted off!");
 
-	  if ( !runstat_nomiss )
-	    {
-	      gridsize = gridInqSize(vars1[0][varID][levelID].grid);
-	      missval  = vars1[0][varID][levelID].missval;
-
-	      for ( i = 0; i < gridsize; i++ )
-		if ( DBL_IS_EQUAL(vars1[tsID][varID][levelID].ptr[i], missval) )
-		  imask[i] = 0;
-		else
-		  imask[i] = 1;
-
-	      for ( i = 0; i < gridsize; i++ )
-		samp1[tsID][varID][levelID].ptr[i] = (double) imask[i];
-
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(i, inp)
-#endif
-	      for ( inp = 0; inp < tsID; inp++ )
-		{
-		  double *ptr = samp1[inp][varID][levelID].ptr;
-		  for ( i = 0; i < gridsize; i++ )
-		    if ( imask[i] > 0 ) ptr[i]++;
-		}
-	    }
-
-	  if ( lvarstd )
-	    {
-	      farmoq(&vars2[tsID][varID][levelID], vars1[tsID][varID][levelID]);
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared)
-#endif
-	      for ( inp = 0; inp < tsID; inp++ )
-		{
-		  farsumq(&vars2[inp][varID][levelID], vars1[tsID][varID][levelID]);
-		  farsum(&vars1[inp][varID][levelID], vars1[tsID][varID][levelID]);
-		}
-	    }
-	  else
-	    {
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared)
-#endif
-	      for ( inp = 0; inp < tsID; inp++ )
-		{
-		  farfun(&vars1[inp][varID][levelID], vars1[tsID][varID][levelID], operfunc);
-		}
-	    }
+	  runaccAdd(racc[varID][levelID], array);
 	}
     }
 
   otsID = 0;
   while ( TRUE )
     {
-      if ( lmean )
-	for ( varID = 0; varID < nvars; varID++ )
-	  {
-	    if ( vlistInqVarTsteptype(vlistID1, varID) == TSTEP_CONSTANT ) continue;
-	    nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
-	    for ( levelID = 0; levelID < nlevel; levelID++ )
-	      {
-		if ( runstat_nomiss )
-		  farcmul(&vars1[0][varID][levelID], 1.0/ndates);
-		else
-		  fardiv(&vars1[0][varID][levelID], samp1[0][varID][levelID]);
-	      }
-	  }
-      else if ( lvarstd )
-	for ( varID = 0; varID < nvars; varID++ )
-	  {
-	    if ( vlistInqVarTsteptype(vlistID1, varID) == TSTEP_CONSTANT ) continue;
-	    nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
-	    for ( levelID = 0; levelID < nlevel; levelID++ )
-	      {
-		if ( runstat_nomiss )
-		  {
-		    if ( lstd )
-		      farcstdx(&vars1[0][varID][levelID], vars2[0][varID][levelID], ndates, divisor);
-		    else
-		      farcvarx(&vars1[0][varID][levelID], vars2[0][varID][levelID], ndates, divisor);
-		  }
-		else
-		  {
-		    if ( lstd )
-		      farstdx(&vars1[0][varID][levelID], vars2[0][varID][levelID], samp1[0][varID][levelID], divisor);
-		    else
-		      farvarx(&vars1[0][varID][levelID], vars2[0][varID][levelID], samp1[0][varID][levelID], divisor);
-		  }
-	      }
-	  }
-
       dtlist_stat_taxisDefTimestep(dtlist, taxisID2, ndates);
       streamDefTimestep(streamID2, otsID);
 
@@ -247,29 +153,16 @@ void *Runstat(void *argument)
 
 	  if ( otsID && vlistInqVarTsteptype(vlistID1, varID) == TSTEP_CONSTANT ) continue;
 
+	  nmiss = runaccStat(racc[varID][levelID], operfunc, array);
+
 	  streamDefRecord(streamID2, varID, levelID);
-	  streamWriteRecord(streamID2, vars1[0][varID][levelID].ptr, vars1[0][varID][levelID].nmiss);
+	  streamWriteRecord(streamID2, array, nmiss);
 	}
 
       otsID++;
 
       dtlist_shift(dtlist);
 
-      vars1[ndates] = vars1[0];
-      if ( !runstat_nomiss )
-	samp1[ndates] = samp1[0];
-      if ( lvarstd )
-        vars2[ndates] = vars2[0];
-
-      for ( inp = 0; inp < ndates; inp++ )
-	{
-	  vars1[inp] = vars1[inp+1];
-	  if ( !runstat_nomiss )
-	    samp1[inp] = samp1[inp+1];
-	  if ( lvarstd )
-	    vars2[inp] = vars2[inp+1];
-	}
-
       nrecs = streamInqTimestep(streamID1, tsID);
       if ( nrecs == 0 ) break;
 
@@ -279,77 +172,28 @@ void *Runstat(void *argument)
 	{
 	  streamInqRecord(streamID1, &varID, &levelID);
 	  
-	  streamReadRecord(streamID1, vars1[ndates-1][varID][levelID].ptr, &nmiss);
-	  vars1[ndates-1][varID][levelID].nmiss = nmiss;
+	  streamReadRecord(streamID1, array, &nmiss);
 
 	  if ( runstat_nomiss && nmiss > 0 ) cdoAbort("Missing values supported swichted off!");
 
-	  if ( !runstat_nomiss )
-	    {
-	      gridsize = gridInqSize(vars1[0][varID][levelID].grid);
-	      missval  = vars1[0][varID][levelID].missval;
-
-	      for ( i = 0; i < gridsize; i++ )
-		if ( DBL_IS_EQUAL(vars1[ndates-1][varID][levelID].ptr[i], missval) )
-		  imask[i] = 0;
-		else
-		  imask[i] = 1;
-
-	      for ( i = 0; i < gridsize; i++ )
-		samp1[ndates-1][varID][levelID].ptr[i] = (double) imask[i];
-
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(i, inp)
-#endif
-	      for ( inp = 0; inp < ndates-1; inp++ )
-		{
-		  double *ptr = samp1[inp][varID][levelID].ptr;
-		  for ( i = 0; i < gridsize; i++ )
-		    if ( imask[i] > 0 ) ptr[i]++;
-		}
-	    }
-
-	  if ( lvarstd )
-	    {
-	      farmoq(&vars2[ndates-1][varID][levelID], vars1[ndates-1][varID][levelID]);
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared)
-#endif
-	      for ( inp = 0; inp < ndates-1; inp++ )
-		{
-		  farsumq(&vars2[inp][varID][levelID], vars1[ndates-1][varID][levelID]);
-		  farsum(&vars1[inp][varID][levelID], vars1[ndates-1][varID][levelID]);
-		}
-	    }
-	  else
-	    {
-#if defined(_OPENMP)
-#pragma omp parallel for default(shared)
-#endif
-	      for ( inp = 0; inp < ndates-1; inp++ )
-		{
-		  farfun(&vars1[inp][varID][levelID], vars1[ndates-1][varID][levelID], operfunc);
-		}
-	    }
+	  runaccAdd(racc[varID][levelID], array);
 	}
 
       tsID++;
     }
 
-  for ( its = 0; its < ndates; its++ )
+  for ( varID = 0; varID < nvars; varID++ )
     {
-      field_free(vars1[its], vlistID1);
-      if ( !runstat_nomiss ) field_free(samp1[its], vlistID1);
-      if ( lvarstd ) field_free(vars2[its], vlistID1);
+      nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+      for ( levelID = 0; levelID < nlevel; levelID++ )
+	runaccDelete(racc[varID][levelID]);
+      free(racc[varID]);
     }
-
-  free(vars1);
-  if ( !runstat_nomiss ) free(samp1);
-  if ( lvarstd ) free(vars2);
+  free(racc);
 
   if ( recVarID   ) free(recVarID);
   if ( recLevelID ) free(recLevelID);
-  if ( imask )      free(imask);
+  if ( array )      free(array);
 
   dtlist_delete(dtlist);
 
@@ -63,27 +63,38 @@ void *Seaspctl(void *argument)
 
   season_start = get_season_start();
 
+  /* the percentile sketch needs no min/max files, the output time steps are taken from ifile1 */
+  int lbounds = hsetNeedsBounds();
+  int streamID2 = CDI_UNDEFID, streamID3 = CDI_UNDEFID;
+  int taxisID2 = CDI_UNDEFID, taxisID3 = CDI_UNDEFID;
+
   int streamID1 = streamOpenRead(cdoStreamName(0));
-  int streamID2 = streamOpenRead(cdoStreamName(1));
-  int streamID3 = streamOpenRead(cdoStreamName(2));
 
   int vlistID1 = streamInqVlist(streamID1);
-  int vlistID2 = streamInqVlist(streamID2);
-  int vlistID3 = streamInqVlist(streamID3);
   int vlistID4 = vlistDuplicate(vlistID1);
 
-  vlistCompare(vlistID1, vlistID2, CMP_ALL);
-  vlistCompare(vlistID1, vlistID3, CMP_ALL);
+  if ( lbounds )
+    {
+      streamID2 = streamOpenRead(cdoStreamName(1));
+      streamID3 = streamOpenRead(cdoStreamName(2));
+
+      int vlistID2 = streamInqVlist(streamID2);
+      int vlistID3 = streamInqVlist(streamID3);
+
+      vlistCompare(vlistID1, vlistID2, CMP_ALL);
+      vlistCompare(vlistID1, vlistID3, CMP_ALL);
+
+      taxisID2 = vlistInqTaxis(vlistID2);
+      taxisID3 = vlistInqTaxis(vlistID3);
+      /* TODO - check that time axes 2 and 3 are equal */
+    }
 
   int taxisID1 = vlistInqTaxis(vlistID1);
-  int taxisID2 = vlistInqTaxis(vlistID2);
-  int taxisID3 = vlistInqTaxis(vlistID3);
-  /* TODO - check that time axes 2 and 3 are equal */
 
   int taxisID4 = taxisDuplicate(taxisID1);
   vlistDefTaxis(vlistID4, taxisID4);
 
-  int streamID4 = streamOpenWrite(cdoStreamName(3), cdoFiletype());
+  int streamID4 = streamOpenWrite(cdoStreamName(lbounds ? 3 : 1), cdoFiletype());
 
   streamDefVlist(streamID4, vlistID4);
 
@@ -127,33 +138,41 @@ void *Seaspctl(void *argument)
   otsID   = 0;
   while ( TRUE )
     {
-      nrecs = streamInqTimestep(streamID2, otsID);
-      if ( nrecs != streamInqTimestep(streamID3, otsID) )
-        cdoAbort("Number of records at time step %d of %s and %s differ!", otsID+1, cdoStreamName(1)->args, cdoStreamName(2)->args);
-      
-      vdate2 = taxisInqVdate(taxisID2);
-      vtime2 = taxisInqVtime(taxisID2);
-      vdate3 = taxisInqVdate(taxisID3);
-      vtime3 = taxisInqVtime(taxisID3);
-      if ( vdate2 != vdate3 || vtime2 != vtime3 )
-        cdoAbort("Verification dates at time step %d of %s and %s differ!", otsID+1, cdoStreamName(1)->args, cdoStreamName(2)->args);
-
-      for ( recID = 0; recID < nrecs; recID++ )
+      if ( lbounds )
         {
-          streamInqRecord(streamID2, &varID, &levelID);
-	  streamReadRecord(streamID2, vars1[varID][levelID].ptr, &nmiss);
-          vars1[varID][levelID].nmiss = nmiss;
+          nrecs = streamInqTimestep(streamID2, otsID);
+          if ( nrecs != streamInqTimestep(streamID3, otsID) )
+            cdoAbort("Number of records at time step %d of %s and %s differ!", otsID+1, cdoStreamName(1)->args, cdoStreamName(2)->args);
+
+          vdate2 = taxisInqVdate(taxisID2);
+          vtime2 = taxisInqVtime(taxisID2);
+          vdate3 = taxisInqVdate(taxisID3);
+          vtime3 = taxisInqVtime(taxisID3);
+          if ( vdate2 != vdate3 || vtime2 != vtime3 )
+            cdoAbort("Verification dates at time step %d of %s and %s differ!", otsID+1, cdoStreamName(1)->args, cdoStreamName(2)->args);
+
+          for ( recID = 0; recID < nrecs; recID++ )
+            {
+              streamInqRecord(streamID2, &varID, &levelID);
+              streamReadRecord(streamID2, vars1[varID][levelID].ptr, &nmiss);
+              vars1[varID][levelID].nmiss = nmiss;
+            }
+
+          for ( recID = 0; recID < nrecs; recID++ )
+            {
+              streamInqRecord(streamID3, &varID, &levelID);
+              streamReadRecord(streamID3, field.ptr, &nmiss);
+              field.nmiss   = nmiss;
+              field.grid    = vars1[varID][levelID].grid;
+              field.missval = vars1[varID][levelID].missval;
+
+              hsetDefVarLevelBounds(hset, varID, levelID, &vars1[varID][levelID], &field);
+            }
         }
-
-      for ( recID = 0; recID < nrecs; recID++ )
+      else
         {
-          streamInqRecord(streamID3, &varID, &levelID);
-	  streamReadRecord(streamID3, field.ptr, &nmiss);
-          field.nmiss   = nmiss;
-          field.grid    = vars1[varID][levelID].grid;
-	  field.missval = vars1[varID][levelID].missval;
-	  
-	  hsetDefVarLevelBounds(hset, varID, levelID, &vars1[varID][levelID], &field);
+          hsetReset(hset);
+          nrecs = 1;  /* the periods are defined by ifile1 only */
         }
 
       nsets   = 0;
@@ -268,8 +287,11 @@ void *Seaspctl(void *argument)
   if ( recLevelID ) free(recLevelID);
 
   streamClose(streamID4);
-  streamClose(streamID3);
-  streamClose(streamID2);
+  if ( lbounds )
+    {
+      streamClose(streamID3);
+      streamClose(streamID2);
+    }
   streamClose(streamID1);
 
   cdoFinish();
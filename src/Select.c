@@ -802,6 +802,14 @@ void *Select(void *argument)
 	  vlistCompare(vlistID0, vlistID1, CMP_ALL);
 	}
 
+      /* tell the reader which records are not needed */
+      for ( varID = 0; varID < nvars; varID++ )
+	{
+	  zaxisID = vlistInqVarZaxis(vlistID0, varID);
+	  nlevs   = zaxisInqSize(zaxisID);
+	  for ( levID = 0; levID < nlevs; levID++ )
+	    streamDefRecordFilter(streamID1, varID, levID, vlistInqFlag(vlistID0, varID, levID));
+	}
 
       if ( nvars2 == 0 )
 	{
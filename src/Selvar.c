@@ -376,6 +376,15 @@ void *Selvar(void *argument)
 
   if ( npar == 0 ) cdoAbort("No variables selected!");
 
+  /* tell the reader which records are not needed */
+  for ( varID = 0; varID < nvars; varID++ )
+    {
+      zaxisID = vlistInqVarZaxis(vlistID1, varID);
+      nlevs   = zaxisInqSize(zaxisID);
+      for ( levID = 0; levID < nlevs; levID++ )
+	streamDefRecordFilter(streamID1, varID, levID, vlistInqFlag(vlistID1, varID, levID));
+    }
+
   int vlistID2 = vlistCreate();
   vlistCopyFlag(vlistID2, vlistID1);
 
@@ -32,6 +32,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "par_io.h"
 
 void create_uuid(unsigned char uuid[CDI_UUID_SIZE]);
 void uuid2str(const unsigned char *uuid, char *uuidstr);
@@ -78,6 +79,7 @@ void *Split(void *argument)
   int nmiss;
   int swap_obase = FALSE;
   const char *uuid_attribute = NULL;
+  par_write_t *pw = NULL;
 
   cdoInitialize(argument);
 
@@ -104,6 +106,8 @@ void *Split(void *argument)
 
   if ( UNCHANGED_RECORD ) lcopy = TRUE;
 
+  if ( ! lcopy ) pw = parWriteNew(cdoFiletype());
+
   int streamID1 = streamOpenRead(cdoStreamName(0));
 
   int vlistID1 = streamInqVlist(streamID1);
@@ -182,9 +186,7 @@ void *Split(void *argument)
 	      gen_filename(filename, swap_obase, cdoStreamName(1)->args, filesuffix);
 	    }
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamIDs[index] = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamIDs[index] = parWriteOpen(pw, filename, cdoFiletype());
 	}
       if ( codes ) free(codes);
     }
@@ -239,9 +241,7 @@ void *Split(void *argument)
 	  strcat(filename, paramstr);
 	  gen_filename(filename, swap_obase, cdoStreamName(1)->args, filesuffix);
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamIDs[index] = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamIDs[index] = parWriteOpen(pw, filename, cdoFiletype());
 	}
       if ( params ) free(params);
     }
@@ -291,9 +291,7 @@ void *Split(void *argument)
 	  sprintf(filename+nchars, "%03d", tabnums[index]);
 	  gen_filename(filename, swap_obase, cdoStreamName(1)->args, filesuffix);
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamIDs[index] = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamIDs[index] = parWriteOpen(pw, filename, cdoFiletype());
 	}
       if ( tabnums ) free(tabnums);
     }
@@ -326,9 +324,7 @@ void *Split(void *argument)
 	  strcat(filename, varname);
 	  gen_filename(filename, swap_obase, cdoStreamName(1)->args, filesuffix);
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamIDs[index] = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamIDs[index] = parWriteOpen(pw, filename, cdoFiletype());
 	}
     }
   else if ( operatorID == SPLITLEVEL )
@@ -379,9 +375,7 @@ void *Split(void *argument)
 	  sprintf(filename+nchars, "%06g", levels[index]);
 	  gen_filename(filename, swap_obase, cdoStreamName(1)->args, filesuffix);
    
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamIDs[index] = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamIDs[index] = parWriteOpen(pw, filename, cdoFiletype());
 	}
       if ( levels ) free(levels);
     }
@@ -422,9 +416,7 @@ void *Split(void *argument)
 	  sprintf(filename+nchars, "%02d", vlistGridIndex(vlistID1, gridIDs[index])+1);
 	  gen_filename(filename, swap_obase, cdoStreamName(1)->args, filesuffix);
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamIDs[index] = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamIDs[index] = parWriteOpen(pw, filename, cdoFiletype());
 	}
       if ( gridIDs ) free(gridIDs);
     }
@@ -464,9 +456,7 @@ void *Split(void *argument)
 	  sprintf(filename+nchars, "%02d", vlistZaxisIndex(vlistID1, zaxisIDs[index])+1);
 	  gen_filename(filename, swap_obase, cdoStreamName(1)->args, filesuffix);
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamIDs[index] = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamIDs[index] = parWriteOpen(pw, filename, cdoFiletype());
 	}
       if ( zaxisIDs ) free(zaxisIDs);
     }
@@ -485,7 +475,7 @@ void *Split(void *argument)
                          UUIDSTR_SIZE, uuidstr);
         }
 
-      streamDefVlist(streamIDs[index], vlistIDs[index]);
+      parWriteDefVlist(pw, streamIDs[index], vlistIDs[index]);
     }
 
   double *array = NULL;
@@ -500,7 +490,7 @@ void *Split(void *argument)
   while ( (nrecs = streamInqTimestep(streamID1, tsID)) )
     {
       for ( index = 0; index < nsplit; index++ )
-	streamDefTimestep(streamIDs[index], tsID);
+	parWriteDefTimestep(pw, streamIDs[index], tsID);
 
       for ( recID = 0; recID < nrecs; recID++ )
 	{
@@ -513,15 +503,15 @@ void *Split(void *argument)
 	  /*
 	    printf("%d %d %d %d %d %d\n", index, vlistID2, varID, levelID, varID2, levelID2);
 	  */
-	  streamDefRecord(streamIDs[index], varID2, levelID2);
 	  if ( lcopy )
 	    {
+	      streamDefRecord(streamIDs[index], varID2, levelID2);
 	      streamCopyRecord(streamIDs[index], streamID1);
 	    }
 	  else
 	    {
 	      streamReadRecord(streamID1, array, &nmiss);
-	      streamWriteRecord(streamIDs[index], array, nmiss);
+	      parWriteRecord(pw, streamIDs[index], varID2, levelID2, array, nmiss);
 	    }
 	}
 
@@ -532,9 +522,11 @@ void *Split(void *argument)
 
   for ( index = 0; index < nsplit; index++ )
     {
-      streamClose(streamIDs[index]);
+      parWriteClose(pw, streamIDs[index]);
       vlistDestroy(vlistIDs[index]);
     }
+
+  parWriteDelete(pw);
  
   if ( ! lcopy )
     if ( array ) free(array);
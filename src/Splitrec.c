@@ -25,6 +25,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "par_io.h"
 
 
 void *Splitrec(void *argument)
@@ -44,6 +45,7 @@ void *Splitrec(void *argument)
   int gridsize;
   int nmiss;
   double *array = NULL;
+  par_write_t *pw = NULL;
 
   cdoInitialize(argument);
 
@@ -51,6 +53,8 @@ void *Splitrec(void *argument)
 
   if ( UNCHANGED_RECORD ) lcopy = TRUE;
 
+  if ( ! lcopy ) pw = parWriteNew(cdoFiletype());
+
   streamID1 = streamOpenRead(cdoStreamName(0));
 
   vlistID1 = streamInqVlist(streamID1);
@@ -92,34 +96,34 @@ void *Splitrec(void *argument)
 
 	  if ( cdoVerbose ) cdoPrint("create file %s", filename);
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamID2 = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamID2 = parWriteOpen(pw, filename, cdoFiletype());
 
-	  streamDefVlist(streamID2, vlistID2);
+	  parWriteDefVlist(pw, streamID2, vlistID2);
 
 	  varID2   = vlistFindVar(vlistID2, varID);
 	  levelID2 = vlistFindLevel(vlistID2, varID, levelID);
 
-	  streamDefTimestep(streamID2, 0);
-	  streamDefRecord(streamID2, varID2, levelID2);
+	  parWriteDefTimestep(pw, streamID2, 0);
 	  if ( lcopy )
 	    {
+	      streamDefRecord(streamID2, varID2, levelID2);
 	      streamCopyRecord(streamID2, streamID1);
 	    }
 	  else
 	    {
 	      streamReadRecord(streamID1, array, &nmiss);
-	      streamWriteRecord(streamID2, array, nmiss);
+	      parWriteRecord(pw, streamID2, varID2, levelID2, array, nmiss);
 	    }
 
-	  streamClose(streamID2);
+	  parWriteClose(pw, streamID2);
 	  vlistDestroy(vlistID2);
 	}
 
       tsID++;
     }
 
+  parWriteDelete(pw);
+
   streamClose(streamID1);
 
   if ( ! lcopy )
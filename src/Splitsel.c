@@ -25,6 +25,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "par_io.h"
 
 
 void *Splitsel(void *argument)
@@ -55,6 +56,7 @@ void *Splitsel(void *argument)
   int lcopy = FALSE;
   double *array = NULL;
   field_t **vars = NULL;
+  par_write_t *pw = NULL;
 
   cdoInitialize(argument);
 
@@ -64,6 +66,8 @@ void *Splitsel(void *argument)
 
   if ( UNCHANGED_RECORD ) lcopy = TRUE;
 
+  if ( ! lcopy ) pw = parWriteNew(cdoFiletype());
+
   /*  operatorInputArg("nsets <noffset <nskip>>"); */
 
   nargc = operatorArgc();
@@ -163,11 +167,9 @@ void *Splitsel(void *argument)
       sprintf(filename+nchars+6, "%s", filesuffix);
 	  
       if ( cdoVerbose ) cdoPrint("create file %s", filename);
-      argument_t *fileargument = file_argument_new(filename);
-      streamID2 = streamOpenWrite(fileargument, cdoFiletype());
-      file_argument_free(fileargument);
+      streamID2 = parWriteOpen(pw, filename, cdoFiletype());
 
-      streamDefVlist(streamID2, vlistID2);
+      parWriteDefVlist(pw, streamID2, vlistID2);
 
       tsID2 = 0;
 
@@ -183,7 +185,7 @@ void *Splitsel(void *argument)
 	   */
 
 	  taxisCopyTimestep(taxisID2, taxisID1);
-	  streamDefTimestep(streamID2, tsID2);
+	  parWriteDefTimestep(pw, streamID2, tsID2);
 
 	  if ( tsID > 0 && tsID2 == 0 && nconst )
 	    {
@@ -194,9 +196,8 @@ void *Splitsel(void *argument)
 		      nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
 		      for ( levelID = 0; levelID < nlevel; levelID++ )
 			{
-			  streamDefRecord(streamID2, varID, levelID);
 			  nmiss = vars[varID][levelID].nmiss;
-			  streamWriteRecord(streamID2, vars[varID][levelID].ptr, nmiss);
+			  parWriteRecord(pw, streamID2, varID, levelID, vars[varID][levelID].ptr, nmiss);
 			}
 		    }
 		}
@@ -206,15 +207,15 @@ void *Splitsel(void *argument)
 	    {
 	      
 	      streamInqRecord(streamID1, &varID, &levelID);
-	      streamDefRecord(streamID2,  varID,  levelID);
 	      if ( lcopy && !(tsID == 0 && nconst) )
 		{
+		  streamDefRecord(streamID2,  varID,  levelID);
 		  streamCopyRecord(streamID2, streamID1);
 		}
 	      else
 		{
 		  streamReadRecord(streamID1, array, &nmiss);
-		  streamWriteRecord(streamID2, array, nmiss);
+		  parWriteRecord(pw, streamID2, varID, levelID, array, nmiss);
 
 		  if ( tsID == 0 && nconst )
 		    {
@@ -233,7 +234,7 @@ void *Splitsel(void *argument)
 	  tsID2++;	  
 	}
       
-      streamClose(streamID2);
+      parWriteClose(pw, streamID2);
       if ( nrecs == 0 ) break;
 
       nrecs = streamInqTimestep(streamID1, tsID);
@@ -254,6 +255,8 @@ void *Splitsel(void *argument)
 
  LABEL_END:
 
+  parWriteDelete(pw);
+
   streamClose(streamID1);
  
   if ( array ) free(array);
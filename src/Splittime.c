@@ -28,6 +28,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "par_io.h"
 #include "util.h"
 
 #include <time.h>
@@ -73,6 +74,7 @@ void *Splittime(void *argument)
   double *array = NULL;
   field_t **vars = NULL;
   const char *format = NULL;
+  par_write_t *pw = NULL;
 
   cdoInitialize(argument);
 
@@ -92,6 +94,8 @@ void *Splittime(void *argument)
 
   if ( UNCHANGED_RECORD ) lcopy = TRUE;
 
+  if ( ! lcopy ) pw = parWriteNew(cdoFiletype());
+
   if ( operatorID == SPLITMON )
     {
       if ( operatorArgc() == 1 ) format = operatorArgv()[0];
@@ -230,17 +234,15 @@ void *Splittime(void *argument)
 
 	  if ( cdoVerbose ) cdoPrint("create file %s", filename);
 
-	  argument_t *fileargument = file_argument_new(filename);
-	  streamID2 = streamOpenWrite(fileargument, cdoFiletype());
-	  file_argument_free(fileargument);
+	  streamID2 = parWriteOpen(pw, filename, cdoFiletype());
 
-	  streamDefVlist(streamID2, vlistID2);
+	  parWriteDefVlist(pw, streamID2, vlistID2);
 
 	  streamIDs[index] = streamID2;
 	}
 
       taxisCopyTimestep(taxisID2, taxisID1);
-      streamDefTimestep(streamID2, tsIDs[index]);
+      parWriteDefTimestep(pw, streamID2, tsIDs[index]);
 
       if ( tsID > 0 && tsIDs[index] == 0 && nconst )
 	{
@@ -251,9 +253,8 @@ void *Splittime(void *argument)
 		  nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
 		  for ( levelID = 0; levelID < nlevel; levelID++ )
 		    {
-		      streamDefRecord(streamID2, varID, levelID);
 		      nmiss = vars[varID][levelID].nmiss;
-		      streamWriteRecord(streamID2, vars[varID][levelID].ptr, nmiss);
+		      parWriteRecord(pw, streamID2, varID, levelID, vars[varID][levelID].ptr, nmiss);
 		    }
 		}
 	    }
@@ -262,15 +263,15 @@ void *Splittime(void *argument)
       for ( recID = 0; recID < nrecs; recID++ )
 	{
 	  streamInqRecord(streamID1, &varID, &levelID);
-	  streamDefRecord(streamID2,  varID,  levelID);
 	  if ( lcopy && !(tsID == 0 && nconst) )
 	    {
+	      streamDefRecord(streamID2,  varID,  levelID);
 	      streamCopyRecord(streamID2, streamID1);
 	    }
 	  else
 	    {
 	      streamReadRecord(streamID1, array, &nmiss);
-	      streamWriteRecord(streamID2, array, nmiss);
+	      parWriteRecord(pw, streamID2, varID, levelID, array, nmiss);
 
 	      if ( tsID == 0 && nconst )
 		{
@@ -294,8 +295,10 @@ void *Splittime(void *argument)
   for ( index = 0; index < MAX_STREAMS; index++ )
     {
       streamID2 = streamIDs[index];
-      if ( streamID2 >= 0 ) streamClose(streamID2);
+      if ( streamID2 >= 0 ) parWriteClose(pw, streamID2);
     }
+
+  parWriteDelete(pw);
  
   if ( array ) free(array);
 
@@ -26,6 +26,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "par_io.h"
 
 
 #define MAX_YEARS 99999
@@ -48,6 +49,7 @@ void *Splityear(void *argument)
   int cyear[MAX_YEARS];
   int nmiss;
   double *array = NULL;
+  par_write_t *pw = NULL;
 
   cdoInitialize(argument);
 
@@ -55,6 +57,8 @@ void *Splityear(void *argument)
 
   if ( UNCHANGED_RECORD ) lcopy = TRUE;
 
+  if ( ! lcopy ) pw = parWriteNew(cdoFiletype());
+
   int SPLITYEAR    = cdoOperatorAdd("splityear",     func_date, 10000, NULL);
   int SPLITYEARMON = cdoOperatorAdd("splityearmon",  func_date,   100, NULL);
   
@@ -115,7 +119,7 @@ void *Splityear(void *argument)
 
 	      year1 = year2;
 
-	      if ( streamID2 >= 0 ) streamClose(streamID2);
+	      if ( streamID2 >= 0 ) parWriteClose(pw, streamID2);
 
 	      sprintf(filename+nchars, "%04d", year1);
 	      if ( ic > 0 ) sprintf(filename+strlen(filename), "_%d", ic+1);
@@ -124,11 +128,9 @@ void *Splityear(void *argument)
 	  
 	      if ( cdoVerbose ) cdoPrint("create file %s", filename);
 
-	      argument_t *fileargument = file_argument_new(filename);
-	      streamID2 = streamOpenWrite(fileargument, cdoFiletype());
-	      file_argument_free(fileargument);
+	      streamID2 = parWriteOpen(pw, filename, cdoFiletype());
 
-	      streamDefVlist(streamID2, vlistID2);
+	      parWriteDefVlist(pw, streamID2, vlistID2);
 	    }
 	  mon1 = mon2;
 	}
@@ -142,7 +144,7 @@ void *Splityear(void *argument)
 
 	      index1 = index2;
 
-	      if ( streamID2 >= 0 ) streamClose(streamID2);
+	      if ( streamID2 >= 0 ) parWriteClose(pw, streamID2);
 
 	      sprintf(filename+nchars, "%04d", index1);
 	      //if ( ic > 0 ) sprintf(filename+strlen(filename), "_%d", ic+1);
@@ -151,30 +153,28 @@ void *Splityear(void *argument)
 	  
 	      if ( cdoVerbose ) cdoPrint("create file %s", filename);
 
-	      argument_t *fileargument = file_argument_new(filename);
-	      streamID2 = streamOpenWrite(fileargument, cdoFiletype());
-	      file_argument_free(fileargument);
+	      streamID2 = parWriteOpen(pw, filename, cdoFiletype());
 
-	      streamDefVlist(streamID2, vlistID2);
+	      parWriteDefVlist(pw, streamID2, vlistID2);
 	    }
 	}
       
       taxisCopyTimestep(taxisID2, taxisID1);
 
-      streamDefTimestep(streamID2, tsID2++);
+      parWriteDefTimestep(pw, streamID2, tsID2++);
 
       for ( recID = 0; recID < nrecs; recID++ )
 	{
 	  streamInqRecord(streamID1, &varID, &levelID);
-	  streamDefRecord(streamID2,  varID,  levelID);
 	  if ( lcopy )
 	    {
+	      streamDefRecord(streamID2,  varID,  levelID);
 	      streamCopyRecord(streamID2, streamID1);
 	    }
 	  else
 	    {
 	      streamReadRecord(streamID1, array, &nmiss);
-	      streamWriteRecord(streamID2, array, nmiss);
+	      parWriteRecord(pw, streamID2, varID, levelID, array, nmiss);
 	    }
 	}
 
@@ -182,7 +182,9 @@ void *Splityear(void *argument)
     }
 
   streamClose(streamID1);
-  streamClose(streamID2);
+  parWriteClose(pw, streamID2);
+
+  parWriteDelete(pw);
  
   if ( ! lcopy )
     if ( array ) free(array);
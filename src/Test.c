@@ -19,6 +19,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "percentiles.h"
 
 
 void *Test(void *argument)
@@ -158,3 +159,169 @@ void *Testdata(void *argument)
 
   return (0);
 }
+
+
+static
+int cmpdouble(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return (x > y) - (x < y);
+}
+
+/* fraction of the n sorted values less than or equal to x */
+static
+double rankfrac(const double *sorted, int n, double x)
+{
+  int lo = 0, hi = n, mid;
+
+  while ( lo < hi )
+    {
+      mid = (lo + hi)/2;
+      if ( sorted[mid] <= x ) lo = mid + 1;
+      else                    hi = mid;
+    }
+
+  return ((double) lo/n);
+}
+
+/*
+  Checks hsetMerge() with CDO_PCTL_METHOD=sketch: the sketches of the first and the
+  second half of the time series are merged and compared with the one-pass sketch.
+  Both must be within the rank error 2 pi sqrt(q(1-q))/nbins of the exact percentiles
+  and within this error of each other.
+*/
+void *Testpctlmerge(void *argument)
+{
+  static const double pns[] = {1, 5, 10, 25, 50, 75, 90, 95, 99};
+  int npns = sizeof(pns)/sizeof(pns[0]);
+  int streamID1, vlistID1, nvars, nrecs, varID, levelID, recID, nmiss;
+  int tsID, nts, nalloc, ipn, k, gridID;
+  long i, gridsize;
+  double q, maxerr, err, errmax = 0;
+  double pctl[2];
+  double **values;
+  double *series, *result;
+  HISTOGRAM_SET *hset[3];
+  field_t field;
+
+  cdoInitialize(argument);
+
+  if ( hsetNeedsBounds() ) cdoAbort("Merging needs CDO_PCTL_METHOD=sketch!");
+
+  streamID1 = streamOpenRead(cdoStreamName(0));
+  vlistID1 = streamInqVlist(streamID1);
+  nvars = vlistNvars(vlistID1);
+
+  /* all values of the first level of all variables, values[varID][tsID*gridsize+i] */
+  values = (double **) malloc(nvars*sizeof(double *));
+  for ( varID = 0; varID < nvars; ++varID ) values[varID] = NULL;
+
+  nts = 0;
+  nalloc = 0;
+  while ( (nrecs = streamInqTimestep(streamID1, nts)) )
+    {
+      if ( nts == nalloc )
+	{
+	  nalloc = nalloc ? 2*nalloc : 256;
+	  for ( varID = 0; varID < nvars; ++varID )
+	    values[varID] = (double *) realloc(values[varID], nalloc*gridInqSize(vlistInqVarGrid(vlistID1, varID))*sizeof(double));
+	}
+
+      for ( recID = 0; recID < nrecs; recID++ )
+	{
+	  streamInqRecord(streamID1, &varID, &levelID);
+	  if ( levelID > 0 ) continue;
+	  gridsize = gridInqSize(vlistInqVarGrid(vlistID1, varID));
+	  streamReadRecord(streamID1, values[varID]+nts*gridsize, &nmiss);
+	  if ( nmiss ) cdoAbort("Missing values not supported!");
+	}
+
+      nts++;
+    }
+
+  if ( nts < 2 ) cdoAbort("At least two time steps needed!");
+
+  /* 0: one pass, 1: first half, 2: second half merged into 1 */
+  for ( k = 0; k < 3; ++k )
+    {
+      hset[k] = hsetCreate(nvars);
+      for ( varID = 0; varID < nvars; ++varID )
+	hsetCreateVarLevels(hset[k], varID, 1, vlistInqVarGrid(vlistID1, varID));
+      hsetReset(hset[k]);
+    }
+
+  field_init(&field);
+
+  for ( varID = 0; varID < nvars; ++varID )
+    {
+      gridID = vlistInqVarGrid(vlistID1, varID);
+      gridsize = gridInqSize(gridID);
+      field.grid = gridID;
+      field.missval = vlistInqVarMissval(vlistID1, varID);
+
+      for ( tsID = 0; tsID < nts; ++tsID )
+	{
+	  field.ptr = values[varID]+tsID*gridsize;
+	  hsetAddVarLevelValues(hset[0], varID, 0, &field);
+	  hsetAddVarLevelValues(hset[tsID < nts/2 ? 1 : 2], varID, 0, &field);
+	}
+    }
+
+  hsetMerge(hset[1], hset[2]);
+
+  for ( varID = 0; varID < nvars; ++varID )
+    {
+      gridID = vlistInqVarGrid(vlistID1, varID);
+      gridsize = gridInqSize(gridID);
+      series = (double *) malloc(nts*sizeof(double));
+      result = (double *) malloc(2*gridsize*sizeof(double));
+
+      for ( ipn = 0; ipn < npns; ++ipn )
+	{
+	  q = pns[ipn]/100;
+	  /* documented rank error of the sketch and the resolution of the series */
+	  maxerr = 2*M_PI*sqrt(q*(1-q))/hset[0]->nbins + 1./nts;
+
+	  field.grid = gridID;
+	  for ( k = 0; k < 2; ++k )
+	    {
+	      field.ptr = result + k*gridsize;
+	      hsetGetVarLevelPercentiles(&field, hset[k], varID, 0, pns[ipn]);
+	    }
+
+	  for ( i = 0; i < gridsize; ++i )
+	    {
+	      for ( tsID = 0; tsID < nts; ++tsID ) series[tsID] = values[varID][tsID*gridsize+i];
+	      qsort(series, nts, sizeof(double), cmpdouble);
+
+	      pctl[0] = rankfrac(series, nts, result[i]);
+	      pctl[1] = rankfrac(series, nts, result[gridsize+i]);
+
+	      err = fabs(pctl[1] - pctl[0]);
+	      if ( fabs(pctl[0] - q) > err ) err = fabs(pctl[0] - q);
+	      if ( fabs(pctl[1] - q) > err ) err = fabs(pctl[1] - q);
+	      if ( err > errmax ) errmax = err;
+
+	      if ( err > maxerr )
+		cdoAbort("Percentile %g of variable %d at point %ld: rank error %g > %g (one pass %g, merged %g)!",
+			 pns[ipn], varID+1, i+1, err, maxerr, pctl[0], pctl[1]);
+	    }
+	}
+
+      free(result);
+      free(series);
+    }
+
+  if ( cdoVerbose ) cdoPrint("Max. rank error %g of %d time steps", errmax, nts);
+
+  streamClose(streamID1);
+
+  for ( k = 0; k < 3; ++k ) hsetDestroy(hset[k]);
+  for ( varID = 0; varID < nvars; ++varID ) free(values[varID]);
+  free(values);
+
+  cdoFinish();
+
+  return (0);
+}
@@ -26,6 +26,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "tstore.h"
 
 
 #define  NALLOC_INC  1024
@@ -50,7 +51,7 @@ void *Timsort(void *argument)
   int nrecs;
   int gridID, varID, levelID, recID;
   int tsID;
-  int i;
+  long i, first, npoints, nblk;
   int nts;
   int nalloc = 0;
   int streamID1, streamID2;
@@ -58,8 +59,8 @@ void *Timsort(void *argument)
   int nmiss;
   int nvars, nlevel;
   int *vdate = NULL, *vtime = NULL;
-  double **sarray = NULL;
-  field_t ***vars = NULL;
+  double *array, *tile;
+  tstore_t *store;
 
   cdoInitialize(argument);
 
@@ -78,6 +79,10 @@ void *Timsort(void *argument)
 
   nvars = vlistNvars(vlistID1);
 
+  array = (double*) malloc(vlistGridsizeMax(vlistID1)*sizeof(double));
+
+  store = tstore_new(vlistID1);
+
   tsID = 0;
   while ( (nrecs = streamInqTimestep(streamID1, tsID)) )
     {
@@ -86,22 +91,16 @@ void *Timsort(void *argument)
 	  nalloc += NALLOC_INC;
 	  vdate = (int*) realloc(vdate, nalloc*sizeof(int));
 	  vtime = (int*) realloc(vtime, nalloc*sizeof(int));
-	  vars  = (field_t ***) realloc(vars, nalloc*sizeof(field_t **));
 	}
 
       vdate[tsID] = taxisInqVdate(taxisID1);
       vtime[tsID] = taxisInqVtime(taxisID1);
 
-      vars[tsID] = field_malloc(vlistID1, FIELD_NONE);
-
       for ( recID = 0; recID < nrecs; recID++ )
 	{
 	  streamInqRecord(streamID1, &varID, &levelID);
-	  gridID   = vlistInqVarGrid(vlistID1, varID);
-	  gridsize = gridInqSize(gridID);
-	  vars[tsID][varID][levelID].ptr = (double*) malloc(gridsize*sizeof(double));
-	  streamReadRecord(streamID1, vars[tsID][varID][levelID].ptr, &nmiss);
-	  vars[tsID][varID][levelID].nmiss = nmiss;
+	  streamReadRecord(streamID1, array, &nmiss);
+	  tstore_put_field(store, tsID, varID, levelID, array, nmiss);
 	}
 
       tsID++;
@@ -109,10 +108,6 @@ void *Timsort(void *argument)
 
   nts = tsID;
 
-  sarray = (double **) malloc(ompNumThreads*sizeof(double *));
-  for ( i = 0; i < ompNumThreads; i++ )
-    sarray[i] = (double*) malloc(nts*sizeof(double));
-
   for ( varID = 0; varID < nvars; varID++ )
     {
       if ( vlistInqVarTsteptype(vlistID1, varID) == TSTEP_CONSTANT ) continue;
@@ -120,31 +115,28 @@ void *Timsort(void *argument)
       gridID   = vlistInqVarGrid(vlistID1, varID);
       gridsize = gridInqSize(gridID);
       nlevel   = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+      npoints  = tstore_tilesize(store, varID);
+      tile     = (double*) malloc(npoints*nts*sizeof(double));
+
       for ( levelID = 0; levelID < nlevel; levelID++ )
-	{
+	for ( first = 0; first < gridsize; first += npoints )
+	  {
+	    nblk = gridsize - first < npoints ? gridsize - first : npoints;
+
+	    tstore_get_tile(store, varID, levelID, first, nblk, tile);
+
 #if defined(_OPENMP)
-#pragma omp parallel for default(shared) private(i, tsID)
+#pragma omp parallel for default(shared) private(i)
 #endif
-	  for ( i = 0; i < gridsize; i++ )
-	    {
-	      int ompthID = cdo_omp_get_thread_num();
-
-	      for ( tsID = 0; tsID < nts; tsID++ )
-		sarray[ompthID][tsID] = vars[tsID][varID][levelID].ptr[i];
+	    for ( i = 0; i < nblk; i++ )
+	      qsort(tile+i*nts, nts, sizeof(double), cmpdarray);
 
-	      qsort(sarray[ompthID], nts, sizeof(double), cmpdarray);  	      
+	    tstore_put_tile(store, varID, levelID, first, nblk, tile);
+	  }
 
-	      for ( tsID = 0; tsID < nts; tsID++ )
-		vars[tsID][varID][levelID].ptr[i] = sarray[ompthID][tsID];
-	    }
-	}
+      free(tile);
     }
 
-  for ( i = 0; i < ompNumThreads; i++ )
-    if ( sarray[i] ) free(sarray[i]);
-
-  if ( sarray ) free(sarray);
-
   for ( tsID = 0; tsID < nts; tsID++ )
     {
       taxisDefVdate(taxisID2, vdate[tsID]);
@@ -156,19 +148,20 @@ void *Timsort(void *argument)
 	  nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
 	  for ( levelID = 0; levelID < nlevel; levelID++ )
 	    {
-	      if ( vars[tsID][varID][levelID].ptr )
+	      nmiss = tstore_inq_nmiss(store, tsID, varID, levelID);
+	      if ( nmiss >= 0 )
 		{
-		  nmiss = vars[tsID][varID][levelID].nmiss;
+		  tstore_get_field(store, tsID, varID, levelID, array);
 		  streamDefRecord(streamID2, varID, levelID);
-		  streamWriteRecord(streamID2, vars[tsID][varID][levelID].ptr, nmiss);
+		  streamWriteRecord(streamID2, array, nmiss);
 		}
 	    }
 	}
-
-      field_free(vars[tsID], vlistID1);      
     }
 
-  if ( vars  ) free(vars);
+  tstore_delete(store);
+
+  free(array);
   if ( vdate ) free(vdate);
   if ( vtime ) free(vtime);
 
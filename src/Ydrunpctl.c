@@ -72,22 +72,33 @@ void *Ydrunpctl(void *argument)
       nsets[dayoy] = 0;
     }
 
+  /* the percentile sketch needs no min/max files, the output time steps are taken from ifile1 */
+  int lbounds = hsetNeedsBounds();
+  int streamID2 = CDI_UNDEFID, streamID3 = CDI_UNDEFID;
+  int taxisID2 = CDI_UNDEFID, taxisID3 = CDI_UNDEFID;
+
   int streamID1 = streamOpenRead(cdoStreamName(0));
-  int streamID2 = streamOpenRead(cdoStreamName(1));
-  int streamID3 = streamOpenRead(cdoStreamName(2));
 
   int vlistID1 = streamInqVlist(streamID1);
-  int vlistID2 = streamInqVlist(streamID2);
-  int vlistID3 = streamInqVlist(streamID3);
   int vlistID4 = vlistDuplicate(vlistID1);
 
-  vlistCompare(vlistID1, vlistID2, CMP_ALL);
-  vlistCompare(vlistID1, vlistID3, CMP_ALL);
+  if ( lbounds )
+    {
+      streamID2 = streamOpenRead(cdoStreamName(1));
+      streamID3 = streamOpenRead(cdoStreamName(2));
+
+      int vlistID2 = streamInqVlist(streamID2);
+      int vlistID3 = streamInqVlist(streamID3);
+
+      vlistCompare(vlistID1, vlistID2, CMP_ALL);
+      vlistCompare(vlistID1, vlistID3, CMP_ALL);
+
+      taxisID2 = vlistInqTaxis(vlistID2);
+      taxisID3 = vlistInqTaxis(vlistID3);
+      /* TODO - check that time axes 2 and 3 are equal */
+    }
 
   int taxisID1 = vlistInqTaxis(vlistID1);
-  int taxisID2 = vlistInqTaxis(vlistID2);
-  int taxisID3 = vlistInqTaxis(vlistID3);
-  /* TODO - check that time axes 2 and 3 are equal */
 
   int taxisID4 = taxisDuplicate(taxisID1);
   if ( taxisHasBounds(taxisID4) ) taxisDeleteBounds(taxisID4);
@@ -96,7 +107,7 @@ void *Ydrunpctl(void *argument)
   int calendar = taxisInqCalendar(taxisID1);
   int dpy      = calendar_dpy(calendar);
 
-  int streamID4 = streamOpenWrite(cdoStreamName(3), cdoFiletype());
+  int streamID4 = streamOpenWrite(cdoStreamName(lbounds ? 3 : 1), cdoFiletype());
 
   streamDefVlist(streamID4, vlistID4);
 
@@ -120,7 +131,7 @@ void *Ydrunpctl(void *argument)
     }
 
   tsID = 0;
-  while ( (nrecs = streamInqTimestep(streamID2, tsID)) )
+  while ( lbounds && (nrecs = streamInqTimestep(streamID2, tsID)) )
     {
       if ( nrecs != streamInqTimestep(streamID3, tsID) )
         cdoAbort("Number of records at time step %d of %s and %s differ!", tsID+1, cdoStreamName(1)->args, cdoStreamName(2)->args);
@@ -148,13 +159,13 @@ void *Ydrunpctl(void *argument)
 
       if ( vars2[dayoy] == NULL )
 	{
-	  vars2[dayoy] = field_malloc(vlistID2, FIELD_PTR);
+	  vars2[dayoy] = field_malloc(vlistID1, FIELD_PTR);
           hsets[dayoy] = hsetCreate(nvars);
 
 	  for ( varID = 0; varID < nvars; varID++ )
 	    {
-	      gridID   = vlistInqVarGrid(vlistID2, varID);
-	      nlevels  = zaxisInqSize(vlistInqVarZaxis(vlistID2, varID));
+	      gridID   = vlistInqVarGrid(vlistID1, varID);
+	      nlevels  = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
 
               hsetCreateVarLevels(hsets[dayoy], varID, nlevels, gridID);
 	    }
@@ -225,7 +236,21 @@ void *Ydrunpctl(void *argument)
       vtimes1[dayoy] = vtime;
       
       if ( vars2[dayoy] == NULL )
-        cdoAbort("No data for day %d in %s and %s", dayoy, cdoStreamName(1)->args, cdoStreamName(2)->args);
+	{
+	  if ( lbounds )
+	    cdoAbort("No data for day %d in %s and %s", dayoy, cdoStreamName(1)->args, cdoStreamName(2)->args);
+
+	  vars2[dayoy] = field_malloc(vlistID1, FIELD_PTR);
+          hsets[dayoy] = hsetCreate(nvars);
+
+	  for ( varID = 0; varID < nvars; varID++ )
+	    {
+	      gridID   = vlistInqVarGrid(vlistID1, varID);
+	      nlevels  = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+
+              hsetCreateVarLevels(hsets[dayoy], varID, nlevels, gridID);
+	    }
+	}
 
       for ( varID = 0; varID < nvars; varID++ )
 	{
@@ -268,9 +293,9 @@ void *Ydrunpctl(void *argument)
   for ( dayoy = 0; dayoy < NDAY; dayoy++ )
     if ( nsets[dayoy] )
       {
-        if ( vdates1[dayoy] != vdates2[dayoy] )
+        if ( lbounds && vdates1[dayoy] != vdates2[dayoy] )
           cdoAbort("Verification dates for day %d of %s, %s and %s are different!", dayoy, cdoStreamName(1)->args, cdoStreamName(2)->args, cdoStreamName(3)->args);
-        if ( vtimes1[dayoy] != vtimes2[dayoy] )
+        if ( lbounds && vtimes1[dayoy] != vtimes2[dayoy] )
           cdoAbort("Verification times for day %d of %s, %s and %s are different!", dayoy, cdoStreamName(1)->args, cdoStreamName(2)->args, cdoStreamName(3)->args);
 
 	for ( varID = 0; varID < nvars; varID++ )
@@ -318,7 +343,7 @@ void *Ydrunpctl(void *argument)
     {
       if ( vars2[dayoy] != NULL )
 	{
-	  field_free(vars2[dayoy], vlistID2); 
+	  field_free(vars2[dayoy], vlistID1); 
 	  hsetDestroy(hsets[dayoy]);
 	}
     }
@@ -329,8 +354,11 @@ void *Ydrunpctl(void *argument)
   if ( recLevelID ) free(recLevelID);
 
   streamClose(streamID4);
-  streamClose(streamID3);
-  streamClose(streamID2);
+  if ( lbounds )
+    {
+      streamClose(streamID3);
+      streamClose(streamID2);
+    }
   streamClose(streamID1);
 
   cdoFinish();
@@ -33,6 +33,7 @@
 #include "cdo.h"
 #include "cdo_int.h"
 #include "pstream.h"
+#include "runacc.h"
 
 
 #define NDAY 373
@@ -64,11 +65,12 @@ void *Ydrunstat(void *argument)
   int levelID;
   int tsID;
   int otsID;
-  int inp, its;
+  int inp;
   int nmiss;
+  int nlevel;
   int vdate, vtime;
   int dayoy;
-  field_t ***vars1 = NULL, ***vars2 = NULL;
+  field_t **vars1 = NULL, **vars2 = NULL;
   datetime_t *datetime;
   YDAY_STATS *stats;
     
@@ -91,6 +93,10 @@ void *Ydrunstat(void *argument)
   int ndates = parameter2int(operatorArgv()[0]);
 
   int lvarstd = operfunc == func_std || operfunc == func_var || operfunc == func_std1 || operfunc == func_var1;
+  int lminmax = operfunc == func_min || operfunc == func_max;
+  /* the running windows are summed up, the statistic is computed in ydstatFinalize */
+  int winfunc = lminmax ? operfunc : operfunc == func_avg ? func_add : func_sum;
+  int runfunc = lvarstd ? func_var : winfunc;
   
   int streamID1 = streamOpenRead(cdoStreamName(0));
 
@@ -109,6 +115,7 @@ void *Ydrunstat(void *argument)
 
   streamDefVlist(streamID2, vlistID2);
 
+  int nvars    = vlistNvars(vlistID1);
   int nrecords = vlistNrecs(vlistID1);
 
   int *recVarID   = (int*) malloc(nrecords*sizeof(int));
@@ -117,16 +124,22 @@ void *Ydrunstat(void *argument)
   datetime = (datetime_t*) malloc((ndates+1)*sizeof(datetime_t));
   
   stats = ydstatCreate(vlistID1);
-  vars1 = (field_t ***) malloc((ndates+1)*sizeof(field_t **));
-  if ( lvarstd )
-    vars2 = (field_t ***) malloc((ndates+1)*sizeof(field_t **));
-  
-  for ( its = 0; its < ndates; its++ )
+
+  runacc_t ***racc = (runacc_t ***) malloc(nvars*sizeof(runacc_t **));
+  for ( varID = 0; varID < nvars; varID++ )
     {
-      vars1[its] = field_malloc(vlistID1, FIELD_PTR);
-      if ( lvarstd )
-	vars2[its] = field_malloc(vlistID1, FIELD_PTR);
+      int gridsize = gridInqSize(vlistInqVarGrid(vlistID1, varID));
+      nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+      double missval = vlistInqVarMissval(vlistID1, varID);
+
+      racc[varID] = (runacc_t **) malloc(nlevel*sizeof(runacc_t *));
+      for ( levelID = 0; levelID < nlevel; levelID++ )
+	racc[varID][levelID] = runaccNew(runfunc, ndates, gridsize, missval);
     }
+
+  vars1 = field_malloc(vlistID1, FIELD_PTR);
+  if ( lvarstd )
+    vars2 = field_malloc(vlistID1, FIELD_PTR);
   
   for ( tsID = 0; tsID < ndates; tsID++ )
     {
@@ -147,25 +160,8 @@ void *Ydrunstat(void *argument)
 	      recLevelID[recID] = levelID;
 	    }
 	  
-	  streamReadRecord(streamID1, vars1[tsID][varID][levelID].ptr, &nmiss);
-	  vars1[tsID][varID][levelID].nmiss = nmiss;
-
-	  if ( lvarstd )
-	    {
-	      farmoq(&vars2[tsID][varID][levelID], vars1[tsID][varID][levelID]);
-	      for ( inp = 0; inp < tsID; inp++ )
-		{
-		  farsumq(&vars2[inp][varID][levelID], vars1[tsID][varID][levelID]);
-		  farsum(&vars1[inp][varID][levelID], vars1[tsID][varID][levelID]);
-		}
-	    }
-	  else
-	    {
-	      for ( inp = 0; inp < tsID; inp++ )
-		{
-		  farfun(&vars1[inp][varID][levelID], vars1[tsID][varID][levelID], operfunc);
-		}
-	    }
+	  streamReadRecord(streamID1, vars1[varID][levelID].ptr, &nmiss);
+	  runaccAdd(racc[varID][levelID], vars1[varID][levelID].ptr);
 	}
     }
   
@@ -175,25 +171,23 @@ void *Ydrunstat(void *argument)
       
       vdate = datetime[ndates].date;
       vtime = datetime[ndates].time;
-      
-      if ( lvarstd )   
-        ydstatUpdate(stats, vdate, vtime, vars1[0], vars2[0], ndates, operfunc);
-      else
-        ydstatUpdate(stats, vdate, vtime, vars1[0], NULL, ndates, operfunc);
-        
-      datetime[ndates] = datetime[0];
-      vars1[ndates] = vars1[0];
-      if ( lvarstd )
-        vars2[ndates] = vars2[0];
 
-      for ( inp = 0; inp < ndates; inp++ )
+      for ( varID = 0; varID < nvars; varID++ )
 	{
-	  datetime[inp] = datetime[inp+1];
-	  vars1[inp] = vars1[inp+1];
-	  if ( lvarstd )
-	    vars2[inp] = vars2[inp+1];
+	  if ( vlistInqVarTsteptype(vlistID1, varID) == TSTEP_CONSTANT ) continue;
+	  nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+	  for ( levelID = 0; levelID < nlevel; levelID++ )
+	    {
+	      vars1[varID][levelID].nmiss = runaccStat(racc[varID][levelID], winfunc, vars1[varID][levelID].ptr);
+	      if ( lvarstd )
+		vars2[varID][levelID].nmiss = runaccSumq(racc[varID][levelID], vars2[varID][levelID].ptr);
+	    }
 	}
 
+      ydstatUpdate(stats, vdate, vtime, vars1, vars2, ndates, operfunc);
+        
+      for ( inp = 0; inp < ndates-1; inp++ ) datetime[inp] = datetime[inp+1];
+
       nrecs = streamInqTimestep(streamID1, tsID);
       if ( nrecs == 0 ) break;
 
@@ -204,25 +198,8 @@ void *Ydrunstat(void *argument)
 	{
 	  streamInqRecord(streamID1, &varID, &levelID);
 	  
-	  streamReadRecord(streamID1, vars1[ndates-1][varID][levelID].ptr, &nmiss);
-	  vars1[ndates-1][varID][levelID].nmiss = nmiss;
-
-	  if ( lvarstd )
-	    {
-	      for ( inp = 0; inp < ndates-1; inp++ )
-		{
-		  farsumq(&vars2[inp][varID][levelID], vars1[ndates-1][varID][levelID]);
-		  farsum(&vars1[inp][varID][levelID], vars1[ndates-1][varID][levelID]);
-		}
-	      farmoq(&vars2[ndates-1][varID][levelID], vars1[ndates-1][varID][levelID]);
-	    }
-	  else
-	    {
-	      for ( inp = 0; inp < ndates-1; inp++ )
-		{
-		  farfun(&vars1[inp][varID][levelID], vars1[ndates-1][varID][levelID], operfunc);
-		}
-	    }
+	  streamReadRecord(streamID1, vars1[varID][levelID].ptr, &nmiss);
+	  runaccAdd(racc[varID][levelID], vars1[varID][levelID].ptr);
 	}
 
       tsID++;
@@ -270,15 +247,19 @@ void *Ydrunstat(void *argument)
 	otsID++;
       }
   
-  for ( its = 0; its < ndates; its++ )
+  for ( varID = 0; varID < nvars; varID++ )
     {
-      field_free(vars1[its], vlistID1);
-      if ( lvarstd ) field_free(vars2[its], vlistID1);
+      nlevel = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+      for ( levelID = 0; levelID < nlevel; levelID++ )
+	runaccDelete(racc[varID][levelID]);
+      free(racc[varID]);
     }
+  free(racc);
+
+  field_free(vars1, vlistID1);
+  if ( lvarstd ) field_free(vars2, vlistID1);
   
   ydstatDestroy(stats);
-  free(vars1);
-  if ( lvarstd ) free(vars2);
 
   if ( datetime ) free(datetime);
 
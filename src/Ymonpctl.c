@@ -42,7 +42,7 @@ void *Ymonpctl(void *argument)
   int tsID;
   int otsID;
   long nsets[NMONTH];
-  int streamID1, streamID2, streamID3, streamID4;
+  int streamID1, streamID2 = CDI_UNDEFID, streamID3 = CDI_UNDEFID, streamID4;
   int vlistID1, vlistID2, vlistID3, vlistID4, taxisID1, taxisID2, taxisID3, taxisID4;
   int nmiss;
   int nvars, nlevels;
@@ -70,28 +70,37 @@ void *Ymonpctl(void *argument)
       nsets[month] = 0;
     }
 
+  /* the percentile sketch needs no min/max files, the output time steps are taken from ifile1 */
+  int lbounds = hsetNeedsBounds();
+
   streamID1 = streamOpenRead(cdoStreamName(0));
-  streamID2 = streamOpenRead(cdoStreamName(1));
-  streamID3 = streamOpenRead(cdoStreamName(2));
 
   vlistID1 = streamInqVlist(streamID1);
-  vlistID2 = streamInqVlist(streamID2);
-  vlistID3 = streamInqVlist(streamID3);
   vlistID4 = vlistDuplicate(vlistID1);
 
-  vlistCompare(vlistID1, vlistID2, CMP_ALL);
-  vlistCompare(vlistID1, vlistID3, CMP_ALL);
+  if ( lbounds )
+    {
+      streamID2 = streamOpenRead(cdoStreamName(1));
+      streamID3 = streamOpenRead(cdoStreamName(2));
+
+      vlistID2 = streamInqVlist(streamID2);
+      vlistID3 = streamInqVlist(streamID3);
+
+      vlistCompare(vlistID1, vlistID2, CMP_ALL);
+      vlistCompare(vlistID1, vlistID3, CMP_ALL);
+
+      taxisID2 = vlistInqTaxis(vlistID2);
+      taxisID3 = vlistInqTaxis(vlistID3);
+      /* TODO - check that time axes 2 and 3 are equal */
+    }
 
   taxisID1 = vlistInqTaxis(vlistID1);
-  taxisID2 = vlistInqTaxis(vlistID2);
-  taxisID3 = vlistInqTaxis(vlistID3);
-  /* TODO - check that time axes 2 and 3 are equal */
 
   taxisID4 = taxisDuplicate(taxisID1);
   if ( taxisHasBounds(taxisID4) ) taxisDeleteBounds(taxisID4);
   vlistDefTaxis(vlistID4, taxisID4);
 
-  streamID4 = streamOpenWrite(cdoStreamName(3), cdoFiletype());
+  streamID4 = streamOpenWrite(cdoStreamName(lbounds ? 3 : 1), cdoFiletype());
 
   streamDefVlist(streamID4, vlistID4);
 
@@ -106,7 +115,7 @@ void *Ymonpctl(void *argument)
   field.ptr = (double*) malloc(gridsize*sizeof(double));
 
   tsID = 0;
-  while ( (nrecs = streamInqTimestep(streamID2, tsID)) )
+  while ( lbounds && (nrecs = streamInqTimestep(streamID2, tsID)) )
     {
       if ( nrecs != streamInqTimestep(streamID3, tsID) )
         cdoAbort("Number of records at time step %d of %s and %s differ!", tsID+1, cdoStreamName(1)->args, cdoStreamName(2)->args);
@@ -176,7 +185,21 @@ void *Ymonpctl(void *argument)
       vtimes1[month] = vtime;
 
       if ( vars1[month] == NULL )
-        cdoAbort("No data for month %d in %s and %s", month, cdoStreamName(1)->args, cdoStreamName(2)->args);
+	{
+	  if ( lbounds )
+	    cdoAbort("No data for month %d in %s and %s", month, cdoStreamName(1)->args, cdoStreamName(2)->args);
+
+	  vars1[month] = field_malloc(vlistID1, FIELD_PTR);
+          hsets[month] = hsetCreate(nvars);
+
+	  for ( varID = 0; varID < nvars; varID++ )
+	    {
+	      gridID   = vlistInqVarGrid(vlistID1, varID);
+	      nlevels  = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+
+              hsetCreateVarLevels(hsets[month], varID, nlevels, gridID);
+	    }
+	}
 
       for ( recID = 0; recID < nrecs; recID++ )
 	{
@@ -202,9 +225,9 @@ void *Ymonpctl(void *argument)
   for ( month = 0; month < NMONTH; month++ )
     if ( nsets[month] )
       {
-        if ( vdates1[month] != vdates2[month] )
+        if ( lbounds && vdates1[month] != vdates2[month] )
           cdoAbort("Verification dates for month %d of %s, %s and %s are different!", month, cdoStreamName(1)->args, cdoStreamName(2)->args, cdoStreamName(3)->args);
-        if ( vtimes1[month] != vtimes2[month] )
+        if ( lbounds && vtimes1[month] != vtimes2[month] )
           cdoAbort("Verification times for month %d of %s, %s and %s are different!", month, cdoStreamName(1)->args, cdoStreamName(2)->args, cdoStreamName(3)->args);
 
 	for ( varID = 0; varID < nvars; varID++ )
@@ -249,8 +272,11 @@ void *Ymonpctl(void *argument)
   if ( recLevelID ) free(recLevelID);
 
   streamClose(streamID4);
-  streamClose(streamID3);
-  streamClose(streamID2);
+  if ( lbounds )
+    {
+      streamClose(streamID3);
+      streamClose(streamID2);
+    }
   streamClose(streamID1);
 
   cdoFinish();
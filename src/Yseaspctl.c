@@ -43,7 +43,7 @@ void *Yseaspctl(void *argument)
   int tsID;
   int otsID;
   long nsets[NSEAS];
-  int streamID1, streamID2, streamID3, streamID4;
+  int streamID1, streamID2 = CDI_UNDEFID, streamID3 = CDI_UNDEFID, streamID4;
   int vlistID1, vlistID2, vlistID3, vlistID4, taxisID1, taxisID2, taxisID3, taxisID4;
   int nmiss;
   int nvars, nlevels;
@@ -73,28 +73,37 @@ void *Yseaspctl(void *argument)
       nsets[seas] = 0;
     }
 
+  /* the percentile sketch needs no min/max files, the output time steps are taken from ifile1 */
+  int lbounds = hsetNeedsBounds();
+
   streamID1 = streamOpenRead(cdoStreamName(0));
-  streamID2 = streamOpenRead(cdoStreamName(1));
-  streamID3 = streamOpenRead(cdoStreamName(2));
 
   vlistID1 = streamInqVlist(streamID1);
-  vlistID2 = streamInqVlist(streamID2);
-  vlistID3 = streamInqVlist(streamID3);
   vlistID4 = vlistDuplicate(vlistID1);
 
-  vlistCompare(vlistID1, vlistID2, CMP_ALL);
-  vlistCompare(vlistID1, vlistID3, CMP_ALL);
+  if ( lbounds )
+    {
+      streamID2 = streamOpenRead(cdoStreamName(1));
+      streamID3 = streamOpenRead(cdoStreamName(2));
+
+      vlistID2 = streamInqVlist(streamID2);
+      vlistID3 = streamInqVlist(streamID3);
+
+      vlistCompare(vlistID1, vlistID2, CMP_ALL);
+      vlistCompare(vlistID1, vlistID3, CMP_ALL);
+
+      taxisID2 = vlistInqTaxis(vlistID2);
+      taxisID3 = vlistInqTaxis(vlistID3);
+      /* TODO - check that time axes 2 and 3 are equal */
+    }
 
   taxisID1 = vlistInqTaxis(vlistID1);
-  taxisID2 = vlistInqTaxis(vlistID2);
-  taxisID3 = vlistInqTaxis(vlistID3);
-  /* TODO - check that time axes 2 and 3 are equal */
 
   taxisID4 = taxisDuplicate(taxisID1);
   if ( taxisHasBounds(taxisID4) ) taxisDeleteBounds(taxisID4);
   vlistDefTaxis(vlistID4, taxisID4);
 
-  streamID4 = streamOpenWrite(cdoStreamName(3), cdoFiletype());
+  streamID4 = streamOpenWrite(cdoStreamName(lbounds ? 3 : 1), cdoFiletype());
 
   streamDefVlist(streamID4, vlistID4);
 
@@ -109,7 +118,7 @@ void *Yseaspctl(void *argument)
   field.ptr = (double*) malloc(gridsize*sizeof(double));
 
   tsID = 0;
-  while ( (nrecs = streamInqTimestep(streamID2, tsID)) )
+  while ( lbounds && (nrecs = streamInqTimestep(streamID2, tsID)) )
     {
       if ( nrecs != streamInqTimestep(streamID3, tsID) )
         cdoAbort("Number of records at time step %d of %s and %s differ!", tsID+1, cdoStreamName(1)->args, cdoStreamName(2)->args);
@@ -202,7 +211,21 @@ void *Yseaspctl(void *argument)
       vtimes1[seas] = vtime;
 
       if ( vars1[seas] == NULL )
-        cdoAbort("No data for season %d in %s and %s", seas, cdoStreamName(1)->args, cdoStreamName(2)->args);
+	{
+	  if ( lbounds )
+	    cdoAbort("No data for season %d in %s and %s", seas, cdoStreamName(1)->args, cdoStreamName(2)->args);
+
+	  vars1[seas] = field_malloc(vlistID1, FIELD_PTR);
+          hsets[seas] = hsetCreate(nvars);
+
+	  for ( varID = 0; varID < nvars; varID++ )
+	    {
+	      gridID   = vlistInqVarGrid(vlistID1, varID);
+	      nlevels  = zaxisInqSize(vlistInqVarZaxis(vlistID1, varID));
+
+              hsetCreateVarLevels(hsets[seas], varID, nlevels, gridID);
+	    }
+	}
 
       for ( recID = 0; recID < nrecs; recID++ )
 	{
@@ -228,9 +251,9 @@ void *Yseaspctl(void *argument)
   for ( seas = 0; seas < NSEAS; seas++ )
     if ( nsets[seas] )
       {
-        if ( vdates1[seas] != vdates2[seas] )
+        if ( lbounds && vdates1[seas] != vdates2[seas] )
           cdoAbort("Verification dates for season %d of %s, %s and %s are different!", seas, cdoStreamName(1)->args, cdoStreamName(2)->args, cdoStreamName(3)->args);
-        if ( vtimes1[seas] != vtimes2[seas] )
+        if ( lbounds && vtimes1[seas] != vtimes2[seas] )
           cdoAbort("Verification times for season %d of %s, %s and %s are different!", seas, cdoStreamName(1)->args, cdoStreamName(2)->args, cdoStreamName(3)->args);
 
 	for ( varID = 0; varID < nvars; varID++ )
@@ -275,8 +298,11 @@ void *Yseaspctl(void *argument)
   if ( recLevelID ) free(recLevelID);
 
   streamClose(streamID4);
-  streamClose(streamID3);
-  streamClose(streamID2);
+  if ( lbounds )
+    {
+      streamClose(streamID3);
+      streamClose(streamID2);
+    }
   streamClose(streamID1);
 
   cdoFinish();
@@ -172,6 +172,8 @@ void cdo_usage(void)
 #if defined(_OPENMP)
   fprintf(stderr, "    -P <nthreads>  Set number of OpenMP threads\n");
 #endif
+  fprintf(stderr, "    --pipe_queue <nrecs>\n");
+  fprintf(stderr, "                   Number of records a pipe can hold, 0 means synchronous pipes (default: 0)\n");
   fprintf(stderr, "    -Q             Alphanumeric sorting of netCDF parameter names\n");
   fprintf(stderr, "    -R, --regular  Convert GRIB1 data from reduced to regular grid (only with cgribex)\n");
   fprintf(stderr, "    -r             Generate a relative time axis\n");
@@ -744,6 +746,54 @@ void get_env_vars(void)
         }
     }
 
+  envstr = getenv("CDO_PIPE_QUEUE");
+  if ( envstr )
+    {
+      int ival = atoi(envstr);
+      if ( ival >= 0 )
+        {
+          CDO_Pipe_Queue = ival;
+          if ( cdoVerbose )
+            fprintf(stderr, "CDO_PIPE_QUEUE = %s\n", envstr);
+        }
+    }
+
+  envstr = getenv("CDO_TSTORE_MEMORY");
+  if ( envstr )
+    {
+      long lval = atol(envstr);
+      if ( lval >= 0 )
+        {
+          CDO_Tstore_Memory = lval;
+          if ( cdoVerbose )
+            fprintf(stderr, "CDO_TSTORE_MEMORY = %s\n", envstr);
+        }
+    }
+
+  envstr = getenv("CDO_ENSSTAT_GROUP");
+  if ( envstr )
+    {
+      int ival = atoi(envstr);
+      if ( ival >= 0 )
+        {
+          CDO_Ensstat_Group = ival;
+          if ( cdoVerbose )
+            fprintf(stderr, "CDO_ENSSTAT_GROUP = %s\n", envstr);
+        }
+    }
+
+  envstr = getenv("CDO_WRITE_THREADS");
+  if ( envstr )
+    {
+      int ival = atoi(envstr);
+      if ( ival >= 0 )
+        {
+          CDO_Write_Threads = ival;
+          if ( cdoVerbose )
+            fprintf(stderr, "CDO_WRITE_THREADS = %s\n", envstr);
+        }
+    }
+
   envstr = getenv("CDO_COLOR");
   if ( envstr )
     {
@@ -954,6 +1004,8 @@ void cdo_set_options(void)
     }
   
   if ( CDO_netcdf_hdr_pad > 0 ) cdiDefGlobal("NETCDF_HDR_PAD", CDO_netcdf_hdr_pad);
+
+  if ( cdoVerbose ) cdiDefGlobal("VERBOSE", TRUE);
 }
 
 
@@ -997,6 +1049,7 @@ int parse_options_long(int argc, char *argv[])
   int lnetcdf_hdr_pad;
   int luse_fftw;
   int lremap_genweights;
+  int lpipe_queue;
 
   struct cdo_option opt_long[] =
     {
@@ -1005,6 +1058,7 @@ int parse_options_long(int argc, char *argv[])
       { "hdr_pad",           required_argument,    &lnetcdf_hdr_pad,  1 },
       { "use_fftw",          required_argument,          &luse_fftw,  1 },
       { "remap_genweights",  required_argument,  &lremap_genweights,  1 },
+      { "pipe_queue",        required_argument,        &lpipe_queue,  1 },
       { "no_warnings",             no_argument,           &_Verbose,  0 },
       { "format",            required_argument,                NULL, 'f' },
       { "help",                    no_argument,                NULL, 'h' },
@@ -1024,6 +1078,7 @@ int parse_options_long(int argc, char *argv[])
       lnetcdf_hdr_pad = 0;
       luse_fftw = 0;
       lremap_genweights = 0;
+      lpipe_queue = 0;
 
       c = cdo_getopt_long(argc, argv, "f:b:e:P:p:g:i:k:l:m:n:t:D:z:aBCcdhHLMOQRrsSTuVvWXZ", opt_long, NULL);
       if ( c == -1 ) break;
@@ -1057,6 +1112,13 @@ int parse_options_long(int argc, char *argv[])
             {
               remap_genweights = str_to_int(CDO_optarg);
             }
+          else if ( lpipe_queue )
+            {
+              int pipe_queue = str_to_int(CDO_optarg);
+              if ( pipe_queue < 0 )
+                cdoAbort("Unsupported value for option --pipe_queue=%d [range: >= 0]", pipe_queue);
+              CDO_Pipe_Queue = pipe_queue;
+            }
           break;
         case 'a':
           cdoDefaultTimeType = TAXIS_ABSOLUTE;
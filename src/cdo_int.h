@@ -70,7 +70,7 @@ char *strdup(const char *s);
 #define  DATE_IS_NEQ(dtstr1, dtstr2, len) (memcmp(dtstr1, dtstr2, len) != 0)
 
 enum T_WEIGHT_MODE {WEIGHT_OFF, WEIGHT_ON};
-enum T_EIGEN_MODE  {JACOBI, DANIELSON_LANCZOS};
+enum T_EIGEN_MODE  {JACOBI, DANIELSON_LANCZOS, LANCZOS};
 
 #if defined(__xlC__) /* performance problems on IBM */
 #ifndef DBL_IS_NAN
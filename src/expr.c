@@ -79,987 +79,798 @@ static func_t fun_sym_tbl[] =
 
 static int NumFunc = sizeof(fun_sym_tbl) / sizeof(fun_sym_tbl[0]);
 
-static
-nodeType *expr_con_con(int oper, nodeType *p1, nodeType *p2)
-{
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
-
-  p->type = typeCon;
+/*
+  The expressions are parsed only once. The init pass of the parser compiles each statement
+  into a plan, a list of the nodes in postorder. For each timestep the plan is evaluated
+  block by block, a block is a part of one level with at most EXPR_BLOCKSIZE grid points.
+  The intermediate results of a block are kept in small work arrays instead of temporary
+  fields, the blocks are distributed over the OpenMP threads.
+
+  The old evaluation used different formulas for operands with and without missing values.
+  The number of missing values of an intermediate result is only known after the whole
+  field is computed, so the plan assumes the values of the previous timestep and evaluates
+  the statement again if one of them was wrong.
+*/
+
+#define  EXPR_BLOCKSIZE  1024
+
+#define  EXPR_CON        0
+#define  EXPR_VAR        1
+#define  EXPR_OPR        2
+#define  EXPR_FUN        3
 
-  double cval1 = p1->u.con.value;
-  double cval2 = p2->u.con.value;
+typedef struct {
+  int     type;
+  int     oper;
+  int     funcID;
+  int     nops;
+  int     op[3];
+  int     varID;
+  int     mvforce;           /* use the missing value formula for any nmiss */
+  int     hasmiss;           /* nmiss > 0 is assumed for this result */
+  long    ngp, nlev;
+  double  missval;           /* missing value of the result */
+  double  missval1, missval2;
+  double  cval;
+  double *cdata;             /* constant expanded to a block */
+}
+exprnode_t;
 
-  switch ( oper )
-    {
-    case '+':  cval1 = cval1 + cval2; break;
-    case '-':  cval1 = cval1 - cval2; break;
-    case '*':  cval1 = cval1 * cval2; break;
-    case '/':  cval1 = cval1 / cval2; break;
-    case '^':  cval1 = pow(cval1, cval2); break;
-    default:   cdoAbort("%s: operator %c unsupported!", __func__, oper); break;
-    }
+typedef struct {
+  int     first, root;       /* node range of the statement */
+  int     varID;             /* output variable */
+  long    ngp, nlev;
+}
+exprstmt_t;
 
-  return (p);
+typedef struct {
+  double *work;
+  long   *nmiss;
 }
+exprwork_t;
+
+struct exprplan {
+  int         nnodes, nalloc;
+  exprnode_t *nodes;
+  int         nstmts;
+  exprstmt_t *stmts;
+  int         nwork;
+  exprwork_t *work;
+};
+
 
 static
-nodeType *expr_con_var(int oper, nodeType *p1, nodeType *p2)
+exprplan_t *plan_new(void)
 {
-  int gridID   = p2->gridID;
-  int zaxisID  = p2->zaxisID;
-  int nmiss    = p2->nmiss;
-  double missval1 = p2->missval;
-  double missval2 = p2->missval;
-
-  int ngp  = gridInqSize(gridID);
-  int nlev = zaxisInqSize(zaxisID);
-  long n   = ngp*nlev;
-  long i;
+  exprplan_t *plan = (exprplan_t*) malloc(sizeof(exprplan_t));
 
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
+  plan->nnodes = 0;
+  plan->nalloc = 64;
+  plan->nodes  = (exprnode_t*) malloc(plan->nalloc*sizeof(exprnode_t));
+  plan->nstmts = 0;
+  plan->stmts  = NULL;
+  plan->nwork  = 0;
+  plan->work   = NULL;
 
-  p->type     = typeVar;
-  p->tmpvar   = 1;
-  p->u.var.nm = strdupx("tmp");
-  p->gridID   = gridID;
-  p->zaxisID  = zaxisID;
-  p->missval  = missval1;
+  return (plan);
+}
 
-  p->data = (double*) malloc(n*sizeof(double));
-  double *restrict odat = p->data;
-  const double *restrict idat = p2->data;
-  double cval = p1->u.con.value;
 
-  switch ( oper )
+void expr_plan_delete(exprplan_t *plan)
+{
+  int i;
+
+  if ( plan == NULL ) return;
+
+  for ( i = 0; i < plan->nnodes; ++i )
+    if ( plan->nodes[i].cdata ) free(plan->nodes[i].cdata);
+
+  for ( i = 0; i < plan->nwork; ++i )
     {
-    case '+':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = ADD(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] = cval + idat[i];
-      break;
-    case '-':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = SUB(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] = cval - idat[i];
-      break;
-    case '*':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MUL(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] = cval * idat[i];
-      break;
-    case '/':
-      for ( i=0; i<n; ++i ) odat[i] = DIV(cval, idat[i]);
-      break;
-    case '^':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = POW(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] = pow(cval, idat[i]);
-      break;
-    case '<':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLT(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLT(cval, idat[i]);
-      break;
-    case '>':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPGT(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPGT(cval, idat[i]);
-      break;
-    case LE:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLE(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLE(cval, idat[i]);
-      break;
-    case GE:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPGE(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPGE(cval, idat[i]);
-      break;
-    case NE:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPNE(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPNE(cval, idat[i]);
-      break;
-    case EQ:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPEQ(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPEQ(cval, idat[i]);
-      break;
-    case LEG:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLEG(cval, idat[i]);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLEG(cval, idat[i]);
-      break;
-    default:
-      cdoAbort("%s: operator %c unsupported!", __func__, oper);
-      break;
+      free(plan->work[i].work);
+      free(plan->work[i].nmiss);
     }
 
-  nmiss = 0;
-  for ( i = 0; i < n; i++ )
-    if ( DBL_IS_EQUAL(p->data[i], missval1) ) nmiss++;
+  if ( plan->work  ) free(plan->work);
+  if ( plan->stmts ) free(plan->stmts);
+  free(plan->nodes);
+  free(plan);
+}
 
-  p->nmiss = nmiss;
+static
+int plan_add_node(exprplan_t *plan, const exprnode_t *node)
+{
+  if ( plan->nnodes == plan->nalloc )
+    {
+      plan->nalloc *= 2;
+      plan->nodes = (exprnode_t*) realloc(plan->nodes, plan->nalloc*sizeof(exprnode_t));
+    }
 
-  if ( p2->tmpvar ) free(p2->data);
+  plan->nodes[plan->nnodes] = *node;
 
-  return (p);
+  return (plan->nnodes++);
 }
 
 static
-nodeType *expr_var_con(int oper, nodeType *p1, nodeType *p2)
+int plan_add_con(exprplan_t *plan, double cval)
 {
-  int gridID   = p1->gridID;
-  int zaxisID  = p1->zaxisID;
-  int nmiss    = p1->nmiss;
-  double missval1 = p1->missval;
-  double missval2 = p1->missval;
-
-  int ngp  = gridInqSize(gridID);
-  int nlev = zaxisInqSize(zaxisID);
-  long n   = ngp*nlev;
+  exprnode_t node;
   long i;
 
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
+  memset(&node, 0, sizeof(exprnode_t));
+  node.type  = EXPR_CON;
+  node.ngp   = 1;
+  node.nlev  = 1;
+  node.cval  = cval;
+  node.cdata = (double*) malloc(EXPR_BLOCKSIZE*sizeof(double));
+  for ( i = 0; i < EXPR_BLOCKSIZE; ++i ) node.cdata[i] = cval;
 
-  p->type     = typeVar;
-  p->tmpvar   = 1;
-  p->u.var.nm = strdupx("tmp");
-  p->gridID   = gridID;
-  p->zaxisID  = zaxisID;
-  p->missval  = missval1;
+  return (plan_add_node(plan, &node));
+}
 
-  p->data = (double*) malloc(n*sizeof(double));
-  double *restrict odat = p->data;
-  const double *restrict idat = p1->data;
-  double cval = p2->u.con.value;
+static
+int expr_find_var(int vlistID, const char *name)
+{
+  char varname[256];
+  int varID, nvars = vlistNvars(vlistID);
 
-  switch ( oper )
+  for ( varID = 0; varID < nvars; varID++ )
     {
-    case '+':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = ADD(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] = idat[i] + cval;
-      break;
-    case '-':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = SUB(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] = idat[i] - cval;
-      break;
-    case '*':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MUL(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] = idat[i] * cval;
-      break;
-    case '/':
-      if ( nmiss || IS_EQUAL(cval, 0) ) for ( i=0; i<n; ++i ) odat[i] = DIV(idat[i], cval);
-      else                              for ( i=0; i<n; ++i ) odat[i] = idat[i] / cval;
-      break;
-    case '^':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = POW(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] = pow(idat[i], cval);
-      break;
-    case '<':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLT(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLT(idat[i], cval);
-      break;
-    case '>':
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPGT(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPGT(idat[i], cval);
-      break;
-    case LE:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLE(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLE(idat[i], cval);
-      break;
-    case GE:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPGE(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPGE(idat[i], cval);
-      break;
-    case NE:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPNE(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPNE(idat[i], cval);
-      break;
-    case EQ:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPEQ(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPEQ(idat[i], cval);
-      break;
-    case LEG:
-      if ( nmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLEG(idat[i], cval);
-      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLEG(idat[i], cval);
-      break;
-    default:
-      cdoAbort("%s: operator %c unsupported!", __func__, oper);
-      break;
+      vlistInqVarName(vlistID, varID, varname);
+      if ( strcmp(varname, name) == 0 ) break;
     }
 
-  nmiss = 0;
-  for ( i = 0; i < n; i++ )
-    if ( DBL_IS_EQUAL(p->data[i], missval1) ) nmiss++;
-
-  p->nmiss = nmiss;
+  if ( varID == nvars ) cdoAbort("Variable >%s< not found!", name);
 
-  if ( p1->tmpvar ) free(p1->data);
-
-  return (p);
+  return (varID);
 }
 
 static
-nodeType *expr_var_var(int oper, nodeType *p1, nodeType *p2)
+int expr_find_func(const char *fun)
 {
-  long i;
-  long nlev, k;
-  long loff, loff1, loff2;
-  int nmiss;
+  int i;
 
-  int nmiss1   = p1->nmiss;
-  int nmiss2   = p2->nmiss;
-  double missval1 = p1->missval;
-  double missval2 = p2->missval;
+  for ( i = 0; i < NumFunc; i++ )
+    if ( strcmp(fun, fun_sym_tbl[i].name) == 0 ) return (i);
 
-  long ngp1 = gridInqSize(p1->gridID);
-  long ngp2 = gridInqSize(p2->gridID);
+  cdoAbort("Function >%s< not available!", fun);
 
-  if ( ngp1 != ngp2 ) cdoAbort("Number of grid points differ. ngp1 = %ld, ngp2 = %ld", ngp1, ngp2);
+  return (-1);
+}
 
-  long ngp = ngp1;
+static
+double expr_con_con(int oper, double cval1, double cval2)
+{
+  switch ( oper )
+    {
+    case '+':  cval1 = cval1 + cval2; break;
+    case '-':  cval1 = cval1 - cval2; break;
+    case '*':  cval1 = cval1 * cval2; break;
+    case '/':  cval1 = cval1 / cval2; break;
+    case '^':  cval1 = pow(cval1, cval2); break;
+    default:   cdoAbort("%s: operator %c unsupported!", __func__, oper); break;
+    }
 
-  long nlev1 = zaxisInqSize(p1->zaxisID);
-  long nlev2 = zaxisInqSize(p2->zaxisID);
+  return (cval1);
+}
 
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
+/*
+  Compiles the (sub)expression p, returns the index of the result node.
+  Operations with constants only are evaluated here.
+*/
+static
+int plan_compile(exprplan_t *plan, nodeType *p, parse_parm_t *parse_arg)
+{
+  exprnode_t node;
+  int i, op[3];
 
-  p->type     = typeVar;
-  p->tmpvar   = 1;
-  p->u.var.nm = strdupx("tmp");
+  memset(&node, 0, sizeof(exprnode_t));
 
-  if ( nlev1 > nlev2 )
-    {
-      nlev = nlev1;
-      p->gridID  = p1->gridID;
-      p->zaxisID = p1->zaxisID;
-      p->missval = p1->missval;
-      if ( nlev2 != 1 ) cdoAbort("nlev2 = %d must be 1!", nlev2);
-    }
-  else if ( nlev2 > nlev1 )
-    {
-      nlev = nlev2;
-      p->gridID  = p2->gridID;
-      p->zaxisID = p2->zaxisID;
-      p->missval = p2->missval;
-      if ( nlev1 != 1 ) cdoAbort("nlev1 = %d must be 1!", nlev1);
-    }
-  else
+  switch ( p->type )
     {
-      nlev = nlev1;
-      p->gridID  = p1->gridID;
-      p->zaxisID = p1->zaxisID;
-      p->missval = p1->missval;
-    }
+    case typeCon:
+      return (plan_add_con(plan, p->u.con.value));
+    case typeVar:
+      node.type    = EXPR_VAR;
+      node.varID   = expr_find_var(parse_arg->vlistID1, p->u.var.nm);
+      node.ngp     = gridInqSize(p->gridID);
+      node.nlev    = zaxisInqSize(p->zaxisID);
+      node.missval = p->missval;
+      break;
+    case typeFun:
+      op[0] = plan_compile(plan, p->u.fun.op, parse_arg);
+      node.funcID = expr_find_func(p->u.fun.name);
+      if ( plan->nodes[op[0]].type == EXPR_CON )
+	{
+	  if ( fun_sym_tbl[node.funcID].type != 0 ) cdoAbort("Function >%s< not available!", p->u.fun.name);
+	  return (plan_add_con(plan, fun_sym_tbl[node.funcID].func(plan->nodes[op[0]].cval)));
+	}
 
-  p->data = (double*) malloc(ngp*nlev*sizeof(double));
+      node.type     = EXPR_FUN;
+      node.nops     = 1;
+      node.op[0]    = op[0];
+      node.ngp      = plan->nodes[op[0]].ngp;
+      node.nlev     = plan->nodes[op[0]].nlev;
+      node.missval  = plan->nodes[op[0]].missval;
+      node.missval1 = node.missval;
+      break;
+    case typeOpr:
+      node.type = EXPR_OPR;
+      node.oper = p->u.opr.oper;
+      node.nops = p->u.opr.nops;
+      for ( i = 0; i < node.nops; ++i )
+	op[i] = node.op[i] = plan_compile(plan, p->u.opr.op[i], parse_arg);
 
-  for ( k = 0; k < nlev; k++ )
-    {
-      loff = k*ngp;
+      if ( node.oper == UMINUS )
+	{
+	  const exprnode_t *p1 = &plan->nodes[op[0]];
 
-      if ( nlev1 == 1 ) loff1 = 0;
-      else              loff1 = k*ngp;
+	  if ( p1->type == EXPR_CON ) return (plan_add_con(plan, -p1->cval));
 
-      if ( nlev2 == 1 ) loff2 = 0;
-      else              loff2 = k*ngp;
+	  node.ngp      = p1->ngp;
+	  node.nlev     = p1->nlev;
+	  node.missval  = p1->missval;
+	  node.missval1 = p1->missval;
+	}
+      else if ( node.oper == '?' )
+	{
+	  const exprnode_t *px = &plan->nodes[op[0]];
 
-      const double *restrict idat1 = p1->data+loff1;
-      const double *restrict idat2 = p2->data+loff2;
-      double *restrict odat = p->data+loff;
-      int nmiss = nmiss1 > 0 || nmiss2 > 0;
+	  if ( px->type == EXPR_CON )
+	    cdoAbort("expr?expr:expr: First expression is a constant but must be a variable!");
 
-      switch ( oper )
-	{
-	case '+':
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = ADD(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] = idat1[i] + idat2[i];
-	  break;
-	case '-':
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = SUB(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] = idat1[i] - idat2[i];
-	  break;
-	case '*':
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MUL(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] = idat1[i] * idat2[i];
-	  break;
-	case '/':
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = DIV(idat1[i], idat2[i]);
-	  else
+	  node.ngp      = px->ngp;
+	  node.nlev     = px->nlev;
+	  node.missval1 = px->missval;
+
+	  for ( i = 1; i < 3; ++i )
 	    {
-	      for ( i = 0; i < ngp; ++i )
+	      const exprnode_t *pi = &plan->nodes[op[i]];
+	      if ( pi->type == EXPR_CON ) continue;
+
+	      if ( pi->ngp > 1 && pi->ngp != node.ngp )
+		cdoAbort("expr?expr:expr: Number of grid points differ. ngp1 = %ld, ngp%d = %ld", node.ngp, i+1, pi->ngp);
+	      if ( pi->nlev > 1 && pi->nlev != node.nlev )
 		{
-		  if ( IS_EQUAL(idat2[i], 0.) ) odat[i] = missval1;
-		  else                          odat[i] = idat1[i] / idat2[i];
+		  if ( node.nlev == 1 )
+		    {
+		      node.nlev = pi->nlev;
+		      px = pi;
+		    }
+		  else
+		    cdoAbort("expr?expr:expr: Number of levels differ. nlev = %ld, nlev%d = %ld", node.nlev, i+1, pi->nlev);
 		}
 	    }
-	  break;
-	case '^':
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = POW(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] = pow(idat1[i], idat2[i]);
-	  break;
-	case '<':
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MVCOMPLT(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] =   COMPLT(idat1[i], idat2[i]);
-	  break;
-	case '>':
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MVCOMPGT(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] =   COMPGT(idat1[i], idat2[i]);
-	  break;
-	case LE:
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MVCOMPLE(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] =   COMPLE(idat1[i], idat2[i]);
-	  break;
-	case GE:
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MVCOMPGE(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] =   COMPGE(idat1[i], idat2[i]);
-	  break;
-	case NE:
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MVCOMPNE(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] =   COMPNE(idat1[i], idat2[i]);
-	  break;
-	case EQ:
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MVCOMPEQ(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] =   COMPEQ(idat1[i], idat2[i]);
-	  break;
-	case LEG:
-	  if ( nmiss ) for ( i=0; i<ngp; ++i ) odat[i] = MVCOMPLEG(idat1[i], idat2[i]);
-	  else         for ( i=0; i<ngp; ++i ) odat[i] =   COMPLEG(idat1[i], idat2[i]);
-	  break;
-	default:
-	  cdoAbort("%s: operator %c unsupported!", __func__, oper);
-          break;
+
+	  node.missval = px->missval;
 	}
-    }
+      else
+	{
+	  const exprnode_t *p1 = &plan->nodes[op[0]];
+	  const exprnode_t *p2 = &plan->nodes[op[1]];
 
-  nmiss = 0;
-  for ( i = 0; i < ngp*nlev; i++ )
-    if ( DBL_IS_EQUAL(p->data[i], missval1) ) nmiss++;
+	  if ( p1->type == EXPR_CON && p2->type == EXPR_CON )
+	    return (plan_add_con(plan, expr_con_con(node.oper, p1->cval, p2->cval)));
 
-  p->nmiss = nmiss;
+	  if ( p1->type == EXPR_CON )
+	    {
+	      node.ngp      = p2->ngp;
+	      node.nlev     = p2->nlev;
+	      node.missval  = p2->missval;
+	      node.missval1 = p2->missval;
+	      node.missval2 = p2->missval;
+	      if ( node.oper == '/' ) node.mvforce = TRUE;
+	    }
+	  else if ( p2->type == EXPR_CON )
+	    {
+	      node.ngp      = p1->ngp;
+	      node.nlev     = p1->nlev;
+	      node.missval  = p1->missval;
+	      node.missval1 = p1->missval;
+	      node.missval2 = p1->missval;
+	      if ( node.oper == '/' && IS_EQUAL(p2->cval, 0) ) node.mvforce = TRUE;
+	    }
+	  else
+	    {
+	      if ( p1->ngp != p2->ngp )
+		cdoAbort("Number of grid points differ. ngp1 = %ld, ngp2 = %ld", p1->ngp, p2->ngp);
+
+	      node.ngp      = p1->ngp;
+	      node.missval1 = p1->missval;
+	      node.missval2 = p2->missval;
+
+	      if ( p1->nlev > p2->nlev )
+		{
+		  if ( p2->nlev != 1 ) cdoAbort("nlev2 = %ld must be 1!", p2->nlev);
+		  node.nlev    = p1->nlev;
+		  node.missval = p1->missval;
+		}
+	      else if ( p2->nlev > p1->nlev )
+		{
+		  if ( p1->nlev != 1 ) cdoAbort("nlev1 = %ld must be 1!", p1->nlev);
+		  node.nlev    = p2->nlev;
+		  node.missval = p2->missval;
+		}
+	      else
+		{
+		  node.nlev    = p1->nlev;
+		  node.missval = p1->missval;
+		}
+	    }
 
-  if ( p1->tmpvar ) free(p1->data);
-  if ( p2->tmpvar ) free(p2->data);
+	  switch ( node.oper )
+	    {
+	    case '+': case '-': case '*': case '/': case '^':
+	    case '<': case '>': case LE: case GE: case NE: case EQ: case LEG:
+	      break;
+	    default:
+	      cdoAbort("%s: operator %c unsupported!", __func__, node.oper);
+	      break;
+	    }
+	}
+      break;
+    }
 
-  return (p);
+  return (plan_add_node(plan, &node));
 }
 
-static
-void ex_copy(nodeType *p2, nodeType *p1)
+/*
+  Adds the statement <output variable varID> = p to the plan.
+*/
+void expr_plan_add(parse_parm_t *parse_arg, nodeType *p, int varID)
 {
-  long ngp, ngp1, ngp2, i;
-  long nlev;
+  exprplan_t *plan;
+  exprstmt_t *stmt;
+  int first;
 
-  if ( cdoVerbose )
-    printf("\tcopy %s\n", p1->u.var.nm);
+  if ( parse_arg->plan == NULL ) parse_arg->plan = plan_new();
+  plan = parse_arg->plan;
 
-  ngp1 = gridInqSize(p1->gridID);
-  ngp2 = gridInqSize(p2->gridID);
+  first = plan->nnodes;
 
-  if ( ngp1 != ngp2 )
-    cdoAbort("Number of grid points differ. ngp1 = %d, ngp2 = %d", ngp1, ngp2);
+  plan->stmts = (exprstmt_t*) realloc(plan->stmts, (plan->nstmts+1)*sizeof(exprstmt_t));
+  stmt = &plan->stmts[plan->nstmts++];
 
-  ngp = ngp2;
-  nlev = zaxisInqSize(p2->zaxisID);
+  stmt->first = first;
+  stmt->root  = plan_compile(plan, p, parse_arg);
+  stmt->varID = varID;
+  stmt->ngp   = gridInqSize(vlistInqVarGrid(parse_arg->vlistID2, varID));
+  stmt->nlev  = zaxisInqSize(vlistInqVarZaxis(parse_arg->vlistID2, varID));
 
-  for ( i = 0; i < ngp*nlev; i++ )
-    p2->data[i] = p1->data[i];
+  const exprnode_t *root = &plan->nodes[stmt->root];
 
-  p2->missval = p1->missval;
-  p2->nmiss   = p1->nmiss;
+  if ( root->ngp != stmt->ngp )
+    cdoAbort("Number of grid points differ. ngp1 = %ld, ngp2 = %ld", root->ngp, stmt->ngp);
+  if ( root->nlev != stmt->nlev )
+    cdoAbort("Number of levels differ. nlev1 = %ld, nlev2 = %ld", root->nlev, stmt->nlev);
 }
 
 static
-nodeType *expr(int oper, nodeType *p1, nodeType *p2)
+void ex_binary(const exprnode_t *node, int lmiss, long n, const double *restrict idat1,
+	       const double *restrict idat2, double *restrict odat)
 {
-  nodeType *p = NULL;
+  double missval1 = node->missval1;
+  double missval2 = node->missval2;
+  long i;
 
-  if ( p1->type == typeVar && p2->type == typeVar )
-    {
-      p = expr_var_var(oper, p1, p2);
-      if ( cdoVerbose )
-	printf("\t%s %c %s\n", p1->u.var.nm, oper, p2->u.var.nm);
-    }
-  else if ( p1->type == typeCon && p2->type == typeCon )
+  switch ( node->oper )
     {
-      p = expr_con_con(oper, p1, p2);
-      if ( cdoVerbose )
-	printf("\t%g %c %g\n", p1->u.con.value, oper, p2->u.con.value);
-    }
-  else if ( p1->type == typeVar && p2->type == typeCon )
-    {
-      p = expr_var_con(oper, p1, p2);
-      if ( cdoVerbose )
-	printf("\t%s %c %g\n", p1->u.var.nm, oper, p2->u.con.value);
-    }
-  else if ( p1->type == typeCon && p2->type == typeVar )
-    {
-      p = expr_con_var(oper, p1, p2);
-      if ( cdoVerbose )
-	printf("\t%g %c %s\n", p1->u.con.value, oper, p2->u.var.nm);
+    case '+':
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = ADD(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] = idat1[i] + idat2[i];
+      break;
+    case '-':
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = SUB(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] = idat1[i] - idat2[i];
+      break;
+    case '*':
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MUL(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] = idat1[i] * idat2[i];
+      break;
+    case '/':
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = DIV(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] = IS_EQUAL(idat2[i], 0.) ? missval1 : idat1[i] / idat2[i];
+      break;
+    case '^':
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = POW(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] = pow(idat1[i], idat2[i]);
+      break;
+    case '<':
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLT(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLT(idat1[i], idat2[i]);
+      break;
+    case '>':
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPGT(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] =   COMPGT(idat1[i], idat2[i]);
+      break;
+    case LE:
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLE(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLE(idat1[i], idat2[i]);
+      break;
+    case GE:
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPGE(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] =   COMPGE(idat1[i], idat2[i]);
+      break;
+    case NE:
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPNE(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] =   COMPNE(idat1[i], idat2[i]);
+      break;
+    case EQ:
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPEQ(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] =   COMPEQ(idat1[i], idat2[i]);
+      break;
+    case LEG:
+      if ( lmiss ) for ( i=0; i<n; ++i ) odat[i] = MVCOMPLEG(idat1[i], idat2[i]);
+      else         for ( i=0; i<n; ++i ) odat[i] =   COMPLEG(idat1[i], idat2[i]);
+      break;
     }
-  else
-    cdoAbort("Internal problem!");
-
-  return (p);
 }
 
 static
-nodeType *ex_fun_con(char *fun, nodeType *p1)
+void ex_fun(const exprnode_t *node, int lmiss, long n, const double *restrict idat, double *restrict odat)
 {
-  int i;
-  int funcID = -1;
-
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
-
-  p->type = typeCon;
-
-  for ( i = 0; i < NumFunc; i++)
-    if ( fun_sym_tbl[i].type == 0 )
-      if ( strcmp(fun, fun_sym_tbl[i].name) == 0 )
-	{ 
-	  funcID = i;
-	  break;
-	}
-
-  if ( funcID == -1 )
-    cdoAbort("Function >%s< not available!", fun);
-
-  p->u.con.value = fun_sym_tbl[funcID].func(p1->u.con.value);
+  double (*func)(double) = fun_sym_tbl[node->funcID].func;
+  double missval = node->missval1;
+  long i;
 
-  return (p);
+  for ( i = 0; i < n; i++ )
+    {
+      errno = -1;
+      odat[i] = (lmiss && DBL_IS_EQUAL(idat[i], missval)) ? missval : func(idat[i]);
+      if ( errno == EDOM || errno == ERANGE ) odat[i] = missval;
+      else if ( isnan(odat[i]) )  odat[i] = missval;
+    }
 }
 
 static
-nodeType *ex_fun_var(char *fun, nodeType *p1)
+void ex_uminus(const exprnode_t *node, int lmiss, long n, const double *restrict idat, double *restrict odat)
 {
+  double missval = node->missval1;
   long i;
-  int funcID = -1;
-  int gridID  = p1->gridID;
-  int zaxisID = p1->zaxisID;
-  int nmiss   = p1->nmiss;
-  double missval = p1->missval;
-
-  long ngp  = gridInqSize(gridID);
-  long nlev = zaxisInqSize(zaxisID);
-
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
-
-  p->type     = typeVar;
-  p->tmpvar   = 1;
-  p->u.var.nm = strdupx("tmp");
-  p->gridID   = gridID;
-  p->zaxisID  = zaxisID;
-  p->missval  = missval;
-
-  p->data = (double*) malloc(ngp*nlev*sizeof(double));
-
-  for ( i = 0; i < NumFunc; i++)
-    if ( strcmp(fun, fun_sym_tbl[i].name) == 0 )
-      { 
-	funcID = i;
-	break;
-      }
-
-  if ( funcID == -1 )
-    cdoAbort("Function >%s< not available!", fun);
 
-  if ( nmiss > 0 )
-    {
-      for ( i = 0; i < ngp*nlev; i++ )
-	{
-	  errno = -1;
-	  p->data[i] = DBL_IS_EQUAL(p1->data[i], missval) ? missval : fun_sym_tbl[funcID].func(p1->data[i]);
-	  if ( errno == EDOM || errno == ERANGE ) p->data[i] = missval;
-	  else if ( isnan(p->data[i]) )  p->data[i] = missval;
-	}
-    }
-  else
-    {
-      for ( i = 0; i < ngp*nlev; i++ )
-	{
-	  errno = -1;
-	  p->data[i] = fun_sym_tbl[funcID].func(p1->data[i]);
-	  if ( errno == EDOM || errno == ERANGE ) p->data[i] = missval;
-	  else if ( isnan(p->data[i]) )  p->data[i] = missval;
-	}
-    }
-
-  nmiss = 0;
-  for ( i = 0; i < ngp*nlev; i++ )
-    if ( DBL_IS_EQUAL(p->data[i], missval) ) nmiss++;
-
-  p->nmiss = nmiss;
-
-  if ( p1->tmpvar ) free(p1->data);
-
-  return (p);
+  if ( lmiss ) for ( i = 0; i < n; i++ ) odat[i] = DBL_IS_EQUAL(idat[i], missval) ? missval : -idat[i];
+  else         for ( i = 0; i < n; i++ ) odat[i] = -idat[i];
 }
 
 static
-nodeType *ex_fun(char *fun, nodeType *p1)
+void ex_ifelse(const exprnode_t *node, const exprnode_t *p2, const exprnode_t *p3, int lmiss, long n,
+	       const double *restrict idat1, const double *restrict idat2, const double *restrict idat3,
+	       double *restrict odat)
 {
-  nodeType *p = NULL;
+  double missval1 = node->missval1;
+  double missval2 = p2->type == EXPR_CON ? missval1 : p2->missval;
+  double missval3 = p3->type == EXPR_CON ? missval1 : p3->missval;
+  double ival2 = idat2[0];
+  double ival3 = idat3[0];
+  long i;
 
-  if ( p1->type == typeVar )
-    {
-      p = ex_fun_var(fun, p1);
-      if ( cdoVerbose ) printf("\t%s (%s)\n", fun, p1->u.var.nm);
-    }
-  else if ( p1->type == typeCon )
+  for ( i = 0; i < n; ++i )
     {
-      p = ex_fun_con(fun, p1);
-      if ( cdoVerbose ) printf("\t%s (%g)\n", fun, p1->u.con.value);
-    }
-  else
-    cdoAbort("Internal problem!");
+      if ( p2->ngp > 1 ) ival2 = idat2[i];
+      if ( p3->ngp > 1 ) ival3 = idat3[i];
 
-  return (p);
+      if ( lmiss && DBL_IS_EQUAL(idat1[i], missval1) )
+	odat[i] = missval1;
+      else if ( IS_NOT_EQUAL(idat1[i], 0) )
+	odat[i] = DBL_IS_EQUAL(ival2, missval2) ? missval1 : ival2;
+      else
+	odat[i] = DBL_IS_EQUAL(ival3, missval3) ? missval1 : ival3;
+    }
 }
 
+/* data of the node inode for the level k and the block starting at the grid point i0 */
 static
-nodeType *ex_uminus_var(nodeType *p1)
+const double *plan_operand(const exprplan_t *plan, int inode, const parse_parm_t *parse_arg,
+			   const double *work, long k, long i0)
 {
-  int gridID  = p1->gridID;
-  int zaxisID = p1->zaxisID;
-  int nmiss   = p1->nmiss;
-  double missval = p1->missval;
-
-  long ngp  = gridInqSize(gridID);
-  long nlev = zaxisInqSize(zaxisID);
-
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
+  const exprnode_t *node = &plan->nodes[inode];
 
-  p->type     = typeVar;
-  p->tmpvar   = 1;
-  p->u.var.nm = strdupx("tmp");
-  p->gridID   = gridID;
-  p->zaxisID  = zaxisID;
-  p->missval  = missval;
+  if ( node->type == EXPR_CON ) return (node->cdata);
 
-  p->data = (double*) malloc(ngp*nlev*sizeof(double));
-
-  if ( nmiss > 0 )
-    {
-      for ( long i = 0; i < ngp*nlev; i++ )
-	p->data[i] = DBL_IS_EQUAL(p1->data[i], missval) ? missval : -(p1->data[i]);
-    }
-  else
+  if ( node->type == EXPR_VAR )
     {
-      for ( long i = 0; i < ngp*nlev; i++ )
-	p->data[i] = -(p1->data[i]);
+      if ( node->nlev == 1 ) k  = 0;
+      if ( node->ngp  == 1 ) i0 = 0;
+      return (parse_arg->vardata1[node->varID] + k*node->ngp + i0);
     }
 
-  p->nmiss = nmiss;
-  
-  return (p);
+  return (work + (long)inode*EXPR_BLOCKSIZE);
 }
 
 static
-nodeType *ex_uminus_con(nodeType *p1)
+void plan_exec_block(const exprplan_t *plan, const exprstmt_t *stmt, const parse_parm_t *parse_arg,
+		     exprwork_t *work, long k, long i0, long n)
 {
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
+  const double *idat[3];
+  double *odat;
+  long i, nb, nmiss;
+  int inode, j;
 
-  p->type = typeCon;
+  for ( inode = stmt->first; inode <= stmt->root; ++inode )
+    {
+      const exprnode_t *node = &plan->nodes[inode];
 
-  p->u.con.value = -(p1->u.con.value);
+      if ( node->type == EXPR_CON || node->type == EXPR_VAR ) continue;
 
-  return (p);
-}
+      /* a single point or level is broadcasted to the other operands */
+      long kx = node->nlev == 1 ? 0 : k;
+      long ix = node->ngp  == 1 ? 0 : i0;
+      nb = node->ngp == 1 ? 1 : n;
 
-static
-nodeType *ex_uminus(nodeType *p1)
-{
-  nodeType *p = NULL;
+      for ( j = 0; j < node->nops; ++j )
+	idat[j] = plan_operand(plan, node->op[j], parse_arg, work->work, kx, ix);
 
-  if ( p1->type == typeVar )
-    {
-      p = ex_uminus_var(p1);
-      if ( cdoVerbose ) printf("\t- (%s)\n", p1->u.var.nm);
-    }
-  else if ( p1->type == typeCon )
-    {
-      p = ex_uminus_con(p1);
-      if ( cdoVerbose ) printf("\t- (%g)\n", p1->u.con.value);
-    }
-  else
-    cdoAbort("Internal problem!");
+      if ( inode == stmt->root )
+	odat = parse_arg->vardata2[stmt->varID] + k*stmt->ngp + i0;
+      else
+	odat = work->work + (long)inode*EXPR_BLOCKSIZE;
 
-  return (p);
-}
+      const exprnode_t *p1 = &plan->nodes[node->op[0]];
 
-static
-nodeType *ex_ifelse(nodeType *p1, nodeType *p2, nodeType *p3)
-{
-  if ( cdoVerbose ) printf("\t %s ? %s : %s\n", p1->u.var.nm, p2->u.var.nm, p3->u.var.nm);
-
-  if ( p1->type == typeCon ) cdoAbort("expr?expr:expr: First expression is a constant but must be a variable!");
-
-  int nmiss1 = p1->nmiss;
-  long ngp1 = gridInqSize(p1->gridID);
-  long nlev1 = zaxisInqSize(p1->zaxisID);
-  double missval1 = p1->missval;
-  double *pdata1 = p1->data;
-
-  long ngp = ngp1;
-  long nlev = nlev1;
-  nodeType *px = p1;
-
-  double missval2 = missval1;
-  double *pdata2;
-  long ngp2 = 1;
-  long nlev2 = 1;
-  
-  if ( p2->type == typeCon )
-    {
-      pdata2 = &p2->u.con.value;
-    }
-  else
-    {
-      ngp2 = gridInqSize(p2->gridID);
-      nlev2 = zaxisInqSize(p2->zaxisID);
-      missval2 = p2->missval;
-      pdata2 = p2->data;
-      if ( ngp2 > 1 && ngp2 != ngp1 )
-	cdoAbort("expr?expr:expr: Number of grid points differ. ngp1 = %ld, ngp2 = %ld", ngp1, ngp2);
-      if ( nlev2 > 1 && nlev2 != nlev )
+      if ( node->type == EXPR_FUN )
+	ex_fun(node, p1->hasmiss, nb, idat[0], odat);
+      else if ( node->oper == UMINUS )
+	ex_uminus(node, p1->hasmiss, nb, idat[0], odat);
+      else if ( node->oper == '?' )
+	ex_ifelse(node, &plan->nodes[node->op[1]], &plan->nodes[node->op[2]], p1->hasmiss, nb,
+		  idat[0], idat[1], idat[2], odat);
+      else
 	{
-	  if ( nlev == 1 )
-	    {
-	      nlev = nlev2;
-	      px = p2;
-	    }
-	  else
-	    cdoAbort("expr?expr:expr: Number of levels differ. nlev = %ld, nlev2 = %ld", nlev, nlev2);
+	  const exprnode_t *p2 = &plan->nodes[node->op[1]];
+	  ex_binary(node, node->mvforce || p1->hasmiss || p2->hasmiss, nb, idat[0], idat[1], odat);
 	}
-    }
 
-  double missval3 = missval1;
-  double *pdata3;
-  long ngp3 = 1;
-  long nlev3 = 1;
-  
-  if ( p3->type == typeCon )
-    {
-      pdata3 = &p3->u.con.value;
-    }
-  else
-    {
-      ngp3 = gridInqSize(p3->gridID);
-      nlev3 = zaxisInqSize(p3->zaxisID);
-      missval3 = p3->missval;
-      pdata3 = p3->data;
-      if ( ngp3 > 1 && ngp3 != ngp1 )
-	cdoAbort("expr?expr:expr: Number of grid points differ. ngp1 = %ld, ngp3 = %ld", ngp1, ngp3);
-      if ( nlev3 > 1 && nlev3 != nlev )
+      if ( inode != stmt->root && node->oper != UMINUS )
 	{
-	  if ( nlev == 1 )
-	    {
-	      nlev = nlev3;
-	      px = p3;
-	    }
-	  else
-	    cdoAbort("expr?expr:expr: Number of levels differ. nlev = %ld, nlev3 = %ld", nlev, nlev3);
+	  double missval1 = node->missval1;
+	  nmiss = 0;
+	  for ( i = 0; i < nb; ++i )
+	    if ( DBL_IS_EQUAL(odat[i], missval1) ) nmiss++;
+	  work->nmiss[inode] += nmiss;
 	}
     }
 
-  nodeType *p = (nodeType*) malloc(sizeof(nodeType));
-
-  p->type     = typeVar;
-  p->tmpvar   = 1;
-  p->u.var.nm = strdupx("tmp");
-
-  p->gridID  = px->gridID;
-  p->zaxisID = px->zaxisID;
-  p->missval = px->missval;
-
-  p->data = (double*) malloc(ngp*nlev*sizeof(double));
-
-  long loff, loff1, loff2, loff3;
-
-  for ( long k = 0; k < nlev; ++k )
+  if ( plan->nodes[stmt->root].type == EXPR_VAR )
     {
-      loff = k*ngp;
+      odat = parse_arg->vardata2[stmt->varID] + k*stmt->ngp + i0;
+      idat[0] = plan_operand(plan, stmt->root, parse_arg, work->work, k, i0);
+      for ( i = 0; i < n; ++i ) odat[i] = idat[0][i];
+    }
+}
 
-      if ( nlev1 == 1 ) loff1 = 0;
-      else              loff1 = k*ngp;
+static
+void plan_exec_stmt(exprplan_t *plan, const exprstmt_t *stmt, const parse_parm_t *parse_arg)
+{
+  long nblocks = (stmt->ngp + EXPR_BLOCKSIZE - 1)/EXPR_BLOCKSIZE;
+  long ntasks  = stmt->nlev*nblocks;
+  long itask;
+  int inode, ith, lchange;
 
-      if ( nlev2 == 1 ) loff2 = 0;
-      else              loff2 = k*ngp;
+  for ( inode = stmt->first; inode <= stmt->root; ++inode )
+    {
+      exprnode_t *node = &plan->nodes[inode];
+      if ( node->type == EXPR_VAR ) node->hasmiss = parse_arg->nmiss[node->varID] > 0;
+    }
 
-      if ( nlev3 == 1 ) loff3 = 0;
-      else              loff3 = k*ngp;
+  do
+    {
+      for ( ith = 0; ith < plan->nwork; ++ith )
+	for ( inode = stmt->first; inode <= stmt->root; ++inode )
+	  plan->work[ith].nmiss[inode] = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(static)
+#endif
+      for ( itask = 0; itask < ntasks; ++itask )
+	{
+	  int ompthID = cdo_omp_get_thread_num();
+	  long k  = itask/nblocks;
+	  long i0 = (itask%nblocks)*EXPR_BLOCKSIZE;
+	  long n  = stmt->ngp - i0;
+	  if ( n > EXPR_BLOCKSIZE ) n = EXPR_BLOCKSIZE;
 
-      const double *restrict idat1 = pdata1+loff1;
-      const double *restrict idat2 = pdata2+loff2;
-      const double *restrict idat3 = pdata3+loff3;
-      double *restrict odat = p->data+loff;
+	  plan_exec_block(plan, stmt, parse_arg, &plan->work[ompthID], k, i0, n);
+	}
 
-      double ival2 = idat2[0];
-      double ival3 = idat3[0];
-      for ( long i = 0; i < ngp; ++i ) 
+      /* evaluate again if the assumed nmiss of an operand was wrong */
+      lchange = FALSE;
+      for ( inode = stmt->first; inode < stmt->root; ++inode )
 	{
-	  if ( ngp2 > 1 ) ival2 = idat2[i];
-	  if ( ngp3 > 1 ) ival3 = idat3[i];
+	  exprnode_t *node = &plan->nodes[inode];
+	  int hasmiss;
 
-	  if ( nmiss1 && DBL_IS_EQUAL(idat1[i], missval1) )
-	    odat[i] = missval1;
-	  else if ( IS_NOT_EQUAL(idat1[i], 0) )
-	    odat[i] = DBL_IS_EQUAL(ival2, missval2) ? missval1 : ival2;
+	  if ( node->type == EXPR_CON || node->type == EXPR_VAR ) continue;
+
+	  if ( node->oper == UMINUS )
+	    hasmiss = plan->nodes[node->op[0]].hasmiss;
 	  else
-	    odat[i] = DBL_IS_EQUAL(ival3, missval3) ? missval1 : ival3;
+	    {
+	      long nmiss = 0;
+	      for ( ith = 0; ith < plan->nwork; ++ith ) nmiss += plan->work[ith].nmiss[inode];
+	      hasmiss = nmiss > 0;
+	    }
+
+	  if ( hasmiss != node->hasmiss )
+	    {
+	      node->hasmiss = hasmiss;
+	      lchange = TRUE;
+	    }
 	}
     }
-
-  return (p);
+  while ( lchange );
 }
 
-
-int exNode(nodeType *p, parse_parm_t *parse_arg)
+/*
+  Evaluates all statements of the plan with the input data of parse_arg.
+*/
+void expr_plan_run(parse_parm_t *parse_arg)
 {
-  if ( ! p ) return(0);
+  exprplan_t *plan = parse_arg->plan;
+  int i;
 
-  /* node is leaf */
-  if ( p->type == typeCon || p->type == typeVar || p->u.opr.nops == 0 )
-    {
-      return (0);
-    }
+  if ( plan == NULL ) return;
 
-  /* node has children */
-  for ( int k = 0; k < p->u.opr.nops; k++ )
+  if ( plan->work == NULL )
     {
-      exNode(p->u.opr.op[k], parse_arg);
+      plan->nwork = ompNumThreads;
+      plan->work  = (exprwork_t*) malloc(plan->nwork*sizeof(exprwork_t));
+      for ( i = 0; i < plan->nwork; ++i )
+	{
+	  plan->work[i].work  = (double*) malloc((long)plan->nnodes*EXPR_BLOCKSIZE*sizeof(double));
+	  plan->work[i].nmiss = (long*) malloc(plan->nnodes*sizeof(long));
+	}
     }
 
-  return (0);
+  for ( i = 0; i < plan->nstmts; ++i )
+    plan_exec_stmt(plan, &plan->stmts[i], parse_arg);
 }
 
-
+/*
+  Init pass of the parser: checks the variables, defines the output variables
+  and compiles the statements into the plan of parse_arg.
+*/
 nodeType *expr_run(nodeType *p, parse_parm_t *parse_arg)
 {
   int gridID1 = -1, zaxisID1 = -1, tsteptype1 = -1;
   double missval = 0;
-  char varname[256];
-  int varID, nvars;
+  int varID;
   nodeType *rnode = NULL;
 
   if ( ! p ) return (rnode);
 
-  /*  if ( ! parse_arg->init ) { exNode(p, parse_arg); return (0); } */
-
   switch ( p->type )
     {
     case typeCon:       
-      if ( parse_arg->init )
-	{
-	  if ( parse_arg->debug )
-	    printf("\tpush const \t%g\n", p->u.con.value);
-	}
-      else
-	{
-	  rnode = p;
-	}
+      if ( parse_arg->debug )
+	printf("\tpush const \t%g\n", p->u.con.value);
 
       break;
     case typeVar:
-      /*    if ( parse_arg->init ) */
-	{
-	  if ( parse_arg->debug )
-	    printf("\tpush var \t%s\n", p->u.var.nm);
+      {
+	int nlev1, nlev2 = 0;
 
-	  nvars = vlistNvars(parse_arg->vlistID1);
-	  for ( varID = 0; varID < nvars; varID++ )
-	    {
-	      vlistInqVarName(parse_arg->vlistID1, varID, varname);
-	      if ( strcmp(varname, p->u.var.nm) == 0 ) break;
-	    }
+	if ( parse_arg->debug )
+	  printf("\tpush var \t%s\n", p->u.var.nm);
 
-	  if ( varID == nvars )
-	    {
-	      cdoAbort("Variable >%s< not found!", p->u.var.nm);
-	    }
-	  else
-	    {
-	      int nlev1, nlev2 = 0;
-	      if ( varID >= MAX_VARS ) cdoAbort("Too many parameter (limit=%d)!", MAX_VARS);
+	varID = expr_find_var(parse_arg->vlistID1, p->u.var.nm);
 
-	      if ( parse_arg->var_needed[varID] == 0 )
-		{
+	if ( varID >= MAX_VARS ) cdoAbort("Too many parameter (limit=%d)!", MAX_VARS);
 
-		  parse_arg->var[varID] = strdupx(p->u.var.nm);
-		  parse_arg->varID[varID] = varID;
-		  parse_arg->var_needed[varID] = 1;
-		}
+	if ( parse_arg->var_needed[varID] == 0 )
+	  {
+	    parse_arg->var[varID] = strdupx(p->u.var.nm);
+	    parse_arg->varID[varID] = varID;
+	    parse_arg->var_needed[varID] = 1;
+	  }
 
-	      gridID1    = vlistInqVarGrid(parse_arg->vlistID1, varID);
-	      zaxisID1   = vlistInqVarZaxis(parse_arg->vlistID1, varID);
-	      tsteptype1 = vlistInqVarTsteptype(parse_arg->vlistID1, varID);
-	      missval    = vlistInqVarMissval(parse_arg->vlistID1, varID);
-	      nlev1 = zaxisInqSize(zaxisID1);
+	gridID1    = vlistInqVarGrid(parse_arg->vlistID1, varID);
+	zaxisID1   = vlistInqVarZaxis(parse_arg->vlistID1, varID);
+	tsteptype1 = vlistInqVarTsteptype(parse_arg->vlistID1, varID);
+	missval    = vlistInqVarMissval(parse_arg->vlistID1, varID);
+	nlev1 = zaxisInqSize(zaxisID1);
 
-	      parse_arg->missval2 = missval;
+	parse_arg->missval2 = missval;
 
-	      if ( parse_arg->gridID2 == -1 )
-		parse_arg->gridID2 = gridID1;
+	if ( parse_arg->gridID2 == -1 )
+	  parse_arg->gridID2 = gridID1;
 
-	      if ( parse_arg->zaxisID2 != -1 ) nlev2 = zaxisInqSize(parse_arg->zaxisID2);
+	if ( parse_arg->zaxisID2 != -1 ) nlev2 = zaxisInqSize(parse_arg->zaxisID2);
 
-	      if ( parse_arg->zaxisID2 == -1 || (nlev1 > 1 && nlev2 == 1) )
-		parse_arg->zaxisID2 = zaxisID1;
+	if ( parse_arg->zaxisID2 == -1 || (nlev1 > 1 && nlev2 == 1) )
+	  parse_arg->zaxisID2 = zaxisID1;
 
-	      if ( parse_arg->tsteptype2 == -1 || parse_arg->tsteptype2 == TSTEP_CONSTANT )
-		parse_arg->tsteptype2 = tsteptype1;
-	    }
-	}
-	/* else */
-	{ 
-	  if ( parse_arg->debug )
-	    printf("var: %s %d %d %d\n", p->u.var.nm, varID, gridID1, zaxisID1);
-	  p->gridID  = gridID1;
-	  p->zaxisID = zaxisID1;
-	  p->missval = missval;
-          p->nmiss   = 0;
-	  if ( ! parse_arg->init )
-	    {
-	      p->data  = parse_arg->vardata1[varID];
-	      p->nmiss = parse_arg->nmiss[varID];
-	    }
-	  p->tmpvar  = 0;
-	  rnode = p;
-	}
+	if ( parse_arg->tsteptype2 == -1 || parse_arg->tsteptype2 == TSTEP_CONSTANT )
+	  parse_arg->tsteptype2 = tsteptype1;
+
+	if ( parse_arg->debug )
+	  printf("var: %s %d %d %d\n", p->u.var.nm, varID, gridID1, zaxisID1);
+
+	p->gridID  = gridID1;
+	p->zaxisID = zaxisID1;
+	p->missval = missval;
+	p->nmiss   = 0;
+	p->tmpvar  = 0;
+	rnode = p;
+      }
 
       break;
     case typeFun:
-      if ( parse_arg->init )
-	{
-	  expr_run(p->u.fun.op, parse_arg);
+      expr_run(p->u.fun.op, parse_arg);
+
+      if ( parse_arg->debug )
+	printf("\tcall \t%s\n", p->u.fun.name);
 
-	  if ( parse_arg->debug )
-	    printf("\tcall \t%s\n", p->u.fun.name);
-	}
-      else
-	{
-	  rnode = ex_fun(p->u.fun.name, expr_run(p->u.fun.op, parse_arg));
-	}
       break;
     case typeOpr:
       switch( p->u.opr.oper )
 	{
         case '=':
-	  parse_arg->gridID2    = -1;
-	  parse_arg->zaxisID2   = -1;
-          parse_arg->tsteptype2 = -1;
+	  {
+	    const char *varname = p->u.opr.op[0]->u.var.nm;
 
-	  rnode = expr_run(p->u.opr.op[1], parse_arg);
+	    parse_arg->gridID2    = -1;
+	    parse_arg->zaxisID2   = -1;
+	    parse_arg->tsteptype2 = -1;
 
-	  if ( parse_arg->init )
-	    {
-	      if ( parse_arg->debug )
-		printf("\tpop  var \t%s\n", p->u.opr.op[0]->u.var.nm);
-	      /*
-	      if ( p->u.opr.op[1]->type != typeVar )
-		cdoAbort("Operand not variable!");
-	      */
-	      if ( parse_arg->gridID2 == -1 || parse_arg->zaxisID2 == -1 || parse_arg->tsteptype2 == -1 )
-		cdoAbort("Operand not variable!");
-
-	      varID = vlistDefVar(parse_arg->vlistID2, parse_arg->gridID2, parse_arg->zaxisID2, parse_arg->tsteptype2);
-	      const char *varname = p->u.opr.op[0]->u.var.nm;
-	      vlistDefVarName(parse_arg->vlistID2, varID, varname);
-	      vlistDefVarMissval(parse_arg->vlistID2, varID, parse_arg->missval2);
-	      if ( memcmp(varname, "var", 3) == 0 )
-		{
-		  if ( strlen(varname) > 3 && isdigit(varname[3]) )
-		    {
-		      int code = atoi(varname+3);
-		      vlistDefVarCode(parse_arg->vlistID2, varID, code);
-		    }
-		}
-	    }
-	  else
-	    {
-	      if ( parse_arg->debug )
-		printf("\tpop var\t%s\t%s\n", p->u.opr.op[0]->u.var.nm, rnode->u.var.nm);
+	    expr_run(p->u.opr.op[1], parse_arg);
 
-	      nvars = vlistNvars(parse_arg->vlistID2);
-	      for ( varID = 0; varID < nvars; varID++ )
-		{
-		  vlistInqVarName(parse_arg->vlistID2, varID, varname);
-		  if ( strcmp(varname, p->u.opr.op[0]->u.var.nm) == 0 ) break;
-		}
+	    if ( parse_arg->debug )
+	      printf("\tpop  var \t%s\n", varname);
 
-	      if ( varID == nvars )
-		{
-		  cdoAbort("Variable >%s< not found!", p->u.opr.op[0]->u.var.nm);
-		}
-	      else
-		{
-		  parse_arg->gridID2  = vlistInqVarGrid(parse_arg->vlistID2, varID);
-		  parse_arg->zaxisID2 = vlistInqVarZaxis(parse_arg->vlistID2, varID);
-		  parse_arg->tsteptype2 = vlistInqVarTsteptype(parse_arg->vlistID2, varID);
-		  missval  = vlistInqVarMissval(parse_arg->vlistID2, varID);
-	      
-		  p->gridID  = parse_arg->gridID2;
-		  p->zaxisID = parse_arg->zaxisID2;
-		  p->missval = missval;
-		  p->data    = parse_arg->vardata2[varID];
-		  p->tmpvar  = 0;
-
-		  ex_copy(p, rnode);
-
-		  if ( rnode->tmpvar ) free(rnode->data);
-		}
-	    }
+	    if ( parse_arg->gridID2 == -1 || parse_arg->zaxisID2 == -1 || parse_arg->tsteptype2 == -1 )
+	      cdoAbort("Operand not variable!");
+
+	    varID = vlistDefVar(parse_arg->vlistID2, parse_arg->gridID2, parse_arg->zaxisID2, parse_arg->tsteptype2);
+	    vlistDefVarName(parse_arg->vlistID2, varID, varname);
+	    vlistDefVarMissval(parse_arg->vlistID2, varID, parse_arg->missval2);
+	    if ( memcmp(varname, "var", 3) == 0 )
+	      {
+		if ( strlen(varname) > 3 && isdigit(varname[3]) )
+		  {
+		    int code = atoi(varname+3);
+		    vlistDefVarCode(parse_arg->vlistID2, varID, code);
+		  }
+	      }
+
+	    /* the result is stored in the first output variable with this name */
+	    expr_plan_add(parse_arg, p->u.opr.op[1], expr_find_var(parse_arg->vlistID2, varname));
+	  }
 
 	  break;
         case UMINUS:    
-	  if ( parse_arg->init )
-	    {
-	      expr_run(p->u.opr.op[0], parse_arg);
+	  expr_run(p->u.opr.op[0], parse_arg);
 
-	      if ( parse_arg->debug )
-		printf("\tneg\n");
-	    }
-	  else
-	    {
-	      rnode = ex_uminus(expr_run(p->u.opr.op[0], parse_arg));
-	    }
+	  if ( parse_arg->debug )
+	    printf("\tneg\n");
 
 	  break;
         case '?':    
-	  if ( parse_arg->init )
-	    {
-	      expr_run(p->u.opr.op[0], parse_arg);
-	      expr_run(p->u.opr.op[1], parse_arg);
-	      expr_run(p->u.opr.op[2], parse_arg);
+	  expr_run(p->u.opr.op[0], parse_arg);
+	  expr_run(p->u.opr.op[1], parse_arg);
+	  expr_run(p->u.opr.op[2], parse_arg);
 
-	      if ( parse_arg->debug )
-		printf("\t?:\n");
-	    }
-	  else
-	    {
-	      rnode = ex_ifelse(expr_run(p->u.opr.op[0], parse_arg),
-			        expr_run(p->u.opr.op[1], parse_arg),
-			        expr_run(p->u.opr.op[2], parse_arg));
-	    }
+	  if ( parse_arg->debug )
+	    printf("\t?:\n");
 
 	  break;
         default:
-	  if ( parse_arg->init )
-	    {
-	      expr_run(p->u.opr.op[0], parse_arg);
-	      expr_run(p->u.opr.op[1], parse_arg);
-	      if ( parse_arg->debug )
-		switch( p->u.opr.oper )
-		  {
-		  case '+':  printf("\tadd\n"); break;
-		  case '-':  printf("\tsub\n"); break;
-		  case '*':  printf("\tmul\n"); break;
-		  case '/':  printf("\tdiv\n"); break;
-		  case '<':  printf("\tcompLT\n"); break;
-		  case '>':  printf("\tcompGT\n"); break;
-		  case LE:   printf("\tcompLE\n"); break;
-		  case GE:   printf("\tcompGE\n"); break;
-		  case NE:   printf("\tcompNE\n"); break;
-		  case EQ:   printf("\tcompEQ\n"); break;
-		  case LEG:  printf("\tcompLEG\n"); break;
-		  }
-	    }
-	  else
-	    {
-	      rnode = expr(p->u.opr.oper, expr_run(p->u.opr.op[0], parse_arg),
-			                  expr_run(p->u.opr.op[1], parse_arg));
-	    }
+	  expr_run(p->u.opr.op[0], parse_arg);
+	  expr_run(p->u.opr.op[1], parse_arg);
+	  if ( parse_arg->debug )
+	    switch( p->u.opr.oper )
+	      {
+	      case '+':  printf("\tadd\n"); break;
+	      case '-':  printf("\tsub\n"); break;
+	      case '*':  printf("\tmul\n"); break;
+	      case '/':  printf("\tdiv\n"); break;
+	      case '<':  printf("\tcompLT\n"); break;
+	      case '>':  printf("\tcompGT\n"); break;
+	      case LE:   printf("\tcompLE\n"); break;
+	      case GE:   printf("\tcompGE\n"); break;
+	      case NE:   printf("\tcompNE\n"); break;
+	      case EQ:   printf("\tcompEQ\n"); break;
+	      case LEG:  printf("\tcompLEG\n"); break;
+	      }
           break;
         }
       break;
@@ -66,6 +66,8 @@ typedef struct nodeTypeTag {
 
 #define MAX_VARS 1024
 
+typedef struct exprplan exprplan_t;
+
 typedef struct{ /* prs_sct */
   int    vlistID1, vlistID2;
   int    nvars1, nvars2;
@@ -80,6 +82,7 @@ typedef struct{ /* prs_sct */
   int    tsteptype2;
   double missval2;
   double **vardata1, **vardata2;
+  exprplan_t *plan;           /* compiled statements */
 } parse_parm_t;
 
 
@@ -103,3 +106,7 @@ void yyerror(void *parse_arg, void *scanner, char *errstr);
 int  yylex_init(void **);
 int  yylex_destroy(void *);
 void yyset_extra(YY_EXTRA_TYPE, void *);
+
+void expr_plan_add(parse_parm_t *parse_arg, nodeType *p, int varID);
+void expr_plan_run(parse_parm_t *parse_arg);
+void expr_plan_delete(exprplan_t *plan);
@@ -0,0 +1,421 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+/*
+  Complex FFT of arbitrary length for a batch of vectors (not normalized)
+
+    X[k] = sum_j x[j] * exp(sign*2*pi*i*j*k/n)
+
+  The vectors of a batch are interleaved, element j of vector b is
+  re[j*lot+b], so the inner loops run over contiguous blocks of lot or more
+  values. Lengths with prime factors up to FFT_MAX_RADIX are transformed by a
+  mixed radix Stockham FFT (radix 4, 2, 3 and a generic odd radix), other
+  lengths by Bluestein's algorithm as a cyclic convolution of length
+  2^a*3^b*5^c >= 2n-1.
+*/
+
+#if defined(HAVE_CONFIG_H)
+#  include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "fftplan.h"
+
+
+#define  FFT_MAX_RADIX    16
+#define  FFT_MAX_FACTORS  64
+
+struct fftplan {
+  long       n;
+  int        nfact;
+  long       fact[FFT_MAX_FACTORS];
+  double    *wr, *wi;     /* exp(2*pi*i*t/n), t < n */
+  /* Bluestein */
+  long       m;           /* convolution length, 0 for mixed radix */
+  double    *cr, *ci;     /* chirp exp(pi*i*t*t/n), t < n */
+  double    *kr, *ki;     /* FFT of the conjugate chirp, scaled by 1/m */
+  fftplan_t *sub;         /* plan of length m */
+};
+
+
+static
+long fft_factorize(long n, long *fact, int *nfact)
+{
+  long pmax = 1;
+
+  *nfact = 0;
+  while ( n%4 == 0 ) { fact[(*nfact)++] = 4; n /= 4; pmax = 4; }
+  while ( n%2 == 0 ) { fact[(*nfact)++] = 2; n /= 2; if ( pmax < 2 ) pmax = 2; }
+
+  for ( long p = 3; p*p <= n; p += 2 )
+    while ( n%p == 0 ) { fact[(*nfact)++] = p; n /= p; pmax = p; }
+
+  if ( n > 1 ) { fact[(*nfact)++] = n; if ( pmax < n ) pmax = n; }
+
+  return (pmax);
+}
+
+/* smallest 2^a*3^b*5^c >= n */
+static
+long fft_goodsize(long n)
+{
+  long best = 1;
+
+  while ( best < n ) best *= 2;
+
+  for ( long p3 = 1; p3 < best; p3 *= 3 )
+    for ( long p5 = p3; p5 < best; p5 *= 5 )
+      {
+        long len = p5;
+        while ( len < n ) len *= 2;
+        if ( len < best ) best = len;
+      }
+
+  return (best);
+}
+
+
+fftplan_t *fftplan_new(long n)
+{
+  fftplan_t *plan = (fftplan_t*) malloc(sizeof(fftplan_t));
+
+  plan->n   = n;
+  plan->m   = 0;
+  plan->wr  = plan->wi = NULL;
+  plan->cr  = plan->ci = NULL;
+  plan->kr  = plan->ki = NULL;
+  plan->sub = NULL;
+
+  long pmax = fft_factorize(n, plan->fact, &plan->nfact);
+
+  if ( pmax <= FFT_MAX_RADIX )
+    {
+      plan->wr = (double*) malloc(n*sizeof(double));
+      plan->wi = (double*) malloc(n*sizeof(double));
+      for ( long t = 0; t < n; ++t )
+        {
+          plan->wr[t] = cos(2*M_PI*t/n);
+          plan->wi[t] = sin(2*M_PI*t/n);
+        }
+    }
+  else
+    {
+      long m = fft_goodsize(2*n-1);
+
+      plan->m   = m;
+      plan->sub = fftplan_new(m);
+      plan->cr  = (double*) malloc(n*sizeof(double));
+      plan->ci  = (double*) malloc(n*sizeof(double));
+      plan->kr  = (double*) calloc(m, sizeof(double));
+      plan->ki  = (double*) calloc(m, sizeof(double));
+
+      for ( long t = 0; t < n; ++t )
+        {
+          /* t*t mod 2n keeps the argument small */
+          double arg = M_PI*((t*t)%(2*n))/n;
+          plan->cr[t] = cos(arg);
+          plan->ci[t] = sin(arg);
+        }
+
+      plan->kr[0] = plan->cr[0];
+      plan->ki[0] = -plan->ci[0];
+      for ( long t = 1; t < n; ++t )
+        {
+          plan->kr[t] = plan->kr[m-t] =  plan->cr[t];
+          plan->ki[t] = plan->ki[m-t] = -plan->ci[t];
+        }
+
+      double *work = (double*) malloc(fftplan_worksize(plan->sub, 1)*sizeof(double));
+      fftplan_exec(plan->sub, plan->kr, plan->ki, 1, -1, work);
+      free(work);
+
+      for ( long k = 0; k < m; ++k )
+        {
+          plan->kr[k] /= m;
+          plan->ki[k] /= m;
+        }
+    }
+
+  return (plan);
+}
+
+
+void fftplan_delete(fftplan_t *plan)
+{
+  if ( plan->sub ) fftplan_delete(plan->sub);
+  if ( plan->wr ) free(plan->wr);
+  if ( plan->wi ) free(plan->wi);
+  if ( plan->cr ) free(plan->cr);
+  if ( plan->ci ) free(plan->ci);
+  if ( plan->kr ) free(plan->kr);
+  if ( plan->ki ) free(plan->ki);
+  free(plan);
+}
+
+/* number of doubles needed for the work array of fftplan_exec */
+long fftplan_worksize(const fftplan_t *plan, long lot)
+{
+  if ( plan->m ) return (2*plan->m*lot + fftplan_worksize(plan->sub, lot));
+
+  return (2*plan->n*lot);
+}
+
+/*
+  One Stockham pass of radix r on the current length r*m, blk is the stride
+  times lot:
+
+    y[r*p+j] = W_rm^(j*p) * sum_k x[p+k*m] * W_r^(j*k)
+*/
+static
+void fft_pass2(long m, long blk, long tstep, int sign, const double *wr, const double *wi,
+               const double *restrict xr, const double *restrict xi, double *restrict yr, double *restrict yi)
+{
+  for ( long p = 0; p < m; ++p )
+    {
+      const double *x0r = xr + p*blk,     *x0i = xi + p*blk;
+      const double *x1r = xr + (p+m)*blk, *x1i = xi + (p+m)*blk;
+      double *y0r = yr + 2*p*blk, *y0i = yi + 2*p*blk;
+      double *y1r = y0r + blk,    *y1i = y0i + blk;
+      double w1r = wr[p*tstep], w1i = sign*wi[p*tstep];
+
+      for ( long i = 0; i < blk; ++i )
+        {
+          double dr = x0r[i] - x1r[i];
+          double di = x0i[i] - x1i[i];
+          y0r[i] = x0r[i] + x1r[i];
+          y0i[i] = x0i[i] + x1i[i];
+          y1r[i] = dr*w1r - di*w1i;
+          y1i[i] = dr*w1i + di*w1r;
+        }
+    }
+}
+
+static
+void fft_pass3(long m, long blk, long tstep, int sign, const double *wr, const double *wi,
+               const double *restrict xr, const double *restrict xi, double *restrict yr, double *restrict yi)
+{
+  double c3 = sign*0.5*sqrt(3.);
+
+  for ( long p = 0; p < m; ++p )
+    {
+      const double *x0r = xr + p*blk,       *x0i = xi + p*blk;
+      const double *x1r = xr + (p+m)*blk,   *x1i = xi + (p+m)*blk;
+      const double *x2r = xr + (p+2*m)*blk, *x2i = xi + (p+2*m)*blk;
+      double *y0r = yr + 3*p*blk, *y0i = yi + 3*p*blk;
+      double *y1r = y0r + blk,    *y1i = y0i + blk;
+      double *y2r = y1r + blk,    *y2i = y1i + blk;
+      double w1r = wr[p*tstep],   w1i = sign*wi[p*tstep];
+      double w2r = wr[2*p*tstep], w2i = sign*wi[2*p*tstep];
+
+      for ( long i = 0; i < blk; ++i )
+        {
+          double t1r = x1r[i] + x2r[i], t1i = x1i[i] + x2i[i];
+          double t2r = x0r[i] - 0.5*t1r, t2i = x0i[i] - 0.5*t1i;
+          double t3r = c3*(x1r[i] - x2r[i]), t3i = c3*(x1i[i] - x2i[i]);
+          double ar = t2r - t3i, ai = t2i + t3r;
+          double br = t2r + t3i, bi = t2i - t3r;
+          y0r[i] = x0r[i] + t1r;
+          y0i[i] = x0i[i] + t1i;
+          y1r[i] = ar*w1r - ai*w1i;
+          y1i[i] = ar*w1i + ai*w1r;
+          y2r[i] = br*w2r - bi*w2i;
+          y2i[i] = br*w2i + bi*w2r;
+        }
+    }
+}
+
+static
+void fft_pass4(long m, long blk, long tstep, int sign, const double *wr, const double *wi,
+               const double *restrict xr, const double *restrict xi, double *restrict yr, double *restrict yi)
+{
+  for ( long p = 0; p < m; ++p )
+    {
+      const double *x0r = xr + p*blk,       *x0i = xi + p*blk;
+      const double *x1r = xr + (p+m)*blk,   *x1i = xi + (p+m)*blk;
+      const double *x2r = xr + (p+2*m)*blk, *x2i = xi + (p+2*m)*blk;
+      const double *x3r = xr + (p+3*m)*blk, *x3i = xi + (p+3*m)*blk;
+      double *y0r = yr + 4*p*blk, *y0i = yi + 4*p*blk;
+      double *y1r = y0r + blk,    *y1i = y0i + blk;
+      double *y2r = y1r + blk,    *y2i = y1i + blk;
+      double *y3r = y2r + blk,    *y3i = y2i + blk;
+      double w1r = wr[p*tstep],   w1i = sign*wi[p*tstep];
+      double w2r = wr[2*p*tstep], w2i = sign*wi[2*p*tstep];
+      double w3r = wr[3*p*tstep], w3i = sign*wi[3*p*tstep];
+
+      for ( long i = 0; i < blk; ++i )
+        {
+          double t0r = x0r[i] + x2r[i], t0i = x0i[i] + x2i[i];
+          double t1r = x0r[i] - x2r[i], t1i = x0i[i] - x2i[i];
+          double t2r = x1r[i] + x3r[i], t2i = x1i[i] + x3i[i];
+          /* (x1 - x3) * W_4 with W_4 = sign*i */
+          double t3r = -sign*(x1i[i] - x3i[i]), t3i = sign*(x1r[i] - x3r[i]);
+          double ar = t1r + t3r, ai = t1i + t3i;
+          double br = t0r - t2r, bi = t0i - t2i;
+          double cr = t1r - t3r, ci = t1i - t3i;
+          y0r[i] = t0r + t2r;
+          y0i[i] = t0i + t2i;
+          y1r[i] = ar*w1r - ai*w1i;
+          y1i[i] = ar*w1i + ai*w1r;
+          y2r[i] = br*w2r - bi*w2i;
+          y2i[i] = br*w2i + bi*w2r;
+          y3r[i] = cr*w3r - ci*w3i;
+          y3i[i] = cr*w3i + ci*w3r;
+        }
+    }
+}
+
+static
+void fft_passg(long r, long m, long blk, long tstep, int sign, const double *wr, const double *wi,
+               const double *restrict xr, const double *restrict xi, double *restrict yr, double *restrict yi)
+{
+  for ( long p = 0; p < m; ++p )
+    for ( long j = 0; j < r; ++j )
+      {
+        double *yjr = yr + (r*p+j)*blk, *yji = yi + (r*p+j)*blk;
+
+        memcpy(yjr, xr + p*blk, blk*sizeof(double));
+        memcpy(yji, xi + p*blk, blk*sizeof(double));
+
+        for ( long k = 1; k < r; ++k )
+          {
+            const double *xkr = xr + (p+k*m)*blk, *xki = xi + (p+k*m)*blk;
+            long idx = ((j*k)%r)*m*tstep;
+            double cr = wr[idx], ci = sign*wi[idx];
+
+            for ( long i = 0; i < blk; ++i )
+              {
+                yjr[i] += xkr[i]*cr - xki[i]*ci;
+                yji[i] += xkr[i]*ci + xki[i]*cr;
+              }
+          }
+
+        if ( j > 0 && p > 0 )
+          {
+            double w1r = wr[j*p*tstep], w1i = sign*wi[j*p*tstep];
+
+            for ( long i = 0; i < blk; ++i )
+              {
+                double ar = yjr[i], ai = yji[i];
+                yjr[i] = ar*w1r - ai*w1i;
+                yji[i] = ar*w1i + ai*w1r;
+              }
+          }
+      }
+}
+
+static
+void fft_mixed(const fftplan_t *plan, double *re, double *im, long lot, int sign, double *work)
+{
+  long n = plan->n;
+  double *xr = re, *xi = im;
+  double *yr = work, *yi = work + n*lot;
+  long ncur = n, blk = lot;
+
+  for ( int f = 0; f < plan->nfact; ++f )
+    {
+      long r = plan->fact[f];
+      long m = ncur/r;
+      long tstep = n/ncur;
+
+      switch ( r )
+        {
+        case 2:  fft_pass2(m, blk, tstep, sign, plan->wr, plan->wi, xr, xi, yr, yi); break;
+        case 3:  fft_pass3(m, blk, tstep, sign, plan->wr, plan->wi, xr, xi, yr, yi); break;
+        case 4:  fft_pass4(m, blk, tstep, sign, plan->wr, plan->wi, xr, xi, yr, yi); break;
+        default: fft_passg(r, m, blk, tstep, sign, plan->wr, plan->wi, xr, xi, yr, yi); break;
+        }
+
+      double *tr = xr, *ti = xi;
+      xr = yr; xi = yi;
+      yr = tr; yi = ti;
+      ncur = m;
+      blk *= r;
+    }
+
+  if ( xr != re )
+    {
+      memcpy(re, xr, n*lot*sizeof(double));
+      memcpy(im, xi, n*lot*sizeof(double));
+    }
+}
+
+static
+void fft_bluestein(const fftplan_t *plan, double *re, double *im, long lot, int sign, double *work)
+{
+  long n = plan->n, m = plan->m;
+  double *ar = work, *ai = work + m*lot;
+
+  for ( long t = 0; t < n; ++t )
+    {
+      double cr = plan->cr[t], ci = sign*plan->ci[t];
+      const double *xr = re + t*lot, *xi = im + t*lot;
+      double *yr = ar + t*lot, *yi = ai + t*lot;
+
+      for ( long b = 0; b < lot; ++b )
+        {
+          yr[b] = xr[b]*cr - xi[b]*ci;
+          yi[b] = xr[b]*ci + xi[b]*cr;
+        }
+    }
+
+  memset(ar + n*lot, 0, (m-n)*lot*sizeof(double));
+  memset(ai + n*lot, 0, (m-n)*lot*sizeof(double));
+
+  fftplan_exec(plan->sub, ar, ai, lot, -sign, work + 2*m*lot);
+
+  for ( long k = 0; k < m; ++k )
+    {
+      double kr = plan->kr[k], ki = sign*plan->ki[k];
+      double *yr = ar + k*lot, *yi = ai + k*lot;
+
+      for ( long b = 0; b < lot; ++b )
+        {
+          double tr = yr[b];
+          yr[b] = tr*kr - yi[b]*ki;
+          yi[b] = tr*ki + yi[b]*kr;
+        }
+    }
+
+  fftplan_exec(plan->sub, ar, ai, lot, sign, work + 2*m*lot);
+
+  for ( long k = 0; k < n; ++k )
+    {
+      double cr = plan->cr[k], ci = sign*plan->ci[k];
+      const double *yr = ar + k*lot, *yi = ai + k*lot;
+      double *xr = re + k*lot, *xi = im + k*lot;
+
+      for ( long b = 0; b < lot; ++b )
+        {
+          xr[b] = yr[b]*cr - yi[b]*ci;
+          xi[b] = yr[b]*ci + yi[b]*cr;
+        }
+    }
+}
+
+/*
+  Transform lot interleaved vectors in place, work needs
+  fftplan_worksize(plan, lot) doubles.
+*/
+void fftplan_exec(const fftplan_t *plan, double *re, double *im, long lot, int sign, double *work)
+{
+  if ( plan->m )
+    fft_bluestein(plan, re, im, lot, sign, work);
+  else
+    fft_mixed(plan, re, im, lot, sign, work);
+}
@@ -0,0 +1,30 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+#ifndef _FFTPLAN_H
+#define _FFTPLAN_H
+
+/* complex FFT of arbitrary length for a batch of vectors */
+typedef struct fftplan fftplan_t;
+
+fftplan_t *fftplan_new(long n);
+void       fftplan_delete(fftplan_t *plan);
+
+long fftplan_worksize(const fftplan_t *plan, long lot);
+void fftplan_exec(const fftplan_t *plan, double *re, double *im, long lot, int sign, double *work);
+
+#endif  /* _FFTPLAN_H */
@@ -139,6 +139,24 @@ void farmod(field_t *field, const double divisor);
 
 void farinv(field_t *field);
 
+/* field_kernels.c */
+
+size_t arrnmiss(size_t len, const double *restrict array, double missval);
+size_t arraddmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrsubmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrmulmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrdivmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrsummv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrsumqmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrcountmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrminmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrmaxmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrmoqmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2);
+size_t arrcaddmv(size_t len, double *restrict a, double rconst, double missval);
+size_t arrcmulmv(size_t len, double *restrict a, double rconst, double missval);
+size_t arrcdivmv(size_t len, double *restrict a, double rconst, double missval);
+size_t arrinvmv(size_t len, double *restrict a, double missval);
+
 /* field2.c */
 
 void farfun(field_t *field1, field_t field2, const int function);
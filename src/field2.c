@@ -71,7 +71,7 @@ void arradd(const size_t n, double * restrict a, const double * restrict b)
 
 void faradd(field_t *field1, field_t field2)
 {
-  size_t   i, len;
+  size_t   len;
   int          nwpv     = field1->nwpv;
   const int    grid1    = field1->grid;
   const int    nmiss1   = field1->nmiss;
@@ -92,12 +92,7 @@ void faradd(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ ) 
-	array1[i] = ADD(array1[i], array2[i]);
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arraddmv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -108,7 +103,7 @@ void faradd(field_t *field1, field_t field2)
 
 void farsum(field_t *field1, field_t field2)
 {
-  size_t   i, len;
+  size_t   len;
   int          nwpv     = field1->nwpv;
   const int    grid1    = field1->grid;
   const int    nmiss1   = field1->nmiss;
@@ -129,18 +124,7 @@ void farsum(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ )
-	if ( !DBL_IS_EQUAL(array2[i], missval2) )
-	  {
-	    if ( !DBL_IS_EQUAL(array1[i], missval1) )
-	      array1[i] += array2[i];
-	    else
-	      array1[i] = array2[i];
-	  }
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrsummv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -226,18 +210,7 @@ void farsumq(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ )
-	if ( !DBL_IS_EQUAL(array2[i], missval2) )
-	  {
-	    if ( !DBL_IS_EQUAL(array1[i], missval1) )
-	      array1[i] += array2[i]*array2[i];
-	    else
-	      array1[i] = array2[i]*array2[i];
-	  }
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrsumqmv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -269,12 +242,7 @@ void farsub(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ ) 
-	array1[i] = SUB(array1[i], array2[i]);
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrsubmv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -306,12 +274,7 @@ void farmul(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ ) 
-	array1[i] = MUL(array1[i], array2[i]);
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrmulmv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -323,7 +286,7 @@ void farmul(field_t *field1, field_t field2)
 
 void fardiv(field_t *field1, field_t field2)
 {
-  size_t   i, len;
+  size_t   len;
   int          nwpv     = field1->nwpv;
   const int    grid1    = field1->grid;
   const double missval1 = field1->missval;
@@ -339,12 +302,7 @@ void fardiv(field_t *field1, field_t field2)
   if ( len != (size_t) (nwpv*gridInqSize(grid2)) )
     cdoAbort("Fields have different gridsize (%s)", __func__);
 
-  for ( i = 0; i < len; i++ ) 
-    array1[i] = DIV(array1[i], array2[i]);
-
-  field1->nmiss = 0;
-  for ( i = 0; i < len; i++ )
-    if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+  field1->nmiss = (int) arrdivmv(len, array1, array2, missval1, missval2);
 }
 
 
@@ -397,16 +355,7 @@ void farmin(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ )
-	{
-	  array1[i] = DBL_IS_EQUAL(array2[i], missval2) ? array1[i] :
-	              DBL_IS_EQUAL(array1[i], missval1) ? array2[i] :
-		      MIN(array1[i], array2[i]);
-	}
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrminmv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -438,16 +387,7 @@ void farmax(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ )
-	{
-	  array1[i] = DBL_IS_EQUAL(array2[i], missval2) ? array1[i] :
-	              DBL_IS_EQUAL(array1[i], missval1) ? array2[i] :
-		      MAX(array1[i], array2[i]);
-	}
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrmaxmv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -789,15 +729,7 @@ void farmoq(field_t *field1, field_t field2)
 
   if ( nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ )
-	if ( !DBL_IS_EQUAL(array2[i], missval2) )
-	  array1[i] = array2[i]*array2[i];
-	else
-	  array1[i] = missval1;
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrmoqmv(len, array1, array2, missval1, missval2);
     }
   else
     {
@@ -844,18 +776,7 @@ void farcount(field_t *field1, field_t field2)
 
   if ( nmiss1 > 0 || nmiss2 > 0 )
     {
-      for ( i = 0; i < len; i++ )
-	if ( !DBL_IS_EQUAL(array2[i], missval2) )
-	  {
-	    if ( !DBL_IS_EQUAL(array1[i], missval1) )
-	      array1[i] += 1.0;
-	    else
-	      array1[i] = 1.0;
-	  }
-
-      field1->nmiss = 0;
-      for ( i = 0; i < len; i++ )
-	if ( DBL_IS_EQUAL(array1[i], missval1) ) field1->nmiss++;
+      field1->nmiss = (int) arrcountmv(len, array1, array2, missval1, missval2);
     }
   else
     {
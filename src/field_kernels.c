@@ -0,0 +1,647 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+/*
+  Array kernels with missing values
+
+  The results are the same as with the FADD, FSUB, FMUL, FDIV macros of field.h.
+  The test of the missing value is done without branches: DBL_IS_EQUAL(x, missval)
+  is (x == missval) if missval is a number and (x != x) if missval is NaN, the NaN
+  case is decided once per array. All candidates are computed and the result is
+  selected with a mask. The main loops use SSE2 or AVX (if enabled at compile time),
+  the remainder is done by the same formulas in scalar code. The kernels return the
+  number of missing values of the result.
+*/
+
+#include "cdo_int.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+
+typedef __m256d vdouble;
+
+#define  VLEN          4
+#define  vload(p)      _mm256_loadu_pd(p)
+#define  vstore(p,x)   _mm256_storeu_pd(p,x)
+#define  vset1(x)      _mm256_set1_pd(x)
+#define  vmask(flag)   _mm256_castsi256_pd(_mm256_set1_epi64x(-(long long)(flag)))
+#define  vadd(x,y)     _mm256_add_pd(x,y)
+#define  vsub(x,y)     _mm256_sub_pd(x,y)
+#define  vmul(x,y)     _mm256_mul_pd(x,y)
+#define  vdiv(x,y)     _mm256_div_pd(x,y)
+#define  vand(x,y)     _mm256_and_pd(x,y)
+#define  vor(x,y)      _mm256_or_pd(x,y)
+#define  veq(x,y)      _mm256_cmp_pd(x,y,_CMP_EQ_OQ)
+#define  vequ(x,y)     _mm256_cmp_pd(x,y,_CMP_EQ_UQ)            /* IS_EQUAL(x,y) */
+#define  vlt(x,y)      _mm256_cmp_pd(x,y,_CMP_LT_OQ)
+#define  visnan(x)     _mm256_cmp_pd(x,x,_CMP_UNORD_Q)
+#define  vsel(m,x,y)   _mm256_blendv_pd(y,x,m)            /* m ? x : y */
+#define  vcount(m)     bitcount[_mm256_movemask_pd(m)]
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128d vdouble;
+
+#define  VLEN          2
+#define  vload(p)      _mm_loadu_pd(p)
+#define  vstore(p,x)   _mm_storeu_pd(p,x)
+#define  vset1(x)      _mm_set1_pd(x)
+#define  vmask(flag)   _mm_castsi128_pd(_mm_set1_epi32(-(int)(flag)))
+#define  vadd(x,y)     _mm_add_pd(x,y)
+#define  vsub(x,y)     _mm_sub_pd(x,y)
+#define  vmul(x,y)     _mm_mul_pd(x,y)
+#define  vdiv(x,y)     _mm_div_pd(x,y)
+#define  vand(x,y)     _mm_and_pd(x,y)
+#define  vor(x,y)      _mm_or_pd(x,y)
+#define  veq(x,y)      _mm_cmpeq_pd(x,y)
+#define  vequ(x,y)     _mm_or_pd(_mm_cmpeq_pd(x,y), _mm_cmpunord_pd(x,y))
+#define  vlt(x,y)      _mm_cmplt_pd(x,y)
+#define  visnan(x)     _mm_cmpunord_pd(x,x)
+#define  vsel(m,x,y)   _mm_or_pd(_mm_and_pd(m,x), _mm_andnot_pd(m,y))
+#define  vcount(m)     bitcount[_mm_movemask_pd(m)]
+#endif
+
+#if defined(VLEN)
+static const int bitcount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+#define  VMISS(x, vmv, vmvnan)  vor(veq(x, vmv), vand(visnan(x), vmvnan))
+#endif
+
+#define  IS_MISS(x, mv, mvnan)  (((x) == (mv)) | ((mvnan) & ((x) != (x))))
+
+
+size_t arrnmiss(size_t len, const double *restrict array, double missval)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan = DBL_IS_NAN(missval);
+
+#if defined(VLEN)
+  const vdouble vmv = vset1(missval), vmvnan = vmask(mvnan);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    nmiss += vcount(VMISS(vload(array+i), vmv, vmvnan));
+#endif
+
+  for ( ; i < len; i++ )
+    nmiss += IS_MISS(array[i], missval, mvnan);
+
+  return (nmiss);
+}
+
+/* a = FADD(a, b) */
+size_t arraddmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble r = vsel(vor(VMISS(x, vmv1, vmvnan1), VMISS(y, vmv2, vmvnan2)), vmv1, vadd(x, y));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = (IS_MISS(a[i], missval1, mvnan1) | IS_MISS(b[i], missval2, mvnan2)) ? missval1 : a[i] + b[i];
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = FSUB(a, b) */
+size_t arrsubmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble r = vsel(vor(VMISS(x, vmv1, vmvnan1), VMISS(y, vmv2, vmvnan2)), vmv1, vsub(x, y));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = (IS_MISS(a[i], missval1, mvnan1) | IS_MISS(b[i], missval2, mvnan2)) ? missval1 : a[i] - b[i];
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = FMUL(a, b), zero times missing value is zero, like FMUL a NaN b counts as zero */
+size_t arrmulmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+  const vdouble vzero = vset1(0.);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble zero = vor(veq(x, vzero), vequ(y, vzero));
+      const vdouble r = vsel(zero, vzero, vsel(vor(VMISS(x, vmv1, vmvnan1), VMISS(y, vmv2, vmvnan2)), vmv1, vmul(x, y)));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const int zero = (a[i] == 0.) | IS_EQUAL(b[i], 0.);
+      const double r = zero ? 0. : (IS_MISS(a[i], missval1, mvnan1) | IS_MISS(b[i], missval2, mvnan2)) ? missval1 : a[i] * b[i];
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = FDIV(a, b) */
+size_t arrdivmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+  const vdouble vzero = vset1(0.);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble r = vsel(vor(vor(VMISS(x, vmv1, vmvnan1), VMISS(y, vmv2, vmvnan2)), veq(y, vzero)), vmv1, vdiv(x, y));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = (IS_MISS(a[i], missval1, mvnan1) | IS_MISS(b[i], missval2, mvnan2) | (b[i] == 0.)) ? missval1 : a[i] / b[i];
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* sum of the valid values, missing only if both are missing */
+size_t arrsummv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble r = vsel(VMISS(y, vmv2, vmvnan2), x, vsel(VMISS(x, vmv1, vmvnan1), y, vadd(x, y)));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = IS_MISS(b[i], missval2, mvnan2) ? a[i] : IS_MISS(a[i], missval1, mvnan1) ? b[i] : a[i] + b[i];
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* sum of the squares of the valid values of b */
+size_t arrsumqmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble y2 = vmul(y, y);
+      const vdouble r = vsel(VMISS(y, vmv2, vmvnan2), x, vsel(VMISS(x, vmv1, vmvnan1), y2, vadd(x, y2)));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = IS_MISS(b[i], missval2, mvnan2) ? a[i] : IS_MISS(a[i], missval1, mvnan1) ? b[i]*b[i] : a[i] + b[i]*b[i];
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* number of the valid values of b */
+size_t arrcountmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+  const vdouble vone = vset1(1.);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble r = vsel(VMISS(y, vmv2, vmvnan2), x, vsel(VMISS(x, vmv1, vmvnan1), vone, vadd(x, vone)));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = IS_MISS(b[i], missval2, mvnan2) ? a[i] : IS_MISS(a[i], missval1, mvnan1) ? 1. : a[i] + 1.;
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* minimum of the valid values */
+size_t arrminmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble r = vsel(VMISS(y, vmv2, vmvnan2), x, vsel(VMISS(x, vmv1, vmvnan1), y, vsel(vlt(x, y), x, y)));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = IS_MISS(b[i], missval2, mvnan2) ? a[i] : IS_MISS(a[i], missval1, mvnan1) ? b[i] : MIN(a[i], b[i]);
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* maximum of the valid values */
+size_t arrmaxmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i), y = vload(b+i);
+      const vdouble r = vsel(VMISS(y, vmv2, vmvnan2), x, vsel(VMISS(x, vmv1, vmvnan1), y, vsel(vlt(y, x), x, y)));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = IS_MISS(b[i], missval2, mvnan2) ? a[i] : IS_MISS(a[i], missval1, mvnan1) ? b[i] : MAX(a[i], b[i]);
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = b*b */
+size_t arrmoqmv(size_t len, double *restrict a, const double *restrict b, double missval1, double missval2)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan1 = DBL_IS_NAN(missval1);
+  const int mvnan2 = DBL_IS_NAN(missval2);
+
+#if defined(VLEN)
+  const vdouble vmv1 = vset1(missval1), vmvnan1 = vmask(mvnan1);
+  const vdouble vmv2 = vset1(missval2), vmvnan2 = vmask(mvnan2);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble y = vload(b+i);
+      const vdouble r = vsel(VMISS(y, vmv2, vmvnan2), vmv1, vmul(y, y));
+      nmiss += vcount(VMISS(r, vmv1, vmvnan1));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = IS_MISS(b[i], missval2, mvnan2) ? missval1 : b[i]*b[i];
+      nmiss += IS_MISS(r, missval1, mvnan1);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = FADD(a, rconst), missval is the missing value of a and rconst */
+size_t arrcaddmv(size_t len, double *restrict a, double rconst, double missval)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan = DBL_IS_NAN(missval);
+  const int cmiss = IS_MISS(rconst, missval, mvnan);
+#if defined(VLEN)
+  const vdouble vmv = vset1(missval), vmvnan = vmask(mvnan);
+  const vdouble vc = vset1(rconst), vcmiss = vmask(cmiss);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i);
+      const vdouble r = vsel(vor(VMISS(x, vmv, vmvnan), vcmiss), vmv, vadd(x, vc));
+      nmiss += vcount(VMISS(r, vmv, vmvnan));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = (IS_MISS(a[i], missval, mvnan) | cmiss) ? missval : a[i] + rconst;
+      nmiss += IS_MISS(r, missval, mvnan);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = FMUL(a, rconst) */
+size_t arrcmulmv(size_t len, double *restrict a, double rconst, double missval)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan = DBL_IS_NAN(missval);
+  const int cmiss = IS_MISS(rconst, missval, mvnan);
+  const int czero = IS_EQUAL(rconst, 0.);
+#if defined(VLEN)
+  const vdouble vmv = vset1(missval), vmvnan = vmask(mvnan);
+  const vdouble vc = vset1(rconst), vcmiss = vmask(cmiss), vczero = vmask(czero);
+  const vdouble vzero = vset1(0.);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i);
+      const vdouble r = vsel(vor(veq(x, vzero), vczero), vzero, vsel(vor(VMISS(x, vmv, vmvnan), vcmiss), vmv, vmul(x, vc)));
+      nmiss += vcount(VMISS(r, vmv, vmvnan));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = ((a[i] == 0.) | czero) ? 0. : (IS_MISS(a[i], missval, mvnan) | cmiss) ? missval : a[i] * rconst;
+      nmiss += IS_MISS(r, missval, mvnan);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = FDIV(a, rconst) */
+size_t arrcdivmv(size_t len, double *restrict a, double rconst, double missval)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan = DBL_IS_NAN(missval);
+  const int cmiss = IS_MISS(rconst, missval, mvnan) | (rconst == 0.);
+#if defined(VLEN)
+  const vdouble vmv = vset1(missval), vmvnan = vmask(mvnan);
+  const vdouble vc = vset1(rconst), vcmiss = vmask(cmiss);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i);
+      const vdouble r = vsel(vor(VMISS(x, vmv, vmvnan), vcmiss), vmv, vdiv(x, vc));
+      nmiss += vcount(VMISS(r, vmv, vmvnan));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = (IS_MISS(a[i], missval, mvnan) | cmiss) ? missval : a[i] / rconst;
+      nmiss += IS_MISS(r, missval, mvnan);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+/* a = FDIV(1, a) */
+size_t arrinvmv(size_t len, double *restrict a, double missval)
+{
+  size_t i = 0, nmiss = 0;
+  const int mvnan = DBL_IS_NAN(missval);
+  const int cmiss = IS_MISS(1., missval, mvnan);
+#if defined(VLEN)
+  const vdouble vmv = vset1(missval), vmvnan = vmask(mvnan);
+  const vdouble vone = vset1(1.), vcmiss = vmask(cmiss);
+  const vdouble vzero = vset1(0.);
+
+  for ( ; i + VLEN <= len; i += VLEN )
+    {
+      const vdouble x = vload(a+i);
+      const vdouble r = vsel(vor(vor(VMISS(x, vmv, vmvnan), vcmiss), veq(x, vzero)), vmv, vdiv(vone, x));
+      nmiss += vcount(VMISS(r, vmv, vmvnan));
+      vstore(a+i, r);
+    }
+#endif
+
+  for ( ; i < len; i++ )
+    {
+      const double r = (IS_MISS(a[i], missval, mvnan) | cmiss | (a[i] == 0.)) ? missval : 1. / a[i];
+      nmiss += IS_MISS(r, missval, mvnan);
+      a[i] = r;
+    }
+
+  return (nmiss);
+}
+
+
+#if defined(TEST_FIELD_KERNELS)
+/*
+  Benchmark and check against the macros of field.h:
+
+  gcc -O2 -DHAVE_CONFIG_H -DTEST_FIELD_KERNELS -I. -I../libcdi/src field_kernels.c -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#undef  malloc
+#undef  free
+
+static
+double kernel_dtime(void)
+{
+  struct timeval mytime;
+  gettimeofday(&mytime, NULL);
+  return ((double) mytime.tv_sec + (double) mytime.tv_usec*1.0e-6);
+}
+
+/* the old formulation with the out of line functions */
+static __attribute__ ((noinline))
+double ref_add(double x, double y, double missval1, double missval2) { return (FADD(x, y)); }
+static __attribute__ ((noinline))
+double ref_mul(double x, double y, double missval1, double missval2) { return (FMUL(x, y)); }
+static __attribute__ ((noinline))
+double ref_div(double x, double y, double missval1, double missval2) { return (FDIV(x, y)); }
+
+static
+size_t ref_nmiss(size_t len, const double *array, double missval1)
+{
+  size_t i, nmiss = 0;
+  for ( i = 0; i < len; i++ )
+    if ( DBL_IS_EQUAL(array[i], missval1) ) nmiss++;
+  return (nmiss);
+}
+
+#define  NRUN  200
+
+int main(void)
+{
+  size_t len = 100000, i, n0 = 0, n1 = 0;
+  int irun, itest, imv;
+  double missvals[2] = {-9.e33, NAN};
+  double missval1, missval2, t0, tref, tnew;
+  double *a  = (double*) malloc(len*sizeof(double));
+  double *b  = (double*) malloc(len*sizeof(double));
+  double *r0 = (double*) malloc(len*sizeof(double));
+  double *r1 = (double*) malloc(len*sizeof(double));
+  const char *names[] = {"add", "sum", "mul", "div", "min"};
+
+  printf("test  missval      ref ns/elem  new ns/elem\n");
+
+  for ( imv = 0; imv < 2; ++imv )
+    for ( itest = 0; itest < 5; ++itest )
+      {
+	missval1 = missval2 = missvals[imv];
+	srand(42);
+	for ( i = 0; i < len; i++ )
+	  {
+	    a[i] = rand()%10 == 0 ? missval1 : (double) (rand()%100 - 10);
+	    b[i] = rand()%10 == 0 ? missval2 : (double) (rand()%100 - 10);
+	  }
+
+	t0 = kernel_dtime();
+	for ( irun = 0; irun < NRUN; ++irun )
+	  {
+	    memcpy(r0, a, len*sizeof(double));
+	    if ( itest == 0 )
+	      for ( i = 0; i < len; i++ ) r0[i] = ref_add(r0[i], b[i], missval1, missval2);
+	    else if ( itest == 1 )
+	      for ( i = 0; i < len; i++ )
+		{
+		  if ( !DBL_IS_EQUAL(b[i], missval2) )
+		    r0[i] = DBL_IS_EQUAL(r0[i], missval1) ? b[i] : r0[i] + b[i];
+		}
+	    else if ( itest == 2 )
+	      for ( i = 0; i < len; i++ ) r0[i] = ref_mul(r0[i], b[i], missval1, missval2);
+	    else if ( itest == 3 )
+	      for ( i = 0; i < len; i++ ) r0[i] = ref_div(r0[i], b[i], missval1, missval2);
+	    else
+	      for ( i = 0; i < len; i++ )
+		r0[i] = DBL_IS_EQUAL(b[i], missval2) ? r0[i] : DBL_IS_EQUAL(r0[i], missval1) ? b[i] : MIN(r0[i], b[i]);
+	    n0 = ref_nmiss(len, r0, missval1);
+	  }
+	tref = kernel_dtime() - t0;
+
+	t0 = kernel_dtime();
+	for ( irun = 0; irun < NRUN; ++irun )
+	  {
+	    memcpy(r1, a, len*sizeof(double));
+	    if      ( itest == 0 ) n1 = arraddmv(len, r1, b, missval1, missval2);
+	    else if ( itest == 1 ) n1 = arrsummv(len, r1, b, missval1, missval2);
+	    else if ( itest == 2 ) n1 = arrmulmv(len, r1, b, missval1, missval2);
+	    else if ( itest == 3 ) n1 = arrdivmv(len, r1, b, missval1, missval2);
+	    else                   n1 = arrminmv(len, r1, b, missval1, missval2);
+	  }
+	tnew = kernel_dtime() - t0;
+
+	printf("%4s  %-8g %12.3f %12.3f", names[itest], missval1, 1.e9*tref/(NRUN*len), 1.e9*tnew/(NRUN*len));
+	if ( n0 != n1 ) printf("  nmiss differs!");
+	for ( i = 0; i < len; i++ )
+	  if ( !DBL_IS_EQUAL(r0[i], r1[i]) || (r0[i] == 0. && signbit(r0[i]) != signbit(r1[i])) ) break;
+	if ( i < len ) printf("  result differs at %zu!", i);
+	printf("\n");
+      }
+
+  free(a);
+  free(b);
+  free(r0);
+  free(r1);
+
+  return (0);
+}
+#endif
@@ -37,7 +37,6 @@ void farcmul(field_t *field, double rconst)
   int    grid     = field->grid;
   int    nmiss    = field->nmiss;
   double missval1 = field->missval;
-  double missval2 = field->missval;
   double *array   = field->ptr;
 
   if ( nwpv != 2 ) nwpv = 1;
@@ -46,8 +45,7 @@ void farcmul(field_t *field, double rconst)
 
   if ( nmiss > 0 )
     {
-      for ( i = 0; i < len; i++ ) 
-	array[i] = MUL(array[i], rconst);
+      (void) arrcmulmv((size_t) len, array, rconst, missval1);
     }
   else
     {
@@ -68,15 +66,13 @@ void farcdiv(field_t *field, double rconst)
   int    grid     = field->grid;
   int    nmiss    = field->nmiss;
   double missval1 = field->missval;
-  double missval2 = field->missval;
   double *array   = field->ptr;
 
   len    = gridInqSize(grid);
 
   if ( nmiss > 0 || IS_EQUAL(rconst, 0) )
     {
-      for ( i = 0; i < len; i++ )
-	array[i] = DIV(array[i], rconst);
+      (void) arrcdivmv((size_t) len, array, rconst, missval1);
 
       if ( IS_EQUAL(rconst, 0) ) field->nmiss = len;
     }
@@ -94,15 +90,13 @@ void farcadd(field_t *field, double rconst)
   int    grid     = field->grid;
   int    nmiss    = field->nmiss;
   double missval1 = field->missval;
-  double missval2 = field->missval;
   double *array   = field->ptr;
 
   len    = gridInqSize(grid);
 
   if ( nmiss > 0 )
     {
-      for ( i = 0; i < len; i++ ) 
-	array[i] = ADD(array[i], rconst);
+      (void) arrcaddmv((size_t) len, array, rconst, missval1);
     }
   else
     {
@@ -120,20 +114,14 @@ void farcsub(field_t *field, double rconst)
 
 void farinv(field_t *field)
 {
-  int i, len;
+  int len;
   int    grid     = field->grid;
   double missval1 = field->missval;
-  double missval2 = field->missval;
   double *array   = field->ptr;
 
   len    = gridInqSize(grid);
 
-  for ( i = 0; i < len; i++ ) 
-    array[i] = DIV(1.0, array[i]);
-
-  field->nmiss = 0;
-  for ( i = 0; i < len; i++ )
-    if ( DBL_IS_EQUAL(array[i], missval1) ) field->nmiss++;
+  field->nmiss = (int) arrinvmv((size_t) len, array, missval1);
 }
 
 
@@ -27,10 +27,14 @@
 #include "operator_help.h"
 #include "modules.h"
 #include "error.h"
+#include "percentiles.h"
 
 
 #define  MAX_MOD_OPERATORS  128         /* maximum number of operators for a module */
 
+/* percentile operators: ifile1, min and max with histograms, only ifile1 with CDO_PCTL_METHOD=sketch */
+#define  PCTL_STREAMS  -3
+
 typedef struct {
   void  *(*func)(void *);               /* Module                   */
   char **help;                          /* Help                     */
@@ -180,6 +184,7 @@ void *Template2(void *argument);
 void *Test(void *argument);
 void *Test2(void *argument);
 void *Testdata(void *argument);
+void *Testpctlmerge(void *argument);
 void *Tests(void *argument);
 void *Timsort(void *argument);
 void *Timcount(void *argument);
@@ -426,6 +431,7 @@ void *Maggraph(void *argument);
 #define  TestOperators          {"test"}
 #define  Test2Operators         {"test2"}
 #define  TestdataOperators      {"testdata"}
+#define  TestpctlmergeOperators {"testpctlmerge"}
 #define  TestsOperators         {"normal", "studentt", "chisquare", "beta", "fisher"}
 #define  TimsortOperators       {"timsort"}
 #define  TimcountOperators      {"timcount"}
@@ -648,7 +654,7 @@ static modules_t Modules[] =
   { Runpctl,        RunpctlHelp,       RunpctlOperators,       CDI_REAL,  1,  1 },
   { Runstat,        RunstatHelp,       RunstatOperators,       CDI_REAL,  1,  1 },
   { Seascount,      NULL,              SeascountOperators,     CDI_BOTH,  1,  1 },
-  { Seaspctl,       SeaspctlHelp,      SeaspctlOperators,      CDI_REAL,  3,  1 },
+  { Seaspctl,       SeaspctlHelp,      SeaspctlOperators,      CDI_REAL, PCTL_STREAMS,  1 },
   { Seasstat,       SeasstatHelp,      SeasstatOperators,      CDI_REAL,  1,  1 },
   { Selbox,         SelboxHelp,        SelboxOperators,        CDI_BOTH,  1,  1 },
   { Select,         SelectHelp,        SelectOperators,        CDI_BOTH, -1,  1 },
@@ -688,18 +694,19 @@ static modules_t Modules[] =
   { Test,           NULL,              TestOperators,          CDI_REAL,  1,  1 },
   { Test2,          NULL,              Test2Operators,         CDI_REAL,  2,  1 },
   { Testdata,       NULL,              TestdataOperators,      CDI_REAL,  1,  1 },
+  { Testpctlmerge,  NULL,              TestpctlmergeOperators, CDI_REAL,  1,  0 },
   { Tests,          NULL,              TestsOperators,         CDI_REAL,  1,  1 },
   { Timcount,       NULL,              TimcountOperators,      CDI_BOTH,  1,  1 },
   { Timcount,       NULL,              YearcountOperators,     CDI_BOTH,  1,  1 },
   { Timcount,       NULL,              MoncountOperators,      CDI_BOTH,  1,  1 },
   { Timcount,       NULL,              DaycountOperators,      CDI_BOTH,  1,  1 },
   { Timcount,       NULL,              HourcountOperators,     CDI_BOTH,  1,  1 },
-  { Timpctl,        TimpctlHelp,       TimpctlOperators,       CDI_REAL,  3,  1 },
-  { Timpctl,        YearpctlHelp,      YearpctlOperators,      CDI_REAL,  3,  1 },
-  { Timpctl,        MonpctlHelp,       MonpctlOperators,       CDI_REAL,  3,  1 },
-  { Timpctl,        DaypctlHelp,       DaypctlOperators,       CDI_REAL,  3,  1 },
-  { Timpctl,        HourpctlHelp,      HourpctlOperators,      CDI_REAL,  3,  1 },
-  { Timselpctl,     TimselpctlHelp,    TimselpctlOperators,    CDI_REAL,  3,  1 },
+  { Timpctl,        TimpctlHelp,       TimpctlOperators,       CDI_REAL, PCTL_STREAMS,  1 },
+  { Timpctl,        YearpctlHelp,      YearpctlOperators,      CDI_REAL, PCTL_STREAMS,  1 },
+  { Timpctl,        MonpctlHelp,       MonpctlOperators,       CDI_REAL, PCTL_STREAMS,  1 },
+  { Timpctl,        DaypctlHelp,       DaypctlOperators,       CDI_REAL, PCTL_STREAMS,  1 },
+  { Timpctl,        HourpctlHelp,      HourpctlOperators,      CDI_REAL, PCTL_STREAMS,  1 },
+  { Timselpctl,     TimselpctlHelp,    TimselpctlOperators,    CDI_REAL, PCTL_STREAMS,  1 },
   { Timsort,        TimsortHelp,       TimsortOperators,       CDI_REAL,  1,  1 },
   { Timselstat,     TimselstatHelp,    TimselstatOperators,    CDI_REAL,  1,  1 },
   { Timstat,        TimstatHelp,       TimstatOperators,       CDI_BOTH,  1,  1 },
@@ -729,17 +736,17 @@ static modules_t Modules[] =
   { YAR,            NULL,              YAROperators,           CDI_REAL,  1,  1 },
   { Yearmonstat,    YearmonmeanHelp,   YearmonstatOperators,   CDI_REAL,  1,  1 },
   { Ydayarith,      YdayarithHelp,     YdayarithOperators,     CDI_REAL,  2,  1 },
-  { Ydaypctl,       YdaypctlHelp,      YdaypctlOperators,      CDI_REAL,  3,  1 },
+  { Ydaypctl,       YdaypctlHelp,      YdaypctlOperators,      CDI_REAL, PCTL_STREAMS,  1 },
   { Ydaystat,       YdaystatHelp,      YdaystatOperators,      CDI_REAL,  1,  1 },
-  { Ydrunpctl,      YdrunpctlHelp,     YdrunpctlOperators,     CDI_REAL,  3,  1 },
+  { Ydrunpctl,      YdrunpctlHelp,     YdrunpctlOperators,     CDI_REAL, PCTL_STREAMS,  1 },
   { Ydrunstat,      YdrunstatHelp,     YdrunstatOperators,     CDI_REAL,  1,  1 },
   { Yhourarith,     YhourarithHelp,    YhourarithOperators,    CDI_REAL,  2,  1 },
   { Yhourstat,      YhourstatHelp,     YhourstatOperators,     CDI_REAL,  1,  1 },
   { Ymonarith,      YmonarithHelp,     YmonarithOperators,     CDI_REAL,  2,  1 },
   { Ymonarith,      YseasarithHelp,    YseasarithOperators,    CDI_REAL,  2,  1 },
-  { Ymonpctl,       YmonpctlHelp,      YmonpctlOperators,      CDI_REAL,  3,  1 },
+  { Ymonpctl,       YmonpctlHelp,      YmonpctlOperators,      CDI_REAL, PCTL_STREAMS,  1 },
   { Ymonstat,       YmonstatHelp,      YmonstatOperators,      CDI_REAL,  1,  1 },
-  { Yseaspctl,      YseaspctlHelp,     YseaspctlOperators,     CDI_REAL,  3,  1 },
+  { Yseaspctl,      YseaspctlHelp,     YseaspctlOperators,     CDI_REAL, PCTL_STREAMS,  1 },
   { Yseasstat,      YseasstatHelp,     YseasstatOperators,     CDI_REAL,  1,  1 },
   { Zonstat,        ZonstatHelp,       ZonstatOperators,       CDI_REAL,  1,  1 },
   { EcaCfd,         EcaCfdHelp,        EcaCfdOperators,        CDI_REAL,  1,  1 },
@@ -994,6 +1001,7 @@ int operatorStreamInCnt(char *operatorName)
 {
   int modID;
   modID = operatorInqModID(operatorAlias(operatorName));
+  if ( Modules[modID].streamInCnt == PCTL_STREAMS ) return (hsetNeedsBounds() ? 3 : 1);
   return (Modules[modID].streamInCnt);
 }
 
@@ -2044,6 +2044,10 @@ static char *TimselpctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2184,6 +2188,10 @@ static char *TimpctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2267,6 +2275,10 @@ static char *HourpctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2350,6 +2362,10 @@ static char *DaypctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2433,6 +2449,10 @@ static char *MonpctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2541,6 +2561,10 @@ static char *YearpctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2618,6 +2642,10 @@ static char *SeaspctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2771,6 +2799,10 @@ static char *YdaypctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2864,6 +2896,10 @@ static char *YmonpctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -2949,6 +2985,10 @@ static char *YseaspctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -3061,6 +3101,10 @@ static char *YdrunpctlHelp[] = {
     "ENVIRONMENT",
     "    CDO_PCTL_NBINS",
     "        Sets the number of histogram bins. The default number is 101.",
+    "    CDO_PCTL_METHOD",
+    "        Sets the percentile method, hist (default) or sketch. The sketch (t-digest) needs",
+    "        no bounds and is computed in a single pass over ifile1, ifile2 and ifile3 are",
+    "        omitted in this case.",
     NULL
 };
 
@@ -3351,6 +3395,10 @@ static char *RemapgridHelp[] = {
     "        of this variable is 0.0.",
     "    CDO_REMAP_RADIUS ",
     "        Remap search radius in degree, default 180 degree.",
+    "    CDO_REMAP_CACHE  ",
+    "        Directory of a persistent remap weights cache. The weights are read from this",
+    "        directory if source and target grid, mask and method are identical, otherwise",
+    "        they are computed and stored in SCRIP format. Needs netCDF support.",
     "",
     "NOTE",
     "    For this module the author has converted the original Fortran 90 SCRIP ",
@@ -3421,6 +3469,10 @@ static char *GenweightsHelp[] = {
     "        of this variable is 0.0.",
     "    CDO_REMAP_RADIUS ",
     "        Remap search radius in degree, default 180 degree.",
+    "    CDO_REMAP_CACHE  ",
+    "        Directory of a persistent remap weights cache. The weights are read from this",
+    "        directory if source and target grid, mask and method are identical, otherwise",
+    "        they are computed and stored in SCRIP format. Needs netCDF support.",
     "",
     "NOTE",
     "    For this module the author has converted the original Fortran 90 SCRIP software to ",
@@ -4485,6 +4537,9 @@ static char *FillmissHelp[] = {
     "    fillmiss2  Fill missing values",
     "               Fill missing values by using the neares value from up/down/left/right neightbours. ",
     "",
+    "    On unstructured grids the missing cells are filled layer by layer from their",
+    "    neighbour cells (mean or first neighbour), the grid cell bounds are needed.",
+    "",
     "PARAMETER",
     "    maxiter  INTEGER  Number of iterations to perform this nearest neightbours replacement",
     NULL
@@ -8,10 +8,14 @@
 
 #include <string.h> /* memcpy */
 
+#include <cdi.h>
+
 #include "cdo.h"
 #include "cdo_int.h"
 #include "par_io.h"
 #include "pstream.h"
+#include "util.h"
+#include "thread_pool.h"
 
 
 void *readRecord(void *arg)
@@ -110,3 +114,349 @@ void parReadRecord(int streamID, int *varID, int *levelID, double *array, int *n
     }
 #endif
 }
+
+/*
+  Writer threads for operators with many output streams (CDO_WRITE_THREADS).
+
+  Each writer is a thread pool with one thread, every output stream is assigned
+  to one writer and its records are written in the order of the calls. A writer
+  has a ring of PW_QSIZE entries, the caller waits until the job of the next
+  entry is done. A timestep carries a copy of the time axis, the caller may
+  define the next timestep before the writer is done. NetCDF and GRIB2 outputs
+  are written on the calling thread, these libraries are not thread safe.
+*/
+
+#define  PW_QSIZE  16
+
+enum {PW_TIMESTEP = 1, PW_RECORD, PW_CLOSE};
+
+typedef struct {
+  int     type;
+  int     done;
+  int     streamID;
+  int     tsID, varID, levelID, nmiss;
+  int     taxisID;          /* copy of the time axis of the timestep */
+  int     taxisIDsrc;       /* source of the copy */
+  int     taxisIDw;         /* time axis of the output stream */
+  int     vlistIDw;         /* vlist of the output stream */
+  size_t  size;             /* allocated size of data */
+  double *data;
+} pw_entry_t;
+
+typedef struct {
+  threadpool_t   *pool;
+  int             next;     /* next entry of the ring */
+  pw_entry_t      queue[PW_QSIZE];
+} pw_writer_t;
+
+typedef struct {
+  int writer;               /* writer thread of the stream */
+  int taxisID;              /* time axis of the caller */
+  int taxisIDw;
+  int vlistIDw;
+} pw_stream_t;
+
+typedef struct {
+  pw_writer_t    *writer;
+  pw_entry_t     *entry;
+} pw_close_t;
+
+struct par_write_s {
+  int             nwriters;
+  int             next;     /* writer thread of the next stream */
+  pw_writer_t    *writers;
+  int             nstreams; /* size of streams, indexed by streamID */
+  pw_stream_t    *streams;
+  int             nopen, maxopen;
+  int             nclosing, first, nalloc;
+  pw_close_t     *closing;  /* ring of the submitted closes */
+};
+
+
+static
+void pw_write_job(void *arg)
+{
+  pw_entry_t *entry = (pw_entry_t *) arg;
+
+  if ( entry->type == PW_TIMESTEP )
+    {
+      if ( entry->taxisIDw != CDI_UNDEFID ) taxisCopyTimestep(entry->taxisIDw, entry->taxisID);
+      streamDefTimestep(entry->streamID, entry->tsID);
+    }
+  else if ( entry->type == PW_RECORD )
+    {
+      streamDefRecord(entry->streamID, entry->varID, entry->levelID);
+      streamWriteRecord(entry->streamID, entry->data, entry->nmiss);
+    }
+  else if ( entry->type == PW_CLOSE )
+    {
+      streamClose(entry->streamID);
+      vlistDestroy(entry->vlistIDw);
+      if ( entry->taxisIDw != CDI_UNDEFID ) taxisDestroy(entry->taxisIDw);
+    }
+}
+
+/* waits until the next entry of the writer is free */
+static
+pw_entry_t *pw_entry_get(pw_writer_t *writer)
+{
+  pw_entry_t *entry = &writer->queue[writer->next];
+
+  threadPoolWait(writer->pool, &entry->done);
+  writer->next = (writer->next + 1)%PW_QSIZE;
+
+  return (entry);
+}
+
+static
+void pw_entry_put(pw_writer_t *writer, pw_entry_t *entry)
+{
+  threadPoolSubmit(writer->pool, pw_write_job, entry, &entry->done);
+}
+
+
+par_write_t *parWriteNew(int filetype)
+{
+  par_write_t *pw = NULL;
+  int i, j;
+
+  if ( CDO_Write_Threads <= 0 ) return (NULL);
+
+#if ! defined(HAVE_LIBPTHREAD)
+  if ( cdoVerbose ) cdoPrint("Writer threads not available, pthreads not enabled!");
+  return (NULL);
+#endif
+
+  if ( filetype == FILETYPE_NC || filetype == FILETYPE_NC2 || filetype == FILETYPE_NC4 ||
+       filetype == FILETYPE_NC4C || filetype == FILETYPE_GRB2 )
+    {
+      if ( cdoVerbose ) cdoPrint("Writer threads not used for this output file type!");
+      return (NULL);
+    }
+
+  pw = (par_write_t *) malloc(sizeof(par_write_t));
+  pw->nwriters = CDO_Write_Threads;
+  pw->next     = 0;
+  pw->nstreams = 0;
+  pw->streams  = NULL;
+  pw->nopen    = 0;
+  pw->maxopen  = 2*pw->nwriters;
+  pw->nclosing = 0;
+  pw->first    = 0;
+  pw->nalloc   = 0;
+  pw->closing  = NULL;
+
+  pw->writers = (pw_writer_t *) malloc(pw->nwriters*sizeof(pw_writer_t));
+  for ( i = 0; i < pw->nwriters; ++i )
+    {
+      pw_writer_t *writer = &pw->writers[i];
+      writer->next = 0;
+      for ( j = 0; j < PW_QSIZE; ++j )
+	{
+	  writer->queue[j].done    = TRUE;
+	  writer->queue[j].taxisID = CDI_UNDEFID;
+	  writer->queue[j].size    = 0;
+	  writer->queue[j].data    = NULL;
+	}
+      writer->pool = threadPoolNew(1);
+    }
+
+  if ( cdoVerbose ) cdoPrint("Using %d writer threads", pw->nwriters);
+
+  return (pw);
+}
+
+
+void parWriteDelete(par_write_t *pw)
+{
+  int i, j;
+
+  if ( pw == NULL ) return;
+
+  for ( i = 0; i < pw->nwriters; ++i )
+    {
+      pw_writer_t *writer = &pw->writers[i];
+
+      /* finishes the submitted jobs */
+      threadPoolDelete(writer->pool);
+
+      for ( j = 0; j < PW_QSIZE; ++j )
+	{
+	  if ( writer->queue[j].taxisID != CDI_UNDEFID ) taxisDestroy(writer->queue[j].taxisID);
+	  if ( writer->queue[j].data ) free(writer->queue[j].data);
+	}
+    }
+
+  free(pw->writers);
+  if ( pw->streams ) free(pw->streams);
+  if ( pw->closing ) free(pw->closing);
+  free(pw);
+}
+
+/*
+  Opens an output stream. With writer threads the call waits for the oldest
+  submitted close while too many streams are open.
+*/
+int parWriteOpen(par_write_t *pw, const char *filename, int filetype)
+{
+  int streamID;
+
+  if ( pw )
+    {
+      while ( pw->nopen >= pw->maxopen && pw->nclosing > 0 )
+	{
+	  pw_close_t *pending = &pw->closing[pw->first];
+	  /* a reused entry belongs to a later job of the same writer */
+	  threadPoolWait(pending->writer->pool, &pending->entry->done);
+	  pw->first = (pw->first + 1)%pw->nalloc;
+	  pw->nclosing--;
+	  pw->nopen--;
+	}
+      pw->nopen++;
+    }
+
+  argument_t *fileargument = file_argument_new(filename);
+  streamID = streamOpenWrite(fileargument, filetype);
+  file_argument_free(fileargument);
+
+  return (streamID);
+}
+
+
+void parWriteDefVlist(par_write_t *pw, int streamID, int vlistID)
+{
+  if ( pw )
+    {
+      pw_stream_t *stream;
+      int i;
+
+      if ( streamID >= pw->nstreams )
+	{
+	  pw->streams = (pw_stream_t *) realloc(pw->streams, (streamID+1)*sizeof(pw_stream_t));
+	  for ( i = pw->nstreams; i <= streamID; ++i ) pw->streams[i].writer = -1;
+	  pw->nstreams = streamID+1;
+	}
+
+      stream = &pw->streams[streamID];
+      stream->writer   = pw->next;
+      pw->next = (pw->next + 1)%pw->nwriters;
+
+      /* the stream gets its own time axis, it is set by the writer thread */
+      stream->taxisID  = vlistInqTaxis(vlistID);
+      stream->taxisIDw = CDI_UNDEFID;
+      stream->vlistIDw = vlistDuplicate(vlistID);
+      if ( stream->taxisID != CDI_UNDEFID )
+	{
+	  stream->taxisIDw = taxisDuplicate(stream->taxisID);
+	  vlistDefTaxis(stream->vlistIDw, stream->taxisIDw);
+	}
+
+      streamDefVlist(streamID, stream->vlistIDw);
+      return;
+    }
+
+  streamDefVlist(streamID, vlistID);
+}
+
+
+void parWriteDefTimestep(par_write_t *pw, int streamID, int tsID)
+{
+  if ( pw )
+    {
+      pw_stream_t *stream = &pw->streams[streamID];
+      pw_writer_t *writer = &pw->writers[stream->writer];
+      pw_entry_t *entry = pw_entry_get(writer);
+
+      entry->type     = PW_TIMESTEP;
+      entry->streamID = streamID;
+      entry->tsID     = tsID;
+      entry->taxisIDw = stream->taxisIDw;
+      if ( stream->taxisID != CDI_UNDEFID )
+	{
+	  if ( entry->taxisID != CDI_UNDEFID && entry->taxisIDsrc != stream->taxisID )
+	    {
+	      taxisDestroy(entry->taxisID);
+	      entry->taxisID = CDI_UNDEFID;
+	    }
+	  if ( entry->taxisID == CDI_UNDEFID ) entry->taxisID = taxisDuplicate(stream->taxisID);
+	  entry->taxisIDsrc = stream->taxisID;
+	  taxisCopyTimestep(entry->taxisID, stream->taxisID);
+	}
+
+      pw_entry_put(writer, entry);
+      return;
+    }
+
+  streamDefTimestep(streamID, tsID);
+}
+
+
+void parWriteRecord(par_write_t *pw, int streamID, int varID, int levelID, const double *array, int nmiss)
+{
+  if ( pw )
+    {
+      pw_stream_t *stream = &pw->streams[streamID];
+      pw_writer_t *writer = &pw->writers[stream->writer];
+      pw_entry_t *entry = pw_entry_get(writer);
+      size_t size;
+
+      size = gridInqSize(vlistInqVarGrid(stream->vlistIDw, varID));
+      if ( vlistInqVarNumber(stream->vlistIDw, varID) == CDI_COMP ) size *= 2;
+
+      if ( entry->size < size )
+	{
+	  entry->size = size;
+	  entry->data = (double *) realloc(entry->data, size*sizeof(double));
+	}
+
+      entry->type     = PW_RECORD;
+      entry->streamID = streamID;
+      entry->varID    = varID;
+      entry->levelID  = levelID;
+      entry->nmiss    = nmiss;
+      memcpy(entry->data, array, size*sizeof(double));
+
+      pw_entry_put(writer, entry);
+      return;
+    }
+
+  streamDefRecord(streamID, varID, levelID);
+  streamWriteRecord(streamID, (double *) array, nmiss);
+}
+
+
+void parWriteClose(par_write_t *pw, int streamID)
+{
+  if ( pw )
+    {
+      pw_stream_t *stream = &pw->streams[streamID];
+      pw_writer_t *writer = &pw->writers[stream->writer];
+      pw_entry_t *entry = pw_entry_get(writer);
+      int i;
+
+      entry->type     = PW_CLOSE;
+      entry->streamID = streamID;
+      entry->taxisIDw = stream->taxisIDw;
+      entry->vlistIDw = stream->vlistIDw;
+      stream->writer  = -1;
+
+      if ( pw->nclosing == pw->nalloc )
+	{
+	  int nalloc = pw->nalloc ? 2*pw->nalloc : 16;
+	  pw_close_t *closing = (pw_close_t *) malloc(nalloc*sizeof(pw_close_t));
+	  for ( i = 0; i < pw->nclosing; ++i ) closing[i] = pw->closing[(pw->first + i)%pw->nalloc];
+	  if ( pw->closing ) free(pw->closing);
+	  pw->closing = closing;
+	  pw->nalloc  = nalloc;
+	  pw->first   = 0;
+	}
+      pw->closing[(pw->first + pw->nclosing)%pw->nalloc].writer = writer;
+      pw->closing[(pw->first + pw->nclosing)%pw->nalloc].entry  = entry;
+      pw->nclosing++;
+
+      pw_entry_put(writer, entry);
+      return;
+    }
+
+  streamClose(streamID);
+}
@@ -32,6 +32,18 @@ typedef struct {
 par_io_t;
 
 
+void *readRecord(void *arg);
 void parReadRecord(int streamID, int *varID, int *levelID, double *array, int *nmiss, par_io_t *parIO);
 
+/* writer threads for operators with many output streams */
+typedef struct par_write_s par_write_t;
+
+par_write_t *parWriteNew(int filetype);
+void parWriteDelete(par_write_t *pw);
+int  parWriteOpen(par_write_t *pw, const char *filename, int filetype);
+void parWriteDefVlist(par_write_t *pw, int streamID, int vlistID);
+void parWriteDefTimestep(par_write_t *pw, int streamID, int tsID);
+void parWriteRecord(par_write_t *pw, int streamID, int varID, int levelID, const double *array, int nmiss);
+void parWriteClose(par_write_t *pw, int streamID);
+
 #endif  /* _PAR_IO_H */
@@ -17,6 +17,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include <cdi.h>
@@ -41,6 +42,29 @@ static int histGetEnvNBins()
 }
 
 
+static int hsetGetEnvMethod()
+{
+  const char *str = getenv("CDO_PCTL_METHOD");
+
+  if ( str == NULL || strcmp(str, "hist") == 0 ) return PCTL_HIST;
+  if ( strcmp(str, "sketch") == 0 ) return PCTL_SKETCH_TDIGEST;
+
+  cdoAbort("Environment variable CDO_PCTL_METHOD=%s unsupported (hist or sketch)!", str);
+
+  return PCTL_HIST;
+}
+
+
+/*
+  The histograms need the min/max values of each period (ifile2/ifile3), the
+  sketch is computed in a single pass over ifile1.
+*/
+int hsetNeedsBounds(void)
+{
+  return hsetGetEnvMethod() == PCTL_HIST;
+}
+
+
 static void histDefBounds(HISTOGRAM *hist, double a, double b)
 {
   int i;
@@ -157,6 +181,249 @@ static double histGetPercentile(const HISTOGRAM *hist, double p)
 }
 
 
+/*
+  Percentile sketch (t-digest, Dunning and Ertl 2019) with the arcsine scale function
+
+    k(q) = nbins/(2 pi) * asin(2q-1)
+
+  A centroid never spans more than one unit of k, so it covers at most the rank fraction
+  2 pi sqrt(q(1-q))/nbins. With the default of 101 bins the rank error is below 1.6%
+  at the median and decreases towards the tails. Up to 2*nbins values are stored
+  exactly and give the same result as the histogram method.
+*/
+static double sketchQlimit(double q, int nbins)
+{
+  double k = nbins/(2*M_PI) * asin(2*q - 1) + 1;
+
+  if ( k >= nbins/4. ) return 1;
+
+  return (sin(k*2*M_PI/nbins) + 1)/2;
+}
+
+
+/* quicksort of the centroids by mean, small partitions are finished by insertion sort */
+static void sketchSort(PCTL_CENTROID *cent, int n)
+{
+  PCTL_CENTROID c;
+  double pivot;
+  int i, j;
+
+  while ( n > 16 )
+    {
+      /* median of three moved to the middle */
+      if ( cent[n/2].mean < cent[0].mean ) { c = cent[n/2]; cent[n/2] = cent[0]; cent[0] = c; }
+      if ( cent[n-1].mean < cent[n/2].mean )
+        {
+          c = cent[n/2]; cent[n/2] = cent[n-1]; cent[n-1] = c;
+          if ( cent[n/2].mean < cent[0].mean ) { c = cent[n/2]; cent[n/2] = cent[0]; cent[0] = c; }
+        }
+      pivot = cent[n/2].mean;
+
+      for ( i = 0, j = n - 1; ; i++, j-- )
+        {
+          while ( cent[i].mean < pivot ) i++;
+          while ( cent[j].mean > pivot ) j--;
+          if ( i >= j ) break;
+          c = cent[i]; cent[i] = cent[j]; cent[j] = c;
+        }
+
+      /* recurse into the smaller part */
+      if ( j + 1 < n - j - 1 )
+        {
+          sketchSort(cent, j + 1);
+          cent += j + 1;
+          n    -= j + 1;
+        }
+      else
+        {
+          sketchSort(cent + j + 1, n - j - 1);
+          n = j + 1;
+        }
+    }
+
+  for ( i = 1; i < n; i++ )
+    {
+      c = cent[i];
+      for ( j = i; j > 0 && cent[j-1].mean > c.mean; j-- ) cent[j] = cent[j-1];
+      cent[j] = c;
+    }
+}
+
+
+static void sketchCompress(PCTL_SKETCH *sketch, int nbins)
+{
+  PCTL_CENTROID *cent = sketch->cent;
+  PCTL_CENTROID *prefix = NULL;
+  PCTL_CENTROID c;
+  double total = 0, wsofar = 0, wlimit;
+  int i, j, n = -1;
+  int ncent = sketch->ncent, nvals = sketch->nvals;
+
+  /* the centroids of the last compression are sorted, only the new values need sorting */
+  sketchSort(cent+ncent, nvals-ncent);
+
+  if ( ncent > 0 )
+    {
+      prefix = (PCTL_CENTROID*) malloc(ncent*sizeof(PCTL_CENTROID));
+      if ( prefix == NULL )
+        cdoAbort("Not enough memory (%s)", __func__);
+      memcpy(prefix, cent, ncent*sizeof(PCTL_CENTROID));
+    }
+
+  for ( i = 0; i < nvals; i++ ) total += cent[i].weight;
+
+  wlimit = total * sketchQlimit(0, nbins);
+
+  /* merge both sorted sequences, the output never overtakes the input */
+  for ( i = 0, j = ncent; i < ncent || j < nvals; )
+    {
+      if ( j == nvals || (i < ncent && prefix[i].mean <= cent[j].mean) )
+        c = prefix[i++];
+      else
+        c = cent[j++];
+
+      if ( n >= 0 && wsofar + cent[n].weight + c.weight <= wlimit )
+        {
+          cent[n].weight += c.weight;
+          cent[n].mean   += (c.mean - cent[n].mean) * c.weight / cent[n].weight;
+        }
+      else
+        {
+          if ( n >= 0 )
+            {
+              wsofar += cent[n].weight;
+              wlimit  = total * sketchQlimit(wsofar/total, nbins);
+            }
+          cent[++n] = c;
+        }
+    }
+
+  if ( prefix ) free(prefix);
+
+  sketch->nvals = n + 1;
+  sketch->ncent = n + 1;
+}
+
+
+static void sketchAddCentroid(PCTL_SKETCH *sketch, double mean, double weight, int nbins)
+{
+  int maxcap = 2*nbins;
+
+  if ( sketch->nvals == sketch->capacity )
+    {
+      if ( sketch->capacity >= maxcap ) sketchCompress(sketch, nbins);
+
+      /* the scale function limits the number of centroids to about nbins/2 */
+      if ( sketch->nvals == sketch->capacity )
+        {
+          if ( sketch->capacity < maxcap )
+            sketch->capacity = MIN(MAX(2*sketch->capacity, 8), maxcap);
+          else
+            sketch->capacity *= 2;
+
+          sketch->cent = (PCTL_CENTROID*) realloc(sketch->cent, sketch->capacity*sizeof(PCTL_CENTROID));
+          if ( sketch->cent == NULL )
+            cdoAbort("Not enough memory (%s)", __func__);
+        }
+    }
+
+  sketch->cent[sketch->nvals].mean   = mean;
+  sketch->cent[sketch->nvals].weight = weight;
+  sketch->nvals++;
+}
+
+
+static void sketchAddValue(PCTL_SKETCH *sketch, double value, int nbins)
+{
+  if ( sketch->nsamp == 0 )
+    {
+      sketch->min = value;
+      sketch->max = value;
+    }
+  else
+    {
+      if ( value < sketch->min ) sketch->min = value;
+      if ( value > sketch->max ) sketch->max = value;
+    }
+
+  sketchAddCentroid(sketch, value, 1, nbins);
+  sketch->nsamp++;
+}
+
+
+static void sketchMerge(PCTL_SKETCH *sketch1, const PCTL_SKETCH *sketch2, int nbins)
+{
+  int i;
+
+  if ( sketch2->nsamp == 0 ) return;
+
+  if ( sketch1->nsamp == 0 )
+    {
+      sketch1->min = sketch2->min;
+      sketch1->max = sketch2->max;
+    }
+  else
+    {
+      if ( sketch2->min < sketch1->min ) sketch1->min = sketch2->min;
+      if ( sketch2->max > sketch1->max ) sketch1->max = sketch2->max;
+    }
+
+  for ( i = 0; i < sketch2->nvals; i++ )
+    sketchAddCentroid(sketch1, sketch2->cent[i].mean, sketch2->cent[i].weight, nbins);
+
+  sketch1->nsamp += sketch2->nsamp;
+}
+
+
+static double sketchGetPercentile(const PCTL_SKETCH *sketch, double p, PCTL_CENTROID *work)
+{
+  const PCTL_CENTROID *cent = work;
+  double s, left, right, wsum = 0;
+  int i, n = sketch->nvals;
+
+  assert( sketch->nsamp > 0 );
+  assert( p >= 0 );
+  assert( p <= 100 );
+
+  s = sketch->nsamp * (p / 100.0);
+
+  if ( n == sketch->nsamp )
+    {
+      /* all values are stored exactly */
+      double *values = (double *) work;
+      int k = (int)ceil(s) - 1;
+
+      for ( i = 0; i < n; i++ ) values[i] = sketch->cent[i].mean;
+      if ( k < 0 ) k = 0;
+      if ( k > n - 1 ) k = n - 1;
+
+      return (double)nth_element(values, n, k);
+    }
+
+  memcpy(work, sketch->cent, n*sizeof(PCTL_CENTROID));
+  sketchSort(work, n);
+
+  if ( s <= cent[0].weight/2 )
+    return sketch->min + (cent[0].mean - sketch->min) * s / (cent[0].weight/2);
+
+  for ( i = 0; i < n - 1; i++ )
+    {
+      left  = wsum + cent[i].weight/2;
+      right = wsum + cent[i].weight + cent[i+1].weight/2;
+
+      if ( s < right )
+        return cent[i].mean + (cent[i+1].mean - cent[i].mean) * (s - left) / (right - left);
+
+      wsum += cent[i].weight;
+    }
+
+  left = sketch->nsamp - cent[n-1].weight/2;
+  if ( s <= left ) return cent[n-1].mean;
+
+  return cent[n-1].mean + (sketch->max - cent[n-1].mean) * (s - left) / (cent[n-1].weight/2);
+}
+
+
 HISTOGRAM_SET *hsetCreate(int nvars)
 {
   int varID;
@@ -169,10 +436,13 @@ HISTOGRAM_SET *hsetCreate(int nvars)
     cdoAbort("Not enough memory (%s)", __func__);
     
   hset->nvars   = nvars;
+  hset->method  = hsetGetEnvMethod();
+  hset->nbins   = histGetEnvNBins();
   hset->nlevels = (int*) malloc(nvars * sizeof(int));
   hset->grids   = (int*) malloc(nvars * sizeof(int));
   hset->histograms = (HISTOGRAM ***) malloc(nvars * sizeof(HISTOGRAM **));
-  if ( hset->histograms == NULL )
+  hset->sketches   = (PCTL_SKETCH ***) malloc(nvars * sizeof(PCTL_SKETCH **));
+  if ( hset->histograms == NULL || hset->sketches == NULL )
     cdoAbort("Not enough memory (%s)", __func__);
   
   for ( varID = 0; varID < nvars; varID++ )
@@ -180,6 +450,7 @@ HISTOGRAM_SET *hsetCreate(int nvars)
       hset->nlevels[varID]    = 0;
       hset->grids[varID]      = 0;
       hset->histograms[varID] = NULL;
+      hset->sketches[varID]   = NULL;
     }
   
   return hset;
@@ -190,10 +461,12 @@ void hsetCreateVarLevels(HISTOGRAM_SET *hset, int varID, int nlevels, int grid)
 {
   int nvars, nhists, nbins, levelID, histID;
   HISTOGRAM *hists;
-  
-  nbins = histGetEnvNBins();
+  PCTL_SKETCH *sketches;
   
   assert( hset != NULL );
+
+  nbins = hset->nbins;
+
   assert( nlevels > 0 );
   assert( nbins   > 0 );
   
@@ -211,6 +484,23 @@ void hsetCreateVarLevels(HISTOGRAM_SET *hset, int varID, int nlevels, int grid)
   hset->nlevels[varID] = nlevels;
   hset->grids[varID]   = grid;
 
+  if ( hset->method == PCTL_SKETCH_TDIGEST )
+    {
+      hset->sketches[varID] = (PCTL_SKETCH **) malloc(nlevels * sizeof(PCTL_SKETCH *));
+      if ( hset->sketches[varID] == NULL )
+        cdoAbort("Not enough memory (%s)", __func__);
+
+      /* the centroids are allocated with the first values */
+      for ( levelID = 0; levelID < nlevels; levelID++ )
+        {
+          sketches = hset->sketches[varID][levelID] = (PCTL_SKETCH*) calloc(nhists, sizeof(PCTL_SKETCH));
+          if ( sketches == NULL )
+            cdoAbort("Not enough memory (%s)", __func__);
+        }
+
+      return;
+    }
+
   hset->histograms[varID] = (HISTOGRAM **) malloc(nlevels * sizeof(HISTOGRAM *));
   if ( hset->histograms[varID] == NULL )
     cdoAbort("Not enough memory (%s)", __func__);
@@ -246,6 +536,20 @@ void hsetDestroy(HISTOGRAM_SET *hset)
       for ( varID = hset->nvars; varID-- > 0; )
         {
           nhists = gridInqSize(hset->grids[varID]);
+
+          if ( hset->sketches[varID] )
+            {
+              for ( levelID = hset->nlevels[varID]; levelID-- > 0; )
+                {
+                  for ( histID = nhists; histID-- > 0; )
+                    if ( hset->sketches[varID][levelID][histID].cent )
+                      free(hset->sketches[varID][levelID][histID].cent);
+                  free(hset->sketches[varID][levelID]);
+                }
+              free(hset->sketches[varID]);
+              continue;
+            }
+
           for ( levelID = hset->nlevels[varID]; levelID-- > 0; )
             {
               for ( histID = nhists; histID-- > 0; )
@@ -256,6 +560,7 @@ void hsetDestroy(HISTOGRAM_SET *hset)
         }
       
       free(hset->histograms);
+      free(hset->sketches);
       free(hset->grids);
       free(hset->nlevels);
       free(hset);
@@ -265,6 +570,33 @@ void hsetDestroy(HISTOGRAM_SET *hset)
 }
 
 
+/*
+  Starts a new sample of all sketches, used instead of hsetDefVarLevelBounds() if no bounds are needed.
+*/
+void hsetReset(HISTOGRAM_SET *hset)
+{
+  int varID, levelID, i, nhists;
+
+  assert( hset != NULL );
+
+  if ( hset->method != PCTL_SKETCH_TDIGEST )
+    cdoAbort("Histograms need bounds, use hsetDefVarLevelBounds (%s)", __func__);
+
+  for ( varID = 0; varID < hset->nvars; varID++ )
+    {
+      nhists = gridInqSize(hset->grids[varID]);
+
+      for ( levelID = 0; levelID < hset->nlevels[varID]; levelID++ )
+        {
+          PCTL_SKETCH *sketches = hset->sketches[varID][levelID];
+
+          for ( i = 0; i < nhists; i++ )
+            sketches[i].nsamp = sketches[i].nvals = sketches[i].ncent = 0;
+        }
+    }
+}
+
+
 void hsetDefVarLevelBounds(HISTOGRAM_SET *hset, int varID, int levelID, const field_t *field1, const field_t *field2)
 {
   const double *array1 = field1->ptr;
@@ -299,13 +631,24 @@ void hsetDefVarLevelBounds(HISTOGRAM_SET *hset, int varID, int levelID, const fi
   if ( grid != field1->grid || grid != field2->grid )
     cdoAbort("Grids are different", __func__);
   
-  hists  = hset->histograms[varID][levelID];
-  
-  assert( hists != NULL );
-  
   nhists = gridInqSize(grid);
   
   assert( nhists > 0 );
+
+  if ( hset->method == PCTL_SKETCH_TDIGEST )
+    {
+      /* the sketch needs no bounds, only start a new sample */
+      PCTL_SKETCH *sketches = hset->sketches[varID][levelID];
+
+      for ( i = 0; i < nhists; i++ )
+        sketches[i].nsamp = sketches[i].nvals = sketches[i].ncent = 0;
+
+      return;
+    }
+  
+  hists  = hset->histograms[varID][levelID];
+  
+  assert( hists != NULL );
          
   for ( i = 0; i < nhists; i++ )
     {
@@ -348,13 +691,25 @@ void hsetAddVarLevelValues(HISTOGRAM_SET *hset, int varID, int levelID, const fi
   if ( grid != field->grid )
     cdoAbort("Grids are different", __func__);
 
-  hists  = hset->histograms[varID][levelID];
-  
-  assert( hists != NULL );
-  
   nhists = gridInqSize(grid);
   
   assert( nhists > 0 );
+
+  if ( hset->method == PCTL_SKETCH_TDIGEST )
+    {
+      PCTL_SKETCH *sketches = hset->sketches[varID][levelID];
+      int nbins = hset->nbins;
+
+      for ( i = 0; i < nhists; i++ )
+        if ( !field->nmiss || !DBL_IS_EQUAL(array[i], field->missval) )
+          sketchAddValue(&sketches[i], array[i], nbins);
+
+      return;
+    }
+
+  hists  = hset->histograms[varID][levelID];
+  
+  assert( hists != NULL );
   
   if ( field->nmiss )
     {
@@ -402,13 +757,43 @@ void hsetGetVarLevelPercentiles(field_t *field, const HISTOGRAM_SET *hset, int v
   if ( grid != field->grid )
     cdoAbort("Grids are different (%s)", __func__);
 
-  hists  = hset->histograms[varID][levelID];
-
-  assert( hists != NULL );
-
   nhists = gridInqSize(grid);
 
   assert( nhists > 0 );
+
+  if ( hset->method == PCTL_SKETCH_TDIGEST )
+    {
+      const PCTL_SKETCH *sketches = hset->sketches[varID][levelID];
+      PCTL_CENTROID *work = NULL;
+      int maxvals = 0;
+
+      for ( i = 0; i < nhists; i++ )
+        if ( sketches[i].nvals > maxvals ) maxvals = sketches[i].nvals;
+
+      if ( maxvals > 0 ) work = (PCTL_CENTROID*) malloc(maxvals * sizeof(PCTL_CENTROID));
+
+      field->nmiss = 0;
+      for ( i = 0; i < nhists; i++ )
+        {
+          if ( sketches[i].nsamp )
+            {
+              array[i] = sketchGetPercentile(&sketches[i], p, work);
+            }
+          else
+            {
+              array[i] = field->missval;
+              field->nmiss++;
+            }
+        }
+
+      if ( work ) free(work);
+
+      return;
+    }
+
+  hists  = hset->histograms[varID][levelID];
+
+  assert( hists != NULL );
  
   field->nmiss = 0;
   for ( i = 0; i < nhists; i++ )
@@ -424,3 +809,33 @@ void hsetGetVarLevelPercentiles(field_t *field, const HISTOGRAM_SET *hset, int v
         }
     } 
 }
+
+/*
+  Merges the percentile sketches of hset2 into hset1, e.g. to combine independent chunks of the time series.
+*/
+void hsetMerge(HISTOGRAM_SET *hset1, const HISTOGRAM_SET *hset2)
+{
+  int varID, levelID, i, nhists;
+
+  assert( hset1 != NULL );
+  assert( hset2 != NULL );
+
+  if ( hset1->method != PCTL_SKETCH_TDIGEST || hset2->method != PCTL_SKETCH_TDIGEST )
+    cdoAbort("Histograms can't be merged, use CDO_PCTL_METHOD=sketch (%s)", __func__);
+
+  if ( hset1->nvars != hset2->nvars )
+    cdoAbort("Number of variables differ (%s)", __func__);
+
+  for ( varID = 0; varID < hset1->nvars; varID++ )
+    {
+      if ( hset1->nlevels[varID] != hset2->nlevels[varID] ||
+           gridInqSize(hset1->grids[varID]) != gridInqSize(hset2->grids[varID]) )
+        cdoAbort("Grids or levels of variable %d differ (%s)", varID+1, __func__);
+
+      nhists = gridInqSize(hset1->grids[varID]);
+
+      for ( levelID = 0; levelID < hset1->nlevels[varID]; levelID++ )
+        for ( i = 0; i < nhists; i++ )
+          sketchMerge(&hset1->sketches[varID][levelID][i], &hset2->sketches[varID][levelID][i], hset1->nbins);
+    }
+}
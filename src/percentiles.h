@@ -30,11 +30,39 @@ typedef struct {
 }
 HISTOGRAM;
 
+/* centroid of a percentile sketch, a single value has the weight 1 */
+typedef struct {
+  double mean;
+  double weight;
+}
+PCTL_CENTROID;
+
+/*
+  Mergeable percentile sketch (t-digest). All values are kept exactly as long
+  as they fit into the capacity of 2*nbins centroids, afterwards they are
+  merged into centroids with a size limited by the arcsine scale function.
+*/
+typedef struct {
+  int    nsamp;
+  int    nvals;
+  int    ncent;     /* number of sorted centroids before the unmerged values */
+  int    capacity;
+  double min;
+  double max;
+  PCTL_CENTROID *cent;
+}
+PCTL_SKETCH;
+
+enum {PCTL_HIST = 0, PCTL_SKETCH_TDIGEST};
+
 typedef struct {
   int    nvars;
   int   *nlevels;
   int   *grids;
+  int    method;
+  int    nbins;
   HISTOGRAM ***histograms;
+  PCTL_SKETCH ***sketches;
 }
 HISTOGRAM_SET;
 
@@ -42,9 +70,12 @@ HISTOGRAM_SET;
 HISTOGRAM_SET *hsetCreate(int nvars);
 void hsetCreateVarLevels(HISTOGRAM_SET *hset, int varID, int nlevels, int nhists);
 void hsetDestroy(HISTOGRAM_SET *hset);
+int  hsetNeedsBounds(void);
+void hsetReset(HISTOGRAM_SET *hset);
 
 void hsetDefVarLevelBounds(HISTOGRAM_SET *hset, int varID, int levelID, const field_t *min, const field_t *max);
 void hsetAddVarLevelValues(HISTOGRAM_SET *histField, int varID, int levelID, const field_t *field);
 void hsetGetVarLevelPercentiles(field_t *field, const HISTOGRAM_SET *hset, int varID, int levelID, double pn); 
+void hsetMerge(HISTOGRAM_SET *hset1, const HISTOGRAM_SET *hset2);
 
 #endif /*PERCENTILES_H_*/
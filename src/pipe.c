@@ -91,6 +91,24 @@ void pipe_init(pipe_t *pipe)
   pipe->usedata = TRUE;
   pipe->pstreamptr_in = 0;
 
+  pipe->qsize   = CDO_Pipe_Queue;
+  pipe->qhead   = 0;
+  pipe->qcount  = 0;
+  pipe->queue   = NULL;
+  pipe->nqrecs  = 0;
+  pipe->nwstall = 0;
+  pipe->nrstall = 0;
+  pipe->taxisIDw = CDI_UNDEFID;
+  pipe->taxisIDr = CDI_UNDEFID;
+  memset(&pipe->qrec, 0, sizeof(piperec_t));
+
+  if ( pipe->qsize > 0 )
+    {
+      pipe->queue = (piperec_t*) malloc(pipe->qsize*sizeof(piperec_t));
+      memset(pipe->queue, 0, pipe->qsize*sizeof(piperec_t));
+      for ( int i = 0; i < pipe->qsize; ++i ) pipe->queue[i].taxisID = CDI_UNDEFID;
+    }
+
   pipe->mutex = (pthread_mutex_t*) malloc(sizeof(pthread_mutex_t));
   pthread_mutex_init(pipe->mutex, &m_attr);
 
@@ -145,11 +163,238 @@ void pipeDelete(pipe_t *pipe)
       if ( pipe->isclosed )  free(pipe->isclosed);
       if ( pipe->writeCond ) free(pipe->writeCond);
       if ( pipe->readCond )  free(pipe->readCond);
+      if ( pipe->queue )
+        {
+          for ( int i = 0; i < pipe->qsize; ++i )
+            {
+              if ( pipe->queue[i].data ) free(pipe->queue[i].data);
+              if ( pipe->queue[i].taxisID != CDI_UNDEFID ) taxisDestroy(pipe->queue[i].taxisID);
+            }
+          free(pipe->queue);
+        }
+      if ( pipe->qrec.data ) free(pipe->qrec.data);
+      if ( pipe->taxisIDr != CDI_UNDEFID ) taxisDestroy(pipe->taxisIDr);
       free(pipe);
     }
 }
 
 
+/*
+  Bounded record queue (CDO_Pipe_Queue > 0)
+
+  The writer copies each timestep and record into one of qsize owned buffers and
+  returns immediately, it waits only if all buffers are in use. The time axis of
+  each timestep is stored with the queue entry, because the writer may define the
+  next timestep before the reader has inquired the current one.
+*/
+static
+piperec_t *pipe_queue_push(pipe_t *pipe, const char *pname)
+{
+  while ( pipe->qcount == pipe->qsize && !pipe->EOP )
+    {
+      if ( PipeDebug ) Message("%s queue full, wait of readCond", pname);
+      pipe->nwstall++;
+      pthread_cond_wait(pipe->readCond, pipe->mutex);
+    }
+
+  if ( pipe->EOP ) return (NULL);
+
+  return (&pipe->queue[(pipe->qhead + pipe->qcount) % pipe->qsize]);
+}
+
+static
+piperec_t *pipe_queue_head(pipe_t *pipe, const char *pname)
+{
+  while ( pipe->qcount == 0 && !pipe->EOP )
+    {
+      if ( PipeDebug ) Message("%s queue empty, wait of writeCond", pname);
+      pipe->nrstall++;
+      pthread_cond_wait(pipe->writeCond, pipe->mutex);
+    }
+
+  if ( pipe->qcount == 0 ) return (NULL);
+
+  return (&pipe->queue[pipe->qhead]);
+}
+
+static
+void pipe_queue_pop(pipe_t *pipe)
+{
+  pipe->qhead = (pipe->qhead + 1) % pipe->qsize;
+  pipe->qcount--;
+}
+
+static
+void pipe_queue_def_vlist(pipe_t *pipe, int vlistID)
+{
+  /* the reader gets its own time axis, it is updated in pipeInqTimestep */
+  pipe->taxisIDw = vlistInqTaxis(vlistID);
+  pipe->taxisIDr = taxisDuplicate(pipe->taxisIDw);
+  vlistDefTaxis(vlistID, pipe->taxisIDr);
+}
+
+static
+int pipe_queue_inq_timestep(pstream_t *pstreamptr, int tsID)
+{
+  char *pname = pstreamptr->name;
+  pipe_t *pipe = pstreamptr->pipe;
+  piperec_t *qrec;
+  int nrecs = 0;
+
+  // LOCK
+  pthread_mutex_lock(pipe->mutex);
+  if ( tsID == pipe->tsIDr )
+    {
+      nrecs = pipe->nrecs;
+    }
+  else
+    {
+      if ( tsID != pipe->tsIDr+1 )
+	Error("%s unexpected tsID %d %d", pname, tsID, pipe->tsIDr+1);
+
+      pipe->tsIDr = tsID;
+
+      /* skip all records of the previous timestep which were not inquired */
+      while ( (qrec = pipe_queue_head(pipe, pname)) )
+	{
+	  pipe_queue_pop(pipe);
+	  pthread_cond_signal(pipe->readCond);
+	  if ( qrec->type == PIPE_TIMESTEP )
+	    {
+	      nrecs = qrec->nrecs;
+	      taxisCopyTimestep(pipe->taxisIDr, qrec->taxisID);
+	      break;
+	    }
+	}
+
+      pipe->nrecs = nrecs;
+    }
+  pthread_mutex_unlock(pipe->mutex);
+  // UNLOCK
+
+  return (nrecs);
+}
+
+static
+void pipe_queue_def_timestep(pstream_t *pstreamptr, int nrecs)
+{
+  char *pname = pstreamptr->name;
+  pipe_t *pipe = pstreamptr->pipe;
+  piperec_t *qrec;
+
+  // LOCK
+  pthread_mutex_lock(pipe->mutex);
+  qrec = pipe_queue_push(pipe, pname);
+  if ( qrec )
+    {
+      qrec->type  = PIPE_TIMESTEP;
+      qrec->nrecs = nrecs;
+      if ( qrec->taxisID == CDI_UNDEFID ) qrec->taxisID = taxisDuplicate(pipe->taxisIDw);
+      taxisCopyTimestep(qrec->taxisID, pipe->taxisIDw);
+      pipe->qcount++;
+    }
+  pthread_mutex_unlock(pipe->mutex);
+  // UNLOCK
+
+  pthread_cond_signal(pipe->writeCond);
+}
+
+static
+void pipe_queue_inq_record(pstream_t *pstreamptr, int *varID, int *levelID)
+{
+  char *pname = pstreamptr->name;
+  pipe_t *pipe = pstreamptr->pipe;
+  piperec_t *qrec;
+  double *data;
+  size_t size;
+
+  *varID   = -1;
+  *levelID = -1;
+
+  // LOCK
+  pthread_mutex_lock(pipe->mutex);
+  qrec = pipe_queue_head(pipe, pname);
+  if ( qrec && qrec->type == PIPE_RECORD )
+    {
+      /* swap the buffer of the queue entry with the buffer of the reader */
+      data = pipe->qrec.data;
+      size = pipe->qrec.size;
+      pipe->qrec = *qrec;
+      qrec->data = data;
+      qrec->size = size;
+      pipe_queue_pop(pipe);
+
+      *varID   = pipe->qrec.varID;
+      *levelID = pipe->qrec.levelID;
+    }
+  pthread_mutex_unlock(pipe->mutex);
+  // UNLOCK
+
+  pthread_cond_signal(pipe->readCond);
+}
+
+static
+void pipe_queue_read_record(pstream_t *pstreamptr, double *data, int *nmiss)
+{
+  char *pname = pstreamptr->name;
+  pipe_t *pipe = pstreamptr->pipe;
+  int vlistID, datasize;
+
+  if ( ! pipe->qrec.data )
+    Error("No data pointer for %s", pname);
+
+  vlistID = pstreamptr->vlistID;
+  datasize = gridInqSize(vlistInqVarGrid(vlistID, pipe->qrec.varID));
+  pipe->nvals += datasize;
+  if ( vlistNumber(vlistID) != CDI_REAL ) datasize *= 2;
+  memcpy(data, pipe->qrec.data, datasize*sizeof(double));
+  *nmiss = pipe->qrec.nmiss;
+}
+
+static
+void pipe_queue_write_record(pstream_t *pstreamptr, double *data, int nmiss)
+{
+  char *pname = pstreamptr->name;
+  pipe_t *pipe = pstreamptr->pipe;
+  piperec_t *qrec;
+  int vlistID;
+  size_t datasize;
+
+  vlistID = pstreamptr->vlistID;
+  datasize = gridInqSize(vlistInqVarGrid(vlistID, pipe->varID));
+  if ( vlistNumber(vlistID) != CDI_REAL ) datasize *= 2;
+
+  // LOCK
+  pthread_mutex_lock(pipe->mutex);
+  qrec = pipe_queue_push(pipe, pname);
+  if ( qrec )
+    {
+      if ( qrec->size < datasize )
+	{
+	  qrec->size = datasize;
+	  qrec->data = (double*) realloc(qrec->data, datasize*sizeof(double));
+	}
+      /* the copy is done without holding the lock */
+      pthread_mutex_unlock(pipe->mutex);
+      memcpy(qrec->data, data, datasize*sizeof(double));
+      pthread_mutex_lock(pipe->mutex);
+
+      qrec->type    = PIPE_RECORD;
+      qrec->varID   = pipe->varID;
+      qrec->levelID = pipe->levelID;
+      qrec->nmiss   = nmiss;
+      pipe->qcount++;
+      pipe->nqrecs++;
+    }
+  pthread_mutex_unlock(pipe->mutex);
+  // UNLOCK
+
+  pthread_cond_signal(pipe->writeCond);
+
+  if ( PipeDebug ) Message("%s write record %d", pname, pipe->recIDw);
+}
+
+
 void pipeDefVlist(pstream_t *pstreamptr, int vlistID)
 {
   char *pname = pstreamptr->name;
@@ -157,6 +402,8 @@ void pipeDefVlist(pstream_t *pstreamptr, int vlistID)
 
   if ( PipeDebug ) Message("%s pstreamID %d", pname, pstreamptr->self);
 
+  if ( pipe->qsize > 0 ) pipe_queue_def_vlist(pipe, vlistID);
+
   // LOCK
   pthread_mutex_lock(pipe->mutex);
   pstreamptr->vlistID = vlistID;
@@ -222,6 +469,8 @@ int pipeInqTimestep(pstream_t *pstreamptr, int tsID)
 
   if ( PipeDebug ) Message("%s pstreamID %d", pname, pstreamptr->self);
 
+  if ( pipe->qsize > 0 ) return (pipe_queue_inq_timestep(pstreamptr, tsID));
+
   // LOCK
   pthread_mutex_lock(pipe->mutex);
   pipe->usedata = FALSE;
@@ -298,8 +547,17 @@ void pipeDefTimestep(pstream_t *pstreamptr, int tsID)
       // Message("nrecs = %d nvars = %d", nrecs, vlistNvars(vlistID));
     }
 
-  pipe->nrecs = nrecs;
   if ( PipeDebug ) Message("%s nrecs %d tsID %d %d %d", pname, nrecs, tsID, pipe->tsIDw, pipe->tsIDr);
+
+  if ( pipe->qsize > 0 )
+    {
+      pthread_mutex_unlock(pipe->mutex);
+      // UNLOCK
+      pipe_queue_def_timestep(pstreamptr, nrecs);
+      return;
+    }
+
+  pipe->nrecs = nrecs;
   if ( nrecs == 0 ) pipe->EOP = TRUE;
   pthread_mutex_unlock(pipe->mutex);
   // UNLOCK
@@ -331,6 +589,12 @@ int pipeInqRecord(pstream_t *pstreamptr, int *varID, int *levelID)
   int condSignal = FALSE;
 
   if ( PipeDebug ) Message("%s pstreamID %d", pname, pstreamptr->self);
+
+  if ( pipe->qsize > 0 )
+    {
+      pipe_queue_inq_record(pstreamptr, varID, levelID);
+      return (0);
+    }
  
   // LOCK
   pthread_mutex_lock(pipe->mutex);
@@ -393,6 +657,18 @@ void pipeDefRecord(pstream_t *pstreamptr, int varID, int levelID)
 
   if ( PipeDebug ) Message("%s pstreamID %d", pname, pstreamptr->self);
 
+  if ( pipe->qsize > 0 )
+    {
+      // LOCK
+      pthread_mutex_lock(pipe->mutex);
+      pipe->recIDw++;
+      pipe->varID   = varID;
+      pipe->levelID = levelID;
+      pthread_mutex_unlock(pipe->mutex);
+      // UNLOCK
+      return;
+    }
+
   // LOCK
   pthread_mutex_lock(pipe->mutex);
   if ( PipeDebug ) Message("%s has data %d %d", pname, pipe->recIDr, pipe->recIDw);
@@ -480,6 +756,12 @@ void pipeReadRecord(pstream_t *pstreamptr, double *data, int *nmiss)
   *nmiss = 0;
   if ( PipeDebug ) Message("%s pstreamID %d", pname, pstreamptr->self);
 
+  if ( pipe->qsize > 0 )
+    {
+      pipe_queue_read_record(pstreamptr, data, nmiss);
+      return;
+    }
+
   // LOCK
   pthread_mutex_lock(pipe->mutex);
   while ( pipe->hasdata == 0 )
@@ -573,6 +855,12 @@ void pipeWriteRecord(pstream_t *pstreamptr, double *data, int nmiss)
 
   if ( PipeDebug ) Message("%s pstreamID %d", pname, pstreamptr->self);
 
+  if ( pipe->qsize > 0 )
+    {
+      pipe_queue_write_record(pstreamptr, data, nmiss);
+      return;
+    }
+
   /*
   if ( ! pipe->usedata ) return;
   */
@@ -617,4 +905,14 @@ void pipeDebug(int debug)
   PipeDebug = debug;
 }
 
+
+void pipePrintStat(pstream_t *pstreamptr)
+{
+  pipe_t *pipe = pstreamptr->pipe;
+
+  if ( pipe->qsize > 0 )
+    cdoPrint("%s: %ld records, queue size %d, writer stalls %ld, reader stalls %ld",
+	     pstreamptr->name, pipe->nqrecs, pipe->qsize, pipe->nwstall, pipe->nrstall);
+}
+
 #endif
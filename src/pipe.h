@@ -68,6 +68,18 @@ typedef struct {
 
 #if defined(HAVE_LIBPTHREAD)
 
+enum {PIPE_TIMESTEP = 1, PIPE_RECORD};
+
+typedef struct {
+  int     type;            /* PIPE_TIMESTEP or PIPE_RECORD */
+  int     nrecs;
+  int     taxisID;
+  int     varID, levelID;
+  int     nmiss;
+  size_t  size;            /* allocated size of data */
+  double *data;
+} piperec_t;
+
 struct pipe_s {
   int     nrecs, EOP;
   int     varID, levelID;
@@ -81,6 +93,14 @@ struct pipe_s {
   pthread_cond_t *tsDef, *tsInq, *vlistDef, *isclosed;
   pthread_cond_t *recDef, *recInq;
   pthread_cond_t *writeCond, *readCond;
+  /* bounded record queue, only used if qsize > 0 */
+  int        qsize;             /* number of owned record buffers */
+  int        qhead, qcount;     /* first and number of filled queue entries */
+  piperec_t *queue;
+  piperec_t  qrec;              /* current record of the reader */
+  int        taxisIDw, taxisIDr;
+  long       nqrecs;
+  long       nwstall, nrstall;  /* number of waits on a full/empty queue */
 };
 
 typedef struct pipe_s pipe_t;
@@ -89,6 +109,7 @@ pipe_t *pipeNew(void);
 void    pipeDelete(pipe_t *pipe);
 
 void  pipeDebug(int debug);
+void  pipePrintStat(pstream_t *pstreamptr);
 
 void  pipeDefVlist(pstream_t *pstreamptr, int vlistID);
 int   pipeInqVlist(pstream_t *pstreamptr);
@@ -672,7 +672,7 @@ int pstreamOpenWrite(const argument_t *argument, int filetype)
 	  if ( rstatus != -1 ) query_user_exit(argument->args);
 	}
 
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_start(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_start(timer_write);
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO )
 	pthread_mutex_lock(&streamMutex);
@@ -686,7 +686,7 @@ int pstreamOpenWrite(const argument_t *argument, int filetype)
       else
 	pthread_mutex_unlock(&streamOpenWriteMutex);
 #endif
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_stop(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_stop(timer_write);
       if ( fileID < 0 ) cdiOpenError(fileID, "Open failed on >%s<", argument->args);
 
       cdoDefHistory(fileID, commandLine());
@@ -764,7 +764,7 @@ int pstreamOpenAppend(const argument_t *argument)
   
       if ( PSTREAM_Debug ) Message("file %s", argument->args);
 
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_start(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_start(timer_write);
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO )
 	pthread_mutex_lock(&streamMutex);
@@ -778,7 +778,7 @@ int pstreamOpenAppend(const argument_t *argument)
       else
 	pthread_mutex_unlock(&streamOpenReadMutex);
 #endif
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_stop(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_stop(timer_write);
       if ( fileID < 0 ) cdiOpenError(fileID, "Open failed on >%s<", argument->args);
       /*
       cdoInqHistory(fileID);
@@ -826,6 +826,7 @@ void pstreamClose(int pstreamID)
 	  pthread_cond_signal(pipe->tsInq);
 	 
 	  pthread_cond_signal(pipe->recInq);
+	  pthread_cond_signal(pipe->readCond);
 	 
 	  pthread_mutex_lock(pipe->mutex);
 	  pstreamptr->isopen = FALSE;
@@ -834,6 +835,8 @@ void pstreamClose(int pstreamID)
 
 	  pthread_join(pstreamptr->wthreadID, NULL);
 
+	  if ( cdoVerbose ) pipePrintStat(pstreamptr);
+
 	  pthread_mutex_lock(pipe->mutex);
 	  if ( pstreamptr->name ) free(pstreamptr->name);
 	  if ( pstreamptr->argument )
@@ -860,6 +863,7 @@ void pstreamClose(int pstreamID)
 	  pthread_mutex_unlock(pipe->mutex);     
 	  pthread_cond_signal(pipe->tsDef);
 	  pthread_cond_signal(pipe->tsInq);
+	  pthread_cond_signal(pipe->writeCond);
 
 	  pthread_mutex_lock(pipe->mutex);
 	  while ( pstreamptr->isopen )
@@ -1102,7 +1106,7 @@ void pstreamDefVlist(int pstreamID, int vlistID)
 #endif
       pstreamDefVarlist(pstreamptr, vlistID);
 
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_start(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_start(timer_write);
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO ) pthread_mutex_lock(&streamMutex);
 #endif
@@ -1110,7 +1114,7 @@ void pstreamDefVlist(int pstreamID, int vlistID)
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO ) pthread_mutex_unlock(&streamMutex);
 #endif
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_stop(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_stop(timer_write);
     }
 }
 
@@ -1158,7 +1162,7 @@ void pstreamDefRecord(int pstreamID, int varID, int levelID)
   else
 #endif
     {
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_start(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_start(timer_write);
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO ) pthread_mutex_lock(&streamMutex);
 #endif
@@ -1166,7 +1170,7 @@ void pstreamDefRecord(int pstreamID, int varID, int levelID)
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO ) pthread_mutex_unlock(&streamMutex);
 #endif
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_stop(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_stop(timer_write);
     }
 }
 
@@ -1284,7 +1288,7 @@ void pstreamWriteRecord(int pstreamID, double *data, int nmiss)
 #endif
     {
       int varID = pstreamptr->varID;
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_start(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_start(timer_write);
 
       if ( pstreamptr->varlist )
 	if ( pstreamptr->varlist[varID].check_datarange )
@@ -1298,7 +1302,7 @@ void pstreamWriteRecord(int pstreamID, double *data, int nmiss)
       if ( cdoLockIO ) pthread_mutex_unlock(&streamMutex);
 #endif
 
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_stop(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_stop(timer_write);
     }
 }
 
@@ -1321,7 +1325,7 @@ void pstreamWriteRecordF(int pstreamID, float *data, int nmiss)
 #endif
     {
       // int varID = pstreamptr->varID;
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_start(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_start(timer_write);
       /*
       if ( pstreamptr->varlist )
 	if ( pstreamptr->varlist[varID].check_datarange )
@@ -1334,11 +1338,34 @@ void pstreamWriteRecordF(int pstreamID, float *data, int nmiss)
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO ) pthread_mutex_unlock(&streamMutex);
 #endif
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_stop(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_stop(timer_write);
     }
 }
 
 
+void pstreamDefRecordFilter(int pstreamID, int varID, int levelID, int flag)
+{
+  pstream_t *pstreamptr;
+
+  pstreamptr = pstream_to_pointer(pstreamID);
+
+  /* the filter is only a hint for the decoder, pipes pass all records */
+#if defined(HAVE_LIBPTHREAD)
+  if ( pstreamptr->ispipe ) return;
+#endif
+
+  if ( pstreamptr->mfiles ) return;
+
+#if defined(HAVE_LIBPTHREAD)
+  if ( cdoLockIO ) pthread_mutex_lock(&streamMutex);
+#endif
+  streamDefRecordFilter(pstreamptr->fileID, varID, levelID, flag);
+#if defined(HAVE_LIBPTHREAD)
+  if ( cdoLockIO ) pthread_mutex_unlock(&streamMutex);
+#endif
+}
+
+
 int pstreamInqTimestep(int pstreamID, int tsID)
 {
   int nrecs = 0;
@@ -1456,7 +1483,7 @@ void pstreamDefTimestep(int pstreamID, int tsID)
       	  taxisDefType(taxisID, cdoDefaultTimeType);
 	}
 
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_start(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_start(timer_write);
       /* don't use sync -> very slow on GPFS */
       //  if ( tsID > 0 ) streamSync(pstreamptr->fileID);
 #if defined(HAVE_LIBPTHREAD)
@@ -1466,7 +1493,7 @@ void pstreamDefTimestep(int pstreamID, int tsID)
 #if defined(HAVE_LIBPTHREAD)
       if ( cdoLockIO ) pthread_mutex_unlock(&streamMutex);
 #endif
-      if ( processNums() == 1 && ompNumThreads == 1 ) timer_stop(timer_write);
+      if ( processNums() == 1 && ompNumThreads == 1 && CDO_Write_Threads == 0 ) timer_stop(timer_write);
     }
 }
 
@@ -42,6 +42,7 @@
 #define  streamReadRecord         pstreamReadRecord
 
 #define  streamCopyRecord         pstreamCopyRecord
+#define  streamDefRecordFilter    pstreamDefRecordFilter
 
 #define  streamInqGRIBinfo        pstreamInqGRIBinfo
 
@@ -69,6 +70,7 @@ void    pstreamWriteRecord(int pstreamID, double *data, int nmiss);
 void    pstreamWriteRecordF(int pstreamID, float *data, int nmiss);
 void    pstreamReadRecord(int pstreamID, double *data, int *nmiss);
 void    pstreamCopyRecord(int pstreamIDdest, int pstreamIDsrc);
+void    pstreamDefRecordFilter(int pstreamID, int varID, int levelID, int flag);
 
 void    pstreamInqGRIBinfo(int pstreamID, int *intnum, float *fltnum, off_t *bignum);
 
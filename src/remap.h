@@ -72,6 +72,23 @@ typedef RESTR_TYPE restr_t;
 #define  SUBMAP_TYPE_SUM      2
 
 
+typedef struct {
+  double   min[3], max[3];        /* bounding box of the points   */
+  long     first, last;           /* range of the points in idx   */
+  long     left, right;           /* child nodes, -1 for a leaf   */
+}
+kdnode_t;
+
+typedef struct {
+  long      npoints;
+  long      nnodes, nalloc;
+  kdnode_t *nodes;
+  int      *idx;                  /* grid address of the points in tree order */
+  double   *sinlat, *coslat;      /* sin/cos of the coordinates in tree order */
+  double   *sinlon, *coslon;
+}
+kdtree_t;
+
 typedef struct {
   int      lwrite_remap;
   int      gridID;
@@ -114,6 +131,9 @@ typedef struct {
   int*     bin_addr;              /* min,max adds for grid cells in this lat bin  */
 
   restr_t* bin_lats;              /* min,max latitude for each search bin   */
+
+  kdtree_t *search_tree;          /* kd-tree of the cell centers (distwgt, bil, bic) */
+  double   search_box_radius;     /* max. distance of a bil/bic box corner from the first one */
 }
 remapgrid_t;
 
@@ -143,6 +163,9 @@ typedef struct {
 
   double*  wts;              /* map weights for each link [max_links*num_wts] */
 
+  long     row_size;         /* number of target cells of the row index  */
+  long*    row_ptr;          /* first link of each target cell [row_size+1] (links sorted by target) */
+
   remaplink_t links;
 }
 remapvars_t;
@@ -176,6 +199,9 @@ void remap(double *restrict dst_array, double missval, long dst_size, long num_l
 	   long num_wts, const int *restrict dst_add, const int *restrict src_add, const double *restrict src_array, 
 	   const double *restrict src_grad1, const double *restrict src_grad2, const double *restrict src_grad3,
 	   remaplink_t links);
+void remap_csr(double *restrict dst_array, double missval, long dst_size, long nvec, remapvars_t *rv,
+	       const double *restrict src_array, long src_size, int lrenorm, const double *restrict src_grad1,
+	       const double *restrict src_grad2, const double *restrict src_grad3);
 
 void remap_laf(double *restrict dst_array, double missval, long dst_size, long num_links, double *restrict map_wts,
 	       long num_wts, const int *restrict dst_add, const int *restrict src_add, const double *restrict src_array);
@@ -211,6 +237,14 @@ void write_remap_scrip(const char *interp_file, int map_type, int submap_type, i
 void read_remap_scrip(const char *interp_file, int gridID1, int gridID2, int *map_type, int *submap_type, int *num_neighbors,
 		      int *remap_order, remapgrid_t *src_grid, remapgrid_t *tgt_grid, remapvars_t *rv);
 
+char *remap_cache_filename(const char *cachedir, const int *iparam, int niparam, const double *dparam, int ndparam,
+			   const remapgrid_t *src_grid, const remapgrid_t *tgt_grid);
+int  remap_cache_lock(const char *filename);
+void remap_cache_unlock(int fd);
+int  remap_cache_read(const char *filename, int gridID1, int gridID2, remap_t *remap);
+void remap_cache_write(const char *filename, int map_type, int submap_type, int num_neighbors,
+		       int remap_order, const remap_t *remap);
+
 void calc_bin_addr(long gridsize, long nbins, const restr_t* restrict bin_lats, const restr_t* restrict cell_bound_box, int* restrict bin_addr);
 void calc_lat_bins(remapgrid_t* src_grid, remapgrid_t* tgt_grid, int map_type);
 long get_srch_cells(long tgt_cell_add, long nbins, int *bin_addr1, int *bin_addr2,
@@ -228,6 +262,13 @@ int grid_search(remapgrid_t *src_grid, int *restrict src_add, double *restrict s
 		const double *restrict src_center_lat, const double *restrict src_center_lon,
 		const restr_t *restrict src_grid_bound_box, const int *restrict src_bin_add);
 
+void grid_search_tree_new(remapgrid_t *src_grid);
+
+kdtree_t *kdtree_new(long npoints, const double *restrict lon, const double *restrict lat);
+void kdtree_delete(kdtree_t *tree);
+int kdtree_search_nbr(const kdtree_t *tree, int num_neighbors, int *restrict nbr_add, double *restrict nbr_dist,
+		      double plat, double plon, double search_radius);
+
 int find_ij_weights(double plon, double plat, double* restrict src_lats, double* restrict src_lons, double *ig, double *jg);
 int rect_grid_search(long *ii, long *jj, double x, double y, long nxm, long nym, const double *restrict xm, const double *restrict ym);
 
@@ -107,6 +107,8 @@ void scrip_remap_weights_bicubic(remapgrid_t *src_grid, remapgrid_t *tgt_grid, r
 
   weightlinks4_t *weightlinks = (weightlinks4_t *) malloc(tgt_grid_size*sizeof(weightlinks4_t));
 
+  if ( remap_grid_type != REMAP_GRID_TYPE_REG2D ) grid_search_tree_new(src_grid);
+
   /* Loop over destination grid */
 
   double findex = 0;
@@ -235,6 +237,8 @@ void scrip_remap_bicubic(remapgrid_t *src_grid, remapgrid_t *tgt_grid, const dou
 
   remap_gradients(*src_grid, src_array, grad1_lat, grad1_lon, grad1_latlon);
 
+  if ( remap_grid_type != REMAP_GRID_TYPE_REG2D ) grid_search_tree_new(src_grid);
+
   /* Loop over destination grid */
 
   double findex = 0;
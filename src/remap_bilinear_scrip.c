@@ -191,6 +191,8 @@ void scrip_remap_weights_bilinear(remapgrid_t* src_grid, remapgrid_t* tgt_grid,
 
   double findex = 0;
 
+  if ( remap_grid_type != REMAP_GRID_TYPE_REG2D ) grid_search_tree_new(src_grid);
+
   /* Loop over destination grid */
 
 #if defined(_OPENMP)
@@ -317,6 +319,8 @@ void scrip_remap_bilinear(remapgrid_t* src_grid, remapgrid_t* tgt_grid, const do
 
   double findex = 0;
 
+  if ( remap_grid_type != REMAP_GRID_TYPE_REG2D ) grid_search_tree_new(src_grid);
+
   /* Loop over destination grid */
 
 #if defined(_OPENMP)
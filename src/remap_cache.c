@@ -0,0 +1,245 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+/*
+  Persistent remap weight cache (CDO_REMAP_CACHE=<directory>)
+
+  The weights are stored in SCRIP format. The file name is derived from a hash
+  of the remap parameters and of the coordinates and masks of both grids, so
+  any change of the grids gives a new cache entry. New entries are written to a
+  temporary file and renamed, readers never see incomplete files. The lock file
+  avoids that concurrent processes compute the same weights more than once.
+*/
+
+#if defined(HAVE_CONFIG_H)
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <cdi.h>
+#include "cdo.h"
+#include "cdo_int.h"
+#include "remap.h"
+
+
+#define  FNV_OFFSET  0xcbf29ce484222325ULL
+#define  FNV_PRIME   0x100000001b3ULL
+
+static
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+  const unsigned char *p = (const unsigned char *) data;
+  size_t i;
+
+  for ( i = 0; i < len; ++i )
+    {
+      hash ^= p[i];
+      hash *= FNV_PRIME;
+    }
+
+  return (hash);
+}
+
+static
+uint64_t hash_grid(uint64_t hash, const remapgrid_t *grid)
+{
+  long size = grid->size;
+  long ncorners = grid->num_cell_corners;
+
+  hash = hash_bytes(hash, &grid->rank, sizeof(int));
+  hash = hash_bytes(hash, &size, sizeof(long));
+  hash = hash_bytes(hash, grid->dims, 2*sizeof(int));
+  hash = hash_bytes(hash, &grid->non_global, sizeof(int));
+  hash = hash_bytes(hash, &grid->is_cyclic, sizeof(int));
+
+  if ( grid->nvgp && grid->vgpm ) hash = hash_bytes(hash, grid->vgpm, grid->nvgp*sizeof(int));
+  if ( grid->mask ) hash = hash_bytes(hash, grid->mask, size*sizeof(int));
+
+  if ( grid->cell_center_lon ) hash = hash_bytes(hash, grid->cell_center_lon, size*sizeof(double));
+  if ( grid->cell_center_lat ) hash = hash_bytes(hash, grid->cell_center_lat, size*sizeof(double));
+
+  if ( grid->lneed_cell_corners && grid->cell_corner_lon && grid->cell_corner_lat )
+    {
+      hash = hash_bytes(hash, &ncorners, sizeof(long));
+      hash = hash_bytes(hash, grid->cell_corner_lon, ncorners*size*sizeof(double));
+      hash = hash_bytes(hash, grid->cell_corner_lat, ncorners*size*sizeof(double));
+    }
+
+  return (hash);
+}
+
+/*
+  Returns the name of the cache file for the remap parameters and grids (allocated).
+*/
+char *remap_cache_filename(const char *cachedir, const int *iparam, int niparam, const double *dparam, int ndparam,
+			   const remapgrid_t *src_grid, const remapgrid_t *tgt_grid)
+{
+  uint64_t hash = FNV_OFFSET;
+  size_t len;
+  char *filename;
+
+  hash = hash_bytes(hash, VERSION, strlen(VERSION));
+  hash = hash_bytes(hash, iparam, niparam*sizeof(int));
+  hash = hash_bytes(hash, dparam, ndparam*sizeof(double));
+  hash = hash_grid(hash, src_grid);
+  hash = hash_grid(hash, tgt_grid);
+
+  len = strlen(cachedir) + 96;
+  filename = (char*) malloc(len);
+  sprintf(filename, "%s/remap_%ld_%ld_%016llx.nc", cachedir,
+	  src_grid->size, tgt_grid->size, (unsigned long long) hash);
+
+  return (filename);
+}
+
+/*
+  Exclusive lock of <filename>.lock, waits until the lock is available. Returns the file descriptor or -1.
+*/
+int remap_cache_lock(const char *filename)
+{
+  struct flock mylock;
+  char *lockname;
+  int fd;
+
+  lockname = (char*) malloc(strlen(filename) + 6);
+  sprintf(lockname, "%s.lock", filename);
+
+  fd = open(lockname, O_RDWR | O_CREAT, 0666);
+  if ( fd == -1 )
+    {
+      cdoWarning("Open of remap cache lock file %s failed: %s", lockname, strerror(errno));
+      free(lockname);
+      return (-1);
+    }
+
+  memset(&mylock, 0, sizeof(struct flock));
+  mylock.l_type   = F_WRLCK;
+  mylock.l_whence = SEEK_SET;
+
+  while ( fcntl(fd, F_SETLKW, &mylock) == -1 )
+    {
+      if ( errno == EINTR ) continue;
+
+      cdoWarning("Lock of remap cache file %s failed: %s", lockname, strerror(errno));
+      close(fd);
+      fd = -1;
+      break;
+    }
+
+  free(lockname);
+
+  return (fd);
+}
+
+
+void remap_cache_unlock(int fd)
+{
+  struct flock mylock;
+
+  if ( fd == -1 ) return;
+
+  memset(&mylock, 0, sizeof(struct flock));
+  mylock.l_type   = F_UNLCK;
+  mylock.l_whence = SEEK_SET;
+  fcntl(fd, F_SETLK, &mylock);
+
+  close(fd);
+}
+
+/*
+  Reads the weights of the cache file into remap. The grids of remap are already initialized,
+  only the cell areas and fractions are taken from the file. Returns TRUE if the file was found.
+*/
+int remap_cache_read(const char *filename, int gridID1, int gridID2, remap_t *remap)
+{
+  remapgrid_t src_grid, tgt_grid;
+  remapvars_t vars;
+  int map_type, submap_type, num_neighbors, remap_order;
+  struct stat filestat;
+
+  if ( stat(filename, &filestat) != 0 ) return (FALSE);
+
+  if ( cdoVerbose ) cdoPrint("Read remap weights from cache file %s", filename);
+
+  vars.pinit = FALSE;
+  read_remap_scrip(filename, gridID1, gridID2, &map_type, &submap_type, &num_neighbors,
+		   &remap_order, &src_grid, &tgt_grid, &vars);
+
+  if ( src_grid.size != remap->src_grid.size || tgt_grid.size != remap->tgt_grid.size )
+    cdoAbort("Grid size of remap cache file %s differ!", filename);
+
+  if ( src_grid.cell_area && remap->src_grid.cell_area )
+    memcpy(remap->src_grid.cell_area, src_grid.cell_area, src_grid.size*sizeof(double));
+  if ( src_grid.cell_frac && remap->src_grid.cell_frac )
+    memcpy(remap->src_grid.cell_frac, src_grid.cell_frac, src_grid.size*sizeof(double));
+  if ( tgt_grid.cell_area && remap->tgt_grid.cell_area )
+    memcpy(remap->tgt_grid.cell_area, tgt_grid.cell_area, tgt_grid.size*sizeof(double));
+  if ( tgt_grid.cell_frac && remap->tgt_grid.cell_frac )
+    memcpy(remap->tgt_grid.cell_frac, tgt_grid.cell_frac, tgt_grid.size*sizeof(double));
+
+  remapGridFree(&src_grid);
+  remapGridFree(&tgt_grid);
+
+  remapVarsFree(&remap->vars);
+  remap->vars = vars;
+
+  return (TRUE);
+}
+
+/*
+  Writes the weights to a temporary file which is renamed to the cache file.
+  Only a warning is printed if the temporary file can't be created.
+*/
+void remap_cache_write(const char *filename, int map_type, int submap_type, int num_neighbors,
+		       int remap_order, const remap_t *remap)
+{
+  char *tmpname;
+  int fd;
+
+  tmpname = (char*) malloc(strlen(filename) + 32);
+  sprintf(tmpname, "%s.tmp%ld", filename, (long) getpid());
+
+  /* write_remap_scrip() aborts on errors, a cache that can't be written is skipped */
+  fd = open(tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if ( fd == -1 )
+    {
+      cdoWarning("Write of remap cache file %s failed: %s", tmpname, strerror(errno));
+      free(tmpname);
+      return;
+    }
+  close(fd);
+
+  if ( cdoVerbose ) cdoPrint("Write remap weights to cache file %s", filename);
+
+  write_remap_scrip(tmpname, map_type, submap_type, num_neighbors, remap_order,
+		    remap->src_grid, remap->tgt_grid, remap->vars);
+
+  if ( rename(tmpname, filename) != 0 )
+    {
+      cdoWarning("Rename of remap cache file %s failed: %s", tmpname, strerror(errno));
+      unlink(tmpname);
+    }
+
+  free(tmpname);
+}
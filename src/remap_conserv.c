@@ -1019,48 +1019,20 @@ void remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, remapva
 	    }
 	}
 
+      /*
+	Store the appropriate addresses and weights. 
+	Also add contributions to cell areas.
+	The source grid mask is the master mask.
+	The links of masked source cells are removed after the loop,
+	they are needed for the source cell areas.
+      */
       for ( n = 0; n < num_weights; ++n )
 	{
 	  partial_weight = partial_weights[n];
-
-	  src_cell_add = srch_add[n];
-
-#if defined(_OPENMP)
-#pragma omp atomic
-#endif
-	  src_grid->cell_area[src_cell_add] += partial_weight;
-	}
-
-
-      num_weights_old = num_weights;
-      for ( num_weights = 0, n = 0; n < num_weights_old; ++n )
-	{
 	  src_cell_add = srch_add[n];
 
-	  /*
-	    Store the appropriate addresses and weights. 
-	    Also add contributions to cell areas.
-	    The source grid mask is the master mask
-	  */
 	  if ( src_grid->mask[src_cell_add] )
-	    {
-	      partial_weights[num_weights] = partial_weights[n];
-	      srch_add[num_weights] = src_cell_add;
-	      num_weights++;
-	    }
-	}
-
-      for ( n = 0; n < num_weights; ++n )
-	{
-	  partial_weight = partial_weights[n];
-	  src_cell_add = srch_add[n];
-
-#if defined(_OPENMP)
-#pragma omp atomic
-#endif
-	  src_grid->cell_frac[src_cell_add] += partial_weight;
-		  
-	  tgt_grid->cell_frac[tgt_cell_add] += partial_weight;
+	    tgt_grid->cell_frac[tgt_cell_add] += partial_weight;
 	}
 
       store_weightlinks(num_weights, srch_add, partial_weights, tgt_cell_add, weightlinks);
@@ -1075,6 +1047,32 @@ void remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, remapva
       printf("sum_srch_cells2: %d\n", sum_srch_cells2);
     }
 
+  /*
+    Sum up the source cell areas and fractions in the order of the target cells.
+    This is done after the loop to get the same result with any number of threads.
+  */
+  for ( tgt_cell_add = 0; tgt_cell_add < tgt_grid_size; ++tgt_cell_add )
+    {
+      long nlinks = weightlinks[tgt_cell_add].nlinks;
+      addweight_t *addweights = weightlinks[tgt_cell_add].addweights;
+      long ilink, nvalid = 0;
+
+      for ( ilink = 0; ilink < nlinks; ++ilink )
+	{
+	  src_cell_add = addweights[ilink].add;
+	  src_grid->cell_area[src_cell_add] += addweights[ilink].weight;
+
+	  if ( src_grid->mask[src_cell_add] )
+	    {
+	      src_grid->cell_frac[src_cell_add] += addweights[ilink].weight;
+	      addweights[nvalid++] = addweights[ilink];
+	    }
+	}
+
+      if ( nlinks > 0 && nvalid == 0 ) free(addweights);
+      weightlinks[tgt_cell_add].nlinks = nvalid;
+    }
+
   /* Finished with all cells: deallocate search arrays */
   long n;
 
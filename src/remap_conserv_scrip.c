@@ -1210,6 +1210,94 @@ void normalize_weights(remapgrid_t *tgt_grid, remapvars_t *rv, double *src_centr
     }
 }
 
+/*
+  The links found by the threads are buffered per thread and stored after each
+  block of cells. With a static schedule the buffers of the threads hold the links
+  in the order of a sequential run, so the links and the summation order of the
+  weights do not depend on the number of threads.
+*/
+#define  CNSRV_BLK_SIZE  65536
+
+typedef struct {
+  long    num_links;
+  long    max_links;
+  int    *src_add;
+  int    *tgt_add;
+  double *weights;          /* weights[0:3] of each link [max_links*4] */
+} cnsrv_links_t;
+
+static
+void cnsrv_links_init(cnsrv_links_t *links)
+{
+  links->num_links = 0;
+  links->max_links = 0;
+  links->src_add   = NULL;
+  links->tgt_add   = NULL;
+  links->weights   = NULL;
+}
+
+static
+void cnsrv_links_free(cnsrv_links_t *links)
+{
+  if ( links->src_add ) free(links->src_add);
+  if ( links->tgt_add ) free(links->tgt_add);
+  if ( links->weights ) free(links->weights);
+  cnsrv_links_init(links);
+}
+
+static
+void cnsrv_links_add(cnsrv_links_t *links, long src_add, long tgt_add, const double *weights)
+{
+  long n = links->num_links;
+
+  if ( n == links->max_links )
+    {
+      links->max_links = links->max_links ? 2*links->max_links : 1024;
+      links->src_add = (int*) realloc(links->src_add, links->max_links*sizeof(int));
+      links->tgt_add = (int*) realloc(links->tgt_add, links->max_links*sizeof(int));
+      links->weights = (double*) realloc(links->weights, 4*links->max_links*sizeof(double));
+    }
+
+  links->src_add[n] = src_add;
+  links->tgt_add[n] = tgt_add;
+  links->weights[4*n  ] = weights[0];
+  links->weights[4*n+1] = weights[1];
+  links->weights[4*n+2] = weights[2];
+  links->weights[4*n+3] = weights[3];
+  links->num_links++;
+}
+
+/*
+  Stores the buffered links and adds weights[0] to the source cell fraction (src_frac)
+  or weights[3] to the target cell fraction (tgt_frac).
+*/
+static
+void cnsrv_links_store(remapvars_t *rv, cnsrv_links_t *links, grid_store_t *grid_store,
+		       int *link_add1[2], int *link_add2[2], double *src_frac, double *tgt_frac)
+{
+  long n, src_cell_add, tgt_cell_add;
+  long num_links = links->num_links;
+  long num_wts = rv->num_wts;
+  double *weights;
+
+  for ( n = 0; n < num_links; ++n )
+    {
+      src_cell_add = links->src_add[n];
+      tgt_cell_add = links->tgt_add[n];
+      weights = &links->weights[4*n];
+
+      if ( remap_store_link_fast )
+	store_link_cnsrv_fast(rv, src_cell_add, tgt_cell_add, num_wts, weights, grid_store);
+      else
+	store_link_cnsrv(rv, src_cell_add, tgt_cell_add, weights, link_add1, link_add2);
+
+      if ( src_frac ) src_frac[src_cell_add] += weights[0];
+      if ( tgt_frac ) tgt_frac[tgt_cell_add] += weights[3];
+    }
+
+  links->num_links = 0;
+}
+
 /*
   -----------------------------------------------------------------------
 
@@ -1253,7 +1341,6 @@ void scrip_remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, r
 
   double begseg[2];         /* begin lat/lon for full segment */
   double weights[6];        /* local wgt array */
-  long    num_wts;
 
   long    max_srch_cells;   /* num cells in restricted search arrays  */
   long    num_srch_cells;   /* num cells in restricted search arrays  */
@@ -1281,6 +1368,8 @@ void scrip_remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, r
   int avoid_pole_count = 0;         /* count attempts to avoid pole  */
   double avoid_pole_offset = TINY;  /* endpoint offset to avoid pole */
   grid_store_t *grid_store = NULL;
+  cnsrv_links_t cnsrv_links2[ompNumThreads];
+  long blk_start, blk_end;
   double findex = 0;
   extern int timer_remap_con, timer_remap_con_l1, timer_remap_con_l2;
 
@@ -1289,7 +1378,6 @@ void scrip_remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, r
   progressInit();
 
   nbins = src_grid->num_srch_bins;
-  num_wts = rv->num_wts;
 
   if ( remap_store_link_fast )
     {
@@ -1374,197 +1462,201 @@ void scrip_remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, r
   for ( i = 0; i < ompNumThreads; ++i )
     srch_add2[i] = (int*) malloc(tgt_grid_size*sizeof(int));
 
+  for ( i = 0; i < ompNumThreads; ++i )
+    cnsrv_links_init(&cnsrv_links2[i]);
+
   srch_corners    = tgt_num_cell_corners;
 
   if ( cdoTimer ) timer_start(timer_remap_con_l1);
 
+  for ( blk_start = 0; blk_start < src_grid_size; blk_start += CNSRV_BLK_SIZE )
+    {
+      blk_end = MIN(blk_start+CNSRV_BLK_SIZE, src_grid_size);
+
 #if defined(_OPENMP)
 #pragma omp parallel for default(shared) \
-  shared(ompNumThreads, nbins, num_wts, src_centroid_lon, src_centroid_lat, \
+  shared(ompNumThreads, nbins, src_centroid_lon, src_centroid_lat, \
          remap_store_link_fast, grid_store, link_add1, link_add2, rv, cdoVerbose, max_subseg, \
 	 srch_corner_lat2, srch_corner_lon2, max_srch_cells2, 		\
-	 src_num_cell_corners,	srch_corners, src_grid, tgt_grid, tgt_grid_size, src_grid_size, srch_add2, findex) \
+	 src_num_cell_corners,	srch_corners, src_grid, tgt_grid, tgt_grid_size, src_grid_size, srch_add2, findex, \
+	 blk_start, blk_end, cnsrv_links2)	\
   private(srch_add, n, k, num_srch_cells, max_srch_cells, 	\
 	  src_cell_add, tgt_cell_add, ioffset, nsrch_corners, corner, next_corn, beglat, beglon, \
 	  endlat, endlon, lrevers, begseg, lbegin, num_subseg, srch_corner_lat, srch_corner_lon, \
 	  weights, intrsct_lat, intrsct_lon, intrsct_lat_off, intrsct_lon_off, intrsct_x, intrsct_y, \
-	  last_loc, lcoinc, lthresh, luse_last, avoid_pole_count, avoid_pole_offset)
+	  last_loc, lcoinc, lthresh, luse_last, avoid_pole_count, avoid_pole_offset) \
+  schedule(static)
 #endif
-  for ( src_cell_add = 0; src_cell_add < src_grid_size; ++src_cell_add )
-    {
-      int ompthID = cdo_omp_get_thread_num();
-      int lprogress = 1;
-      if ( ompthID != 0 ) lprogress = 0;
+	  for ( src_cell_add = blk_start; src_cell_add < blk_end; ++src_cell_add )
+	{
+	  int ompthID = cdo_omp_get_thread_num();
+	  int lprogress = 1;
+	  if ( ompthID != 0 ) lprogress = 0;
 
 #if defined(_OPENMP)
 #include "pragma_omp_atomic_update.h"
 #endif
-      findex++;
-      if ( lprogress ) progressStatus(0, 0.5, findex/src_grid_size);
+	  findex++;
+	  if ( lprogress ) progressStatus(0, 0.5, findex/src_grid_size);
 
-      srch_add = srch_add2[ompthID];
+	  srch_add = srch_add2[ompthID];
 
-      lthresh   = FALSE;
-      luse_last = FALSE;
-      avoid_pole_count  = 0;
-      avoid_pole_offset = TINY;
+	  lthresh   = FALSE;
+	  luse_last = FALSE;
+	  avoid_pole_count  = 0;
+	  avoid_pole_offset = TINY;
 
-      /* Get search cells */
-      num_srch_cells = get_srch_cells(src_cell_add, nbins, src_grid->bin_addr, tgt_grid->bin_addr,
-				      src_grid->cell_bound_box+src_cell_add*4, tgt_grid->cell_bound_box, tgt_grid_size, srch_add);
+	  /* Get search cells */
+	  num_srch_cells = get_srch_cells(src_cell_add, nbins, src_grid->bin_addr, tgt_grid->bin_addr,
+					  src_grid->cell_bound_box+src_cell_add*4, tgt_grid->cell_bound_box, tgt_grid_size, srch_add);
 
-      if ( num_srch_cells == 0 ) continue;
+	  if ( num_srch_cells == 0 ) continue;
 
-      /* Create search arrays */
+	  /* Create search arrays */
 
-      max_srch_cells  = max_srch_cells2[ompthID];
-      srch_corner_lat = srch_corner_lat2[ompthID];
-      srch_corner_lon = srch_corner_lon2[ompthID];
+	  max_srch_cells  = max_srch_cells2[ompthID];
+	  srch_corner_lat = srch_corner_lat2[ompthID];
+	  srch_corner_lon = srch_corner_lon2[ompthID];
 
-      if ( num_srch_cells > max_srch_cells )
-	{
-	  srch_corner_lat = (double*) realloc(srch_corner_lat, srch_corners*num_srch_cells*sizeof(double));
-	  srch_corner_lon = (double*) realloc(srch_corner_lon, srch_corners*num_srch_cells*sizeof(double));
-
-	  max_srch_cells  = num_srch_cells;
-
-	  max_srch_cells2[ompthID]  = max_srch_cells;
-	  srch_corner_lat2[ompthID] = srch_corner_lat;
-	  srch_corner_lon2[ompthID] = srch_corner_lon;
-	}
-
-      /* gather1 */
-      for ( n = 0; n < num_srch_cells; ++n )
-	{
-	  tgt_cell_add = srch_add[n];
-	  ioffset = tgt_cell_add*srch_corners;
-
-	  nsrch_corners = n*srch_corners;
-	  for ( k = 0; k < srch_corners; k++ )
+	  if ( num_srch_cells > max_srch_cells )
 	    {
-	      srch_corner_lat[nsrch_corners+k] = tgt_grid->cell_corner_lat[ioffset+k];
-	      srch_corner_lon[nsrch_corners+k] = tgt_grid->cell_corner_lon[ioffset+k];
-	    }
-	}
-
-      /* Integrate around this cell */
+	      srch_corner_lat = (double*) realloc(srch_corner_lat, srch_corners*num_srch_cells*sizeof(double));
+	      srch_corner_lon = (double*) realloc(srch_corner_lon, srch_corners*num_srch_cells*sizeof(double));
 
-      ioffset = src_cell_add*src_num_cell_corners;
-
-      for ( corner = 0; corner < src_num_cell_corners; ++corner )
-	{
-          next_corn = (corner+1)%src_num_cell_corners;
+	      max_srch_cells  = num_srch_cells;
 
-          /* Define endpoints of the current segment */
-
-          beglat = src_grid->cell_corner_lat[ioffset+corner];
-          beglon = src_grid->cell_corner_lon[ioffset+corner];
-          endlat = src_grid->cell_corner_lat[ioffset+next_corn];
-          endlon = src_grid->cell_corner_lon[ioffset+next_corn];
-          lrevers = FALSE;
-
-	  /*  To ensure exact path taken during both sweeps, always integrate segments in the same direction (SW to NE). */
-          if ( (endlat < beglat) || (IS_EQUAL(endlat, beglat) && endlon < beglon) )
-	    {
-	      beglat = src_grid->cell_corner_lat[ioffset+next_corn];
-	      beglon = src_grid->cell_corner_lon[ioffset+next_corn];
-	      endlat = src_grid->cell_corner_lat[ioffset+corner];
-	      endlon = src_grid->cell_corner_lon[ioffset+corner];
-	      lrevers = TRUE;
+	      max_srch_cells2[ompthID]  = max_srch_cells;
+	      srch_corner_lat2[ompthID] = srch_corner_lat;
+	      srch_corner_lon2[ompthID] = srch_corner_lon;
 	    }
 
-          /*
-	    If this is a constant-longitude segment, skip the rest 
-	    since the line integral contribution will be ZERO.
-          */
-          if ( IS_EQUAL(endlon, beglon) ) continue;
-
-          begseg[0] = beglat;
-          begseg[1] = beglon;
-          lbegin = TRUE;
-
-	  num_subseg = 0;
-	  /*
-	    Integrate along this segment, detecting intersections 
-	    and computing the line integral for each sub-segment
-	  */
-	  while ( IS_NOT_EQUAL(beglat, endlat) || IS_NOT_EQUAL(beglon, endlon) )
+	  /* gather1 */
+	  for ( n = 0; n < num_srch_cells; ++n )
 	    {
-	      /*  Prevent infinite loops if integration gets stuck near cell or threshold boundary */
-	      num_subseg++;
-	      if ( num_subseg >= max_subseg )
-		cdoAbort("Integration stalled: num_subseg exceeded limit (grid1[%d]: lon1=%g lon2=%g lat1=%g lat2=%g)!",
-			 src_cell_add, beglon, endlon, beglat, endlat);
-
-	      /* Uwe Schulzweida: skip very small regions */
-	      if ( num_subseg%1000 == 0 )
+	      tgt_cell_add = srch_add[n];
+	      ioffset = tgt_cell_add*srch_corners;
+
+	      nsrch_corners = n*srch_corners;
+	      for ( k = 0; k < srch_corners; k++ )
 		{
-		  if ( fabs(beglat-endlat) < 1.e-10 || fabs(beglon-endlon) < 1.e-10 )
-		    {
-		      if ( cdoVerbose )
-			cdoPrint("Skip very small region (grid1[%d]): lon=%g dlon=%g lat=%g dlat=%g",
-				 src_cell_add, beglon, endlon-beglon, beglat, endlat-beglat);
-		      break;
-		    }
+		  srch_corner_lat[nsrch_corners+k] = tgt_grid->cell_corner_lat[ioffset+k];
+		  srch_corner_lon[nsrch_corners+k] = tgt_grid->cell_corner_lon[ioffset+k];
 		}
+	    }
 
-	      /* Find next intersection of this segment with a gridline on grid 2. */
+	  /* Integrate around this cell */
 
-	      intersection(&tgt_cell_add, &intrsct_lat, &intrsct_lon, &lcoinc,
-			   beglat, beglon, endlat, endlon, begseg, 
-			   lbegin, lrevers,
-			   num_srch_cells, srch_corners, srch_add,
-			   srch_corner_lat, srch_corner_lon,
-			   &last_loc, &lthresh, &intrsct_lat_off, &intrsct_lon_off,
-			   &luse_last, &intrsct_x, &intrsct_y,
-			   &avoid_pole_count, &avoid_pole_offset);
+	  ioffset = src_cell_add*src_num_cell_corners;
 
-	      lbegin = FALSE;
+	  for ( corner = 0; corner < src_num_cell_corners; ++corner )
+	    {
+	      next_corn = (corner+1)%src_num_cell_corners;
 
-	      /* Compute line integral for this subsegment. */
+	      /* Define endpoints of the current segment */
 
-	      if ( tgt_cell_add != -1 )
-		line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
-			      src_grid->cell_center_lon[src_cell_add], tgt_grid->cell_center_lon[tgt_cell_add]);
-	      else
-		line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
-			      src_grid->cell_center_lon[src_cell_add], src_grid->cell_center_lon[src_cell_add]);
+	      beglat = src_grid->cell_corner_lat[ioffset+corner];
+	      beglon = src_grid->cell_corner_lon[ioffset+corner];
+	      endlat = src_grid->cell_corner_lat[ioffset+next_corn];
+	      endlon = src_grid->cell_corner_lon[ioffset+next_corn];
+	      lrevers = FALSE;
+
+	      /*  To ensure exact path taken during both sweeps, always integrate segments in the same direction (SW to NE). */
+	      if ( (endlat < beglat) || (IS_EQUAL(endlat, beglat) && endlon < beglon) )
+		{
+		  beglat = src_grid->cell_corner_lat[ioffset+next_corn];
+		  beglon = src_grid->cell_corner_lon[ioffset+next_corn];
+		  endlat = src_grid->cell_corner_lat[ioffset+corner];
+		  endlon = src_grid->cell_corner_lon[ioffset+corner];
+		  lrevers = TRUE;
+		}
 
-	      /* If integrating in reverse order, change sign of weights */
+	      /*
+		If this is a constant-longitude segment, skip the rest 
+		since the line integral contribution will be ZERO.
+	      */
+	      if ( IS_EQUAL(endlon, beglon) ) continue;
 
-	      if ( lrevers ) for ( k = 0; k < 6; ++k ) weights[k] = -weights[k];
+	      begseg[0] = beglat;
+	      begseg[1] = beglon;
+	      lbegin = TRUE;
 
+	      num_subseg = 0;
 	      /*
-		Store the appropriate addresses and weights. 
-		Also add contributions to cell areas and centroids.
+		Integrate along this segment, detecting intersections 
+		and computing the line integral for each sub-segment
 	      */
-	      if ( tgt_cell_add != -1 )
-		if ( src_grid->mask[src_cell_add] )
-		  {
-#if defined(_OPENMP)
-#pragma omp critical
-#endif
+	      while ( IS_NOT_EQUAL(beglat, endlat) || IS_NOT_EQUAL(beglon, endlon) )
+		{
+		  /*  Prevent infinite loops if integration gets stuck near cell or threshold boundary */
+		  num_subseg++;
+		  if ( num_subseg >= max_subseg )
+		    cdoAbort("Integration stalled: num_subseg exceeded limit (grid1[%d]: lon1=%g lon2=%g lat1=%g lat2=%g)!",
+			     src_cell_add, beglon, endlon, beglat, endlat);
+
+		  /* Uwe Schulzweida: skip very small regions */
+		  if ( num_subseg%1000 == 0 )
 		    {
-		      if ( remap_store_link_fast )
-			store_link_cnsrv_fast(rv, src_cell_add, tgt_cell_add, num_wts, weights, grid_store);
-		      else
-			store_link_cnsrv(rv, src_cell_add, tgt_cell_add, weights, link_add1, link_add2);
-
-		      tgt_grid->cell_frac[tgt_cell_add] += weights[3];
+		      if ( fabs(beglat-endlat) < 1.e-10 || fabs(beglon-endlon) < 1.e-10 )
+			{
+			  if ( cdoVerbose )
+			    cdoPrint("Skip very small region (grid1[%d]): lon=%g dlon=%g lat=%g dlat=%g",
+				     src_cell_add, beglon, endlon-beglon, beglat, endlat-beglat);
+			  break;
+			}
 		    }
-		    src_grid->cell_frac[src_cell_add] += weights[0];
-		  }
 
-	      src_grid->cell_area[src_cell_add] += weights[0];
-	      src_centroid_lat[src_cell_add] += weights[1];
-	      src_centroid_lon[src_cell_add] += weights[2];
+		  /* Find next intersection of this segment with a gridline on grid 2. */
+
+		  intersection(&tgt_cell_add, &intrsct_lat, &intrsct_lon, &lcoinc,
+			       beglat, beglon, endlat, endlon, begseg, 
+			       lbegin, lrevers,
+			       num_srch_cells, srch_corners, srch_add,
+			       srch_corner_lat, srch_corner_lon,
+			       &last_loc, &lthresh, &intrsct_lat_off, &intrsct_lon_off,
+			       &luse_last, &intrsct_x, &intrsct_y,
+			       &avoid_pole_count, &avoid_pole_offset);
 
-	      /* Reset beglat and beglon for next subsegment. */
-	      beglat = intrsct_lat;
-	      beglon = intrsct_lon;
+		  lbegin = FALSE;
+
+		  /* Compute line integral for this subsegment. */
+
+		  if ( tgt_cell_add != -1 )
+		    line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
+				  src_grid->cell_center_lon[src_cell_add], tgt_grid->cell_center_lon[tgt_cell_add]);
+		  else
+		    line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
+				  src_grid->cell_center_lon[src_cell_add], src_grid->cell_center_lon[src_cell_add]);
+
+		  /* If integrating in reverse order, change sign of weights */
+
+		  if ( lrevers ) for ( k = 0; k < 6; ++k ) weights[k] = -weights[k];
+
+		  /*
+		    Store the appropriate addresses and weights. 
+		    Also add contributions to cell areas and centroids.
+		  */
+		  if ( tgt_cell_add != -1 )
+		    if ( src_grid->mask[src_cell_add] )
+		      {
+			cnsrv_links_add(&cnsrv_links2[ompthID], src_cell_add, tgt_cell_add, weights);
+			src_grid->cell_frac[src_cell_add] += weights[0];
+		      }
+
+		  src_grid->cell_area[src_cell_add] += weights[0];
+		  src_centroid_lat[src_cell_add] += weights[1];
+		  src_centroid_lon[src_cell_add] += weights[2];
+
+		  /* Reset beglat and beglon for next subsegment. */
+		  beglat = intrsct_lat;
+		  beglon = intrsct_lon;
+		}
+	      /* End of segment */
 	    }
-          /* End of segment */
-        }
+	}
+
+      /* store the links of this block in the order of a sequential run */
+      for ( i = 0; i < ompNumThreads; ++i )
+	cnsrv_links_store(rv, &cnsrv_links2[i], grid_store, link_add1, link_add2, NULL, tgt_grid->cell_frac);
     }
 
   if ( cdoTimer ) timer_stop(timer_remap_con_l1);
@@ -1603,196 +1695,197 @@ void scrip_remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, r
 
   findex = 0;
 
+  for ( blk_start = 0; blk_start < tgt_grid_size; blk_start += CNSRV_BLK_SIZE )
+    {
+      blk_end = MIN(blk_start+CNSRV_BLK_SIZE, tgt_grid_size);
+
 #if defined(_OPENMP)
 #pragma omp parallel for default(shared) \
-  shared(ompNumThreads, nbins, num_wts, tgt_centroid_lon, tgt_centroid_lat, \
+  shared(ompNumThreads, nbins, tgt_centroid_lon, tgt_centroid_lat, \
          remap_store_link_fast, grid_store, link_add1, link_add2, rv, cdoVerbose, max_subseg, \
 	 srch_corner_lat2, srch_corner_lon2, max_srch_cells2, 		\
-	 tgt_num_cell_corners, srch_corners, src_grid, tgt_grid, tgt_grid_size, src_grid_size, srch_add2, findex) \
+	 tgt_num_cell_corners, srch_corners, src_grid, tgt_grid, tgt_grid_size, src_grid_size, srch_add2, findex, \
+	 blk_start, blk_end, cnsrv_links2)	\
   private(srch_add, n, k, num_srch_cells, max_srch_cells,	\
 	  src_cell_add, tgt_cell_add, ioffset, nsrch_corners, corner, next_corn, beglat, beglon, \
 	  endlat, endlon, lrevers, begseg, lbegin, num_subseg, srch_corner_lat, srch_corner_lon, \
 	  weights, intrsct_lat, intrsct_lon, intrsct_lat_off, intrsct_lon_off, intrsct_x, intrsct_y, \
-	  last_loc, lcoinc, lthresh, luse_last, avoid_pole_count, avoid_pole_offset)
+	  last_loc, lcoinc, lthresh, luse_last, avoid_pole_count, avoid_pole_offset) \
+  schedule(static)
 #endif
-  for ( tgt_cell_add = 0; tgt_cell_add < tgt_grid_size; ++tgt_cell_add )
-    {
-      int ompthID = cdo_omp_get_thread_num();
-      int lprogress = 1;
-      if ( ompthID != 0 ) lprogress = 0;
+	  for ( tgt_cell_add = blk_start; tgt_cell_add < blk_end; ++tgt_cell_add )
+	{
+	  int ompthID = cdo_omp_get_thread_num();
+	  int lprogress = 1;
+	  if ( ompthID != 0 ) lprogress = 0;
 
 #if defined(_OPENMP)
 #include "pragma_omp_atomic_update.h"
 #endif
-      findex++;
-      if ( lprogress ) progressStatus(0.5, 0.5, findex/tgt_grid_size);
+	  findex++;
+	  if ( lprogress ) progressStatus(0.5, 0.5, findex/tgt_grid_size);
 
-      srch_add = srch_add2[ompthID];
+	  srch_add = srch_add2[ompthID];
 
-      lthresh   = FALSE;
-      luse_last = FALSE;
-      avoid_pole_count  = 0;
-      avoid_pole_offset = TINY;
+	  lthresh   = FALSE;
+	  luse_last = FALSE;
+	  avoid_pole_count  = 0;
+	  avoid_pole_offset = TINY;
 
-      /* Get search cells */
-      num_srch_cells = get_srch_cells(tgt_cell_add, nbins, tgt_grid->bin_addr, src_grid->bin_addr,
-				      tgt_grid->cell_bound_box+tgt_cell_add*4, src_grid->cell_bound_box, src_grid_size, srch_add);
+	  /* Get search cells */
+	  num_srch_cells = get_srch_cells(tgt_cell_add, nbins, tgt_grid->bin_addr, src_grid->bin_addr,
+					  tgt_grid->cell_bound_box+tgt_cell_add*4, src_grid->cell_bound_box, src_grid_size, srch_add);
 
-      if ( num_srch_cells == 0 ) continue;
+	  if ( num_srch_cells == 0 ) continue;
 
-      /* Create search arrays */
+	  /* Create search arrays */
       
-      max_srch_cells  = max_srch_cells2[ompthID];
-      srch_corner_lat = srch_corner_lat2[ompthID];
-      srch_corner_lon = srch_corner_lon2[ompthID];
+	  max_srch_cells  = max_srch_cells2[ompthID];
+	  srch_corner_lat = srch_corner_lat2[ompthID];
+	  srch_corner_lon = srch_corner_lon2[ompthID];
 
-      if ( num_srch_cells > max_srch_cells )
-	{
-	  srch_corner_lat = (double*) realloc(srch_corner_lat, srch_corners*num_srch_cells*sizeof(double));
-	  srch_corner_lon = (double*) realloc(srch_corner_lon, srch_corners*num_srch_cells*sizeof(double));
-
-	  max_srch_cells  = num_srch_cells;
-
-	  max_srch_cells2[ompthID]  = max_srch_cells;
-	  srch_corner_lat2[ompthID] = srch_corner_lat;
-	  srch_corner_lon2[ompthID] = srch_corner_lon;
-	}
-
-      /* gather2 */
-      for ( n = 0; n < num_srch_cells; ++n )
-	{
-	  src_cell_add = srch_add[n];
-	  ioffset = src_cell_add*srch_corners;
-
-	  nsrch_corners = n*srch_corners;
-	  for ( k = 0; k < srch_corners; ++k )
+	  if ( num_srch_cells > max_srch_cells )
 	    {
-	      srch_corner_lat[nsrch_corners+k] = src_grid->cell_corner_lat[ioffset+k];
-	      srch_corner_lon[nsrch_corners+k] = src_grid->cell_corner_lon[ioffset+k];
-	    }
-	}
-
-      /* Integrate around this cell */
-
-      ioffset = tgt_cell_add*tgt_num_cell_corners;
-
-      for ( corner = 0; corner < tgt_num_cell_corners; ++corner )
-	{
-          next_corn = (corner+1)%tgt_num_cell_corners;
-
-          /* Define endpoints of the current segment */
+	      srch_corner_lat = (double*) realloc(srch_corner_lat, srch_corners*num_srch_cells*sizeof(double));
+	      srch_corner_lon = (double*) realloc(srch_corner_lon, srch_corners*num_srch_cells*sizeof(double));
 
-          beglat = tgt_grid->cell_corner_lat[ioffset+corner];
-          beglon = tgt_grid->cell_corner_lon[ioffset+corner];
-          endlat = tgt_grid->cell_corner_lat[ioffset+next_corn];
-          endlon = tgt_grid->cell_corner_lon[ioffset+next_corn];
-          lrevers = FALSE;
+	      max_srch_cells  = num_srch_cells;
 
-	  /* To ensure exact path taken during both sweeps, always integrate in the same direction */
-          if ( (endlat < beglat) || (IS_EQUAL(endlat, beglat) && endlon < beglon) )
-	    {
-	      beglat = tgt_grid->cell_corner_lat[ioffset+next_corn];
-	      beglon = tgt_grid->cell_corner_lon[ioffset+next_corn];
-	      endlat = tgt_grid->cell_corner_lat[ioffset+corner];
-	      endlon = tgt_grid->cell_corner_lon[ioffset+corner];
-	      lrevers = TRUE;
+	      max_srch_cells2[ompthID]  = max_srch_cells;
+	      srch_corner_lat2[ompthID] = srch_corner_lat;
+	      srch_corner_lon2[ompthID] = srch_corner_lon;
 	    }
 
-          /*
-	    If this is a constant-longitude segment, skip the rest 
-	    since the line integral contribution will be ZERO.
-          */
-          if ( IS_EQUAL(endlon, beglon) ) continue;
-
-          begseg[0] = beglat;
-          begseg[1] = beglon;
-          lbegin = TRUE;
-
-	  num_subseg = 0;
-	  /*
-	    Integrate along this segment, detecting intersections 
-	    and computing the line integral for each sub-segment
-	  */
-	  while ( IS_NOT_EQUAL(beglat, endlat) || IS_NOT_EQUAL(beglon, endlon) )
+	  /* gather2 */
+	  for ( n = 0; n < num_srch_cells; ++n )
 	    {
-	      /*  Prevent infinite loops if integration gets stuck near cell or threshold boundary */
-	      num_subseg++;
-	      if ( num_subseg >= max_subseg )
-		cdoAbort("Integration stalled: num_subseg exceeded limit (grid2[%d]: lon1=%g lon2=%g lat1=%g lat2=%g)!",
-			 tgt_cell_add, beglon, endlon, beglat, endlat);
-
-	      /* Uwe Schulzweida: skip very small regions */
-	      if ( num_subseg%1000 == 0 )
+	      src_cell_add = srch_add[n];
+	      ioffset = src_cell_add*srch_corners;
+
+	      nsrch_corners = n*srch_corners;
+	      for ( k = 0; k < srch_corners; ++k )
 		{
-		  if ( fabs(beglat-endlat) < 1.e-10 || fabs(beglon-endlon) < 1.e-10 )
-		    {
-		      if ( cdoVerbose )
-			cdoPrint("Skip very small region (grid2[%d]): lon=%g dlon=%g lat=%g dlat=%g",
-				 tgt_cell_add, beglon, endlon-beglon, beglat, endlat-beglat);
-		      break;
-		    }
+		  srch_corner_lat[nsrch_corners+k] = src_grid->cell_corner_lat[ioffset+k];
+		  srch_corner_lon[nsrch_corners+k] = src_grid->cell_corner_lon[ioffset+k];
 		}
+	    }
 
-	      /* Find next intersection of this segment with a gridline on grid 2. */
+	  /* Integrate around this cell */
 
-	      intersection(&src_cell_add, &intrsct_lat, &intrsct_lon, &lcoinc,
-			   beglat, beglon, endlat, endlon, begseg,
-			   lbegin, lrevers,
-			   num_srch_cells, srch_corners, srch_add,
-			   srch_corner_lat, srch_corner_lon,
-			   &last_loc, &lthresh, &intrsct_lat_off, &intrsct_lon_off,
-			   &luse_last, &intrsct_x, &intrsct_y,
-			   &avoid_pole_count, &avoid_pole_offset);
+	  ioffset = tgt_cell_add*tgt_num_cell_corners;
 
-	      lbegin = FALSE;
+	  for ( corner = 0; corner < tgt_num_cell_corners; ++corner )
+	    {
+	      next_corn = (corner+1)%tgt_num_cell_corners;
 
-	      /* Compute line integral for this subsegment. */
+	      /* Define endpoints of the current segment */
 
-	      if ( src_cell_add != -1 )
-		line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
-			      src_grid->cell_center_lon[src_cell_add], tgt_grid->cell_center_lon[tgt_cell_add]);
-	      else
-		line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
-			      tgt_grid->cell_center_lon[tgt_cell_add], tgt_grid->cell_center_lon[tgt_cell_add]);
+	      beglat = tgt_grid->cell_corner_lat[ioffset+corner];
+	      beglon = tgt_grid->cell_corner_lon[ioffset+corner];
+	      endlat = tgt_grid->cell_corner_lat[ioffset+next_corn];
+	      endlon = tgt_grid->cell_corner_lon[ioffset+next_corn];
+	      lrevers = FALSE;
+
+	      /* To ensure exact path taken during both sweeps, always integrate in the same direction */
+	      if ( (endlat < beglat) || (IS_EQUAL(endlat, beglat) && endlon < beglon) )
+		{
+		  beglat = tgt_grid->cell_corner_lat[ioffset+next_corn];
+		  beglon = tgt_grid->cell_corner_lon[ioffset+next_corn];
+		  endlat = tgt_grid->cell_corner_lat[ioffset+corner];
+		  endlon = tgt_grid->cell_corner_lon[ioffset+corner];
+		  lrevers = TRUE;
+		}
 
-	      /* If integrating in reverse order, change sign of weights */
+	      /*
+		If this is a constant-longitude segment, skip the rest 
+		since the line integral contribution will be ZERO.
+	      */
+	      if ( IS_EQUAL(endlon, beglon) ) continue;
 
-	      if ( lrevers ) for ( k = 0; k < 6; ++k ) weights[k] = -weights[k];
+	      begseg[0] = beglat;
+	      begseg[1] = beglon;
+	      lbegin = TRUE;
 
+	      num_subseg = 0;
 	      /*
-		Store the appropriate addresses and weights. 
-		Also add contributions to cell areas and centroids.
-		If there is a coincidence, do not store weights
-		because they have been captured in the previous loop.
-		The source grid mask is the master mask
+		Integrate along this segment, detecting intersections 
+		and computing the line integral for each sub-segment
 	      */
-	      if ( ! lcoinc && src_cell_add != -1 )
-		if ( src_grid->mask[src_cell_add] )
-		  {
-#if defined(_OPENMP)
-#pragma omp critical
-#endif
+	      while ( IS_NOT_EQUAL(beglat, endlat) || IS_NOT_EQUAL(beglon, endlon) )
+		{
+		  /*  Prevent infinite loops if integration gets stuck near cell or threshold boundary */
+		  num_subseg++;
+		  if ( num_subseg >= max_subseg )
+		    cdoAbort("Integration stalled: num_subseg exceeded limit (grid2[%d]: lon1=%g lon2=%g lat1=%g lat2=%g)!",
+			     tgt_cell_add, beglon, endlon, beglat, endlat);
+
+		  /* Uwe Schulzweida: skip very small regions */
+		  if ( num_subseg%1000 == 0 )
 		    {
-		      if ( remap_store_link_fast )
-			store_link_cnsrv_fast(rv, src_cell_add, tgt_cell_add, num_wts, weights, grid_store);
-		      else
-			store_link_cnsrv(rv, src_cell_add, tgt_cell_add, weights, link_add1, link_add2);
-
-		      src_grid->cell_frac[src_cell_add] += weights[0];
+		      if ( fabs(beglat-endlat) < 1.e-10 || fabs(beglon-endlon) < 1.e-10 )
+			{
+			  if ( cdoVerbose )
+			    cdoPrint("Skip very small region (grid2[%d]): lon=%g dlon=%g lat=%g dlat=%g",
+				     tgt_cell_add, beglon, endlon-beglon, beglat, endlat-beglat);
+			  break;
+			}
 		    }
-		    tgt_grid->cell_frac[tgt_cell_add] += weights[3];
-		  }
 
-	      tgt_grid->cell_area[tgt_cell_add] += weights[3];
-	      tgt_centroid_lat[tgt_cell_add] += weights[4];
-	      tgt_centroid_lon[tgt_cell_add] += weights[5];
+		  /* Find next intersection of this segment with a gridline on grid 2. */
+
+		  intersection(&src_cell_add, &intrsct_lat, &intrsct_lon, &lcoinc,
+			       beglat, beglon, endlat, endlon, begseg,
+			       lbegin, lrevers,
+			       num_srch_cells, srch_corners, srch_add,
+			       srch_corner_lat, srch_corner_lon,
+			       &last_loc, &lthresh, &intrsct_lat_off, &intrsct_lon_off,
+			       &luse_last, &intrsct_x, &intrsct_y,
+			       &avoid_pole_count, &avoid_pole_offset);
 
-	      /* Reset beglat and beglon for next subsegment. */
-	      beglat = intrsct_lat;
-	      beglon = intrsct_lon;
+		  lbegin = FALSE;
+
+		  /* Compute line integral for this subsegment. */
+
+		  if ( src_cell_add != -1 )
+		    line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
+				  src_grid->cell_center_lon[src_cell_add], tgt_grid->cell_center_lon[tgt_cell_add]);
+		  else
+		    line_integral(weights, beglon, intrsct_lon, beglat, intrsct_lat,
+				  tgt_grid->cell_center_lon[tgt_cell_add], tgt_grid->cell_center_lon[tgt_cell_add]);
+
+		  /* If integrating in reverse order, change sign of weights */
+
+		  if ( lrevers ) for ( k = 0; k < 6; ++k ) weights[k] = -weights[k];
+
+		  /*
+		    Store the appropriate addresses and weights. 
+		    Also add contributions to cell areas and centroids.
+		    If there is a coincidence, do not store weights
+		    because they have been captured in the previous loop.
+		    The source grid mask is the master mask
+		  */
+		  if ( ! lcoinc && src_cell_add != -1 )
+		    if ( src_grid->mask[src_cell_add] )
+		      {
+			cnsrv_links_add(&cnsrv_links2[ompthID], src_cell_add, tgt_cell_add, weights);
+			tgt_grid->cell_frac[tgt_cell_add] += weights[3];
+		      }
+
+		  tgt_grid->cell_area[tgt_cell_add] += weights[3];
+		  tgt_centroid_lat[tgt_cell_add] += weights[4];
+		  tgt_centroid_lon[tgt_cell_add] += weights[5];
+
+		  /* Reset beglat and beglon for next subsegment. */
+		  beglat = intrsct_lat;
+		  beglon = intrsct_lon;
+		}
+	      /* End of segment */
 	    }
-          /* End of segment */
 	}
+
+      /* store the links of this block in the order of a sequential run */
+      for ( i = 0; i < ompNumThreads; ++i )
+	cnsrv_links_store(rv, &cnsrv_links2[i], grid_store, link_add1, link_add2, src_grid->cell_frac, NULL);
     }
 
   if ( cdoTimer ) timer_stop(timer_remap_con_l2);
@@ -1808,6 +1901,9 @@ void scrip_remap_weights_conserv(remapgrid_t *src_grid, remapgrid_t *tgt_grid, r
   for ( i = 0; i < ompNumThreads; ++i )
     free(srch_add2[i]);
 
+  for ( i = 0; i < ompNumThreads; ++i )
+    cnsrv_links_free(&cnsrv_links2[i]);
+
   /*
      Correct for situations where N/S pole not explicitly included in
      grid (i.e. as a grid corner point). If pole is missing from only
@@ -11,46 +11,6 @@
 /*                                                                         */
 /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!! */
 
-static
-void get_restrict_add(remapgrid_t *src_grid, double plat, const int *restrict src_bin_add, int *minadd, int *maxadd)
-{
-  int n, n2;
-  int min_add = 0, max_add = 0, nm1, np1;
-  int nbins;
-  restr_t rlat;
-  restr_t *bin_lats = src_grid->bin_lats;
-
-  nbins = src_grid->num_srch_bins;
-
-  rlat = RESTR_SCALE(plat);
-
-  for ( n = 0; n < nbins; ++n )
-    {
-      n2 = n<<1;
-      if ( rlat >= bin_lats[n2  ] && rlat <= bin_lats[n2+1] )
-	{
-	  min_add = src_bin_add[n2  ];
-	  max_add = src_bin_add[n2+1];
-
-	  nm1 = MAX(n-1, 0);
-	  np1 = MIN(n+1, nbins-1);
-
-	  min_add = MIN(min_add, src_bin_add[2*nm1  ]);
-	  max_add = MAX(max_add, src_bin_add[2*nm1+1]);
-	  min_add = MIN(min_add, src_bin_add[2*np1  ]);
-	  max_add = MAX(max_add, src_bin_add[2*np1+1]);
-	}
-    }
-
-  *minadd = min_add;
-  *maxadd = max_add;
-  /*
-  if ( cdoVerbose )
-    printf("plon %g plat %g min_add %ld max_add %ld diff %ld\n",
-	   plon, plat, min_add, max_add, max_add-min_add);
-  */
-}
-
 static
 void nbr_store_distance(int nadd, double distance, int num_neighbors, int *restrict nbr_add, double *restrict nbr_dist)
 {
@@ -264,10 +224,8 @@ void grid_search_nbr_reg2d(int num_neighbors, remapgrid_t *src_grid, int *restri
 }  /*  grid_search_nbr_reg2d  */
 
 static
-void grid_search_nbr(int num_neighbors, remapgrid_t *src_grid, int *restrict nbr_add, double *restrict nbr_dist, 
-		     double plat, double plon, const int *restrict src_bin_add,
-		     const double *restrict sinlat, const double *restrict coslat,
-		     const double *restrict sinlon, const double *restrict coslon)
+void grid_search_nbr(int num_neighbors, const kdtree_t *search_tree, int *restrict nbr_add, double *restrict nbr_dist, 
+		     double plat, double plon, double search_radius)
 {
   /*
     Output variables:
@@ -277,68 +235,11 @@ void grid_search_nbr(int num_neighbors, remapgrid_t *src_grid, int *restrict nbr
 
     Input variables:
 
-    int src_bin_add[][2]  ! search bins for restricting search
-
     double plat,         ! latitude  of the search point
     double plon,         ! longitude of the search point
   */
-  /*  Local variables */
-  int n, nadd;
-  int min_add, max_add;
-  double search_radius = get_search_radius();
-  double coslat_dst = cos(plat);  // cos(lat)  of the search point
-  double coslon_dst = cos(plon);  // cos(lon)  of the search point
-  double sinlat_dst = sin(plat);  // sin(lat)  of the search point
-  double sinlon_dst = sin(plon);  // sin(lon)  of the search point
-  /* Loop over source grid and find nearest neighbors                         */
-  /* restrict the search using search bins expand the bins to catch neighbors */
-
-  get_restrict_add(src_grid, plat, src_bin_add, &min_add, &max_add);
-
-  /* Initialize distance and address arrays */
-  for ( n = 0; n < num_neighbors; ++n ) nbr_add[n]  = -1;
-  for ( n = 0; n < num_neighbors; ++n ) nbr_dist[n] = BIGNUM;
-
-  int i, ndist = max_add - min_add + 1;
-
-  if ( ndist <= 0 ) return;
-
-  double distance;     /* Angular distance */
-  double *dist = (double*) malloc(ndist*sizeof(double));
-  int    *adds = (int*) malloc(ndist*sizeof(int));
-
-  int j = 0;
-  for ( i = 0; i < ndist; ++i )
-    {
-      nadd = min_add+i;
-      /* Find distance to this point */
-      distance =  sinlat_dst*sinlat[nadd] + coslat_dst*coslat[nadd]*
-	         (coslon_dst*coslon[nadd] + sinlon_dst*sinlon[nadd]);
-      /* 2008-07-30 Uwe Schulzweida: check that distance is inside the range of -1 to 1,
-                                     otherwise the result of acos(distance) is NaN */
-      if ( distance >  1. ) distance =  1.;
-
-      if ( distance >= search_radius )
-	{
-	  dist[j] = distance;
-	  adds[j] = nadd;
-	  j++;
-	}
-    }
-  ndist = j;
-
-#if defined(HAVE_OPENMP4)
-  //#pragma omp simd aligned(dist:16)
-#pragma omp simd
-#endif
-  for ( j = 0; j < ndist; ++j )
-    dist[j] = acos(dist[j]);
-
-  for ( j = 0; j < ndist; ++j )
-    nbr_store_distance(adds[j], dist[j], num_neighbors, nbr_add, nbr_dist);
-
-  free(adds);
-  free(dist);
+  /* Find the nearest neighbors with the kd-tree of the source grid */
+  kdtree_search_nbr(search_tree, num_neighbors, nbr_add, nbr_dist, plat, plon, search_radius);
 
   nbr_check_distance(num_neighbors, nbr_add, nbr_dist);
 
@@ -404,33 +305,24 @@ void scrip_remap_weights_distwgt(int num_neighbors, remapgrid_t *src_grid, remap
     }
   else
     {
-      coslat = (double*) malloc(src_grid_size*sizeof(double));
-      coslon = (double*) malloc(src_grid_size*sizeof(double));
-      sinlat = (double*) malloc(src_grid_size*sizeof(double));
-      sinlon = (double*) malloc(src_grid_size*sizeof(double));
-
-      double *center_lon = src_grid->cell_center_lon;
-      double *center_lat = src_grid->cell_center_lat;
-
-#if defined(_OPENMP)
-#pragma omp parallel for default(none) shared(center_lon, center_lat, src_grid_size, coslat, coslon, sinlat, sinlon)
-#endif
-      for ( n = 0; n < src_grid_size; ++n )
-	{
-	  coslon[n] = cos(center_lon[n]);
-	  sinlon[n] = sin(center_lon[n]);
-	  coslat[n] = cos(center_lat[n]);
-	  sinlat[n] = sin(center_lat[n]);
-	}
+      coslat = NULL;
+      coslon = NULL;
+      sinlat = NULL;
+      sinlon = NULL;
+
+      /* The kd-tree depends only on the coordinates, it is kept for all masks of the source grid */
+      if ( src_grid->search_tree == NULL )
+	src_grid->search_tree = kdtree_new(src_grid_size, src_grid->cell_center_lon, src_grid->cell_center_lat);
     }
 
   /* Loop over destination grid  */
 
   double findex = 0;
+  double search_radius = get_search_radius();
 
 #if defined(_OPENMP)
 #pragma omp parallel for default(none) \
-  shared(ompNumThreads, weightlinks, num_neighbors, remap_grid_type, src_grid, tgt_grid, rv, tgt_grid_size, coslat, coslon, sinlat, sinlon, findex) \
+  shared(ompNumThreads, weightlinks, num_neighbors, remap_grid_type, src_grid, tgt_grid, rv, tgt_grid_size, coslat, coslon, sinlat, sinlon, search_radius, findex) \
   private(tgt_cell_add, n, nadds, dist_tot, plat, plon)
 #endif
   for ( tgt_cell_add = 0; tgt_cell_add < tgt_grid_size; ++tgt_cell_add )
@@ -461,9 +353,8 @@ void scrip_remap_weights_distwgt(int num_neighbors, remapgrid_t *src_grid, remap
 			      sinlat, coslat, sinlon, coslon,
 			      src_grid->reg2d_center_lat, src_grid->reg2d_center_lon);
       else
-	grid_search_nbr(num_neighbors, src_grid, nbr_add, nbr_dist, 
-			plat, plon, src_grid->bin_addr,
-			sinlat, coslat, sinlon, coslon);
+	grid_search_nbr(num_neighbors, src_grid->search_tree, nbr_add, nbr_dist, 
+			plat, plon, search_radius);
 
       /* Compute weights based on inverse distance if mask is false, eliminate those points */
 
@@ -501,10 +392,10 @@ void scrip_remap_weights_distwgt(int num_neighbors, remapgrid_t *src_grid, remap
       store_weightlinks(nadds, nbr_add, nbr_dist, tgt_cell_add, weightlinks);
     }
 
-  free(coslat);
-  free(coslon);
-  free(sinlat);
-  free(sinlon);
+  if ( coslat ) free(coslat);
+  if ( coslon ) free(coslon);
+  if ( sinlat ) free(sinlat);
+  if ( sinlon ) free(sinlon);
 
   weightlinks2remaplinks(tgt_grid_size, weightlinks, rv);
 
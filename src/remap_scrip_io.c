@@ -644,6 +644,8 @@ void read_remap_scrip(const char *interp_file, int gridID1, int gridID2, int *ma
 
   rv->pinit = TRUE;
   rv->wts = NULL;
+  rv->row_ptr  = NULL;
+  rv->row_size = 0;
 
   rv->max_links = rv->num_links;
 
@@ -0,0 +1,338 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+/*
+  KD-tree of the grid cell centers on the unit sphere
+
+  The points are stored as 3D cartesian coordinates, the tree is split at the median
+  of the coordinate with the largest extent. The boxes of the nodes are only used to
+  skip subtrees, the distances of the points are computed with the same formula as the
+  latitude bin search. So the neighbors and distances are identical to a full search.
+  The tree is not changed by a search and can be shared by all OpenMP threads.
+*/
+
+#include "cdo.h"
+#include "remap.h"
+
+
+#define  KD_LEAFSIZE   8
+/* slack for the box test, larger than the rounding error of acos() near zero */
+#define  KD_EPS        1.e-6
+
+
+static
+void kd_swap(int *restrict idx, long i, long j)
+{
+  int tmp = idx[i];
+  idx[i] = idx[j];
+  idx[j] = tmp;
+}
+
+/* partial sort of idx[first..last] with coordinate dim, the element k is at its sorted position */
+static
+void kd_select(int *restrict idx, const double *restrict xyz, int dim, long first, long last, long k)
+{
+  long i, j, mid;
+  double pivot;
+
+  while ( last > first )
+    {
+      mid = (first + last)/2;
+      if ( xyz[3*idx[mid]+dim]  < xyz[3*idx[first]+dim] ) kd_swap(idx, mid, first);
+      if ( xyz[3*idx[last]+dim] < xyz[3*idx[first]+dim] ) kd_swap(idx, last, first);
+      if ( xyz[3*idx[last]+dim] < xyz[3*idx[mid]+dim]   ) kd_swap(idx, last, mid);
+      pivot = xyz[3*idx[mid]+dim];
+
+      i = first;
+      j = last;
+      while ( i <= j )
+	{
+	  while ( xyz[3*idx[i]+dim] < pivot ) i++;
+	  while ( xyz[3*idx[j]+dim] > pivot ) j--;
+	  if ( i <= j ) kd_swap(idx, i++, j--);
+	}
+
+      if      ( k <= j ) last  = j;
+      else if ( k >= i ) first = i;
+      else break;
+    }
+}
+
+static
+long kd_new_node(kdtree_t *tree)
+{
+  if ( tree->nnodes == tree->nalloc )
+    {
+      tree->nalloc *= 2;
+      tree->nodes = (kdnode_t*) realloc(tree->nodes, tree->nalloc*sizeof(kdnode_t));
+    }
+
+  return (tree->nnodes++);
+}
+
+static
+long kd_build(kdtree_t *tree, const double *restrict xyz, long first, long last)
+{
+  long i, k, node = kd_new_node(tree);
+  int dim, n;
+  double min[3], max[3];
+  int *restrict idx = tree->idx;
+
+  for ( n = 0; n < 3; ++n ) min[n] = max[n] = xyz[3*idx[first]+n];
+
+  for ( i = first+1; i < last; ++i )
+    for ( n = 0; n < 3; ++n )
+      {
+	if ( xyz[3*idx[i]+n] < min[n] ) min[n] = xyz[3*idx[i]+n];
+	if ( xyz[3*idx[i]+n] > max[n] ) max[n] = xyz[3*idx[i]+n];
+      }
+
+  for ( n = 0; n < 3; ++n )
+    {
+      tree->nodes[node].min[n] = min[n];
+      tree->nodes[node].max[n] = max[n];
+    }
+  tree->nodes[node].first = first;
+  tree->nodes[node].last  = last;
+  tree->nodes[node].left  = -1;
+  tree->nodes[node].right = -1;
+
+  if ( last - first > KD_LEAFSIZE )
+    {
+      dim = 0;
+      for ( n = 1; n < 3; ++n )
+	if ( (max[n]-min[n]) > (max[dim]-min[dim]) ) dim = n;
+
+      k = (first + last)/2;
+      kd_select(idx, xyz, dim, first, last-1, k);
+
+      /* the node array may be reallocated, don't keep pointers to nodes */
+      long left  = kd_build(tree, xyz, first, k);
+      long right = kd_build(tree, xyz, k, last);
+      tree->nodes[node].left  = left;
+      tree->nodes[node].right = right;
+    }
+
+  return (node);
+}
+
+/*
+  Builds the tree of npoints points with the coordinates lon, lat in radians.
+*/
+kdtree_t *kdtree_new(long npoints, const double *restrict lon, const double *restrict lat)
+{
+  long i, n;
+  kdtree_t *tree = (kdtree_t*) malloc(sizeof(kdtree_t));
+
+  tree->npoints = npoints;
+  tree->nnodes  = 0;
+  tree->nalloc  = 2*(npoints/KD_LEAFSIZE) + 16;
+  tree->nodes   = (kdnode_t*) malloc(tree->nalloc*sizeof(kdnode_t));
+  tree->idx     = (int*) malloc(npoints*sizeof(int));
+  tree->sinlat  = (double*) malloc(npoints*sizeof(double));
+  tree->coslat  = (double*) malloc(npoints*sizeof(double));
+  tree->sinlon  = (double*) malloc(npoints*sizeof(double));
+  tree->coslon  = (double*) malloc(npoints*sizeof(double));
+
+  double *xyz = (double*) malloc(3*npoints*sizeof(double));
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(npoints, lon, lat, xyz, tree)
+#endif
+  for ( i = 0; i < npoints; ++i )
+    {
+      double coslat = cos(lat[i]);
+      xyz[3*i  ] = coslat*cos(lon[i]);
+      xyz[3*i+1] = coslat*sin(lon[i]);
+      xyz[3*i+2] = sin(lat[i]);
+      tree->idx[i] = i;
+    }
+
+  if ( npoints > 0 ) kd_build(tree, xyz, 0, npoints);
+
+  free(xyz);
+
+  /* the sin/cos values are stored in tree order, a leaf is a contiguous block */
+  for ( i = 0; i < npoints; ++i )
+    {
+      n = tree->idx[i];
+      tree->coslon[i] = cos(lon[n]);
+      tree->sinlon[i] = sin(lon[n]);
+      tree->coslat[i] = cos(lat[n]);
+      tree->sinlat[i] = sin(lat[n]);
+    }
+
+  if ( cdoVerbose ) cdoPrint("kdtree: %ld points, %ld nodes", npoints, tree->nnodes);
+
+  return (tree);
+}
+
+
+void kdtree_delete(kdtree_t *tree)
+{
+  if ( tree )
+    {
+      if ( tree->nodes  ) free(tree->nodes);
+      if ( tree->idx    ) free(tree->idx);
+      if ( tree->sinlat ) free(tree->sinlat);
+      if ( tree->coslat ) free(tree->coslat);
+      if ( tree->sinlon ) free(tree->sinlon);
+      if ( tree->coslon ) free(tree->coslon);
+      free(tree);
+    }
+}
+
+
+typedef struct {
+  int     num_neighbors;
+  int     nfound;
+  int    *nbr_add;
+  double *nbr_dist;
+  double  search_radius;         /* cos of the search radius */
+  double  bound2;                /* squared chord distance of the search limit */
+  double  q[3];
+  double  sinlat, coslat, sinlon, coslon;
+}
+kdquery_t;
+
+/* squared distance of the query point to the box of the node */
+static inline
+double kd_box_dist2(const kdnode_t *node, const double *q)
+{
+  int n;
+  double d, dist2 = 0;
+
+  for ( n = 0; n < 3; ++n )
+    {
+      if      ( q[n] < node->min[n] ) d = node->min[n] - q[n];
+      else if ( q[n] > node->max[n] ) d = q[n] - node->max[n];
+      else continue;
+      dist2 += d*d;
+    }
+
+  return (dist2);
+}
+
+static inline
+double kd_chord2(double angle)
+{
+  double chord = 2*sin(0.5*angle) + KD_EPS;
+  return (chord*chord);
+}
+
+/* stores the neighbor ordered by distance and address, like a search in ascending address order */
+static
+void kd_store(kdquery_t *query, int nadd, double distance)
+{
+  int n, k = query->num_neighbors;
+  int nfound = query->nfound;
+  int *restrict nbr_add = query->nbr_add;
+  double *restrict nbr_dist = query->nbr_dist;
+
+  if ( nfound == k )
+    {
+      if ( distance > nbr_dist[k-1] || (distance >= nbr_dist[k-1] && nadd > nbr_add[k-1]) ) return;
+      nfound--;
+    }
+
+  for ( n = nfound; n > 0; --n )
+    {
+      if ( distance > nbr_dist[n-1] || (distance >= nbr_dist[n-1] && nadd > nbr_add[n-1]) ) break;
+      nbr_add[n]  = nbr_add[n-1];
+      nbr_dist[n] = nbr_dist[n-1];
+    }
+
+  nbr_add[n]  = nadd;
+  nbr_dist[n] = distance;
+  query->nfound = nfound + 1;
+
+  if ( query->nfound == k ) query->bound2 = kd_chord2(nbr_dist[k-1]);
+}
+
+static
+void kd_search(const kdtree_t *tree, long inode, kdquery_t *query)
+{
+  const kdnode_t *node = &tree->nodes[inode];
+
+  if ( node->left == -1 )
+    {
+      long i;
+      double distance;
+
+      for ( i = node->first; i < node->last; ++i )
+	{
+	  distance =  query->sinlat*tree->sinlat[i] + query->coslat*tree->coslat[i]*
+	             (query->coslon*tree->coslon[i] + query->sinlon*tree->sinlon[i]);
+	  if ( distance >  1. ) distance =  1.;
+
+	  if ( distance >= query->search_radius )
+	    kd_store(query, tree->idx[i], acos(distance));
+	}
+    }
+  else
+    {
+      long near = node->left, far = node->right;
+      double dist2l = kd_box_dist2(&tree->nodes[node->left],  query->q);
+      double dist2r = kd_box_dist2(&tree->nodes[node->right], query->q);
+
+      if ( dist2r < dist2l )
+	{
+	  near = node->right;
+	  far  = node->left;
+	  double tmp = dist2l; dist2l = dist2r; dist2r = tmp;
+	}
+
+      if ( dist2l <= query->bound2 ) kd_search(tree, near, query);
+      if ( dist2r <= query->bound2 ) kd_search(tree, far,  query);
+    }
+}
+
+/*
+  Finds the num_neighbors nearest points to plon, plat (radians) within the search radius
+  (cos of the angle). The result is sorted by the angular distance, equal distances by the
+  address. Unused entries have the address -1 and the distance BIGNUM.
+  Returns the number of neighbors found.
+*/
+int kdtree_search_nbr(const kdtree_t *tree, int num_neighbors, int *restrict nbr_add, double *restrict nbr_dist,
+		      double plat, double plon, double search_radius)
+{
+  int n;
+  kdquery_t query;
+
+  for ( n = 0; n < num_neighbors; ++n ) nbr_add[n]  = -1;
+  for ( n = 0; n < num_neighbors; ++n ) nbr_dist[n] = BIGNUM;
+
+  if ( tree->npoints == 0 || num_neighbors < 1 ) return (0);
+
+  query.num_neighbors = num_neighbors;
+  query.nfound   = 0;
+  query.nbr_add  = nbr_add;
+  query.nbr_dist = nbr_dist;
+  query.search_radius = search_radius;
+  query.coslat = cos(plat);
+  query.coslon = cos(plon);
+  query.sinlat = sin(plat);
+  query.sinlon = sin(plon);
+  query.q[0] = query.coslat*query.coslon;
+  query.q[1] = query.coslat*query.sinlon;
+  query.q[2] = query.sinlat;
+  query.bound2 = kd_chord2(acos(search_radius));
+
+  kd_search(tree, 0, &query);
+
+  return (query.nfound);
+}
@@ -1,4 +1,5 @@
 #include "cdo.h"
+#include "grid.h"
 #include "remap.h"
 /*
 #if defined(_OPENMP)
@@ -297,6 +298,195 @@ int grid_search_nn(long min_add, long max_add, int *restrict nbr_add, double *re
 }
 
 
+/*
+  Creates the kd-tree of the source grid centers for grid_search() and the
+  largest distance of a box corner from the first (south-west) corner. Both
+  depend only on the coordinates and are kept for all masks of the source grid.
+*/
+void grid_search_tree_new(remapgrid_t *src_grid)
+{
+  long nx = src_grid->dims[0];
+  long ny = src_grid->dims[1];
+  long i, j, n, ip1, jp1;
+  long corner_add[3];
+  const double *lon = src_grid->cell_center_lon;
+  const double *lat = src_grid->cell_center_lat;
+  double cos_max = 1;
+
+  if ( src_grid->search_tree == NULL )
+    src_grid->search_tree = kdtree_new(src_grid->size, lon, lat);
+
+  if ( src_grid->search_box_radius >= 0 ) return;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) shared(nx, ny, lon, lat, src_grid) private(i, n, ip1, jp1, corner_add) \
+  reduction(min:cos_max)
+#endif
+  for ( j = 0; j < ny; ++j )
+    for ( i = 0; i < nx; ++i )
+      {
+        long add = j*nx + i;
+
+        ip1 = i < (nx-1) ? i+1 : (src_grid->is_cyclic ? 0 : i);
+        jp1 = j < (ny-1) ? j+1 : j;
+
+        corner_add[0] = j  *nx + ip1;
+        corner_add[1] = jp1*nx + ip1;
+        corner_add[2] = jp1*nx + i;
+
+        for ( n = 0; n < 3; ++n )
+          {
+            long add2 = corner_add[n];
+            double cosdist = sin(lat[add])*sin(lat[add2]) + cos(lat[add])*cos(lat[add2])*cos(lon[add2]-lon[add]);
+            if ( cosdist < cos_max ) cos_max = cosdist;
+          }
+      }
+
+  if ( cos_max < -1 ) cos_max = -1;
+  src_grid->search_box_radius = acos(cos_max);
+
+  if ( cdoVerbose ) cdoPrint("grid_search: box radius %g degree", src_grid->search_box_radius*RAD2DEG);
+}
+
+/*
+  Checks whether the point is inside the box of the four source grid centers
+  with the south-west corner srch_add. On success src_add, src_lats and
+  src_lons hold the corners of the box.
+*/
+static
+int grid_search_box(const remapgrid_t *src_grid, long srch_add, int *restrict src_add, double *restrict src_lats,
+		    double *restrict src_lons, double plat, double plon, restr_t rlat, restr_t rlon,
+		    const double *restrict src_center_lat, const double *restrict src_center_lon,
+		    const restr_t *restrict src_grid_bound_box)
+{
+  long n, next_n;
+  long nx = src_grid->dims[0];
+  long ny = src_grid->dims[1];
+  long i, j, jp1, ip1, n_add, e_add, ne_add;  /* addresses                        */
+  long srch_add4 = srch_add<<2;
+  /* Vectors for cross-product check */
+  double vec1_lat, vec1_lon;
+  double vec2_lat, vec2_lon, cross_product;
+  int scross[4], scross_last = 0;
+
+  /* First check bounding box */
+  if ( rlon < src_grid_bound_box[srch_add4+2] ||
+       rlon > src_grid_bound_box[srch_add4+3] ||
+       rlat < src_grid_bound_box[srch_add4  ] ||
+       rlat > src_grid_bound_box[srch_add4+1] ) return (0);
+
+  /* We are within bounding box so get really serious */
+
+  /* Determine neighbor addresses */
+  j = srch_add/nx;
+  i = srch_add - j*nx;
+
+  if ( i < (nx-1) )
+    ip1 = i + 1;
+  else
+    {
+      /* 2009-01-09 Uwe Schulzweida: bug fix */
+      if ( src_grid->is_cyclic )
+	ip1 = 0;
+      else
+	ip1 = i;
+    }
+
+  if ( j < (ny-1) )
+    jp1 = j + 1;
+  else
+    {
+      /* 2008-12-17 Uwe Schulzweida: latitute cyclic ??? (bug fix) */
+      jp1 = j;
+    }
+
+  n_add  = jp1*nx + i;
+  e_add  = j  *nx + ip1;
+  ne_add = jp1*nx + ip1;
+
+  src_lons[0] = src_center_lon[srch_add];
+  src_lons[1] = src_center_lon[e_add];
+  src_lons[2] = src_center_lon[ne_add];
+  src_lons[3] = src_center_lon[n_add];
+
+  src_lats[0] = src_center_lat[srch_add];
+  src_lats[1] = src_center_lat[e_add];
+  src_lats[2] = src_center_lat[ne_add];
+  src_lats[3] = src_center_lat[n_add];
+
+  /* For consistency, we must make sure all lons are in same 2pi interval */
+
+  vec1_lon = src_lons[0] - plon;
+  if      ( vec1_lon >  PI ) src_lons[0] -= PI2;
+  else if ( vec1_lon < -PI ) src_lons[0] += PI2;
+
+  for ( n = 1; n < 4; ++n )
+    {
+      vec1_lon = src_lons[n] - src_lons[0];
+      if      ( vec1_lon >  PI ) src_lons[n] -= PI2;
+      else if ( vec1_lon < -PI ) src_lons[n] += PI2;
+    }
+
+  /* corner_loop */
+  for ( n = 0; n < 4; ++n )
+    {
+      next_n = (n+1)%4;
+
+      /*
+	Here we take the cross product of the vector making 
+	up each box side with the vector formed by the vertex
+	and search point.  If all the cross products are 
+	positive, the point is contained in the box.
+      */
+      vec1_lat = src_lats[next_n] - src_lats[n];
+      vec1_lon = src_lons[next_n] - src_lons[n];
+      vec2_lat = plat - src_lats[n];
+      vec2_lon = plon - src_lons[n];
+
+      /* Check for 0,2pi crossings */
+
+      if      ( vec1_lon >  THREE*PIH ) vec1_lon -= PI2;
+      else if ( vec1_lon < -THREE*PIH ) vec1_lon += PI2;
+
+      if      ( vec2_lon >  THREE*PIH ) vec2_lon -= PI2;
+      else if ( vec2_lon < -THREE*PIH ) vec2_lon += PI2;
+
+      cross_product = vec1_lon*vec2_lat - vec2_lon*vec1_lat;
+
+      /* If cross product is less than ZERO, this cell doesn't work    */
+      /* 2008-10-16 Uwe Schulzweida: bug fix for cross_product eq zero */
+
+      scross[n] = cross_product < 0 ? -1 : cross_product > 0 ? 1 : 0;
+
+      if ( n == 0 ) scross_last = scross[n];
+
+      if ( (scross[n] < 0 && scross_last > 0) || (scross[n] > 0 && scross_last < 0) ) break;
+
+      scross_last = scross[n];
+    } /* corner_loop */
+
+  if ( n >= 4 )
+    {
+      n = 0;
+      if      ( scross[0]>=0 && scross[1]>=0 && scross[2]>=0 && scross[3]>=0 ) n = 4;
+      else if ( scross[0]<=0 && scross[1]<=0 && scross[2]<=0 && scross[3]<=0 ) n = 4;
+    }
+
+  /* If cross products all same sign, we found the location */
+  if ( n >= 4 )
+    {
+      src_add[0] = srch_add;
+      src_add[1] = e_add;
+      src_add[2] = ne_add;
+      src_add[3] = n_add;
+
+      return (1);
+    }
+
+  return (0);
+}
+
+
 int grid_search(remapgrid_t *src_grid, int *restrict src_add, double *restrict src_lats, 
 		double *restrict src_lons,  double plat, double plon, const int *restrict src_grid_dims,
 		const double *restrict src_center_lat, const double *restrict src_center_lon,
@@ -324,16 +514,12 @@ int grid_search(remapgrid_t *src_grid, int *restrict src_add, double *restrict s
     int src_bin_add[][2]           ! latitude bins for restricting
   */
   /*  Local variables */
-  long n, n2, next_n, srch_add, srch_add4;    /* dummy indices                    */
-  long nx, ny;                                /* dimensions of src grid           */
+  long n, n2, srch_add;                       /* dummy indices                    */
+  long nx;                                    /* dimensions of src grid           */
   long min_add, max_add;                      /* addresses for restricting search */
-  long i, j, jp1, ip1, n_add, e_add, ne_add;  /* addresses                        */
   long nbins;
-  /* Vectors for cross-product check */
-  double vec1_lat, vec1_lon;
-  double vec2_lat, vec2_lon, cross_product;
-  int scross[4], scross_last = 0;
   int search_result = 0;
+  int lscan = TRUE;
   restr_t rlat, rlon;
   restr_t *bin_lats = src_grid->bin_lats;
 
@@ -342,10 +528,52 @@ int grid_search(remapgrid_t *src_grid, int *restrict src_add, double *restrict s
   rlat = RESTR_SCALE(plat);
   rlon = RESTR_SCALE(plon);
 
-  /* restrict search first using bins */
-
   for ( n = 0; n < 4; ++n ) src_add[n] = 0;
 
+  nx = src_grid_dims[0];
+
+  /*
+    A point inside a box is at most the box radius away from its first corner. So
+    without a center in twice this distance (the boxes at the poles are distorted)
+    there is no box to scan. Otherwise the nearest center is usually a corner of
+    the box around the point, and the boxes with this corner are tried first
+    (in address order, like the scan below).
+  */
+  if ( src_grid->search_tree && src_grid->search_box_radius >= 0 )
+    {
+      int nbr_add;
+      double nbr_dist;
+      long cand[4], ncand = 0, k;
+      long i, j, im1;
+      double search_radius = 2*src_grid->search_box_radius < PI ? cos(2*src_grid->search_box_radius) : -1.;
+
+      if ( kdtree_search_nbr(src_grid->search_tree, 1, &nbr_add, &nbr_dist, plat, plon, search_radius) == 0 )
+	lscan = FALSE;
+      else
+	{
+	  j = nbr_add/nx;
+	  i = nbr_add - j*nx;
+	  im1 = i > 0 ? i-1 : (src_grid->is_cyclic ? nx-1 : -1);
+
+	  if ( j > 0 )
+	    {
+	      if ( im1 >= 0 && im1 < i ) cand[ncand++] = (j-1)*nx + im1;
+	      cand[ncand++] = (j-1)*nx + i;
+	      if ( im1 > i ) cand[ncand++] = (j-1)*nx + im1;
+	    }
+	  if ( im1 >= 0 && im1 < i ) cand[ncand++] = j*nx + im1;
+	  cand[ncand++] = j*nx + i;
+	  if ( im1 > i ) cand[ncand++] = j*nx + im1;
+	}
+
+      for ( k = 0; k < ncand; ++k )
+	if ( grid_search_box(src_grid, cand[k], src_add, src_lats, src_lons, plat, plon, rlat, rlon,
+			     src_center_lat, src_center_lon, src_grid_bound_box) )
+	  return (1);
+    }
+
+  /* restrict search first using bins */
+
   min_add = src_grid->size-1;
   max_add = 0;
 
@@ -361,133 +589,14 @@ int grid_search(remapgrid_t *src_grid, int *restrict src_add, double *restrict s
  
   /* Now perform a more detailed search */
 
-  nx = src_grid_dims[0];
-  ny = src_grid_dims[1];
-
   /* srch_loop */
-  for ( srch_add = min_add; srch_add <= max_add; ++srch_add )
-    {
-      srch_add4 = srch_add<<2;
-      /* First check bounding box */
-      if ( rlon >= src_grid_bound_box[srch_add4+2] &&
-	   rlon <= src_grid_bound_box[srch_add4+3] &&
-	   rlat >= src_grid_bound_box[srch_add4  ] &&
-	   rlat <= src_grid_bound_box[srch_add4+1])
-	{
-	  /* We are within bounding box so get really serious */
-
-          /* Determine neighbor addresses */
-          j = srch_add/nx;
-          i = srch_add - j*nx;
-
-          if ( i < (nx-1) )
-            ip1 = i + 1;
-          else
-	    {
-	      /* 2009-01-09 Uwe Schulzweida: bug fix */
-	      if ( src_grid->is_cyclic )
-		ip1 = 0;
-	      else
-		ip1 = i;
-	    }
-
-          if ( j < (ny-1) )
-            jp1 = j + 1;
-          else
-	    {
-	      /* 2008-12-17 Uwe Schulzweida: latitute cyclic ??? (bug fix) */
-	      jp1 = j;
-	    }
-
-          n_add  = jp1*nx + i;
-          e_add  = j  *nx + ip1;
-	  ne_add = jp1*nx + ip1;
-
-          src_lons[0] = src_center_lon[srch_add];
-          src_lons[1] = src_center_lon[e_add];
-          src_lons[2] = src_center_lon[ne_add];
-          src_lons[3] = src_center_lon[n_add];
-
-          src_lats[0] = src_center_lat[srch_add];
-          src_lats[1] = src_center_lat[e_add];
-          src_lats[2] = src_center_lat[ne_add];
-          src_lats[3] = src_center_lat[n_add];
-
-	  /* For consistency, we must make sure all lons are in same 2pi interval */
-
-          vec1_lon = src_lons[0] - plon;
-          if      ( vec1_lon >  PI ) src_lons[0] -= PI2;
-          else if ( vec1_lon < -PI ) src_lons[0] += PI2;
-
-          for ( n = 1; n < 4; ++n )
-	    {
-	      vec1_lon = src_lons[n] - src_lons[0];
-	      if      ( vec1_lon >  PI ) src_lons[n] -= PI2;
-	      else if ( vec1_lon < -PI ) src_lons[n] += PI2;
-	    }
-
-          /* corner_loop */
-          for ( n = 0; n < 4; ++n )
-	    {
-	      next_n = (n+1)%4;
-
-	      /*
-		Here we take the cross product of the vector making 
-		up each box side with the vector formed by the vertex
-		and search point.  If all the cross products are 
-		positive, the point is contained in the box.
-	      */
-	      vec1_lat = src_lats[next_n] - src_lats[n];
-	      vec1_lon = src_lons[next_n] - src_lons[n];
-	      vec2_lat = plat - src_lats[n];
-	      vec2_lon = plon - src_lons[n];
-
-	      /* Check for 0,2pi crossings */
-
-	      if      ( vec1_lon >  THREE*PIH ) vec1_lon -= PI2;
-	      else if ( vec1_lon < -THREE*PIH ) vec1_lon += PI2;
-
-	      if      ( vec2_lon >  THREE*PIH ) vec2_lon -= PI2;
-	      else if ( vec2_lon < -THREE*PIH ) vec2_lon += PI2;
-
-	      cross_product = vec1_lon*vec2_lat - vec2_lon*vec1_lat;
-
-	      /* If cross product is less than ZERO, this cell doesn't work    */
-	      /* 2008-10-16 Uwe Schulzweida: bug fix for cross_product eq zero */
-
-	      scross[n] = cross_product < 0 ? -1 : cross_product > 0 ? 1 : 0;
-
-	      if ( n == 0 ) scross_last = scross[n];
-
-	      if ( (scross[n] < 0 && scross_last > 0) || (scross[n] > 0 && scross_last < 0) ) break;
-
-	      scross_last = scross[n];
-	    } /* corner_loop */
-
-	  if ( n >= 4 )
-	    {
-	      n = 0;
-	      if      ( scross[0]>=0 && scross[1]>=0 && scross[2]>=0 && scross[3]>=0 ) n = 4;
-	      else if ( scross[0]<=0 && scross[1]<=0 && scross[2]<=0 && scross[3]<=0 ) n = 4;
-	    }
-
-	  /* If cross products all same sign, we found the location */
-          if ( n >= 4 )
-	    {
-	      src_add[0] = srch_add;
-	      src_add[1] = e_add;
-	      src_add[2] = ne_add;
-	      src_add[3] = n_add;
-
-	      search_result = 1;
-
-	      return (search_result);
-	    }
-
-	  /* Otherwise move on to next cell */
-
-        } /* Bounding box check */
-    } /* srch_loop */
+  if ( lscan )
+    for ( srch_add = min_add; srch_add <= max_add; ++srch_add )
+      {
+	if ( grid_search_box(src_grid, srch_add, src_add, src_lats, src_lons, plat, plon, rlat, rlon,
+			     src_center_lat, src_center_lon, src_grid_bound_box) )
+	  return (1);
+      } /* srch_loop */
 
   /*
     If no cell found, point is likely either in a box that straddles either pole or is outside 
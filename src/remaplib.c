@@ -104,6 +104,8 @@ void remapGridFree(remapgrid_t *grid)
   if ( grid->bin_addr ) free(grid->bin_addr);
   if ( grid->bin_lats ) free(grid->bin_lats);
 
+  if ( grid->search_tree ) kdtree_delete(grid->search_tree);
+
 } /* remapGridFree */
 
 /*****************************************************************************/
@@ -121,6 +123,9 @@ void remapVarsFree(remapvars_t *rv)
       if ( rv->src_cell_add ) free(rv->src_cell_add);
       if ( rv->tgt_cell_add ) free(rv->tgt_cell_add);
       if ( rv->wts ) free(rv->wts);
+      if ( rv->row_ptr ) free(rv->row_ptr);
+      rv->row_ptr  = NULL;
+      rv->row_size = 0;
 
       if ( rv->links.option == TRUE )
 	{
@@ -180,6 +185,9 @@ void remapgrid_init(remapgrid_t *grid)
 
   grid->bin_addr         = NULL;
   grid->bin_lats         = NULL;
+
+  grid->search_tree      = NULL;
+  grid->search_box_radius = -1;
 }
 
 /*****************************************************************************/
@@ -990,8 +998,14 @@ void remap_vars_init(int map_type, long src_grid_size, long tgt_grid_size, remap
       rv->src_cell_add = NULL;
       rv->tgt_cell_add = NULL;
       rv->wts          = NULL;
+      rv->row_ptr      = NULL;
     }
 
+  /* the row index belongs to the previous links */
+  if ( rv->row_ptr ) free(rv->row_ptr);
+  rv->row_ptr  = NULL;
+  rv->row_size = 0;
+
   /* Determine the number of weights */
 
 #if defined(_OPENMP)
@@ -1188,6 +1202,187 @@ void remap(double *restrict dst_array, double missval, long dst_size, long num_l
   if ( cdoTimer ) timer_stop(timer_remap);
 }
 
+/*
+  Sorts the links by target address and sets up the row index of the resulting
+  CSR matrix. The sort is stable, the links of one target cell keep their order.
+*/
+static
+void remap_vars_rows(remapvars_t *rv, long dst_size)
+{
+  long num_links = rv->num_links;
+  long num_wts = rv->num_wts;
+  long n, i, k, iw;
+  long *row_ptr, *pos;
+  int *src_add, *tgt_add = rv->tgt_cell_add;
+  double *wts;
+  int lsorted = TRUE;
+
+  if ( rv->row_ptr && rv->row_size == dst_size ) return;
+
+  row_ptr = (long*) realloc(rv->row_ptr, (dst_size+1)*sizeof(long));
+  memset(row_ptr, 0, (dst_size+1)*sizeof(long));
+
+  for ( n = 0; n < num_links; ++n ) row_ptr[tgt_add[n]+1]++;
+  for ( i = 0; i < dst_size; ++i ) row_ptr[i+1] += row_ptr[i];
+
+  for ( n = 1; n < num_links; ++n )
+    if ( tgt_add[n] < tgt_add[n-1] ) { lsorted = FALSE; break; }
+
+  if ( lsorted == FALSE )
+    {
+      pos     = (long*) malloc(dst_size*sizeof(long));
+      src_add = (int*) malloc(num_links*sizeof(int));
+      wts     = (double*) malloc(num_wts*num_links*sizeof(double));
+
+      memcpy(pos, row_ptr, dst_size*sizeof(long));
+
+      for ( n = 0; n < num_links; ++n )
+	{
+	  k = pos[tgt_add[n]]++;
+	  src_add[k] = rv->src_cell_add[n];
+	  for ( iw = 0; iw < num_wts; ++iw ) wts[num_wts*k+iw] = rv->wts[num_wts*n+iw];
+	}
+
+      for ( i = 0; i < dst_size; ++i )
+	for ( k = row_ptr[i]; k < row_ptr[i+1]; ++k ) tgt_add[k] = i;
+
+      memcpy(rv->src_cell_add, src_add, num_links*sizeof(int));
+      memcpy(rv->wts, wts, num_wts*num_links*sizeof(double));
+
+      free(pos);
+      free(src_add);
+      free(wts);
+    }
+
+  rv->row_ptr  = row_ptr;
+  rv->row_size = dst_size;
+}
+
+/*
+  Performs the remapping of nvec source fields with the weights of rv.
+  The links are applied row by row of the target grid, which is race free
+  and sums up the links of each target cell in the same order as remap().
+  Multiple fields (e.g. the levels of one variable) share the index and
+  weight traffic of a row. src_size is the stride of the source fields,
+  the target fields are stored with a stride of dst_size.
+  The gradients for second order remapping are only supported for nvec = 1.
+  With lrenorm the weights are independent of the source mask (first order only):
+  source cells with missval are skipped and the rows with missing sources are
+  renormalized by the sum of the remaining weights (NORM_OPT_FRACAREA).
+*/
+void remap_csr(double *restrict dst_array, double missval, long dst_size, long nvec, remapvars_t *rv,
+	       const double *restrict src_array, long src_size, int lrenorm, const double *restrict src_grad1,
+	       const double *restrict src_grad2, const double *restrict src_grad3)
+{
+  long i, k, iv;
+  long num_wts;
+  long nvalid;
+  const long *restrict row_ptr;
+  const int *restrict src_add;
+  const double *restrict wts;
+  double sum, wsum, val;
+  int iorder;
+  int lfracarea = rv->norm_opt == NORM_OPT_FRACAREA;
+  extern int timer_remap;
+
+  if ( rv->links.option == TRUE )
+    {
+      for ( iv = 0; iv < nvec; ++iv )
+	remap(dst_array+iv*dst_size, missval, dst_size, rv->num_links, rv->wts, rv->num_wts,
+	      rv->tgt_cell_add, rv->src_cell_add, src_array+iv*src_size,
+	      src_grad1, src_grad2, src_grad3, rv->links);
+      return;
+    }
+
+  iorder = src_grad1 ? 2 : 1;
+  if ( iorder == 2 && nvec > 1 ) cdoAbort("Second order remapping of more than one field unsupported!");
+  if ( iorder == 2 && lrenorm ) cdoAbort("Second order remapping with renormalization unsupported!");
+
+  if ( cdoTimer ) timer_start(timer_remap);
+
+  remap_vars_rows(rv, dst_size);
+
+  num_wts = rv->num_wts;
+  row_ptr = rv->row_ptr;
+  src_add = rv->src_cell_add;
+  wts     = rv->wts;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) schedule(static) \
+  shared(dst_size, nvec, missval, iorder, num_wts, row_ptr, src_add, wts, src_size, lrenorm, \
+         lfracarea, dst_array, src_array, src_grad1, src_grad2, src_grad3)	\
+  private(i, k, iv, sum, wsum, val, nvalid)
+#endif
+  for ( i = 0; i < dst_size; ++i )
+    {
+      long kbeg = row_ptr[i];
+      long kend = row_ptr[i+1];
+
+      if ( kbeg == kend )
+	{
+	  for ( iv = 0; iv < nvec; ++iv ) dst_array[iv*dst_size+i] = missval;
+	}
+      else if ( lrenorm )
+	{
+	  for ( iv = 0; iv < nvec; ++iv )
+	    {
+	      const double *restrict src = src_array + iv*src_size;
+	      sum = 0.;
+	      wsum = 0.;
+	      nvalid = 0;
+	      for ( k = kbeg; k < kend; ++k )
+		{
+		  val = src[src_add[k]];
+		  if ( !DBL_IS_EQUAL(val, missval) )
+		    {
+		      sum  += val*wts[num_wts*k];
+		      wsum += wts[num_wts*k];
+		      nvalid++;
+		    }
+		}
+
+	      if ( nvalid == 0 )
+		dst_array[iv*dst_size+i] = missval;
+	      else if ( nvalid < kend-kbeg && lfracarea )
+		dst_array[iv*dst_size+i] = IS_NOT_EQUAL(wsum, 0) ? sum/wsum : missval;
+	      else
+		dst_array[iv*dst_size+i] = sum;
+	    }
+	}
+      else if ( iorder == 1 )   /* First order remapping */
+	{
+	  for ( iv = 0; iv < nvec; ++iv )
+	    {
+	      const double *restrict src = src_array + iv*src_size;
+	      sum = 0.;
+	      for ( k = kbeg; k < kend; ++k ) sum += src[src_add[k]]*wts[num_wts*k];
+	      dst_array[iv*dst_size+i] = sum;
+	    }
+	}
+      else if ( num_wts == 3 )  /* Second order remapping */
+	{
+	  sum = 0.;
+	  for ( k = kbeg; k < kend; ++k )
+	    sum += src_array[src_add[k]]*wts[3*k] +
+	           src_grad1[src_add[k]]*wts[3*k+1] +
+	           src_grad2[src_add[k]]*wts[3*k+2];
+	  dst_array[i] = sum;
+	}
+      else if ( num_wts == 4 )
+	{
+	  sum = 0.;
+	  for ( k = kbeg; k < kend; ++k )
+	    sum += src_array[src_add[k]]*wts[4*k] +
+	           src_grad1[src_add[k]]*wts[4*k+1] +
+	           src_grad2[src_add[k]]*wts[4*k+2] +
+	           src_grad3[src_add[k]]*wts[4*k+3];
+	  dst_array[i] = sum;
+	}
+    }
+
+  if ( cdoTimer ) timer_stop(timer_remap);
+}
+
 static
 long get_max_add(long num_links, long size, const int *restrict add)
 {
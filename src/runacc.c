@@ -0,0 +1,323 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+#include <string.h>
+#include <math.h>
+
+#include "cdo.h"
+#include "cdo_int.h"
+#include "runacc.h"
+
+
+/* error free transformation of s + x, the rounding error is collected in c */
+static inline
+void sum_add(double *restrict s, double *restrict c, double x)
+{
+  double t  = *s + x;
+  double bp = t - *s;
+  /* no rounding error for Inf and NaN, the compensation would become NaN */
+  if ( isfinite(t) ) *c += (*s - (t - bp)) + (x - bp);
+  *s = t;
+}
+
+
+runacc_t *runaccNew(int operfunc, int ndates, size_t len, double missval)
+{
+  runacc_t *racc = (runacc_t*) malloc(sizeof(runacc_t));
+  int lminmax = operfunc == func_min || operfunc == func_max;
+  int lvarstd = operfunc == func_std || operfunc == func_var || operfunc == func_std1 || operfunc == func_var1;
+
+  if ( ndates < 1 ) cdoAbort("Window length must be greater than 0!");
+
+  racc->operfunc = operfunc;
+  racc->ndates   = ndates;
+  racc->nfill    = 0;
+  racc->head     = 0;
+  racc->len      = len;
+  racc->missval  = missval;
+
+  racc->slices  = (double*) malloc(ndates*len*sizeof(double));
+  racc->nsamp   = (int*) calloc(len, sizeof(int));
+  racc->sum     = NULL;
+  racc->sumc    = NULL;
+  racc->sumq    = NULL;
+  racc->sumqc   = NULL;
+  racc->deque   = NULL;
+  racc->dqfirst = NULL;
+  racc->dqlen   = NULL;
+
+  if ( lminmax )
+    {
+      racc->deque   = (int*) malloc(ndates*len*sizeof(int));
+      racc->dqfirst = (int*) calloc(len, sizeof(int));
+      racc->dqlen   = (int*) calloc(len, sizeof(int));
+    }
+  else
+    {
+      racc->sum  = (double*) calloc(len, sizeof(double));
+      racc->sumc = (double*) calloc(len, sizeof(double));
+      if ( lvarstd )
+	{
+	  racc->sumq  = (double*) calloc(len, sizeof(double));
+	  racc->sumqc = (double*) calloc(len, sizeof(double));
+	}
+    }
+
+  return (racc);
+}
+
+
+void runaccDelete(runacc_t *racc)
+{
+  if ( racc )
+    {
+      if ( racc->slices )  free(racc->slices);
+      if ( racc->nsamp )   free(racc->nsamp);
+      if ( racc->sum )     free(racc->sum);
+      if ( racc->sumc )    free(racc->sumc);
+      if ( racc->sumq )    free(racc->sumq);
+      if ( racc->sumqc )   free(racc->sumqc);
+      if ( racc->deque )   free(racc->deque);
+      if ( racc->dqfirst ) free(racc->dqfirst);
+      if ( racc->dqlen )   free(racc->dqlen);
+      free(racc);
+    }
+}
+
+static
+void runacc_remove(runacc_t *racc)
+{
+  int ndates = racc->ndates;
+  int pos = racc->head;
+  size_t i, len = racc->len;
+  double missval = racc->missval;
+  const double *restrict array = racc->slices + pos*len;
+  int *restrict nsamp = racc->nsamp;
+
+  if ( racc->deque )
+    {
+      for ( i = 0; i < len; ++i )
+	if ( racc->dqlen[i] > 0 && racc->deque[i*ndates+racc->dqfirst[i]] == pos )
+	  {
+	    racc->dqfirst[i] = (racc->dqfirst[i] + 1) % ndates;
+	    racc->dqlen[i]--;
+	  }
+    }
+
+  for ( i = 0; i < len; ++i )
+    {
+      if ( DBL_IS_EQUAL(array[i], missval) ) continue;
+
+      nsamp[i]--;
+      if ( racc->sum )
+	{
+	  if ( nsamp[i] == 0 )
+	    {
+	      /* reset to avoid any remaining rounding error */
+	      racc->sum[i] = racc->sumc[i] = 0;
+	      if ( racc->sumq ) racc->sumq[i] = racc->sumqc[i] = 0;
+	    }
+	  else if ( isfinite(array[i]) )
+	    {
+	      sum_add(&racc->sum[i], &racc->sumc[i], -array[i]);
+	      if ( racc->sumq ) sum_add(&racc->sumq[i], &racc->sumqc[i], -array[i]*array[i]);
+	    }
+	  else
+	    {
+	      /* Inf and NaN can't be subtracted, sum up the remaining slices */
+	      int k;
+	      racc->sum[i] = racc->sumc[i] = 0;
+	      if ( racc->sumq ) racc->sumq[i] = racc->sumqc[i] = 0;
+	      for ( k = 1; k < racc->nfill; ++k )
+		{
+		  double val = racc->slices[((pos+k)%ndates)*len+i];
+		  if ( DBL_IS_EQUAL(val, missval) ) continue;
+		  sum_add(&racc->sum[i], &racc->sumc[i], val);
+		  if ( racc->sumq ) sum_add(&racc->sumq[i], &racc->sumqc[i], val*val);
+		}
+	    }
+	}
+    }
+
+  racc->head = (racc->head + 1) % ndates;
+  racc->nfill--;
+}
+
+/*
+  Adds the next slice to the window. If the window is full the oldest slice is removed first.
+*/
+void runaccAdd(runacc_t *racc, const double *array)
+{
+  int ndates = racc->ndates;
+  size_t i, len = racc->len;
+  double missval = racc->missval;
+  int *restrict nsamp = racc->nsamp;
+
+  if ( racc->nfill == ndates ) runacc_remove(racc);
+
+  int pos = (racc->head + racc->nfill) % ndates;
+  double *restrict slice = racc->slices + pos*len;
+
+  memcpy(slice, array, len*sizeof(double));
+
+  for ( i = 0; i < len; ++i )
+    if ( !DBL_IS_EQUAL(slice[i], missval) ) nsamp[i]++;
+
+  if ( racc->sum )
+    {
+      for ( i = 0; i < len; ++i )
+	if ( !DBL_IS_EQUAL(slice[i], missval) )
+	  {
+	    sum_add(&racc->sum[i], &racc->sumc[i], slice[i]);
+	    if ( racc->sumq ) sum_add(&racc->sumq[i], &racc->sumqc[i], slice[i]*slice[i]);
+	  }
+    }
+
+  if ( racc->deque )
+    {
+      int lmin = racc->operfunc == func_min;
+      for ( i = 0; i < len; ++i )
+	{
+	  if ( DBL_IS_EQUAL(slice[i], missval) ) continue;
+
+	  int *restrict deque = racc->deque + i*ndates;
+	  int first = racc->dqfirst[i];
+	  int n = racc->dqlen[i];
+	  /* drop all values from the back which can't become the extremum anymore */
+	  while ( n > 0 )
+	    {
+	      double last = racc->slices[deque[(first+n-1)%ndates]*len+i];
+	      if ( lmin ? last < slice[i] : last > slice[i] ) break;
+	      n--;
+	    }
+	  deque[(first+n)%ndates] = pos;
+	  racc->dqlen[i] = n + 1;
+	}
+    }
+
+  racc->nfill++;
+}
+
+/*
+  Computes the statistic of the current window, returns the number of missing values.
+  The results are the same as accumulating the window with farfun, farsum and farsumq.
+*/
+int runaccStat(const runacc_t *racc, int operfunc, double *array)
+{
+  int ndates = racc->ndates;
+  size_t i, len = racc->len;
+  int nmiss = 0;
+  double missval1 = racc->missval;
+  double missval2 = racc->missval;
+  const int *restrict nsamp = racc->nsamp;
+
+  if ( operfunc == func_min || operfunc == func_max )
+    {
+      if ( racc->deque == NULL || racc->operfunc != operfunc )
+	cdoAbort("Internal problem, %s not accumulated!", operfunc == func_min ? "minimum" : "maximum");
+
+      for ( i = 0; i < len; ++i )
+	{
+	  if ( racc->dqlen[i] > 0 )
+	    array[i] = racc->slices[racc->deque[i*ndates+racc->dqfirst[i]]*len+i];
+	  else
+	    {
+	      array[i] = missval1;
+	      nmiss++;
+	    }
+	}
+
+      return (nmiss);
+    }
+
+  if ( racc->sum == NULL ) cdoAbort("Internal problem, sum not accumulated!");
+
+  if ( operfunc == func_sum || operfunc == func_mean || operfunc == func_add || operfunc == func_avg )
+    {
+      int lmean = operfunc == func_mean || operfunc == func_avg;
+      /* add and avg are missing if any value of the window is missing */
+      int nvalid = (operfunc == func_add || operfunc == func_avg) ? racc->nfill : 1;
+      for ( i = 0; i < len; ++i )
+	{
+	  if ( nsamp[i] < nvalid || nsamp[i] == 0 )
+	    array[i] = missval1;
+	  else
+	    {
+	      array[i] = racc->sum[i] + racc->sumc[i];
+	      if ( lmean ) array[i] /= nsamp[i];
+	    }
+	}
+    }
+  else if ( operfunc == func_var || operfunc == func_var1 || operfunc == func_std || operfunc == func_std1 )
+    {
+      double divisor = operfunc == func_std1 || operfunc == func_var1;
+      int lstd = operfunc == func_std || operfunc == func_std1;
+      double sum, sumq, temp;
+
+      if ( racc->sumq == NULL ) cdoAbort("Internal problem, sum of squares not accumulated!");
+
+      for ( i = 0; i < len; ++i )
+	{
+	  if ( nsamp[i] == 0 )
+	    {
+	      array[i] = missval1;
+	      continue;
+	    }
+
+	  sum  = racc->sum[i] + racc->sumc[i];
+	  sumq = racc->sumq[i] + racc->sumqc[i];
+	  temp = DIV(MUL(sum, sum), nsamp[i]);
+	  array[i] = DIV(SUB(sumq, temp), nsamp[i]-divisor);
+	  if ( array[i] < 0 && array[i] > -1.e-5 ) array[i] = 0;
+	  if ( DBL_IS_EQUAL(array[i], missval1) || array[i] < 0 )
+	    array[i] = missval1;
+	  else if ( lstd )
+	    array[i] = IS_NOT_EQUAL(array[i], 0) ? sqrt(array[i]) : 0;
+	}
+    }
+  else
+    cdoAbort("Internal problem, operator function %d not supported!", operfunc);
+
+  for ( i = 0; i < len; ++i )
+    if ( DBL_IS_EQUAL(array[i], missval1) ) nmiss++;
+
+  return (nmiss);
+}
+
+/*
+  Sum of squares of the current window, as accumulated with farmoq and farsumq.
+*/
+int runaccSumq(const runacc_t *racc, double *array)
+{
+  size_t i, len = racc->len;
+  int nmiss = 0;
+
+  if ( racc->sumq == NULL ) cdoAbort("Internal problem, sum of squares not accumulated!");
+
+  for ( i = 0; i < len; ++i )
+    {
+      if ( racc->nsamp[i] == 0 )
+	{
+	  array[i] = racc->missval;
+	  nmiss++;
+	}
+      else
+	array[i] = racc->sumq[i] + racc->sumqc[i];
+    }
+
+  return (nmiss);
+}
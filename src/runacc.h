@@ -0,0 +1,56 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+#ifndef _RUNACC_H
+#define _RUNACC_H
+
+#include <stddef.h>
+
+/*
+  Sliding window accumulator for one field.
+
+  Each new slice is added to the window statistics and the slice leaving the
+  window is subtracted, so one step costs O(len) independent of the window length.
+  Sums are compensated (TwoSum), minima and maxima are kept in a monotonic deque
+  per gridpoint. Missing values are not counted.
+*/
+typedef struct {
+  int      operfunc;
+  int      ndates;       /* window length */
+  int      nfill;        /* number of slices in the window */
+  int      head;         /* ring position of the oldest slice */
+  size_t   len;
+  double   missval;
+  double  *slices;       /* ring buffer with ndates*len values */
+  int     *nsamp;        /* number of valid values per gridpoint */
+  double  *sum, *sumc;   /* running sum and its compensation */
+  double  *sumq, *sumqc; /* running sum of squares and its compensation */
+  int     *deque;        /* ndates ring positions per gridpoint (min/max) */
+  int     *dqfirst, *dqlen;
+}
+runacc_t;
+
+runacc_t *runaccNew(int operfunc, int ndates, size_t len, double missval);
+void      runaccDelete(runacc_t *racc);
+
+void      runaccAdd(runacc_t *racc, const double *array);
+
+/* operfunc: func_min, func_max, func_add, func_sum, func_mean, func_avg, func_var, func_var1, func_std, func_std1 */
+int       runaccStat(const runacc_t *racc, int operfunc, double *array);
+int       runaccSumq(const runacc_t *racc, double *array);
+
+#endif  /* _RUNACC_H */
@@ -1468,3 +1468,301 @@ int jacobi_1side(double **M, double *A, long n)
   return n_iter;
 }
 
+
+/* ******************************************************************************** */
+/*                                                                                  */
+/*   C O V A R I A N C E   K E R N E L S   A N D   T R U N C A T E D   S O L V E R  */
+/*                                                                                  */
+/* ******************************************************************************** */
+
+#define  COV_BLOCK          128
+#define  GRAM_BLOCK          32
+#define  GRAM_CHUNK         512
+#define  LANCZOS_MIN_STEPS   200
+#define  LANCZOS_CHECK        10
+#define  LANCZOS_PRECISION  1e-12
+
+/*
+  Adds the outer products of the npanel rows of panel to the upper triangle of the
+  n x n matrix covar. Each element gets the products in the order of the rows, the
+  result is identical to a rank-1 update per row. The matrix is updated in tiles,
+  a tile stays in cache for all rows of the panel.
+*/
+void covar_panel_update(double **covar, long n, double **panel, int npanel)
+{
+  long ib;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+  for ( ib = 0; ib < n; ib += COV_BLOCK )
+    {
+      long i, j, jb, j0;
+      long iend = ib+COV_BLOCK < n ? ib+COV_BLOCK : n;
+      long jend;
+      int t;
+
+      for ( jb = ib; jb < n; jb += COV_BLOCK )
+	{
+	  jend = jb+COV_BLOCK < n ? jb+COV_BLOCK : n;
+
+	  for ( t = 0; t < npanel; ++t )
+	    {
+	      const double *restrict x = panel[t];
+
+	      for ( i = ib; i < iend; ++i )
+		{
+		  double xi = x[i];
+		  double *restrict ci = covar[i];
+
+		  j0 = jb > i ? jb : i;
+#if defined(HAVE_OPENMP4)
+#pragma omp simd
+#endif
+		  for ( j = j0; j < jend; ++j ) ci[j] += xi*x[j];
+		}
+	    }
+	}
+    }
+}
+
+/*
+  Computes the upper triangle of the weighted Gram matrix of the n rows of x with length m:
+  gram[j1][j2] = sum_i w[i]*x[j1][i]*x[j2][i]. The sums run over i in ascending order, blocked
+  over tiles of rows and chunks of i.
+*/
+void weighted_gram_matrix(double **gram, double **x, const double *restrict w, long n, long m)
+{
+  long nb = (n + GRAM_BLOCK - 1)/GRAM_BLOCK;
+  long itile, ntiles = nb*nb;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) schedule(dynamic)
+#endif
+  for ( itile = 0; itile < ntiles; ++itile )
+    {
+      long jb1 = (itile/nb)*GRAM_BLOCK;
+      long jb2 = (itile%nb)*GRAM_BLOCK;
+      long j1, j2, i, i0, iend;
+      long jend1 = jb1+GRAM_BLOCK < n ? jb1+GRAM_BLOCK : n;
+      long jend2 = jb2+GRAM_BLOCK < n ? jb2+GRAM_BLOCK : n;
+      double sum;
+
+      if ( jb2 < jb1 ) continue;
+
+      for ( j1 = jb1; j1 < jend1; ++j1 )
+	for ( j2 = (jb2 > j1 ? jb2 : j1); j2 < jend2; ++j2 ) gram[j1][j2] = 0;
+
+      for ( i0 = 0; i0 < m; i0 += GRAM_CHUNK )
+	{
+	  iend = i0+GRAM_CHUNK < m ? i0+GRAM_CHUNK : m;
+
+	  for ( j1 = jb1; j1 < jend1; ++j1 )
+	    {
+	      const double *restrict x1 = x[j1];
+
+	      for ( j2 = (jb2 > j1 ? jb2 : j1); j2 < jend2; ++j2 )
+		{
+		  const double *restrict x2 = x[j2];
+
+		  sum = gram[j1][j2];
+		  for ( i = i0; i < iend; ++i ) sum += w[i]*x1[i]*x2[i];
+		  gram[j1][j2] = sum;
+		}
+	    }
+	}
+    }
+}
+
+/* y = M x */
+static
+void lanczos_multiply(double *restrict y, double **M, const double *restrict x, long n)
+{
+  long r;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared)
+#endif
+  for ( r = 0; r < n; ++r )
+    {
+      const double *restrict mr = M[r];
+      double sum = 0;
+      long s;
+
+      for ( s = 0; s < n; ++s ) sum += mr[s]*x[s];
+      y[r] = sum;
+    }
+}
+
+/* orthogonalizes w against the m rows of v (twice for stability), returns the norm of w */
+static
+double lanczos_orthogonalize(double *restrict w, double **v, int m, long n)
+{
+  int i, pass;
+  long r;
+  double dot, norm = 0;
+
+  for ( pass = 0; pass < 2; ++pass )
+    for ( i = 0; i < m; ++i )
+      {
+	const double *restrict vi = v[i];
+	dot = 0;
+	for ( r = 0; r < n; ++r ) dot += vi[r]*w[r];
+	for ( r = 0; r < n; ++r ) w[r] -= dot*vi[r];
+      }
+
+  for ( r = 0; r < n; ++r ) norm += w[r]*w[r];
+
+  return (sqrt(norm));
+}
+
+/* reproducible start vector orthogonal to the m rows of v, returns FALSE if v spans the space */
+static
+int lanczos_start_vector(double *restrict w, double **v, int m, long n, unsigned long *seed)
+{
+  int ntry;
+  long r;
+  double norm;
+
+  for ( ntry = 0; ntry < 10; ++ntry )
+    {
+      for ( r = 0; r < n; ++r )
+	{
+	  *seed = *seed*6364136223846793005UL + 1442695040888963407UL;
+	  w[r] = (double)(*seed >> 11)/9007199254740992. - 0.5;
+	}
+
+      norm = lanczos_orthogonalize(w, v, m, n);
+      if ( norm > 1.e-8 )
+	{
+	  for ( r = 0; r < n; ++r ) w[r] /= norm;
+	  return (TRUE);
+	}
+    }
+
+  return (FALSE);
+}
+
+/*
+  Computes the neig largest eigenvalues of the symmetric positive semidefinite matrix M with the
+  Lanczos algorithm and full reorthogonalization. After return the first neig rows of M are the
+  eigenvectors and A[0..neig-1] the eigenvalues in descending order, the other rows of M are
+  undefined. Returns the number of Lanczos steps or -1 if the iteration did not converge.
+*/
+int truncated_eigen_solution_of_symmetric_matrix(double **M, double *A, int n, int neig, const char func[])
+{
+  int i, j, a, m = 0, mmax, status = -1;
+  long r;
+  unsigned long seed = 1;
+  double res, maxres = 0, anorm = 0;
+  int invariant, exhausted = FALSE;
+
+  if ( neig < 1 ) return (0);
+
+  mmax = 10*neig + LANCZOS_MIN_STEPS;
+  if ( mmax >= n )
+    {
+      eigen_solution_of_symmetric_matrix(M, A, n, func);
+      return (0);
+    }
+
+  double *varray = (double*) malloc((size_t)(mmax+1)*n*sizeof(double));
+  double **v     = (double**) malloc((mmax+1)*sizeof(double*));
+  double *alpha  = (double*) malloc(mmax*sizeof(double));
+  double *beta   = (double*) malloc(mmax*sizeof(double));
+  double *theta  = (double*) malloc(mmax*sizeof(double));
+  double *tarray = (double*) malloc((size_t)mmax*mmax*sizeof(double));
+  double **t     = (double**) malloc(mmax*sizeof(double*));
+
+  for ( j = 0; j <= mmax; ++j ) v[j] = varray + (size_t)j*n;
+
+  lanczos_start_vector(v[0], v, 0, n, &seed);
+
+  for ( j = 0; j < mmax; ++j )
+    {
+      double *restrict w = v[j+1];
+
+      lanczos_multiply(w, M, v[j], n);
+
+      alpha[j] = 0;
+      for ( r = 0; r < n; ++r ) alpha[j] += v[j][r]*w[r];
+
+      beta[j] = lanczos_orthogonalize(w, v, j+1, n);
+
+      m = j+1;
+
+      if ( fabs(alpha[j]) + beta[j] > anorm ) anorm = fabs(alpha[j]) + beta[j];
+
+      /* invariant subspace, continue with a new start vector */
+      invariant = !(beta[j] > 1.e-12*anorm);
+      if ( invariant )
+	{
+	  beta[j] = 0;
+	  exhausted = !lanczos_start_vector(w, v, m, n, &seed);
+	}
+
+      /* Ritz values of the tridiagonal matrix */
+      if ( m >= neig && (m%LANCZOS_CHECK == 0 || m == mmax || exhausted) )
+	{
+	  for ( i = 0; i < m; ++i ) t[i] = tarray + (size_t)i*m;
+	  for ( i = 0; i < m*m; ++i ) tarray[i] = 0;
+	  for ( i = 0; i < m; ++i )
+	    {
+	      t[i][i] = alpha[i];
+	      if ( i+1 < m ) t[i][i+1] = t[i+1][i] = beta[i];
+	    }
+
+	  eigen_solution_of_symmetric_matrix(t, theta, m, func);
+
+	  maxres = 0;
+	  for ( a = 0; a < neig; ++a )
+	    {
+	      res = fabs(beta[j]*t[a][m-1]);
+	      if ( res > maxres ) maxres = res;
+	    }
+
+	  if ( maxres <= LANCZOS_PRECISION*fabs(theta[0]) || !(fabs(theta[0]) > 0) || exhausted )
+	    {
+	      status = m;
+	      break;
+	    }
+	}
+
+      if ( !invariant )
+	for ( r = 0; r < n; ++r ) w[r] /= beta[j];
+    }
+
+  if ( cdoVerbose )
+    cdoPrint("Finished Lanczos iteration for %d of %d eigenvalues after %d steps", neig, n, m);
+
+  if ( status == -1 )
+    cdoWarning("Eigenvalue computation with Lanczos iteration did not converge (residual %g)!", maxres);
+
+  /* Ritz vectors */
+  for ( a = 0; a < neig; ++a )
+    {
+      A[a] = theta[a];
+      for ( r = 0; r < n; ++r ) M[a][r] = 0;
+    }
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) private(a, i)
+#endif
+  for ( r = 0; r < n; ++r )
+    for ( a = 0; a < neig; ++a )
+      {
+	double sum = 0;
+	for ( i = 0; i < m; ++i ) sum += t[a][i]*v[i][r];
+	M[a][r] = sum;
+      }
+
+  free(t);
+  free(tarray);
+  free(theta);
+  free(beta);
+  free(alpha);
+  free(v);
+  free(varray);
+
+  return (status);
+}
@@ -34,5 +34,10 @@ void heap_sort (double *eig_val, double **a, int n);
 // make parallel eigen solution accessible for eigen value computation in EOF3d.c
 void parallel_eigen_solution_of_symmetric_matrix(double **M, double *A, int n, const char func[]);
 
+// covariance kernels and truncated eigen solution for EOFs.c and Eof3d.c
+void covar_panel_update(double **covar, long n, double **panel, int npanel);
+void weighted_gram_matrix(double **gram, double **x, const double *w, long n, long m);
+int truncated_eigen_solution_of_symmetric_matrix(double **M, double *A, int n, int neig, const char func[]);
+
 
 #endif
@@ -0,0 +1,480 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+/*
+  Time series store for operators which need all timesteps of a gridpoint
+  (CDO_TSTORE_MEMORY=<MB>)
+
+  The fields are stored in time order, one frame with all variables and levels
+  per timestep. The frames are kept in memory until they exceed the memory
+  limit, then they are moved to an unlinked temporary file in $TMPDIR.
+  The operators work on tiles, a block of gridpoints with all timesteps where
+  the time series of a gridpoint is contiguous (tile[i*nts+tsID]). The tiles
+  are transposed in blocks of TS_BLOCK timesteps.
+
+  In file mode the timesteps are grouped into blocks of tsblock (<= TS_BLOCK)
+  frames, stored time-major: value p of the frame at timestep t of the block
+  is at p*tsblock+t. The slice of a tile in a block is one contiguous read or
+  write. One block is buffered in memory, new timesteps are appended to it and
+  the fields of a timestep are taken from it.
+*/
+
+#if defined(HAVE_CONFIG_H)
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include <cdi.h>
+#include "cdo.h"
+#include "cdo_int.h"
+#include "tstore.h"
+
+
+#define  NALLOC_INC      1024
+#define  TS_BLOCK        64
+/* tile size without memory limit */
+#define  TILE_BYTES      (64L*1024*1024)
+
+struct tstore {
+  int       nvars;
+  int       nslots;       /* number of fields per timestep */
+  int      *nlevels;
+  int      *slot;         /* first slot of a variable */
+  long     *gridsize;
+  long     *offset;       /* position of a variable in the frame */
+  long      framesize;
+  int       nsteps;
+  int       nalloc;
+  int      *nmiss;        /* nmiss of all slots and timesteps, -1 if the field is undefined */
+  double  **frames;       /* frames in memory */
+  int       fd;           /* temporary file, -1 in memory mode */
+  long      memmax;
+  int       tsblock;      /* timesteps per block in file mode */
+  int       nfileblocks;  /* number of blocks in the file */
+  int       bufblock;     /* block in buf, -1 if none */
+  int       bufdirty;
+  double   *buf;          /* block buffer in file mode, buf[p*tsblock+t] */
+};
+
+
+tstore_t *tstore_new(int vlistID)
+{
+  int varID;
+  tstore_t *store = (tstore_t*) malloc(sizeof(tstore_t));
+
+  store->nvars    = vlistNvars(vlistID);
+  store->nlevels  = (int*) malloc(store->nvars*sizeof(int));
+  store->slot     = (int*) malloc(store->nvars*sizeof(int));
+  store->gridsize = (long*) malloc(store->nvars*sizeof(long));
+  store->offset   = (long*) malloc(store->nvars*sizeof(long));
+
+  store->nslots    = 0;
+  store->framesize = 0;
+  for ( varID = 0; varID < store->nvars; ++varID )
+    {
+      store->nlevels[varID]  = zaxisInqSize(vlistInqVarZaxis(vlistID, varID));
+      store->gridsize[varID] = gridInqSize(vlistInqVarGrid(vlistID, varID));
+      store->slot[varID]     = store->nslots;
+      store->offset[varID]   = store->framesize;
+      store->nslots    += store->nlevels[varID];
+      store->framesize += store->nlevels[varID]*store->gridsize[varID];
+    }
+
+  store->nsteps = 0;
+  store->nalloc = 0;
+  store->nmiss  = NULL;
+  store->frames = NULL;
+  store->fd     = -1;
+  store->memmax = CDO_Tstore_Memory*1024L*1024L;
+
+  store->tsblock     = 0;
+  store->nfileblocks = 0;
+  store->bufblock    = -1;
+  store->bufdirty    = 0;
+  store->buf         = NULL;
+
+  return (store);
+}
+
+
+void tstore_delete(tstore_t *store)
+{
+  int tsID;
+
+  if ( store->frames )
+    {
+      for ( tsID = 0; tsID < store->nsteps; ++tsID )
+	if ( store->frames[tsID] ) free(store->frames[tsID]);
+      free(store->frames);
+    }
+
+  if ( store->fd != -1 ) close(store->fd);
+  if ( store->buf ) free(store->buf);
+
+  if ( store->nmiss ) free(store->nmiss);
+  free(store->nlevels);
+  free(store->slot);
+  free(store->gridsize);
+  free(store->offset);
+  free(store);
+}
+
+static
+void tstore_pread(tstore_t *store, double *data, long nvals, off_t pos)
+{
+  char *ptr = (char *) data;
+  size_t size = nvals*sizeof(double);
+  ssize_t n;
+
+  pos *= (off_t) sizeof(double);
+  while ( size > 0 )
+    {
+      n = pread(store->fd, ptr, size, pos);
+      if ( n == -1 && errno == EINTR ) continue;
+      if ( n <= 0 ) cdoAbort("Read of time series store failed: %s", n == 0 ? "end of file" : strerror(errno));
+      ptr  += n;
+      pos  += n;
+      size -= n;
+    }
+}
+
+static
+void tstore_pwrite(tstore_t *store, const double *data, long nvals, off_t pos)
+{
+  const char *ptr = (const char *) data;
+  size_t size = nvals*sizeof(double);
+  ssize_t n;
+
+  pos *= (off_t) sizeof(double);
+  while ( size > 0 )
+    {
+      n = pwrite(store->fd, ptr, size, pos);
+      if ( n == -1 && errno == EINTR ) continue;
+      if ( n <= 0 ) cdoAbort("Write of time series store failed: %s", strerror(errno));
+      ptr  += n;
+      pos  += n;
+      size -= n;
+    }
+}
+
+/* position of value p of block blockID in the file */
+static
+off_t tstore_filepos(const tstore_t *store, int blockID, long p)
+{
+  return ((off_t)blockID*store->tsblock*store->framesize + (off_t)p*store->tsblock);
+}
+
+/* makes blockID the block in the buffer, a block behind the file is cleared */
+static
+void tstore_load_block(tstore_t *store, int blockID)
+{
+  long bufsize = store->tsblock*store->framesize;
+
+  if ( blockID == store->bufblock ) return;
+
+  if ( store->bufdirty )
+    {
+      tstore_pwrite(store, store->buf, bufsize, tstore_filepos(store, store->bufblock, 0));
+      if ( store->bufblock >= store->nfileblocks ) store->nfileblocks = store->bufblock + 1;
+    }
+
+  if ( blockID < store->nfileblocks )
+    {
+      tstore_pread(store, store->buf, bufsize, tstore_filepos(store, blockID, 0));
+      store->bufdirty = 0;
+    }
+  else
+    {
+      memset(store->buf, 0, bufsize*sizeof(double));
+      store->bufdirty = 1;
+    }
+
+  store->bufblock = blockID;
+}
+
+/* moves the frames to a temporary file */
+static
+void tstore_spill(tstore_t *store)
+{
+  int tsID, t;
+  long p;
+  const char *tmpdir = getenv("TMPDIR");
+  char *filename;
+  const double *frame;
+
+  if ( tmpdir == NULL || *tmpdir == 0 ) tmpdir = "/tmp";
+
+  filename = (char*) malloc(strlen(tmpdir) + 32);
+  sprintf(filename, "%s/cdo_tstore_XXXXXX", tmpdir);
+
+  store->fd = mkstemp(filename);
+  if ( store->fd == -1 )
+    cdoAbort("Open of time series store %s failed: %s", filename, strerror(errno));
+  unlink(filename);
+
+  /* the block buffer uses a quarter of the memory limit */
+  store->tsblock = store->memmax/4/(store->framesize*(long)sizeof(double));
+  if ( store->tsblock < 1 ) store->tsblock = 1;
+  if ( store->tsblock > TS_BLOCK ) store->tsblock = TS_BLOCK;
+  store->buf = (double*) malloc(store->tsblock*store->framesize*sizeof(double));
+
+  if ( cdoVerbose )
+    cdoPrint("Time series store exceeds %ld MB, move %d timesteps to %s, %d timesteps per block",
+	     CDO_Tstore_Memory, store->nsteps, tmpdir, store->tsblock);
+
+  free(filename);
+
+  for ( tsID = 0; tsID < store->nsteps; ++tsID )
+    {
+      tstore_load_block(store, tsID/store->tsblock);
+
+      t = tsID%store->tsblock;
+      frame = store->frames[tsID];
+      for ( p = 0; p < store->framesize; ++p )
+	store->buf[p*store->tsblock+t] = frame[p];
+
+      free(store->frames[tsID]);
+    }
+
+  free(store->frames);
+  store->frames = NULL;
+}
+
+static
+void tstore_add_timestep(tstore_t *store)
+{
+  int i, tsID = store->nsteps;
+
+  if ( tsID >= store->nalloc )
+    {
+      store->nalloc += NALLOC_INC;
+      store->nmiss = (int*) realloc(store->nmiss, store->nalloc*store->nslots*sizeof(int));
+      if ( store->fd == -1 )
+	store->frames = (double**) realloc(store->frames, store->nalloc*sizeof(double*));
+    }
+
+  for ( i = 0; i < store->nslots; ++i ) store->nmiss[tsID*store->nslots+i] = -1;
+
+  store->nsteps++;
+
+  if ( store->fd == -1 )
+    {
+      store->frames[tsID] = (double*) calloc(store->framesize, sizeof(double));
+
+      if ( store->memmax > 0 && (double)store->nsteps*store->framesize*sizeof(double) > store->memmax )
+	tstore_spill(store);
+    }
+  else
+    tstore_load_block(store, tsID/store->tsblock);
+}
+
+
+void tstore_put_field(tstore_t *store, int tsID, int varID, int levelID, const double *field, int nmiss)
+{
+  long i, gridsize = store->gridsize[varID];
+  long offset = store->offset[varID] + levelID*gridsize;
+  double *dst;
+
+  while ( tsID >= store->nsteps ) tstore_add_timestep(store);
+
+  if ( store->fd == -1 )
+    memcpy(store->frames[tsID]+offset, field, gridsize*sizeof(double));
+  else
+    {
+      tstore_load_block(store, tsID/store->tsblock);
+      dst = store->buf + offset*store->tsblock + tsID%store->tsblock;
+      for ( i = 0; i < gridsize; ++i ) dst[i*store->tsblock] = field[i];
+      store->bufdirty = 1;
+    }
+
+  store->nmiss[tsID*store->nslots+store->slot[varID]+levelID] = nmiss;
+}
+
+
+void tstore_get_field(tstore_t *store, int tsID, int varID, int levelID, double *field)
+{
+  long i, gridsize = store->gridsize[varID];
+  long offset = store->offset[varID] + levelID*gridsize;
+  const double *src;
+
+  if ( store->fd == -1 )
+    memcpy(field, store->frames[tsID]+offset, gridsize*sizeof(double));
+  else
+    {
+      tstore_load_block(store, tsID/store->tsblock);
+      src = store->buf + offset*store->tsblock + tsID%store->tsblock;
+      for ( i = 0; i < gridsize; ++i ) field[i] = src[i*store->tsblock];
+    }
+}
+
+
+int tstore_inq_nmiss(const tstore_t *store, int tsID, int varID, int levelID)
+{
+  return (store->nmiss[tsID*store->nslots+store->slot[varID]+levelID]);
+}
+
+
+int tstore_nsteps(const tstore_t *store)
+{
+  return (store->nsteps);
+}
+
+/*
+  Returns the number of gridpoints of a block of nts timesteps, a quarter of the memory limit is used for the block.
+*/
+long tstore_blocksize(const tstore_t *store, int varID, int nts)
+{
+  long tilebytes = store->memmax > 0 ? store->memmax/4 : TILE_BYTES;
+  long npoints = nts > 0 ? tilebytes/((long)nts*sizeof(double)) : 1;
+
+  if ( npoints < 1 ) npoints = 1;
+  if ( npoints > store->gridsize[varID] ) npoints = store->gridsize[varID];
+
+  return (npoints);
+}
+
+/*
+  Returns the number of gridpoints of a tile with all timesteps.
+*/
+long tstore_tilesize(const tstore_t *store, int varID)
+{
+  return (tstore_blocksize(store, varID, store->nsteps));
+}
+
+/*
+  Reads the gridpoints first to first+npoints-1 of the timesteps tsID to tsID+nts-1, block[i*nts+t].
+*/
+void tstore_get_block(tstore_t *store, int tsID, int nts, int varID, int levelID, long first, long npoints, double *block)
+{
+  int t, t0, nt, blockID, tb;
+  long i;
+  long offset = store->offset[varID] + levelID*store->gridsize[varID] + first;
+  double *span;
+  const double *rows;
+  const double *src[TS_BLOCK];
+
+  if ( store->fd == -1 )
+    {
+      for ( t0 = 0; t0 < nts; t0 += TS_BLOCK )
+	{
+	  nt = nts - t0 < TS_BLOCK ? nts - t0 : TS_BLOCK;
+
+	  for ( t = 0; t < nt; ++t ) src[t] = store->frames[tsID+t0+t] + offset;
+
+	  for ( i = 0; i < npoints; ++i )
+	    for ( t = 0; t < nt; ++t )
+	      block[i*nts+t0+t] = src[t][i];
+	}
+
+      return;
+    }
+
+  /* file mode: one read of npoints*tsblock values per block */
+  tb = store->tsblock;
+  span = (double*) malloc(npoints*tb*sizeof(double));
+
+  for ( t0 = 0; t0 < nts; t0 += nt )
+    {
+      blockID = (tsID+t0)/tb;
+      t  = (tsID+t0)%tb;
+      nt = nts - t0 < tb - t ? nts - t0 : tb - t;
+
+      if ( blockID == store->bufblock )
+	rows = store->buf + offset*tb + t;
+      else
+	{
+	  tstore_pread(store, span, npoints*tb, tstore_filepos(store, blockID, offset));
+	  rows = span + t;
+	}
+
+      for ( i = 0; i < npoints; ++i )
+	memcpy(block+i*nts+t0, rows+i*tb, nt*sizeof(double));
+    }
+
+  free(span);
+}
+
+/*
+  Reads the gridpoints first to first+npoints-1 of all timesteps, tile[i*nts+tsID].
+*/
+void tstore_get_tile(tstore_t *store, int varID, int levelID, long first, long npoints, double *tile)
+{
+  tstore_get_block(store, 0, store->nsteps, varID, levelID, first, npoints, tile);
+}
+
+/*
+  Writes a tile back to all timesteps, the inverse of tstore_get_tile().
+*/
+void tstore_put_tile(tstore_t *store, int varID, int levelID, long first, long npoints, const double *tile)
+{
+  int nts = store->nsteps;
+  int t, t0, nt, tb;
+  long i;
+  long offset = store->offset[varID] + levelID*store->gridsize[varID] + first;
+  double *span, *rows;
+  double *dst[TS_BLOCK];
+
+  if ( store->fd == -1 )
+    {
+      for ( t0 = 0; t0 < nts; t0 += TS_BLOCK )
+	{
+	  nt = nts - t0 < TS_BLOCK ? nts - t0 : TS_BLOCK;
+
+	  for ( t = 0; t < nt; ++t ) dst[t] = store->frames[t0+t] + offset;
+
+	  for ( i = 0; i < npoints; ++i )
+	    for ( t = 0; t < nt; ++t )
+	      dst[t][i] = tile[i*nts+t0+t];
+	}
+
+      return;
+    }
+
+  /* file mode: one write of npoints*tsblock values per block */
+  tb = store->tsblock;
+  span = (double*) malloc(npoints*tb*sizeof(double));
+
+  for ( t0 = 0; t0 < nts; t0 += tb )
+    {
+      nt = nts - t0 < tb ? nts - t0 : tb;
+
+      if ( t0/tb == store->bufblock )
+	{
+	  rows = store->buf + offset*tb;
+	  store->bufdirty = 1;
+	}
+      else
+	{
+	  rows = span;
+	  if ( nt < tb ) memset(span, 0, npoints*tb*sizeof(double));
+	}
+
+      for ( i = 0; i < npoints; ++i )
+	memcpy(rows+i*tb, tile+i*nts+t0, nt*sizeof(double));
+
+      if ( rows == span )
+	tstore_pwrite(store, span, npoints*tb, tstore_filepos(store, t0/tb, offset));
+    }
+
+  free(span);
+}
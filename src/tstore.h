@@ -0,0 +1,38 @@
+/*
+  This file is part of CDO. CDO is a collection of Operators to
+  manipulate and analyse Climate model Data.
+
+  Copyright (C) 2003-2015 Uwe Schulzweida, <uwe.schulzweida AT mpimet.mpg.de>
+  See COPYING file for copying and redistribution conditions.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+*/
+
+#ifndef _TSTORE_H
+#define _TSTORE_H
+
+/* time series store, all timesteps of a vlist in memory or in a temporary file */
+typedef struct tstore tstore_t;
+
+tstore_t *tstore_new(int vlistID);
+void      tstore_delete(tstore_t *store);
+
+void tstore_put_field(tstore_t *store, int tsID, int varID, int levelID, const double *field, int nmiss);
+void tstore_get_field(tstore_t *store, int tsID, int varID, int levelID, double *field);
+int  tstore_inq_nmiss(const tstore_t *store, int tsID, int varID, int levelID);
+int  tstore_nsteps(const tstore_t *store);
+
+long tstore_blocksize(const tstore_t *store, int varID, int nts);
+long tstore_tilesize(const tstore_t *store, int varID);
+void tstore_get_block(tstore_t *store, int tsID, int nts, int varID, int levelID, long first, long npoints, double *block);
+void tstore_get_tile(tstore_t *store, int varID, int levelID, long first, long npoints, double *tile);
+void tstore_put_tile(tstore_t *store, int varID, int levelID, long first, long npoints, const double *tile);
+
+#endif  /* _TSTORE_H */
@@ -81,6 +81,10 @@ int cdoCheckDatarange    = FALSE;
 
 int CDO_Color            = FALSE;
 int CDO_Use_FFTW         = TRUE;
+int CDO_Pipe_Queue       = 0;               // number of record buffers per pipe
+long CDO_Tstore_Memory   = 0;               // memory limit of the time series store [MB]
+int CDO_Ensstat_Group    = 0;               // max. number of open ensemble member files
+int CDO_Write_Threads    = 0;               // number of writer threads of the split operators
 int cdoDiag              = FALSE;
 
 int CDO_Append_History   = TRUE;
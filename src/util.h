@@ -88,6 +88,10 @@ extern int cdoExpMode;
 
 extern int CDO_Color;
 extern int CDO_Use_FFTW;
+extern int CDO_Pipe_Queue;
+extern long CDO_Tstore_Memory;
+extern int CDO_Ensstat_Group;
+extern int CDO_Write_Threads;
 extern int cdoDiag;
 
 extern int cdoNumVarnames;